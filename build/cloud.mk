@@ -5,9 +5,11 @@ CLOUD_SERVER_SOURCES = \
 	$(SRC)/Cloud/Client.cpp \
 	$(SRC)/Cloud/Thermal.cpp \
 	$(SRC)/Cloud/Data.cpp \
+	$(SRC)/Cloud/Sharded.cpp \
+	$(SRC)/Cloud/Journal.cpp \
 	$(SRC)/Cloud/Sender.cpp \
 	$(SRC)/Cloud/Main.cpp
-CLOUD_SERVER_DEPENDS = ASYNC IO OS GEO MATH UTIL
+CLOUD_SERVER_DEPENDS = ASYNC IO OS THREAD GEO MATH UTIL
 $(eval $(call link-program,xcsoar-cloud-server,CLOUD_SERVER))
 
 CLOUD_TO_KML_SOURCES = \
@@ -20,6 +22,23 @@ CLOUD_TO_KML_SOURCES = \
 CLOUD_TO_KML_DEPENDS = ASYNC IO OS GEO MATH UTIL
 $(eval $(call link-program,xcsoar-cloud-to-kml,CLOUD_TO_KML))
 
+TEST_SHARDED_CLOUD_DATA_SOURCES = \
+	$(SRC)/Tracking/SkyLines/Assemble.cpp \
+	$(SRC)/Cloud/Serialiser.cpp \
+	$(SRC)/Cloud/Client.cpp \
+	$(SRC)/Cloud/Thermal.cpp \
+	$(SRC)/Cloud/Data.cpp \
+	$(SRC)/Cloud/Sharded.cpp \
+	$(TEST_SRC_DIR)/tap.c \
+	$(TEST_SRC_DIR)/TestShardedCloudData.cpp
+TEST_SHARDED_CLOUD_DATA_DEPENDS = ASYNC IO OS THREAD GEO MATH UTIL
+$(eval $(call link-program,TestShardedCloudData,TEST_SHARDED_CLOUD_DATA))
+
 ifeq ($(TARGET),UNIX)
 OPTIONAL_OUTPUTS += $(CLOUD_SERVER_BIN) $(CLOUD_TO_KML_BIN)
+OPTIONAL_OUTPUTS += $(TEST_SHARDED_CLOUD_DATA_BIN)
+
+check-cloud: $(TEST_SHARDED_CLOUD_DATA_BIN)
+	@$(NQ)echo "  TEST    $(notdir $^)"
+	$(Q)$(PERL) $(TEST_SRC_DIR)/testall.pl $^
 endif
@@ -87,6 +87,7 @@ TEST_NAMES = \
 	test_pressure \
 	test_task \
 	TestOverwritingRingBuffer \
+	TestSnapshotBuffer TestWorkStealingPool \
 	TestDateTime TestRoughTime TestWrapClock \
 	TestMath \
 	TestMathTables \
@@ -94,10 +95,12 @@ TEST_NAMES = \
 	TestUnits TestEarth TestSunEphemeris \
 	TestValidity TestUTM TestProfile \
 	TestAllocatedGrid \
+	TestTerrainInterpolation \
 	TestRadixTree TestGeoBounds TestGeoClip \
+	TestXShapeCache TestXShapeStore \
 	TestLogger TestGRecord TestDriver TestClimbAvCalc \
 	TestWaypointReader TestThermalBase \
-	TestFlarmNet \
+	TestFlarmNet TestTrafficList \
 	TestColorRamp TestGeoPoint TestDiffFilter \
 	TestFileUtil TestPolars TestCSVLine TestGlidePolar \
 	test_replay_task TestProjection TestFlatPoint TestFlatLine TestFlatGeoPoint \
@@ -108,6 +111,7 @@ TEST_NAMES = \
 	TestTeamCode \
 	TestZeroFinder \
 	TestAirspaceParser \
+	TestAirspacePolygon \
 	TestMETARParser \
 	TestIGCParser \
 	TestByteOrder \
@@ -124,7 +128,6 @@ TEST_NAMES = \
 	TestLeastSquares \
 	TestThermalBand
 
-
 TESTS = $(call name-to-bin,$(TEST_NAMES))
 
 TEST_CRC_SOURCES = \
@@ -155,6 +158,18 @@ TEST_OVERWRITING_RING_BUFFER_SOURCES = \
 TEST_OVERWRITING_RING_BUFFER_DEPENDS = MATH
 $(eval $(call link-program,TestOverwritingRingBuffer,TEST_OVERWRITING_RING_BUFFER))
 
+TEST_SNAPSHOT_BUFFER_SOURCES = \
+	$(TEST_SRC_DIR)/tap.c \
+	$(TEST_SRC_DIR)/TestSnapshotBuffer.cpp
+TEST_SNAPSHOT_BUFFER_DEPENDS = THREAD
+$(eval $(call link-program,TestSnapshotBuffer,TEST_SNAPSHOT_BUFFER))
+
+TEST_WORK_STEALING_POOL_SOURCES = \
+	$(TEST_SRC_DIR)/tap.c \
+	$(TEST_SRC_DIR)/TestWorkStealingPool.cpp
+TEST_WORK_STEALING_POOL_DEPENDS = THREAD
+$(eval $(call link-program,TestWorkStealingPool,TEST_WORK_STEALING_POOL))
+
 TEST_IGC_PARSER_SOURCES = \
 	$(SRC)/IGC/IGCParser.cpp \
 	$(TEST_SRC_DIR)/tap.c \
@@ -184,6 +199,7 @@ $(eval $(call link-program,TestMETARParser,TEST_METAR_PARSER))
 
 TEST_AIRSPACE_PARSER_SOURCES = \
 	$(SRC)/Airspace/AirspaceParser.cpp \
+	$(SRC)/Airspace/AirspaceCache.cpp \
 	$(SRC)/Units/Descriptor.cpp \
 	$(SRC)/Units/System.cpp \
 	$(SRC)/Operation/Operation.cpp \
@@ -197,6 +213,21 @@ TEST_AIRSPACE_PARSER_LDADD = $(FAKE_LIBS)
 TEST_AIRSPACE_PARSER_DEPENDS = IO OS AIRSPACE ZZIP GEO MATH UTIL
 $(eval $(call link-program,TestAirspaceParser,TEST_AIRSPACE_PARSER))
 
+TEST_AIRSPACE_POLYGON_SOURCES = \
+	$(SRC)/Airspace/AirspaceParser.cpp \
+	$(SRC)/Units/Descriptor.cpp \
+	$(SRC)/Units/System.cpp \
+	$(SRC)/Operation/Operation.cpp \
+	$(SRC)/Atmosphere/Pressure.cpp \
+	$(TEST_SRC_DIR)/FakeDialogs.cpp \
+	$(TEST_SRC_DIR)/FakeTerrain.cpp \
+	$(TEST_SRC_DIR)/FakeLanguage.cpp \
+	$(TEST_SRC_DIR)/tap.c \
+	$(TEST_SRC_DIR)/TestAirspacePolygon.cpp
+TEST_AIRSPACE_POLYGON_LDADD = $(FAKE_LIBS)
+TEST_AIRSPACE_POLYGON_DEPENDS = IO OS AIRSPACE ZZIP GEO MATH UTIL
+$(eval $(call link-program,TestAirspacePolygon,TEST_AIRSPACE_POLYGON))
+
 TEST_DATE_TIME_SOURCES = \
 	$(TEST_SRC_DIR)/tap.c \
 	$(TEST_SRC_DIR)/TestDateTime.cpp
@@ -302,7 +333,7 @@ TEST_REACH_SOURCES = \
 	$(TEST_SRC_DIR)/Printing.cpp \
 	$(TEST_SRC_DIR)/tap.c \
 	$(TEST_SRC_DIR)/test_reach.cpp
-TEST_REACH_DEPENDS = TERRAIN IO ZZIP OS ROUTE GLIDE GEO MATH UTIL
+TEST_REACH_DEPENDS = TERRAIN IO ZZIP OS THREAD ROUTE GLIDE GEO MATH UTIL
 $(eval $(call link-program,test_reach,TEST_REACH))
 
 TEST_ROUTE_SOURCES = \
@@ -323,6 +354,7 @@ $(eval $(call link-program,test_route,TEST_ROUTE))
 
 TEST_REPLAY_TASK_SOURCES = \
 	$(SRC)/NMEA/Info.cpp \
+	$(SRC)/FLARM/List.cpp \
 	$(SRC)/NMEA/ExternalSettings.cpp \
 	$(SRC)/NMEA/Attitude.cpp \
 	$(SRC)/NMEA/Acceleration.cpp \
@@ -404,6 +436,14 @@ TEST_FLARM_NET_SOURCES = \
 TEST_FLARM_NET_DEPENDS = IO OS MATH UTIL
 $(eval $(call link-program,TestFlarmNet,TEST_FLARM_NET))
 
+TEST_TRAFFIC_LIST_SOURCES = \
+	$(SRC)/FLARM/List.cpp \
+	$(SRC)/FLARM/FlarmId.cpp \
+	$(TEST_SRC_DIR)/tap.c \
+	$(TEST_SRC_DIR)/TestTrafficList.cpp
+TEST_TRAFFIC_LIST_DEPENDS = MATH
+$(eval $(call link-program,TestTrafficList,TEST_TRAFFIC_LIST))
+
 TEST_GEO_CLIP_SOURCES = \
 	$(TEST_SRC_DIR)/tap.c \
 	$(TEST_SRC_DIR)/TestGeoClip.cpp
@@ -604,12 +644,46 @@ TEST_ALLOCATED_GRID_SOURCES = \
 TEST_ALLOCATED_GRID_DEPENDS = UTIL
 $(eval $(call link-program,TestAllocatedGrid,TEST_ALLOCATED_GRID))
 
+TEST_TERRAIN_INTERPOLATION_SOURCES = \
+	$(SRC)/Terrain/RasterBuffer.cpp \
+	$(SRC)/Terrain/InterpolationBatch.cpp \
+	$(TEST_SRC_DIR)/tap.c \
+	$(TEST_SRC_DIR)/TestTerrainInterpolation.cpp
+TEST_TERRAIN_INTERPOLATION_DEPENDS = UTIL
+$(eval $(call link-program,TestTerrainInterpolation,TEST_TERRAIN_INTERPOLATION))
+
 TEST_RADIX_TREE_SOURCES = \
 	$(TEST_SRC_DIR)/tap.c \
 	$(TEST_SRC_DIR)/TestRadixTree.cpp
 TEST_RADIX_TREE_DEPENDS = UTIL
 $(eval $(call link-program,TestRadixTree,TEST_RADIX_TREE))
 
+TEST_XSHAPE_CACHE_SOURCES = \
+	$(SRC)/Topography/XShapeCache.cpp \
+	$(SRC)/Topography/XShape.cpp \
+	$(TEST_SRC_DIR)/tap.c \
+	$(TEST_SRC_DIR)/TestXShapeCache.cpp
+ifeq ($(OPENGL),y)
+TEST_XSHAPE_CACHE_SOURCES += \
+	$(SCREEN_SRC_DIR)/OpenGL/Triangulate.cpp
+endif
+TEST_XSHAPE_CACHE_DEPENDS = GEO MATH THREAD UTIL SHAPELIB ZZIP
+TEST_XSHAPE_CACHE_CPPFLAGS = $(SCREEN_CPPFLAGS)
+$(eval $(call link-program,TestXShapeCache,TEST_XSHAPE_CACHE))
+
+TEST_XSHAPE_STORE_SOURCES = \
+	$(SRC)/Topography/XShapeStore.cpp \
+	$(SRC)/Topography/XShape.cpp \
+	$(TEST_SRC_DIR)/tap.c \
+	$(TEST_SRC_DIR)/TestXShapeStore.cpp
+ifeq ($(OPENGL),y)
+TEST_XSHAPE_STORE_SOURCES += \
+	$(SCREEN_SRC_DIR)/OpenGL/Triangulate.cpp
+endif
+TEST_XSHAPE_STORE_DEPENDS = GEO MATH OS IO UTIL SHAPELIB ZZIP
+TEST_XSHAPE_STORE_CPPFLAGS = $(SCREEN_CPPFLAGS)
+$(eval $(call link-program,TestXShapeStore,TEST_XSHAPE_STORE))
+
 TEST_LOGGER_SOURCES = \
 	$(SRC)/IGC/IGCFix.cpp \
 	$(SRC)/IGC/IGCWriter.cpp \
@@ -730,6 +804,11 @@ DEBUG_PROGRAM_NAMES = \
 	RunWaveComputer \
 	FlightPath \
 	BenchmarkProjection \
+	BenchmarkTrace \
+	BenchmarkAirspaceWarnings \
+	BenchmarkAirspaceRoute \
+	BenchmarkTerrainInterpolation \
+	BenchmarkTerrainRenderer \
 	BenchmarkFAITriangleSector \
 	DumpTextFile DumpTextZip DumpTextInflate WriteTextFile RunTextWriter \
 	DumpHexColor \
@@ -801,7 +880,7 @@ DEBUG_PROGRAM_NAMES += \
 endif
 
 ifeq ($(HAVE_HTTP),y)
-DEBUG_PROGRAM_NAMES += DownloadFile RunDownloadToFile RunNOAADownloader RunSkyLinesTracking RunLiveTrack24
+DEBUG_PROGRAM_NAMES += DownloadFile RunDownloadToFile RunNOAADownloader RunSkyLinesTracking RunCloudLoad RunLiveTrack24
 endif
 
 ifeq ($(TARGET_IS_LINUX),y)
@@ -897,6 +976,33 @@ BENCHMARK_PROJECTION_DEPENDS = MATH
 BENCHMARK_PROJECTION_CPPFLAGS = $(SCREEN_CPPFLAGS)
 $(eval $(call link-program,BenchmarkProjection,BENCHMARK_PROJECTION))
 
+BENCHMARK_TRACE_SOURCES = \
+	$(SRC)/Engine/Trace/Point.cpp \
+	$(SRC)/Engine/Trace/Trace.cpp \
+	$(TEST_SRC_DIR)/BenchmarkTrace.cpp
+BENCHMARK_TRACE_DEPENDS = OS GEO MATH UTIL
+$(eval $(call link-program,BenchmarkTrace,BENCHMARK_TRACE))
+
+$(eval $(call link-harness-program,BenchmarkAirspaceWarnings))
+
+$(eval $(call link-harness-program,BenchmarkAirspaceRoute))
+
+BENCHMARK_TERRAIN_INTERPOLATION_SOURCES = \
+	$(SRC)/Terrain/RasterBuffer.cpp \
+	$(SRC)/Terrain/InterpolationBatch.cpp \
+	$(TEST_SRC_DIR)/BenchmarkTerrainInterpolation.cpp
+BENCHMARK_TERRAIN_INTERPOLATION_DEPENDS = UTIL
+$(eval $(call link-program,BenchmarkTerrainInterpolation,BENCHMARK_TERRAIN_INTERPOLATION))
+
+BENCHMARK_TERRAIN_RENDERER_SOURCES = \
+	$(SRC)/Projection/Projection.cpp \
+	$(SRC)/Projection/WindowProjection.cpp \
+	$(SRC)/Operation/Operation.cpp \
+	$(TEST_SRC_DIR)/BenchmarkTerrainRenderer.cpp
+BENCHMARK_TERRAIN_RENDERER_CPPFLAGS = $(SCREEN_CPPFLAGS)
+BENCHMARK_TERRAIN_RENDERER_DEPENDS = TERRAIN GEO MATH IO OS THREAD ZZIP UTIL
+$(eval $(call link-program,BenchmarkTerrainRenderer,BENCHMARK_TERRAIN_RENDERER))
+
 BENCHMARK_FAI_TRIANGLE_SECTOR_SOURCES = \
 	$(ENGINE_SRC_DIR)/Task/Shapes/FAITriangleSettings.cpp \
 	$(ENGINE_SRC_DIR)/Task/Shapes/FAITriangleArea.cpp \
@@ -1003,6 +1109,7 @@ $(eval $(call link-program,RunWPASupplicant,RUN_WPA_SUPPLICANT))
 RUN_SL_TRACKING_SOURCES = \
 	$(DEBUG_REPLAY_SOURCES) \
 	$(SRC)/NMEA/Info.cpp \
+	$(SRC)/FLARM/List.cpp \
 	$(SRC)/NMEA/ExternalSettings.cpp \
 	$(SRC)/NMEA/Attitude.cpp \
 	$(SRC)/NMEA/Acceleration.cpp \
@@ -1013,6 +1120,13 @@ RUN_SL_TRACKING_LDADD = $(DEBUG_REPLAY_LDADD)
 RUN_SL_TRACKING_DEPENDS = LIBNET OS GEO MATH UTIL TIME
 $(eval $(call link-program,RunSkyLinesTracking,RUN_SL_TRACKING))
 
+RUN_CLOUD_LOAD_SOURCES = \
+	$(SRC)/Tracking/SkyLines/Client.cpp \
+	$(SRC)/Tracking/SkyLines/Assemble.cpp \
+	$(TEST_SRC_DIR)/RunCloudLoad.cpp
+RUN_CLOUD_LOAD_DEPENDS = LIBNET OS GEO MATH UTIL TIME
+$(eval $(call link-program,RunCloudLoad,RUN_CLOUD_LOAD))
+
 RUN_LIVETRACK24_SOURCES = \
 	$(DEBUG_REPLAY_SOURCES) \
 	$(SRC)/Tracking/LiveTrack24.cpp \
@@ -1117,6 +1231,8 @@ LOAD_TOPOGRAPHY_SOURCES = \
 	$(SRC)/Topography/TopographyStore.cpp \
 	$(SRC)/Topography/TopographyFile.cpp \
 	$(SRC)/Topography/XShape.cpp \
+	$(SRC)/Topography/XShapeStore.cpp \
+	$(SRC)/Topography/XShapeCache.cpp \
 	$(SRC)/Projection/Projection.cpp \
 	$(SRC)/Projection/WindowProjection.cpp \
 	$(SRC)/Operation/Operation.cpp \
@@ -1125,7 +1241,7 @@ ifeq ($(OPENGL),y)
 LOAD_TOPOGRAPHY_SOURCES += \
 	$(SCREEN_SRC_DIR)/OpenGL/Triangulate.cpp
 endif
-LOAD_TOPOGRAPHY_DEPENDS = RESOURCE GEO MATH THREAD IO UTIL SHAPELIB ZZIP
+LOAD_TOPOGRAPHY_DEPENDS = RESOURCE GEO MATH THREAD IO OS UTIL SHAPELIB ZZIP
 LOAD_TOPOGRAPHY_CPPFLAGS = $(SCREEN_CPPFLAGS)
 $(eval $(call link-program,LoadTopography,LOAD_TOPOGRAPHY))
 
@@ -1209,6 +1325,7 @@ $(eval $(call link-program,RunFlightParser,RUN_FLIGHT_PARSER))
 
 RUN_AIRSPACE_PARSER_SOURCES = \
 	$(SRC)/Airspace/AirspaceParser.cpp \
+	$(SRC)/Airspace/AirspaceCache.cpp \
 	$(SRC)/Units/Descriptor.cpp \
 	$(SRC)/Units/System.cpp \
 	$(SRC)/Operation/Operation.cpp \
@@ -1312,6 +1429,7 @@ RUN_DECLARE_SOURCES = \
 	$(SRC)/NMEA/Checksum.cpp \
 	$(SRC)/NMEA/ExternalSettings.cpp \
 	$(SRC)/NMEA/Info.cpp \
+	$(SRC)/FLARM/List.cpp \
 	$(SRC)/NMEA/SwitchState.cpp \
 	$(SRC)/NMEA/Attitude.cpp \
 	$(SRC)/NMEA/Acceleration.cpp \
@@ -1347,6 +1465,7 @@ RUN_ENABLE_NMEA_SOURCES = \
 	$(SRC)/NMEA/Checksum.cpp \
 	$(SRC)/NMEA/ExternalSettings.cpp \
 	$(SRC)/NMEA/Info.cpp \
+	$(SRC)/FLARM/List.cpp \
 	$(SRC)/NMEA/SwitchState.cpp \
 	$(SRC)/NMEA/Attitude.cpp \
 	$(SRC)/NMEA/Acceleration.cpp \
@@ -1437,6 +1556,7 @@ RUN_FLIGHT_LIST_SOURCES = \
 	$(SRC)/NMEA/Checksum.cpp \
 	$(SRC)/NMEA/ExternalSettings.cpp \
 	$(SRC)/NMEA/Info.cpp \
+	$(SRC)/FLARM/List.cpp \
 	$(SRC)/NMEA/SwitchState.cpp \
 	$(SRC)/NMEA/Attitude.cpp \
 	$(SRC)/NMEA/Acceleration.cpp \
@@ -1470,6 +1590,7 @@ RUN_DOWNLOAD_FLIGHT_SOURCES = \
 	$(SRC)/NMEA/Checksum.cpp \
 	$(SRC)/NMEA/ExternalSettings.cpp \
 	$(SRC)/NMEA/Info.cpp \
+	$(SRC)/FLARM/List.cpp \
 	$(SRC)/NMEA/SwitchState.cpp \
 	$(SRC)/NMEA/Attitude.cpp \
 	$(SRC)/NMEA/Acceleration.cpp \
@@ -1502,6 +1623,7 @@ CAI302_TOOL_SOURCES = \
 	$(SRC)/NMEA/Checksum.cpp \
 	$(SRC)/NMEA/ExternalSettings.cpp \
 	$(SRC)/NMEA/Info.cpp \
+	$(SRC)/FLARM/List.cpp \
 	$(SRC)/NMEA/SwitchState.cpp \
 	$(SRC)/NMEA/Attitude.cpp \
 	$(SRC)/NMEA/Acceleration.cpp \
@@ -1861,6 +1983,8 @@ RUN_MAP_WINDOW_SOURCES = \
 	$(SRC)/Topography/TopographyRenderer.cpp \
 	$(SRC)/Topography/TopographyGlue.cpp \
 	$(SRC)/Topography/XShape.cpp \
+	$(SRC)/Topography/XShapeStore.cpp \
+	$(SRC)/Topography/XShapeCache.cpp \
 	$(SRC)/Topography/CachedTopographyRenderer.cpp \
 	$(SRC)/Units/Units.cpp \
 	$(SRC)/Units/Settings.cpp \
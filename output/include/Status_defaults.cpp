@@ -0,0 +1,180 @@
+  {
+    _T("DEFAULT"),
+    _T("IDR_WAV_DRIP"),
+    true,
+    1500,
+  },
+  {
+    _T("Pan mode ON"),
+    _T("IDR_INSERT"),
+    true,
+    1500,
+  },
+  {
+    _T("Pan mode OFF"),
+    _T("IDR_REMOVE"),
+    true,
+    1500,
+  },
+  {
+    _T("AutoZoom ON"),
+    _T("IDR_INSERT"),
+    true,
+    1500,
+  },
+  {
+    _T("AutoZoom OFF"),
+    _T("IDR_REMOVE"),
+    true,
+    1500,
+  },
+  {
+    _T("Calibrate ON"),
+    _T("IDR_INSERT"),
+    true,
+    1500,
+  },
+  {
+    _T("Calibrate OFF"),
+    _T("IDR_REMOVE"),
+    true,
+    1500,
+  },
+  {
+    _T("Closest Airfield Changed!"),
+    _T("IDR_REMOVE"),
+    true,
+    1500,
+  },
+  {
+    _T("SnailTrail OFF"),
+    _T("IDR_REMOVE"),
+    true,
+    1500,
+  },
+  {
+    _T("SnailTrail ON Long"),
+    _T("IDR_INSERT"),
+    true,
+    1500,
+  },
+  {
+    _T("SnailTrail ON Short"),
+    _T("IDR_INSERT"),
+    true,
+    1500,
+  },
+  {
+    _T("Vario Sounds ON"),
+    _T("IDR_INSERT"),
+    true,
+    1500,
+  },
+  {
+    _T("Vario Sounds OFF"),
+    _T("IDR_REMOVE"),
+    true,
+    1500,
+  },
+  {
+    _T("Dropped marker"),
+    _T("IDR_WAV_BEEPBWEEP"),
+    true,
+    1500,
+  },
+  {
+    _T("Waiting for GPS connection"),
+    NULL,
+    true,
+    1500,
+  },
+  {
+    _T("Restarting comm. ports"),
+    NULL,
+    true,
+    1500,
+  },
+  {
+    _T("Waiting for GPS fix"),
+    NULL,
+    true,
+    1500,
+  },
+  {
+    _T("XCI Error"),
+    _T("IDR_FAIL"),
+    true,
+    30000,
+  },
+  {
+    _T("MacCready Value"),
+    NULL,
+    true,
+    5000,
+  },
+  {
+    _T("Auto MacCready ON"),
+    _T("IDR_INSERT"),
+    true,
+    1500,
+  },
+  {
+    _T("Auto MacCready OFF"),
+    _T("IDR_REMOVE"),
+    true,
+    1500,
+  },
+  {
+    _T("Task aborted"),
+    _T("IDR_REMOVE"),
+    true,
+    1500,
+  },
+  {
+    _T("Task Resume"),
+    _T("IDR_REMOVE"),
+    true,
+    1500,
+  },
+  {
+    _T("Bugs performance"),
+    NULL,
+    true,
+    5000,
+  },
+  {
+    _T("Ballast %"),
+    NULL,
+    true,
+    5000,
+  },
+  {
+    _T("Logger ok"),
+    _T("IDR_INSERT"),
+    true,
+    1500,
+  },
+  {
+    _T("Logger off"),
+    _T("IDR_REMOVE"),
+    true,
+    1500,
+  },
+  {
+    _T("Status"),
+    NULL,
+    true,
+    60000,
+  },
+  {
+    _T("Battery low"),
+    _T("IDR_FAIL"),
+    true,
+    5000,
+  },
+  {
+    _T("Screen Mode Full"),
+    NULL,
+    true,
+    1000,
+  },
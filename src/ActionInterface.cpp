@@ -46,15 +46,10 @@ namespace ActionInterface {
 void
 XCSoarInterface::ReceiveGPS()
 {
-  {
-    ScopeLock protect(device_blackboard->mutex);
-
-    ReadBlackboardBasic(device_blackboard->Basic());
+  if (device_blackboard->ui_basic.Update())
+    BorrowBlackboardBasic(device_blackboard->ui_basic.GetFront());
 
-    const NMEAInfo &real = device_blackboard->RealState();
-    Private::movement_detected = real.alive && real.gps.real &&
-      real.MovementDetected();
-  }
+  Private::movement_detected = device_blackboard->movement_detected;
 
   BroadcastGPSUpdate();
 
@@ -66,10 +61,11 @@ XCSoarInterface::ReceiveGPS()
 void
 XCSoarInterface::ReceiveCalculated()
 {
+  if (device_blackboard->ui_calculated.Update())
+    BorrowBlackboardCalculated(device_blackboard->ui_calculated.GetFront());
+
   {
     ScopeLock protect(device_blackboard->mutex);
-
-    ReadBlackboardCalculated(device_blackboard->Calculated());
     device_blackboard->ReadComputerSettings(GetComputerSettings());
   }
 
@@ -0,0 +1,377 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#include "AirspaceCache.hpp"
+#include "Engine/Airspace/Airspaces.hpp"
+#include "Engine/Airspace/AirspacePolygon.hpp"
+#include "Engine/Airspace/AirspaceCircle.hpp"
+#include "IO/FileCache.hpp"
+#include "OS/FileMapping.hpp"
+#include "Util/CRC.hpp"
+#include "Util/tstring.hpp"
+
+#include <map>
+#include <memory>
+
+#include <stdint.h>
+#include <string.h>
+
+namespace {
+
+constexpr uint32_t MAGIC = 0x41535043;
+constexpr uint16_t VERSION = 1;
+
+/**
+ * File layout: the #Header, followed by #Header::num_airspaces
+ * #Record structs, #Header::num_points #Point structs and
+ * #Header::num_chars TCHARs of null-terminated strings.  All values
+ * are in host byte order; the cache is not meant to be portable.
+ *
+ * The payload is not guaranteed to be aligned within the mapping,
+ * therefore all structs are copied out with memcpy().
+ */
+struct Header {
+  uint32_t magic;
+  uint16_t version;
+  uint8_t tchar_size;
+  uint8_t reserved;
+
+  uint32_t num_airspaces;
+  uint32_t num_points;
+  uint32_t num_chars;
+
+  /**
+   * CRC16-CCITT of everything after the header.
+   */
+  uint16_t crc;
+  uint16_t reserved2;
+};
+
+struct Altitude {
+  double altitude, flight_level, altitude_above_terrain;
+  AltitudeReference reference;
+  uint8_t reserved[7];
+};
+
+struct Record {
+  Altitude base, top;
+
+  /**
+   * The radius of an #AirspaceCircle [m].  Unused for polygons.
+   */
+  double radius;
+
+  /**
+   * The range of the #Point array.  A circle has exactly one point,
+   * its center.
+   */
+  uint32_t first_point, num_points;
+
+  /**
+   * Offsets into the string table.
+   */
+  uint32_t name, radio;
+
+  AbstractAirspace::Shape shape;
+  AirspaceClass type;
+  AirspaceActivity days;
+  uint8_t reserved[5];
+};
+
+struct Point {
+  double latitude, longitude;
+};
+
+static_assert(sizeof(Header) == 24, "Wrong size");
+static_assert(sizeof(Altitude) == 32, "Wrong size");
+static_assert(sizeof(Record) == 96, "Wrong size");
+static_assert(sizeof(Point) == 16, "Wrong size");
+
+/**
+ * Collects null-terminated strings in one buffer, storing duplicates
+ * (most airspaces have no radio frequency) only once.
+ */
+class StringTable {
+  std::vector<TCHAR> chars;
+  std::map<tstring, uint32_t> index;
+
+public:
+  uint32_t Add(const tstring &s) {
+    auto i = index.find(s);
+    if (i != index.end())
+      return i->second;
+
+    const uint32_t offset = chars.size();
+    chars.insert(chars.end(), s.begin(), s.end());
+    chars.push_back(_T('\0'));
+    index.emplace(s, offset);
+    return offset;
+  }
+
+  const std::vector<TCHAR> &GetChars() const {
+    return chars;
+  }
+};
+
+}
+
+static Altitude
+ExportAltitude(const AirspaceAltitude &src)
+{
+  Altitude dest{};
+  dest.altitude = src.altitude;
+  dest.flight_level = src.flight_level;
+  dest.altitude_above_terrain = src.altitude_above_terrain;
+  dest.reference = src.reference;
+  return dest;
+}
+
+static AirspaceAltitude
+ImportAltitude(const Altitude &src)
+{
+  AirspaceAltitude dest;
+  dest.altitude = src.altitude;
+  dest.flight_level = src.flight_level;
+  dest.altitude_above_terrain = src.altitude_above_terrain;
+  dest.reference = src.reference;
+  return dest;
+}
+
+static void
+AddPoint(std::vector<Point> &points, const GeoPoint &location)
+{
+  points.push_back({location.latitude.Native(),
+                    location.longitude.Native()});
+}
+
+template<typename T>
+static bool
+WriteArray(FILE *file, const std::vector<T> &v)
+{
+  return v.empty() ||
+    fwrite(v.data(), sizeof(T), v.size(), file) == v.size();
+}
+
+template<typename T>
+static uint16_t
+UpdateCRC(const std::vector<T> &v, uint16_t crc)
+{
+  return UpdateCRC16CCITT(v.data(), v.size() * sizeof(T), crc);
+}
+
+bool
+WriteAirspaceCache(FILE *file,
+                   const std::vector<const AbstractAirspace *> &items)
+{
+  std::vector<Record> records;
+  records.reserve(items.size());
+
+  std::vector<Point> points;
+  StringTable strings;
+
+  for (const AbstractAirspace *as : items) {
+    Record record{};
+    record.base = ExportAltitude(as->GetBase());
+    record.top = ExportAltitude(as->GetTop());
+    record.first_point = points.size();
+    record.name = strings.Add(as->GetName());
+    record.radio = strings.Add(as->GetRadioText());
+    record.shape = as->GetShape();
+    record.type = as->GetType();
+    record.days = as->GetDays();
+
+    switch (as->GetShape()) {
+    case AbstractAirspace::Shape::CIRCLE: {
+      const AirspaceCircle &circle = (const AirspaceCircle &)*as;
+      record.radius = circle.GetRadius();
+      AddPoint(points, circle.GetReferenceLocation());
+      break;
+    }
+
+    case AbstractAirspace::Shape::POLYGON:
+      for (const auto &i : as->GetPoints())
+        AddPoint(points, i.GetLocation());
+      break;
+    }
+
+    record.num_points = points.size() - record.first_point;
+    records.push_back(record);
+  }
+
+  const auto &chars = strings.GetChars();
+
+  Header header{};
+  header.magic = MAGIC;
+  header.version = VERSION;
+  header.tchar_size = sizeof(TCHAR);
+  header.num_airspaces = records.size();
+  header.num_points = points.size();
+  header.num_chars = chars.size();
+
+  uint16_t crc = 0;
+  crc = UpdateCRC(records, crc);
+  crc = UpdateCRC(points, crc);
+  crc = UpdateCRC(chars, crc);
+  header.crc = crc;
+
+  return fwrite(&header, sizeof(header), 1, file) == 1 &&
+    WriteArray(file, records) && WriteArray(file, points) &&
+    WriteArray(file, chars);
+}
+
+gcc_pure
+static bool
+IsValidRecord(const Record &record, const Header &header)
+{
+  if (record.first_point > header.num_points ||
+      record.num_points > header.num_points - record.first_point ||
+      record.name >= header.num_chars || record.radio >= header.num_chars)
+    return false;
+
+  switch (record.shape) {
+  case AbstractAirspace::Shape::CIRCLE:
+    return record.num_points == 1;
+
+  case AbstractAirspace::Shape::POLYGON:
+    return record.num_points >= 3;
+  }
+
+  return false;
+}
+
+static GeoPoint
+ReadPoint(const uint8_t *points, unsigned i)
+{
+  Point point;
+  memcpy(&point, points + i * sizeof(point), sizeof(point));
+  return GeoPoint(Angle::Native(point.longitude),
+                  Angle::Native(point.latitude));
+}
+
+bool
+ReadAirspaceCache(Airspaces &airspaces, const void *data, size_t size)
+{
+  const uint8_t *p = (const uint8_t *)data;
+
+  Header header;
+  if (size < sizeof(header))
+    return false;
+
+  memcpy(&header, p, sizeof(header));
+  if (header.magic != MAGIC || header.version != VERSION ||
+      header.tchar_size != sizeof(TCHAR))
+    return false;
+
+  const uint64_t records_size =
+    uint64_t(header.num_airspaces) * sizeof(Record);
+  const uint64_t points_size = uint64_t(header.num_points) * sizeof(Point);
+  const uint64_t chars_size = uint64_t(header.num_chars) * sizeof(TCHAR);
+  if (sizeof(header) + records_size + points_size + chars_size != size)
+    return false;
+
+  const uint8_t *records = p + sizeof(header);
+  const uint8_t *points = records + records_size;
+  const uint8_t *chars_data = points + points_size;
+
+  if (UpdateCRC16CCITT(records, size - sizeof(header), 0) != header.crc)
+    return false;
+
+  if (header.num_chars == 0 && header.num_airspaces > 0)
+    return false;
+
+  /* copy the string table to get proper alignment, and make sure
+     that every offset points to a null-terminated string */
+  std::unique_ptr<TCHAR[]> chars(new TCHAR[header.num_chars + 1]);
+  memcpy(chars.get(), chars_data, chars_size);
+  if (header.num_chars > 0 && chars[header.num_chars - 1] != _T('\0'))
+    return false;
+
+  for (unsigned i = 0; i < header.num_airspaces; ++i) {
+    Record record;
+    memcpy(&record, records + i * sizeof(record), sizeof(record));
+    if (!IsValidRecord(record, header))
+      return false;
+  }
+
+  std::vector<GeoPoint> polygon;
+
+  for (unsigned i = 0; i < header.num_airspaces; ++i) {
+    Record record;
+    memcpy(&record, records + i * sizeof(record), sizeof(record));
+
+    AbstractAirspace *as;
+    if (record.shape == AbstractAirspace::Shape::CIRCLE) {
+      as = new AirspaceCircle(ReadPoint(points, record.first_point),
+                              record.radius);
+    } else {
+      polygon.clear();
+      polygon.reserve(record.num_points);
+      for (unsigned j = 0; j < record.num_points; ++j)
+        polygon.push_back(ReadPoint(points, record.first_point + j));
+
+      as = new AirspacePolygon(polygon);
+    }
+
+    as->SetProperties(chars.get() + record.name, record.type,
+                      ImportAltitude(record.base),
+                      ImportAltitude(record.top));
+    as->SetRadio(chars.get() + record.radio);
+    as->SetDays(record.days);
+    airspaces.Add(as);
+  }
+
+  return true;
+}
+
+bool
+LoadAirspaceCache(Airspaces &airspaces, FileCache &cache,
+                  const TCHAR *name, Path original_path)
+{
+  size_t offset;
+  auto mapping = cache.Map(name, original_path, offset);
+  if (!mapping)
+    return false;
+
+  if (!ReadAirspaceCache(airspaces, mapping->at(offset),
+                         mapping->size() - offset)) {
+    mapping.reset();
+    cache.Flush(name);
+    return false;
+  }
+
+  return true;
+}
+
+void
+SaveAirspaceCache(FileCache &cache, const TCHAR *name, Path original_path,
+                  const std::vector<const AbstractAirspace *> &items)
+{
+  FILE *file = cache.Save(name, original_path);
+  if (file == nullptr)
+    return;
+
+  if (WriteAirspaceCache(file, items))
+    cache.Commit(name, file);
+  else
+    cache.Cancel(name, file);
+}
@@ -0,0 +1,86 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#ifndef XCSOAR_AIRSPACE_CACHE_HPP
+#define XCSOAR_AIRSPACE_CACHE_HPP
+
+#include <vector>
+
+#include <stdio.h>
+#include <stddef.h>
+#include <tchar.h>
+
+class Airspaces;
+class AbstractAirspace;
+class FileCache;
+class Path;
+
+/*
+ * A compiled representation of an airspace file: the parser output
+ * (polygons with all arcs already expanded, circles, classes,
+ * altitudes and names) in a flat, versioned and checksummed binary
+ * format.  Loading it does not involve any text parsing or geometric
+ * calculations; it is stored in the #FileCache and mapped into
+ * memory.
+ */
+
+/**
+ * Write the specified airspaces to a file in the compiled format.
+ *
+ * @return false on I/O error
+ */
+bool
+WriteAirspaceCache(FILE *file,
+                   const std::vector<const AbstractAirspace *> &items);
+
+/**
+ * Add the airspaces from a compiled file (usually memory-mapped) to
+ * the database.  The whole buffer is validated before the first
+ * airspace is added.
+ *
+ * @return false if the buffer is malformed (and nothing has been
+ * added)
+ */
+bool
+ReadAirspaceCache(Airspaces &airspaces, const void *data, size_t size);
+
+/**
+ * Load the compiled airspaces for the specified original file from
+ * the cache.
+ *
+ * @return true if the airspaces were added, false if the cache is
+ * missing, outdated or malformed
+ */
+bool
+LoadAirspaceCache(Airspaces &airspaces, FileCache &cache,
+                  const TCHAR *name, Path original_path);
+
+/**
+ * Save the airspaces which were parsed from the specified original
+ * file to the cache.
+ */
+void
+SaveAirspaceCache(FileCache &cache, const TCHAR *name, Path original_path,
+                  const std::vector<const AbstractAirspace *> &items);
+
+#endif
@@ -23,6 +23,7 @@ Copyright_License {
 
 #include "Airspace/AirspaceGlue.hpp"
 #include "Airspace/AirspaceParser.hpp"
+#include "Airspace/AirspaceCache.hpp"
 #include "Engine/Airspace/Airspaces.hpp"
 #include "Profile/ProfileKeys.hpp"
 #include "Operation/Operation.hpp"
@@ -33,7 +34,13 @@ Copyright_License {
 #include "IO/ZipArchive.hpp"
 #include "IO/ZipLineReader.hpp"
 #include "IO/MapFile.hpp"
+#include "IO/FileCache.hpp"
 #include "Profile/Profile.hpp"
+#include "Thread/WorkStealingPool.hpp"
+
+#include <algorithm>
+#include <list>
+#include <vector>
 
 #include <string.h>
 
@@ -74,8 +81,140 @@ try {
   return false;
 }
 
+/**
+ * Load the airspaces of one source file from the cache, or parse the
+ * file and compile the result into the cache.
+ *
+ * @param parse a function which parses the source file
+ */
+template<typename P>
+static bool
+LoadAirspaceFile(Airspaces &airspaces, FileCache *cache,
+                 const TCHAR *cache_name, Path path, P &&parse)
+{
+  if (cache != nullptr &&
+      LoadAirspaceCache(airspaces, *cache, cache_name, path))
+    return true;
+
+  const size_t first = airspaces.GetPending().size();
+
+  if (!parse())
+    return false;
+
+  if (cache != nullptr) {
+    const auto &pending = airspaces.GetPending();
+    const std::vector<const AbstractAirspace *> items(pending.begin() + first,
+                                                      pending.end());
+    SaveAirspaceCache(*cache, cache_name, path, items);
+  }
+
+  return true;
+}
+
+/**
+ * An airspace file which is loaded by LoadAirspaceFiles().
+ */
+struct AirspaceFile {
+  const TCHAR *const cache_name;
+
+  /**
+   * The source file, or the map file if #archive is set.
+   */
+  const AllocatedPath path;
+
+  /**
+   * If set, then "airspace.txt" is parsed from this archive.
+   */
+  struct zzip_dir *const archive;
+
+  /**
+   * The (non-owning) airspaces of this file if it was loaded by a
+   * worker thread; they are moved to the destination afterwards.
+   */
+  Airspaces airspaces;
+
+  bool success = false;
+
+  AirspaceFile(const TCHAR *_cache_name, AllocatedPath &&_path,
+               struct zzip_dir *_archive=nullptr)
+    :cache_name(_cache_name), path(std::move(_path)), archive(_archive),
+     airspaces(false) {}
+
+  void Load(Airspaces &dest, FileCache *cache,
+            OperationEnvironment &operation) {
+    AirspaceParser parser(dest);
+    success = LoadAirspaceFile(dest, cache, cache_name, path, [&](){
+        return archive != nullptr
+          ? ParseAirspaceFile(parser, archive, "airspace.txt", operation)
+          : ParseAirspaceFile(parser, path, operation);
+      });
+  }
+};
+
+/**
+ * Loads the first file directly into the destination and all others
+ * into their own #Airspaces object.
+ */
+class AirspaceFileJob final : public TaskRunner::Job {
+  Airspaces &airspaces;
+  const std::vector<AirspaceFile *> &files;
+  FileCache *const cache;
+
+public:
+  AirspaceFileJob(Airspaces &_airspaces,
+                  const std::vector<AirspaceFile *> &_files,
+                  FileCache *_cache)
+    :airspaces(_airspaces), files(_files), cache(_cache) {}
+
+  void RunTask(unsigned i) override {
+    /* progress can only be reported from the calling thread */
+    NullOperationEnvironment operation;
+
+    AirspaceFile &file = *files[i];
+    file.Load(i == 0 ? airspaces : file.airspaces, cache, operation);
+  }
+};
+
+/**
+ * Load the given files in parallel (one thread per file) and add
+ * their airspaces to #airspaces in the order of the list.
+ *
+ * @return true if at least one file was loaded successfully
+ */
+static bool
+LoadAirspaceFiles(Airspaces &airspaces, std::list<AirspaceFile> &files,
+                  FileCache *cache, OperationEnvironment &operation)
+{
+  std::vector<AirspaceFile *> v;
+  for (auto &i : files)
+    v.push_back(&i);
+
+  const unsigned n_threads =
+    std::min<unsigned>(v.size(), WorkStealingPool::GetProcessorCount());
+  if (n_threads <= 1) {
+    for (auto *i : v)
+      i->Load(airspaces, cache, operation);
+  } else {
+    AirspaceFileJob job(airspaces, v, cache);
+    WorkStealingPool pool(n_threads);
+    pool.Run(job, v.size());
+
+    /* a file which failed to parse may still have contributed
+       airspaces, just like with the serial parser */
+    for (auto i = std::next(v.begin()); i != v.end(); ++i)
+      for (auto *a : (*i)->airspaces.GetPending())
+        airspaces.Add(a);
+  }
+
+  bool success = false;
+  for (const auto &i : files)
+    success |= i.success;
+
+  return success;
+}
+
 void
-ReadAirspace(Airspaces &airspaces,
+ReadAirspace(Airspaces &airspaces, FileCache *cache,
              RasterTerrain *terrain,
              const AtmosphericPressure &press,
              OperationEnvironment &operation)
@@ -83,23 +222,25 @@ ReadAirspace(Airspaces &airspaces,
   LogFormat("ReadAirspace");
   operation.SetText(_("Loading Airspace File..."));
 
-  bool airspace_ok = false;
-
-  AirspaceParser parser(airspaces);
+  std::list<AirspaceFile> files;
 
   // Read the airspace filenames from the registry
   auto path = Profile::GetPath(ProfileKeys::AirspaceFile);
   if (!path.IsNull())
-    airspace_ok |= ParseAirspaceFile(parser, path, operation);
+    files.emplace_back(_T("airspace1"), std::move(path));
 
   path = Profile::GetPath(ProfileKeys::AdditionalAirspaceFile);
   if (!path.IsNull())
-    airspace_ok |= ParseAirspaceFile(parser, path, operation);
+    files.emplace_back(_T("airspace2"), std::move(path));
 
   auto archive = OpenMapFile();
   if (archive)
-    airspace_ok |= ParseAirspaceFile(parser, archive->get(), "airspace.txt",
-                                     operation);
+    files.emplace_back(_T("airspace_map"),
+                       Profile::GetPath(ProfileKeys::MapFile),
+                       archive->get());
+
+  const bool airspace_ok = LoadAirspaceFiles(airspaces, files, cache,
+                                             operation);
 
   if (airspace_ok) {
     airspaces.Optimise();
@@ -33,7 +33,12 @@ Copyright_License {
  * Initializes the DeviceBlackboard
  */
 DeviceBlackboard::DeviceBlackboard()
-  :devices(nullptr)
+  :devices(nullptr),
+   calculation_basic(basic_snapshots), ui_basic(basic_snapshots),
+   map_basic(basic_snapshots),
+   ui_calculated(calculated_snapshots), map_calculated(calculated_snapshots),
+   calculation_contest(contest_stats),
+   movement_detected(false)
 {
   // Clear the gps_info and calculated_info
   gps_info.Reset();
@@ -52,6 +57,9 @@ DeviceBlackboard::DeviceBlackboard()
 
   real_clock.Reset();
   replay_clock.Reset();
+
+  PublishBasic();
+  PublishCalculated(calculated_info);
 }
 
 /**
@@ -184,6 +192,12 @@ DeviceBlackboard::ReadBlackboard(const DerivedInfo &derived_info)
   calculated_info = derived_info;
 }
 
+void
+DeviceBlackboard::PublishCalculated(const DerivedInfo &derived_info)
+{
+  calculated_snapshots.Publish(derived_info);
+}
+
 /**
  * Reads the given settings usually provided by the InterfaceBlackboard
  * and saves it to the own Blackboard
@@ -256,6 +270,15 @@ DeviceBlackboard::Merge()
   } else {
     basic = real_data;
   }
+
+  movement_detected = real_data.alive && real_data.gps.real &&
+    real_data.MovementDetected();
+}
+
+void
+DeviceBlackboard::PublishBasic()
+{
+  basic_snapshots.Publish(gps_info);
 }
 
 void
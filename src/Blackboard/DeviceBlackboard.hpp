@@ -29,8 +29,10 @@ Copyright_License {
 #include "Device/Simulator.hpp"
 #include "Device/Features.hpp"
 #include "Thread/Mutex.hpp"
+#include "Thread/SnapshotBuffer.hpp"
 #include "Time/WrapClock.hpp"
 
+#include <atomic>
 #include <cassert>
 
 class MultipleDevices;
@@ -82,6 +84,37 @@ class DeviceBlackboard
 public:
   Mutex mutex;
 
+  /**
+   * Snapshots of Basic() and Calculated() for threads which only
+   * read them.  Basic() snapshots are published with the lock held
+   * (see PublishBasic()), Calculated() snapshots by the
+   * CalculationThread; each is copied only once.
+   */
+  SnapshotBuffer<MoreData, 3> basic_snapshots;
+  SnapshotBuffer<DerivedInfo, 2> calculated_snapshots;
+
+  /**
+   * The readers of #basic_snapshots and #calculated_snapshots.  Each
+   * one is used by exactly one thread, which may borrow its front
+   * buffer without locking #mutex.
+   */
+  SnapshotBuffer<MoreData, 3>::Reader calculation_basic, ui_basic, map_basic;
+  SnapshotBuffer<DerivedInfo, 2>::Reader ui_calculated, map_calculated;
+
+  /**
+   * Results of the ContestThread, consumed by the CalculationThread
+   * through #calculation_contest, which copies them to
+   * DerivedInfo::contest_stats.
+   */
+  SnapshotBuffer<ContestStatistics, 1> contest_stats;
+  SnapshotBuffer<ContestStatistics, 1>::Reader calculation_contest;
+
+  /**
+   * Has the GPS of #real_data detected movement?  Updated by
+   * Merge().
+   */
+  std::atomic<bool> movement_detected;
+
 public:
   DeviceBlackboard();
 
@@ -92,6 +125,15 @@ public:
   }
 
   void ReadBlackboard(const DerivedInfo &derived_info);
+
+  /**
+   * Publish a snapshot of the given calculated data to the
+   * Calculated() readers.  The caller must not hold the lock, and
+   * there may be only one caller at a time (usually the
+   * CalculationThread).
+   */
+  void PublishCalculated(const DerivedInfo &derived_info);
+
   void ReadComputerSettings(const ComputerSettings &settings);
 
 protected:
@@ -170,6 +212,13 @@ public:
    * Caller must lock the blackboard.
    */
   void Merge();
+
+  /**
+   * Publish a snapshot of Basic() to its readers.  Caller must lock
+   * the blackboard; the lock serializes the producers (the
+   * MergeThread, and the main thread during startup).
+   */
+  void PublishBasic();
 };
 
 #endif
@@ -33,6 +33,25 @@ Copyright_License {
  * everything we have in one pointer.
  */
 class FullBlackboard : public BaseBlackboard, public SettingsBlackboard {
+protected:
+  /**
+   * The data returned by Basic() and Calculated(): either the local
+   * copies or snapshots borrowed from another object, see
+   * InterfaceBlackboard::BorrowBlackboardBasic().
+   */
+  const MoreData *basic = &gps_info;
+  const DerivedInfo *calculated = &calculated_info;
+
+public:
+  gcc_pure
+  const MoreData &Basic() const {
+    return *basic;
+  }
+
+  gcc_pure
+  const DerivedInfo &Calculated() const {
+    return *calculated;
+  }
 };
 
 #endif
@@ -26,12 +26,27 @@ void
 InterfaceBlackboard::ReadBlackboardCalculated(const DerivedInfo &derived_info)
 {
   calculated_info = derived_info;
+  calculated = &calculated_info;
 }
 
 void
 InterfaceBlackboard::ReadBlackboardBasic(const MoreData &nmea_info)
 {
   gps_info = nmea_info;
+  basic = &gps_info;
+}
+
+void
+InterfaceBlackboard::ReadCommonStats(const CommonStats &common_stats)
+{
+  if (calculated != &calculated_info) {
+    /* a borrowed snapshot must not be modified: switch to a local
+       copy until the next snapshot arrives */
+    calculated_info = *calculated;
+    calculated = &calculated_info;
+  }
+
+  calculated_info.common_stats = common_stats;
 }
 
 void
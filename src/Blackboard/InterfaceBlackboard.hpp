@@ -33,6 +33,25 @@ public:
   void ReadBlackboardBasic(const MoreData &nmea_info);
   void ReadBlackboardCalculated(const DerivedInfo &derived_info);
 
+  /**
+   * Like ReadBlackboardBasic(), but don't copy the data.  The caller
+   * must keep the referenced object valid and unmodified until the
+   * next ReadBlackboardBasic() or BorrowBlackboardBasic() call.
+   */
+  void BorrowBlackboardBasic(const MoreData &nmea_info) {
+    basic = &nmea_info;
+  }
+
+  /**
+   * Like ReadBlackboardCalculated(), but don't copy the data.  The
+   * caller must keep the referenced object valid and unmodified
+   * until the next ReadBlackboardCalculated() or
+   * BorrowBlackboardCalculated() call.
+   */
+  void BorrowBlackboardCalculated(const DerivedInfo &derived_info) {
+    calculated = &derived_info;
+  }
+
   gcc_const
   SystemSettings &SetSystemSettings() {
     return system_settings;
@@ -48,9 +67,7 @@ public:
     return ui_settings;
   }
 
-  inline void ReadCommonStats(const CommonStats &common_stats) {
-    calculated_info.common_stats = common_stats;
-  }
+  void ReadCommonStats(const CommonStats &common_stats);
 
   void ReadComputerSettings(const ComputerSettings &settings);
 };
@@ -22,6 +22,7 @@ Copyright_License {
 */
 
 #include "CalculationThread.hpp"
+#include "ContestThread.hpp"
 #include "Computer/GlideComputer.hpp"
 #include "Protection.hpp"
 #include "Blackboard/DeviceBlackboard.hpp"
@@ -62,16 +63,16 @@ CalculationThread::Tick()
   const ScopeLockCPU cpu;
 #endif
 
-  bool gps_updated;
+  bool gps_updated = false;
 
   // update and transfer master info to glide computer
-  {
-    ScopeLock protect(device_blackboard->mutex);
+  if (device_blackboard->calculation_basic.Update()) {
+    const MoreData &basic = device_blackboard->calculation_basic.GetFront();
 
-    gps_updated = device_blackboard->Basic().location_available.Modified(glide_computer.Basic().location_available);
+    gps_updated = basic.location_available.Modified(glide_computer.Basic().location_available);
 
     // Copy data from DeviceBlackboard to GlideComputerBlackboard
-    glide_computer.ReadBlackboard(device_blackboard->Basic());
+    glide_computer.ReadBlackboard(basic);
   }
 
   bool force;
@@ -87,6 +88,10 @@ CalculationThread::Tick()
     }
   }
 
+  if (device_blackboard->calculation_contest.Update())
+    /* new results from the ContestThread */
+    glide_computer.ReadContestStatistics(device_blackboard->calculation_contest.GetFront());
+
   glide_computer.Expire();
 
   bool do_idle = false;
@@ -103,6 +108,8 @@ CalculationThread::Tick()
     device_blackboard->ReadBlackboard(glide_computer.Calculated());
   }
 
+  device_blackboard->PublishCalculated(glide_computer.Calculated());
+
   // if (new GPS data)
   if (gps_updated || force)
     // inform map new data is ready
@@ -111,6 +118,10 @@ CalculationThread::Tick()
   if (do_idle) {
     // do slow calculations last, to minimise latency
     glide_computer.ProcessIdle();
+
+    if (contest_thread != nullptr)
+      contest_thread->Update(glide_computer.GetComputerSettings().contest,
+                             glide_computer.GetContestPrediction());
   }
 }
 
@@ -127,7 +127,8 @@ CloudClientContainer::Expire(std::chrono::steady_clock::time_point before)
 CloudClientContainer::query_iterator_range
 CloudClientContainer::QueryWithinRange(GeoPoint location, double range) const
 {
-  const auto q = boost::geometry::index::intersects(BoostRangeBox(location, range));
+  const auto q = BoostRangeQuery(BoostRangeBox(location, range),
+                                 CloudClientIndexable());
   return {rtree.qbegin(q), rtree.qend()};
 }
 
@@ -217,6 +217,14 @@ public:
     return list.empty();
   }
 
+  /**
+   * The public id which will be assigned to the next new
+   * #CloudClient.
+   */
+  unsigned GetNextId() const {
+    return next_id;
+  }
+
   /**
    * For iteration over the list of all clients in unspecified order.
    * The iterators get invalidated by all modifying calls.
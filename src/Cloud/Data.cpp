@@ -32,9 +32,6 @@ using std::cout;
 using std::cerr;
 using std::endl;
 
-static constexpr uint32_t CLOUD_MAGIC = 0x5753f60f;
-static constexpr uint32_t CLOUD_VERSION = 1;
-
 void
 CloudData::DumpClients()
 {
@@ -52,8 +49,8 @@ CloudData::DumpClients()
 void
 CloudData::Save(Serialiser &s) const
 {
-  s.Write32(CLOUD_MAGIC);
-  s.Write32(CLOUD_VERSION);
+  s.Write32(MAGIC);
+  s.Write32(VERSION);
   clients.Save(s);
   s.Write8(1);
   thermals.Save(s);
@@ -63,10 +60,10 @@ CloudData::Save(Serialiser &s) const
 void
 CloudData::Load(Deserialiser &s)
 {
-  if (s.Read32() != CLOUD_MAGIC)
+  if (s.Read32() != MAGIC)
     throw std::runtime_error("Bad magic");
 
-  if (s.Read32() != CLOUD_VERSION)
+  if (s.Read32() != VERSION)
     throw std::runtime_error("Bad version");
 
   clients.Load(s);
@@ -0,0 +1,229 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#include "Journal.hpp"
+#include "Sharded.hpp"
+#include "Serialiser.hpp"
+#include "IO/FileOutputStream.hxx"
+#include "IO/FileReader.hxx"
+#include "OS/FileUtil.hpp"
+#include "Util/PrintException.hxx"
+
+#include <stdexcept>
+
+#include <assert.h>
+
+CloudJournal::CloudJournal(Path db_path)
+  :path(db_path + ".journal"), old_path(db_path + ".journal.old") {}
+
+CloudJournal::~CloudJournal()
+{
+  Close();
+}
+
+void
+CloudJournal::OpenLocked()
+{
+  assert(!file);
+
+  const bool is_new = !File::Exists(path);
+
+  file.reset(new FileOutputStream(path,
+                                  FileOutputStream::Mode::APPEND_OR_CREATE));
+  serialiser.reset(new Serialiser(*file));
+
+  if (is_new) {
+    serialiser->Write32(MAGIC);
+    serialiser->Write32(VERSION);
+  }
+}
+
+void
+CloudJournal::Open()
+{
+  const ScopeLock protect(mutex);
+  OpenLocked();
+}
+
+void
+CloudJournal::CloseLocked()
+{
+  if (!file)
+    return;
+
+  serialiser->Flush();
+  serialiser.reset();
+
+  file->Commit();
+  file.reset();
+}
+
+void
+CloudJournal::Close()
+{
+  const ScopeLock protect(mutex);
+
+  try {
+    CloseLocked();
+  } catch (const std::exception &e) {
+    Fail(e);
+  }
+}
+
+void
+CloudJournal::Fail(const std::exception &e)
+{
+  PrintException(e);
+
+  serialiser.reset();
+  file.reset();
+}
+
+void
+CloudJournal::AppendFix(const CloudClient &client)
+{
+  const ScopeLock protect(mutex);
+  if (!serialiser)
+    return;
+
+  try {
+    serialiser->Write8(uint8_t(RecordType::FIX));
+    client.Save(*serialiser);
+  } catch (const std::exception &e) {
+    Fail(e);
+  }
+}
+
+void
+CloudJournal::AppendThermal(const CloudThermal &thermal)
+{
+  const ScopeLock protect(mutex);
+  if (!serialiser)
+    return;
+
+  try {
+    serialiser->Write8(uint8_t(RecordType::THERMAL));
+    thermal.Save(*serialiser);
+  } catch (const std::exception &e) {
+    Fail(e);
+  }
+}
+
+void
+CloudJournal::Flush()
+{
+  const ScopeLock protect(mutex);
+  if (!serialiser)
+    return;
+
+  try {
+    serialiser->Flush();
+  } catch (const std::exception &e) {
+    Fail(e);
+  }
+}
+
+void
+CloudJournal::Rotate()
+{
+  const ScopeLock protect(mutex);
+
+  try {
+    if (File::Exists(old_path)) {
+      /* the last compaction has failed; keep appending to the
+         current journal until a snapshot succeeds */
+      if (!file)
+        OpenLocked();
+      return;
+    }
+
+    CloseLocked();
+
+    if (File::Exists(path) && !File::Rename(path, old_path))
+      throw std::runtime_error("Failed to rename the journal");
+
+    OpenLocked();
+  } catch (const std::exception &e) {
+    Fail(e);
+  }
+}
+
+void
+CloudJournal::RemoveOld()
+{
+  File::Delete(old_path);
+}
+
+void
+CloudJournal::RemoveAll()
+{
+  const ScopeLock protect(mutex);
+  assert(!file);
+
+  File::Delete(old_path);
+  File::Delete(path);
+}
+
+void
+CloudJournal::Replay(ShardedCloudData &data) const
+{
+  if (File::Exists(old_path))
+    Replay(old_path, data);
+
+  if (File::Exists(path))
+    Replay(path, data);
+}
+
+void
+CloudJournal::Replay(Path path, ShardedCloudData &data)
+{
+  FileReader fr(path);
+  Deserialiser s(fr);
+
+  try {
+    if (s.Read32() != MAGIC)
+      throw std::runtime_error("Bad journal magic");
+
+    if (s.Read32() != VERSION)
+      throw std::runtime_error("Bad journal version");
+
+    while (!s.Read().IsEmpty() || s.Fill(true)) {
+      switch (RecordType(s.Read8())) {
+      case RecordType::FIX:
+        data.Replay(CloudClient::Load(s));
+        break;
+
+      case RecordType::THERMAL:
+        data.Replay(CloudThermal::Load(s));
+        break;
+
+      default:
+        throw std::runtime_error("Malformed journal record");
+      }
+    }
+  } catch (const std::runtime_error &e) {
+    /* the tail of the journal may be truncated after a crash; apply
+       everything up to this point */
+    PrintException(e);
+  }
+}
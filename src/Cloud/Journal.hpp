@@ -0,0 +1,152 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#ifndef XCSOAR_CLOUD_JOURNAL_HPP
+#define XCSOAR_CLOUD_JOURNAL_HPP
+
+#include "OS/Path.hpp"
+#include "Thread/Mutex.hpp"
+
+#include <memory>
+
+#include <stdint.h>
+
+struct CloudClient;
+struct CloudThermal;
+class ShardedCloudData;
+class FileOutputStream;
+class Serialiser;
+namespace std { class exception; }
+
+/**
+ * An append-only log of modifications to the #ShardedCloudData,
+ * written as they arrive.  It complements the snapshot written by
+ * ShardedCloudData::Save(): after a crash, the snapshot plus the
+ * journal restore the state.
+ *
+ * Compaction: Rotate() renames the journal to "*.old" and starts a
+ * new one; after the next snapshot has been committed, the old
+ * journal is obsolete and RemoveOld() deletes it.  Replaying records
+ * which are already in the snapshot is harmless.
+ *
+ * All methods are thread-safe.
+ */
+class CloudJournal {
+  static constexpr uint32_t MAGIC = 0x4a6c4443;
+  static constexpr uint32_t VERSION = 1;
+
+  enum class RecordType : uint8_t {
+    FIX = 1,
+    THERMAL = 2,
+  };
+
+  const AllocatedPath path, old_path;
+
+  Mutex mutex;
+
+  std::unique_ptr<FileOutputStream> file;
+  std::unique_ptr<Serialiser> serialiser;
+
+public:
+  /**
+   * @param db_path the path of the snapshot; the journal files are
+   * stored next to it
+   */
+  explicit CloudJournal(Path db_path);
+  ~CloudJournal();
+
+  CloudJournal(const CloudJournal &) = delete;
+  CloudJournal &operator=(const CloudJournal &) = delete;
+
+  /**
+   * Open the journal for appending, creating it if necessary.
+   *
+   * Throws std::runtime_error on error.
+   */
+  void Open();
+
+  /**
+   * Flush and close the journal.
+   */
+  void Close();
+
+  /**
+   * Append a new or moved client.  Errors are logged, and the
+   * journal is closed.
+   */
+  void AppendFix(const CloudClient &client);
+
+  /**
+   * Append a new thermal.  Errors are logged, and the journal is
+   * closed.
+   */
+  void AppendThermal(const CloudThermal &thermal);
+
+  /**
+   * Submit buffered records to the kernel.
+   */
+  void Flush();
+
+  /**
+   * Rename the current journal to "*.old" and start a new one, unless
+   * an old journal still exists (because the last compaction has
+   * failed); in that case, the old journal and the current one are
+   * both kept until the next snapshot has been committed.
+   */
+  void Rotate();
+
+  /**
+   * Delete the old journal.  Call this after a snapshot has been
+   * committed which was started after Rotate().
+   */
+  void RemoveOld();
+
+  /**
+   * Delete both journals.  Call this after a snapshot has been
+   * committed while the journal was closed.
+   */
+  void RemoveAll();
+
+  /**
+   * Apply the old and the current journal to the given data (which
+   * should have been loaded from the snapshot).  A truncated record
+   * at the end (after a crash) is ignored.
+   *
+   * Throws std::runtime_error on error.
+   */
+  void Replay(ShardedCloudData &data) const;
+
+private:
+  void OpenLocked();
+  void CloseLocked();
+
+  /**
+   * Log the exception and close the journal.  The caller must hold
+   * the lock.
+   */
+  void Fail(const std::exception &e);
+
+  static void Replay(Path path, ShardedCloudData &data);
+};
+
+#endif
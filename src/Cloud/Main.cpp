@@ -21,7 +21,8 @@ Copyright_License {
 }
 */
 
-#include "Data.hpp"
+#include "Sharded.hpp"
+#include "Journal.hpp"
 #include "Dump.hpp"
 #include "Sender.hpp"
 #include "Serialiser.hpp"
@@ -30,6 +31,8 @@ Copyright_License {
 #include "OS/ByteOrder.hpp"
 #include "IO/FileOutputStream.hxx"
 #include "IO/FileReader.hxx"
+#include "IO/Async/AsioThread.hpp"
+#include "Util/NumberParser.hpp"
 #include "Util/PrintException.hxx"
 #include "Compiler.h"
 
@@ -40,8 +43,12 @@ Copyright_License {
 #include <boost/asio/steady_timer.hpp>
 
 #include <array>
+#include <atomic>
+#include <vector>
+#include <memory>
 #include <iostream>
 #include <iomanip>
+#include <sstream>
 
 // TODO: review these settings
 static constexpr double TRAFFIC_RANGE = 50000;
@@ -52,67 +59,54 @@ static constexpr std::chrono::steady_clock::duration MAX_THERMAL_AGE = std::chro
 
 static constexpr std::chrono::steady_clock::duration REQUEST_EXPIRY = std::chrono::minutes(5);
 
+static constexpr unsigned MAX_THREADS = ShardedCloudData::MAX_SHARDS;
+
 using std::cout;
 using std::cerr;
 using std::endl;
 
-class CloudServer final
-  : public SkyLinesTracking::Server,
-#ifdef __linux__
-    SignalListener,
-#endif
-    CloudData
+/**
+ * Write one line to stdout.  The line is formatted completely before
+ * it is written, so lines from different worker threads do not get
+ * mixed up.
+ */
+static void
+Log(const std::ostringstream &os)
 {
-  const AllocatedPath db_path;
-
-  boost::asio::steady_timer save_timer, expire_timer;
-
-public:
-  CloudServer(AllocatedPath &&_db_path, boost::asio::io_service &io_service,
-              boost::asio::ip::udp::endpoint endpoint)
-    :SkyLinesTracking::Server(io_service, endpoint),
-#ifdef __linux__
-    SignalListener(io_service),
-#endif
-    db_path(std::move(_db_path)),
-    save_timer(io_service),
-    expire_timer(io_service)
-  {
-#ifdef __linux__
-    SignalListener::Create(SIGTERM, SIGINT, SIGHUP, SIGUSR1);
-#endif
-
-    ScheduleSave();
-  }
+  cout << os.str() << std::flush;
+}
 
-  using SkyLinesTracking::Server::get_io_service;
+/**
+ * Processes the datagrams received on one socket.  There is one
+ * worker per thread; all of them share the #ShardedCloudData.
+ */
+class CloudWorker final : public SkyLinesTracking::Server {
+  boost::asio::io_service &main_io_service;
 
-  void Load();
-  void Save();
+  ShardedCloudData &data;
 
-private:
-  void ScheduleSave() {
-    save_timer.expires_from_now(std::chrono::minutes(1));
-    save_timer.async_wait([this](const boost::system::error_code &ec){
-        if (ec)
-          return;
+  CloudJournal &journal;
 
-        Save();
-        ScheduleSave();
-      });
-  }
+  /**
+   * Collects the datagrams of a fan-out to many clients.
+   */
+  SendBatch batch;
 
-  void ScheduleExpire() {
-    expire_timer.expires_from_now(std::chrono::minutes(5));
-    expire_timer.async_wait([this](const boost::system::error_code &ec){
-        if (ec)
-          return;
+  /**
+   * The recipients of a fan-out, collected while the shards are
+   * locked.  This is a member to reuse its allocation.
+   */
+  std::vector<Client> recipients;
 
-        clients.Expire(expire_timer.expires_at() - std::chrono::minutes(10));
-        if (!clients.empty())
-          ScheduleExpire();
-      });
-  }
+public:
+  CloudWorker(boost::asio::io_service &_main_io_service,
+              ShardedCloudData &_data, CloudJournal &_journal,
+              boost::asio::io_service &io_service,
+              boost::asio::ip::udp::endpoint endpoint,
+              bool reuse_port)
+    :SkyLinesTracking::Server(io_service, endpoint, reuse_port),
+     main_io_service(_main_io_service),
+     data(_data), journal(_journal), batch(*this) {}
 
 protected:
   /* virtual methods from class SkyLinesTracking::Server */
@@ -142,14 +136,151 @@ protected:
 
   void OnSendError(const boost::asio::ip::udp::endpoint &endpoint,
                    std::exception &&e) override {
-    cerr << "Failed to send to " << endpoint
-         << ": " << e.what()
-         << endl;
+    std::ostringstream os;
+    os << "Failed to send to " << endpoint
+       << ": " << e.what() << '\n';
+    cerr << os.str();
   }
 
   void OnError(std::exception &&e) override {
-    cerr << e.what() << endl;
-    get_io_service().stop();
+    std::ostringstream os;
+    os << e.what() << '\n';
+    cerr << os.str();
+
+    main_io_service.stop();
+  }
+};
+
+class CloudServer final
+#ifdef __linux__
+  : SignalListener
+#endif
+{
+  boost::asio::io_service &io_service;
+
+  const AllocatedPath db_path;
+
+  ShardedCloudData data;
+
+  CloudJournal journal;
+
+  boost::asio::steady_timer compact_timer, flush_timer, expire_timer;
+
+  /**
+   * One thread per #CloudWorker.
+   */
+  std::vector<std::unique_ptr<AsioThread>> threads;
+  std::vector<std::unique_ptr<CloudWorker>> workers;
+
+  /**
+   * Writes snapshots in the background, see Compact().
+   */
+  std::unique_ptr<AsioThread> background;
+
+  /**
+   * Is a Compact() call pending or running?
+   */
+  std::atomic<bool> compacting;
+
+public:
+  CloudServer(AllocatedPath &&_db_path, boost::asio::io_service &_io_service,
+              unsigned n_threads)
+    :
+#ifdef __linux__
+    SignalListener(_io_service),
+#endif
+    io_service(_io_service),
+    db_path(std::move(_db_path)),
+    data(n_threads),
+    journal(db_path),
+    compact_timer(io_service),
+    flush_timer(io_service),
+    expire_timer(io_service),
+    compacting(false)
+  {
+#ifdef __linux__
+    SignalListener::Create(SIGTERM, SIGINT, SIGHUP, SIGUSR1);
+#endif
+
+    ScheduleCompact();
+    ScheduleFlush();
+    ScheduleExpire();
+  }
+
+  ~CloudServer() {
+    StopThreads();
+  }
+
+  /**
+   * Open the journal, create the sockets and start the worker
+   * threads.  Call this after Load() and Checkpoint().
+   */
+  void StartThreads(boost::asio::ip::udp::endpoint endpoint,
+                    unsigned n_threads);
+
+  /**
+   * Stop all threads and close the journal.  After returning, the
+   * data may be accessed without locking.
+   */
+  void StopThreads();
+
+  /**
+   * Load the snapshot and replay the journal.
+   */
+  void Load();
+
+  /**
+   * Write a snapshot and delete the journal.  This may only be
+   * called while the threads are stopped.
+   */
+  void Checkpoint();
+
+private:
+  void Save();
+
+  /**
+   * Start a new journal, write a snapshot and delete the old
+   * journal.  Runs in the #background thread, while the workers
+   * continue to modify the data.
+   */
+  void Compact();
+
+  void TriggerCompact() {
+    if (background != nullptr && !compacting.exchange(true))
+      background->Get().post([this](){ Compact(); });
+  }
+
+  void ScheduleCompact() {
+    compact_timer.expires_from_now(std::chrono::minutes(10));
+    compact_timer.async_wait([this](const boost::system::error_code &ec){
+        if (ec)
+          return;
+
+        TriggerCompact();
+        ScheduleCompact();
+      });
+  }
+
+  void ScheduleFlush() {
+    flush_timer.expires_from_now(std::chrono::seconds(1));
+    flush_timer.async_wait([this](const boost::system::error_code &ec){
+        if (ec)
+          return;
+
+        journal.Flush();
+        ScheduleFlush();
+      });
+  }
+
+  void ScheduleExpire() {
+    expire_timer.expires_from_now(std::chrono::minutes(5));
+    expire_timer.async_wait([this](const boost::system::error_code &ec){
+        if (ec)
+          return;
+
+        data.Expire(expire_timer.expires_at() - std::chrono::minutes(10));
+        ScheduleExpire();
+      });
   }
 
 #ifdef __linux__
@@ -157,15 +288,15 @@ protected:
   void OnSignal(int signo) override {
     switch (signo) {
     case SIGHUP:
-      Save();
+      TriggerCompact();
       break;
 
     case SIGUSR1:
-      DumpClients();
+      data.DumpClients();
       break;
 
     default:
-      get_io_service().stop();
+      io_service.stop();
       break;
     }
   }
@@ -173,122 +304,137 @@ protected:
 };
 
 void
-CloudServer::OnFix(const Client &c,
+CloudWorker::OnFix(const Client &c,
                    std::chrono::milliseconds time_of_day,
                    const ::GeoPoint &location, int altitude)
 {
   (void)time_of_day; // TODO: use this parameter
 
-  CloudClient *client;
-  if (location.IsValid()) {
-    bool was_empty = clients.empty();
-
-    client = &clients.Make(c.endpoint, c.key, location, altitude);
-
-    cout << "FIX\t"
-         << client->endpoint << '\t'
-         << std::hex << client->key << std::dec << '\t'
-         << client->id << '\t'
-         << client->location << '\t'
-         << client->altitude << 'm'
-         << endl;
-
-    if (was_empty)
-      ScheduleExpire();
-  } else {
-    client = clients.Find(c.key);
-    if (client != nullptr)
-      clients.Refresh(*client, c.endpoint);
+  if (!location.IsValid()) {
+    data.WithClient(c.key, [&c](CloudClient &client){
+        client.Refresh(c.endpoint);
+      });
+    return;
+  }
+
+  const auto client = data.Make(c.endpoint, c.key, location, altitude);
+
+  journal.AppendFix(CloudClient(client.endpoint, client.key, client.id,
+                                client.location, client.altitude));
+
+  {
+    std::ostringstream os;
+    os << "FIX\t"
+       << client.endpoint << '\t'
+       << std::hex << client.key << std::dec << '\t'
+       << client.id << '\t'
+       << client.location << '\t'
+       << client.altitude << "m\n";
+    Log(os);
   }
 
   /* send this new traffic location to all interested clients
      immediately */
   const auto now = std::chrono::steady_clock::now();
-  for (const auto &i : clients.QueryWithinRange(location, TRAFFIC_RANGE)) {
-    if (i->key == c.key)
-      /* ignore this client's own submissions - he knows them
-         already */
-      continue;
-
-    if (now > i->wants_traffic)
-      /* not interested (anymore) */
-      continue;
-
-    TrafficResponseSender s(*this, {i->endpoint, i->key});
-    s.Add(client->id, 0, //TODO: time?
-          client->location, client->altitude);
+  recipients.clear();
+  data.VisitClientsWithinRange(location, TRAFFIC_RANGE,
+                               [this, &c, now](const CloudClient &i){
+      if (i.key == c.key)
+        /* ignore this client's own submissions - he knows them
+           already */
+        return;
+
+      if (now > i.wants_traffic)
+        /* not interested (anymore) */
+        return;
+
+      recipients.push_back({i.endpoint, i.key});
+    });
+
+  for (const auto &i : recipients) {
+    TrafficResponseSender s(batch, i);
+    s.Add(client.id, 0, //TODO: time?
+          client.location, client.altitude);
     s.Flush();
   }
+
+  batch.Flush();
 }
 
 void
-CloudServer::OnTrafficRequest(const Client &c, bool near)
+CloudWorker::OnTrafficRequest(const Client &c, bool near)
 {
   if (!near)
     /* "near" is the only selection flag we know */
     return;
 
-  auto *client = clients.Find(c.key);
-  if (client == nullptr)
+  const auto now = std::chrono::steady_clock::now();
+
+  GeoPoint location;
+  if (!data.WithClient(c.key, [now, &location](CloudClient &client){
+        client.wants_traffic = now + REQUEST_EXPIRY;
+        location = client.location;
+      }))
     /* we don't send our data to clients who didn't sent anything to
        us yet */
     return;
 
-  const auto now = std::chrono::steady_clock::now();
-
-  client->wants_traffic = now + REQUEST_EXPIRY;
-
   const auto min_stamp = now - MAX_TRAFFIC_AGE;
 
   TrafficResponseSender s(*this, c);
 
   unsigned n = 0;
-  for (const auto &traffic : clients.QueryWithinRange(client->location,
-                                                      TRAFFIC_RANGE)) {
-    if (traffic.get() == client)
-      continue;
+  data.VisitClientsWithinRange(location, TRAFFIC_RANGE,
+                               [&c, min_stamp, &s, &n](const CloudClient &traffic){
+      if (n > 64)
+        return;
 
-    if (traffic->stamp < min_stamp)
-      /* don't send stale traffic, it's probably not there anymore */
-      continue;
+      if (traffic.key == c.key)
+        return;
 
-    s.Add(traffic->id, 0, //TODO: time?
-          traffic->location, traffic->altitude);
+      if (traffic.stamp < min_stamp)
+        /* don't send stale traffic, it's probably not there
+           anymore */
+        return;
 
-    if (++n > 64)
-      break;
-  }
+      s.Add(traffic.id, 0, //TODO: time?
+            traffic.location, traffic.altitude);
+      ++n;
+    });
 
   s.Flush();
 }
 
 void
-CloudServer::OnWaveSubmit(const Client &c,
+CloudWorker::OnWaveSubmit(const Client &c,
                           std::chrono::milliseconds time_of_day,
                           const ::GeoPoint &a, const ::GeoPoint &b,
                           int bottom_altitude,
                           int top_altitude,
                           double lift)
 {
-  auto *client = clients.Find(c.key);
-  if (client == nullptr)
+  ShardedCloudData::ClientInfo client;
+  if (!data.WithClient(c.key, [&client](CloudClient &_client){
+        client = ShardedCloudData::ClientInfo(_client);
+      }))
     /* we don't trust the client if he didn't sent anything to us
        yet */
     return;
 
-  cout << "WAVE\t"
-       << client->endpoint << '\t'
-       << std::hex << client->key << std::dec << '\t'
-       << client->id << '\t'
-       << a << '\t'
-       << b << '\t'
-       << bottom_altitude << '-' << top_altitude << "m\t"
-       << lift << "m/s"
-       << endl;
+  std::ostringstream os;
+  os << "WAVE\t"
+     << client.endpoint << '\t'
+     << std::hex << client.key << std::dec << '\t'
+     << client.id << '\t'
+     << a << '\t'
+     << b << '\t'
+     << bottom_altitude << '-' << top_altitude << "m\t"
+     << lift << "m/s\n";
+  Log(os);
 }
 
 void
-CloudServer::OnThermalSubmit(const Client &c,
+CloudWorker::OnThermalSubmit(const Client &c,
                              std::chrono::milliseconds time_of_day,
                              const ::GeoPoint &bottom_location,
                              int bottom_altitude,
@@ -296,90 +442,161 @@ CloudServer::OnThermalSubmit(const Client &c,
                              int top_altitude,
                              double lift)
 {
-  auto *client = clients.Find(c.key);
-  if (client == nullptr)
+  ShardedCloudData::ClientInfo client;
+  if (!data.WithClient(c.key, [&client](CloudClient &_client){
+        client = ShardedCloudData::ClientInfo(_client);
+      }))
     /* we don't trust the client if he didn't sent anything to us
        yet */
     return;
 
-  cout << "THERMAL\t"
-       << client->endpoint << '\t'
-       << std::hex << client->key << std::dec << '\t'
-       << client->id << '\t'
+  {
+    std::ostringstream os;
+    os << "THERMAL\t"
+       << client.endpoint << '\t'
+       << std::hex << client.key << std::dec << '\t'
+       << client.id << '\t'
        << top_location << '\t'
        << bottom_altitude << '-' << top_altitude << "m\t"
-       << lift << "m/s"
-       << endl;
+       << lift << "m/s\n";
+    Log(os);
+  }
+
+  const auto thermal =
+    data.MakeThermal(c.key,
+                     AGeoPoint(bottom_location, bottom_altitude),
+                     AGeoPoint(top_location, top_altitude),
+                     lift);
 
-  const auto &thermal =
-    thermals.Make(c.key,
-                  AGeoPoint(bottom_location, bottom_altitude),
-                  AGeoPoint(top_location, top_altitude),
-                  lift);
+  journal.AppendThermal(thermal);
 
   /* send this new thermal to all interested clients immediately */
   const auto now = std::chrono::steady_clock::now();
-  for (const auto &i : clients.QueryWithinRange(bottom_location,
-                                                THERMAL_RANGE)) {
-    if (i->key == c.key)
-      /* ignore this client's own submissions - he knows them
-         already */
-      continue;
-
-    if (now > i->wants_thermals)
-      /* not interested (anymore) */
-      continue;
-
-    ThermalResponseSender s(*this, {i->endpoint, i->key});
+  recipients.clear();
+  data.VisitClientsWithinRange(bottom_location, THERMAL_RANGE,
+                               [this, &c, now](const CloudClient &i){
+      if (i.key == c.key)
+        /* ignore this client's own submissions - he knows them
+           already */
+        return;
+
+      if (now > i.wants_thermals)
+        /* not interested (anymore) */
+        return;
+
+      recipients.push_back({i.endpoint, i.key});
+    });
+
+  for (const auto &i : recipients) {
+    ThermalResponseSender s(batch, i);
     s.Add(thermal.Pack());
     s.Flush();
   }
+
+  batch.Flush();
 }
 
 void
-CloudServer::OnThermalRequest(const Client &c)
+CloudWorker::OnThermalRequest(const Client &c)
 {
-  auto *client = clients.Find(c.key);
-  if (client == nullptr)
+  const auto now = std::chrono::steady_clock::now();
+
+  GeoPoint location;
+  if (!data.WithClient(c.key, [now, &location](CloudClient &client){
+        client.wants_thermals = now + REQUEST_EXPIRY;
+        location = client.location;
+      }))
     /* we don't send our data to clients who didn't sent anything to
        us yet */
     return;
 
-  const auto now = std::chrono::steady_clock::now();
-
-  client->wants_thermals = now + REQUEST_EXPIRY;
-
   const auto min_time = now - MAX_THERMAL_AGE;
 
   ThermalResponseSender s(*this, c);
 
   unsigned n = 0;
-  for (const auto &thermal : thermals.QueryWithinRange(client->location,
-                                                       THERMAL_RANGE)) {
-    if (thermal->client_key == c.key)
-      /* ignore this client's own submissions - he knows them
-         already */
-      continue;
+  data.VisitThermalsWithinRange(location, THERMAL_RANGE,
+                                [&c, min_time, &s, &n](const CloudThermal &thermal){
+      if (n > 256)
+        return;
 
-    if (thermal->time < min_time)
-      /* don't send old thermals, they're useless */
-      continue;
+      if (thermal.client_key == c.key)
+        /* ignore this client's own submissions - he knows them
+           already */
+        return;
 
-    s.Add(thermal->Pack());
+      if (thermal.time < min_time)
+        /* don't send old thermals, they're useless */
+        return;
 
-    if (++n > 256)
-      break;
-  }
+      s.Add(thermal.Pack());
+      ++n;
+    });
 
   s.Flush();
 }
 
+void
+CloudServer::StartThreads(boost::asio::ip::udp::endpoint endpoint,
+                          unsigned n_threads)
+{
+  assert(threads.empty());
+  assert(n_threads > 0);
+
+  journal.Open();
+
+  /* SO_REUSEPORT is only needed (and only portable) with more than
+     one socket */
+  const bool reuse_port = n_threads > 1;
+
+  for (unsigned i = 0; i < n_threads; ++i) {
+    threads.emplace_back(new AsioThread());
+    workers.emplace_back(new CloudWorker(io_service, data, journal,
+                                         threads.back()->Get(),
+                                         endpoint, reuse_port));
+  }
+
+  background.reset(new AsioThread());
+
+  for (auto &thread : threads)
+    if (!thread->Start())
+      throw std::runtime_error("Failed to start worker thread");
+
+  if (!background->Start())
+    throw std::runtime_error("Failed to start background thread");
+}
+
+void
+CloudServer::StopThreads()
+{
+  for (auto &thread : threads)
+    thread->Stop();
+
+  workers.clear();
+  threads.clear();
+
+  if (background != nullptr) {
+    /* this waits for a running Compact() call to finish */
+    background->Stop();
+    background.reset();
+  }
+
+  journal.Close();
+}
+
 void
 CloudServer::Load()
 {
-  FileReader fr(db_path);
-  Deserialiser s(fr);
-  CloudData::Load(s);
+  try {
+    FileReader fr(db_path);
+    Deserialiser s(fr);
+    data.Load(s);
+  } catch (const std::runtime_error &e) {
+    cerr << "Failed to load database" << endl;
+    PrintException(e);
+  }
+
+  journal.Replay(data);
 }
 
 void
@@ -391,40 +608,76 @@ CloudServer::Save()
 
   {
     Serialiser s(fos);
-    CloudData::Save(s);
+    data.Save(s);
     s.Flush();
   }
 
   fos.Commit();
 }
 
+void
+CloudServer::Checkpoint()
+{
+  assert(threads.empty());
+
+  Save();
+  journal.RemoveAll();
+}
+
+void
+CloudServer::Compact()
+{
+  try {
+    journal.Rotate();
+    Save();
+    journal.RemoveOld();
+  } catch (const std::exception &e) {
+    PrintException(e);
+  }
+
+  compacting = false;
+}
+
 int
 main(int argc, char **argv)
 try {
-  if (argc != 2) {
-    cerr << "Usage: " << argv[0] << " DBPATH" << endl;
+  if (argc < 2 || argc > 3) {
+    cerr << "Usage: " << argv[0] << " DBPATH [THREADS]" << endl;
     return EXIT_FAILURE;
   }
 
   const Path db_path(argv[1]);
 
+  unsigned n_threads = 1;
+  if (argc > 2) {
+    char *endptr;
+    n_threads = ParseUnsigned(argv[2], &endptr);
+    if (endptr == argv[2] || *endptr != 0 ||
+        n_threads == 0 || n_threads > MAX_THREADS) {
+      cerr << "Invalid number of threads" << endl;
+      return EXIT_FAILURE;
+    }
+  }
+
   boost::asio::io_service io_service;
 
   const boost::asio::ip::udp::endpoint endpoint(boost::asio::ip::udp::v4(),
-                                                CloudServer::GetDefaultPort());
+                                                SkyLinesTracking::Server::GetDefaultPort());
 
-  CloudServer server(db_path, io_service, endpoint);
+  CloudServer server(db_path, io_service, n_threads);
 
-  try {
-    server.Load();
-  } catch (const std::runtime_error &e) {
-    cerr << "Failed to load database" << endl;
-    PrintException(e);
-  }
+  server.Load();
+
+  /* start with a fresh journal; this also discards a truncated
+     record at the end of the old one */
+  server.Checkpoint();
+
+  server.StartThreads(endpoint, n_threads);
 
   io_service.run();
 
-  server.Save();
+  server.StopThreads();
+  server.Checkpoint();
 
   return EXIT_SUCCESS;
 } catch (const std::exception &exception) {
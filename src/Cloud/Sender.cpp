@@ -26,6 +26,37 @@ Copyright_License {
 #include "Geo/GeoPoint.hpp"
 #include "Util/CRC.hpp"
 
+#include <assert.h>
+#include <string.h>
+
+void
+SendBatch::Add(const boost::asio::ip::udp::endpoint &endpoint,
+               boost::asio::const_buffer data)
+{
+  const size_t size = boost::asio::buffer_size(data);
+  assert(size <= MAX_SIZE);
+
+  if (n_datagrams == CAPACITY)
+    Flush();
+
+  uint8_t *buffer = buffers[n_datagrams];
+  memcpy(buffer, boost::asio::buffer_cast<const void *>(data), size);
+
+  auto &d = datagrams[n_datagrams++];
+  d.endpoint = endpoint;
+  d.data = boost::asio::const_buffer(buffer, size);
+}
+
+void
+SendBatch::Flush()
+{
+  if (n_datagrams == 0)
+    return;
+
+  server.SendBuffers(datagrams.data(), n_datagrams);
+  n_datagrams = 0;
+}
+
 void
 TrafficResponseSender::Add(uint32_t pilot_id, uint32_t time,
                            GeoPoint location, int altitude)
@@ -57,7 +88,11 @@ TrafficResponseSender::Flush()
 
   data.header.header.crc = 0;
   data.header.header.crc = ToBE16(UpdateCRC16CCITT(&data, size, 0));
-  server.SendBuffer(endpoint, boost::asio::const_buffer(&data, size));
+  const boost::asio::const_buffer buffer(&data, size);
+  if (batch != nullptr)
+    batch->Add(endpoint, buffer);
+  else
+    server.SendBuffer(endpoint, buffer);
 }
 
 void
@@ -84,5 +119,9 @@ ThermalResponseSender::Flush()
 
   data.header.header.crc = 0;
   data.header.header.crc = ToBE16(UpdateCRC16CCITT(&data, size, 0));
-  server.SendBuffer(endpoint, boost::asio::const_buffer(&data, size));
+  const boost::asio::const_buffer buffer(&data, size);
+  if (batch != nullptr)
+    batch->Add(endpoint, buffer);
+  else
+    server.SendBuffer(endpoint, buffer);
 }
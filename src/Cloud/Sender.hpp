@@ -30,11 +30,57 @@ Copyright_License {
 
 #include <boost/asio/ip/udp.hpp>
 
+#include <array>
+
+#include <stdint.h>
+
 struct GeoPoint;
 
+/**
+ * Collects datagrams to many clients and submits them with
+ * SkyLinesTracking::Server::SendBuffers(), to reduce the number of
+ * system calls.
+ */
+class SendBatch {
+public:
+  static constexpr size_t CAPACITY = 64;
+  static constexpr size_t MAX_SIZE = 1280;
+
+private:
+  SkyLinesTracking::Server &server;
+
+  std::array<SkyLinesTracking::Server::Datagram, CAPACITY> datagrams;
+  uint8_t buffers[CAPACITY][MAX_SIZE];
+
+  unsigned n_datagrams = 0;
+
+public:
+  explicit SendBatch(SkyLinesTracking::Server &_server):server(_server) {}
+
+  SendBatch(const SendBatch &) = delete;
+  SendBatch &operator=(const SendBatch &) = delete;
+
+  SkyLinesTracking::Server &GetServer() {
+    return server;
+  }
+
+  /**
+   * Copy a datagram into the batch.  Sends the batch when it is
+   * full.
+   */
+  void Add(const boost::asio::ip::udp::endpoint &endpoint,
+           boost::asio::const_buffer data);
+
+  /**
+   * Send all queued datagrams.
+   */
+  void Flush();
+};
+
 class TrafficResponseSender {
   SkyLinesTracking::Server &server;
-  const boost::asio::ip::udp::endpoint &endpoint;
+  SendBatch *const batch;
+  const boost::asio::ip::udp::endpoint endpoint;
 
   static constexpr size_t MAX_TRAFFIC_SIZE = 1024;
   static constexpr size_t MAX_TRAFFIC =
@@ -45,12 +91,27 @@ class TrafficResponseSender {
     std::array<SkyLinesTracking::TrafficResponsePacket::Traffic, MAX_TRAFFIC> traffic;
   } data;
 
+  static_assert(sizeof(Packet) <= SendBatch::MAX_SIZE, "Packet too large");
+
   unsigned n_traffic = 0;
 
 public:
   TrafficResponseSender(SkyLinesTracking::Server &_server,
                         const SkyLinesTracking::Server::Client &client)
-    :server(_server), endpoint(client.endpoint) {
+    :TrafficResponseSender(_server, nullptr, client) {}
+
+  /**
+   * Queue the response datagrams in the given #SendBatch instead of
+   * sending them right away.
+   */
+  TrafficResponseSender(SendBatch &_batch,
+                        const SkyLinesTracking::Server::Client &client)
+    :TrafficResponseSender(_batch.GetServer(), &_batch, client) {}
+
+private:
+  TrafficResponseSender(SkyLinesTracking::Server &_server, SendBatch *_batch,
+                        const SkyLinesTracking::Server::Client &client)
+    :server(_server), batch(_batch), endpoint(client.endpoint) {
     data.header.header.magic = ToBE32(SkyLinesTracking::MAGIC);
     data.header.header.type = ToBE16(SkyLinesTracking::Type::TRAFFIC_RESPONSE);
     data.header.header.key = ToBE64(client.key);
@@ -60,6 +121,7 @@ public:
     data.header.reserved3 = 0;
   }
 
+public:
   void Add(uint32_t pilot_id, uint32_t time,
            GeoPoint location, int altitude);
   void Flush();
@@ -67,7 +129,8 @@ public:
 
 class ThermalResponseSender {
   SkyLinesTracking::Server &server;
-  const boost::asio::ip::udp::endpoint &endpoint;
+  SendBatch *const batch;
+  const boost::asio::ip::udp::endpoint endpoint;
 
   static constexpr size_t MAX_THERMAL_SIZE = 1024;
   static constexpr size_t MAX_THERMAL =
@@ -78,12 +141,27 @@ class ThermalResponseSender {
     std::array<SkyLinesTracking::Thermal, MAX_THERMAL> thermal;
   } data;
 
+  static_assert(sizeof(Packet) <= SendBatch::MAX_SIZE, "Packet too large");
+
   unsigned n_thermal = 0;
 
 public:
   ThermalResponseSender(SkyLinesTracking::Server &_server,
                         const SkyLinesTracking::Server::Client &client)
-    :server(_server), endpoint(client.endpoint) {
+    :ThermalResponseSender(_server, nullptr, client) {}
+
+  /**
+   * Queue the response datagrams in the given #SendBatch instead of
+   * sending them right away.
+   */
+  ThermalResponseSender(SendBatch &_batch,
+                        const SkyLinesTracking::Server::Client &client)
+    :ThermalResponseSender(_batch.GetServer(), &_batch, client) {}
+
+private:
+  ThermalResponseSender(SkyLinesTracking::Server &_server, SendBatch *_batch,
+                        const SkyLinesTracking::Server::Client &client)
+    :server(_server), batch(_batch), endpoint(client.endpoint) {
     data.header.header.magic = ToBE32(SkyLinesTracking::MAGIC);
     data.header.header.type = ToBE16(SkyLinesTracking::Type::THERMAL_RESPONSE);
     data.header.header.key = ToBE64(client.key);
@@ -93,6 +171,7 @@ public:
     data.header.reserved3 = 0;
   }
 
+public:
   void Add(SkyLinesTracking::Thermal t);
   void Flush();
 };
@@ -0,0 +1,352 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#include "Sharded.hpp"
+#include "Serialiser.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+#include <assert.h>
+#include <math.h>
+
+ShardedCloudData::ShardedCloudData(unsigned _n_shards)
+  :n_shards(_n_shards),
+   shards(new Shard[n_shards]),
+   directory(new DirectorySlot[n_shards]),
+   next_id(1)
+{
+  assert(n_shards > 0);
+  assert(n_shards <= MAX_SHARDS);
+}
+
+ShardedCloudData::~ShardedCloudData() = default;
+
+unsigned
+ShardedCloudData::GetCellColumn(Angle longitude)
+{
+  const double x = floor((longitude.AsDelta().Degrees() + 180) / CELL_SIZE);
+  return x > 0 ? unsigned(x) % CELL_COLUMNS : 0;
+}
+
+unsigned
+ShardedCloudData::GetCellRow(Angle latitude)
+{
+  const double y = floor((latitude.Degrees() + 90) / CELL_SIZE);
+  return y > 0 ? std::min(unsigned(y), CELL_ROWS - 1) : 0;
+}
+
+unsigned
+ShardedCloudData::GetShardIndex(unsigned column, unsigned row) const
+{
+  assert(column < CELL_COLUMNS);
+  assert(row < CELL_ROWS);
+
+  /* multiplicative hashing scatters neighbouring cells; the upper
+     bits of the product are mapped onto the shards */
+  const uint32_t hash = (row * CELL_COLUMNS + column) * 2654435761u;
+  return unsigned((uint64_t(hash) * n_shards) >> 32);
+}
+
+uint64_t
+ShardedCloudData::GetShardsWithinRange(GeoPoint location,
+                                       double range) const
+{
+  const uint64_t all = n_shards < 64
+    ? (uint64_t(1) << n_shards) - 1
+    : ~uint64_t(0);
+
+  const auto box = BoostRangeBox(location, range);
+  if (box.max_corner().longitude - box.min_corner().longitude >
+      Angle::HalfCircle())
+    /* the range includes a pole, and thus all longitudes */
+    return all;
+
+  const unsigned west = GetCellColumn(box.min_corner().longitude);
+  const unsigned east = GetCellColumn(box.max_corner().longitude);
+  const unsigned south = GetCellRow(box.min_corner().latitude);
+  const unsigned north = GetCellRow(box.max_corner().latitude);
+
+  /* the box may cross the date line */
+  const unsigned n_columns = (east + CELL_COLUMNS - west) % CELL_COLUMNS + 1;
+  if (n_columns * (north - south + 1) >= n_shards)
+    /* probably covers (almost) all shards */
+    return all;
+
+  uint64_t mask = 0;
+  for (unsigned row = south; row <= north; ++row)
+    for (unsigned i = 0; i < n_columns; ++i)
+      mask |= uint64_t(1) << GetShardIndex((west + i) % CELL_COLUMNS, row);
+
+  return mask;
+}
+
+void
+ShardedCloudData::Insert(DirectorySlot &slot, CloudClient &client)
+{
+  const unsigned i = GetShardIndex(client.location);
+
+  auto &shard = shards[i];
+  {
+    const ScopeLock protect(shard.mutex);
+    shard.data.clients.Insert(client);
+  }
+
+  slot.shards[client.key] = i;
+}
+
+ShardedCloudData::ClientInfo
+ShardedCloudData::Make(const boost::asio::ip::udp::endpoint &endpoint,
+                       uint64_t key, const GeoPoint &location, int altitude)
+{
+  auto &slot = GetSlot(key);
+  const ScopeLock protect(slot.mutex);
+
+  auto i = slot.shards.find(key);
+  if (i != slot.shards.end()) {
+    auto &shard = shards[i->second];
+    const unsigned new_index = GetShardIndex(location);
+
+    CloudClientPtr moved;
+
+    {
+      const ScopeLock protect2(shard.mutex);
+
+      auto *client = shard.data.clients.Find(key);
+      if (client != nullptr) {
+        if (new_index == i->second) {
+          shard.data.clients.Refresh(*client, endpoint, location, altitude);
+          return ClientInfo(*client);
+        }
+
+        /* the client has moved to a cell owned by another shard */
+        moved = client->shared_from_this();
+        shard.data.clients.Remove(*client);
+      }
+    }
+
+    if (moved) {
+      moved->Refresh(endpoint);
+      moved->location = location;
+      moved->altitude = altitude;
+      Insert(slot, *moved);
+      return ClientInfo(*moved);
+    }
+
+    /* expired meanwhile */
+    slot.shards.erase(i);
+  }
+
+  auto client = std::make_shared<CloudClient>(endpoint, key, next_id++,
+                                              location, altitude);
+  Insert(slot, *client);
+  return ClientInfo(*client);
+}
+
+CloudThermal
+ShardedCloudData::MakeThermal(uint64_t client_key,
+                              const AGeoPoint &bottom_location,
+                              const AGeoPoint &top_location,
+                              double lift)
+{
+  /* thermals are indexed by their top location, see
+     CloudThermalIndexable */
+  auto &shard = shards[GetShardIndex(top_location)];
+  const ScopeLock protect(shard.mutex);
+  return shard.data.thermals.Make(client_key, bottom_location, top_location,
+                                  lift);
+}
+
+void
+ShardedCloudData::Replay(const CloudClient &record)
+{
+  auto &slot = GetSlot(record.key);
+  const ScopeLock protect(slot.mutex);
+
+  CloudClientPtr client;
+
+  auto i = slot.shards.find(record.key);
+  if (i != slot.shards.end()) {
+    auto &shard = shards[i->second];
+    const ScopeLock protect2(shard.mutex);
+
+    auto *old = shard.data.clients.Find(record.key);
+    if (old != nullptr) {
+      client = old->shared_from_this();
+      shard.data.clients.Remove(*old);
+    }
+  }
+
+  if (client) {
+    client->endpoint = record.endpoint;
+    client->location = record.location;
+    client->altitude = record.altitude;
+  } else {
+    client = std::make_shared<CloudClient>(record.endpoint, record.key,
+                                           record.id,
+                                           record.location, record.altitude);
+
+    unsigned id = next_id;
+    while (record.id >= id &&
+           !next_id.compare_exchange_weak(id, record.id + 1)) {}
+  }
+
+  client->stamp = record.stamp;
+
+  Insert(slot, *client);
+}
+
+void
+ShardedCloudData::Replay(const CloudThermal &record)
+{
+  auto &shard = shards[GetShardIndex(record.top_location)];
+  const ScopeLock protect(shard.mutex);
+
+  /* the snapshot and the journal store time stamps with a
+     resolution of one second, relative to different reference
+     points */
+  constexpr auto tolerance = std::chrono::seconds(2);
+
+  for (const auto &i : shard.data.thermals.QueryWithinRange(record.top_location,
+                                                             100)) {
+    const auto &thermal = *i;
+    if (thermal.client_key == record.client_key &&
+        thermal.time < record.time + tolerance &&
+        record.time < thermal.time + tolerance)
+      return;
+  }
+
+  auto thermal = std::make_shared<CloudThermal>(record);
+  shard.data.thermals.Insert(*thermal);
+}
+
+void
+ShardedCloudData::Expire(std::chrono::steady_clock::time_point before)
+{
+  for (unsigned i = 0; i < n_shards; ++i) {
+    auto &shard = shards[i];
+    const ScopeLock protect(shard.mutex);
+    shard.data.clients.Expire(before);
+  }
+
+  /* purge directory entries of expired clients */
+  for (unsigned i = 0; i < n_shards; ++i) {
+    auto &slot = directory[i];
+    const ScopeLock protect(slot.mutex);
+
+    for (auto j = slot.shards.begin(); j != slot.shards.end();) {
+      auto &shard = shards[j->second];
+      const ScopeLock protect2(shard.mutex);
+
+      if (shard.data.clients.Find(j->first) == nullptr)
+        j = slot.shards.erase(j);
+      else
+        ++j;
+    }
+  }
+}
+
+void
+ShardedCloudData::DumpClients() const
+{
+  for (unsigned i = 0; i < n_shards; ++i) {
+    auto &shard = shards[i];
+    const ScopeLock protect(shard.mutex);
+    shard.data.DumpClients();
+  }
+}
+
+void
+ShardedCloudData::Save(Serialiser &s) const
+{
+  /* this is the same format as CloudData::Save(), with the clients
+     and thermals of all shards concatenated */
+
+  s.Write32(CloudData::MAGIC);
+  s.Write32(CloudData::VERSION);
+
+  s.Write32(next_id);
+
+  for (unsigned i = 0; i < n_shards; ++i) {
+    auto &shard = shards[i];
+    const ScopeLock protect(shard.mutex);
+
+    for (const auto &client : shard.data.clients) {
+      s.Write8(1);
+      client.Save(s);
+    }
+  }
+
+  s.Write8(0);
+  s.Write8(0);
+
+  s.Write8(1);
+  s.Write8(1);
+
+  for (unsigned i = 0; i < n_shards; ++i) {
+    auto &shard = shards[i];
+    const ScopeLock protect(shard.mutex);
+
+    for (const auto &thermal : shard.data.thermals) {
+      s.Write8(1);
+      thermal.Save(s);
+    }
+  }
+
+  s.Write8(0);
+  s.Write8(0);
+
+  s.Write8(0);
+}
+
+void
+ShardedCloudData::Load(Deserialiser &s)
+{
+  std::unique_ptr<CloudData> data(new CloudData());
+  data->Load(s);
+
+  next_id = data->clients.GetNextId();
+
+  /* move all objects to their shards, oldest first, to preserve the
+     order of the lists */
+
+  while (!data->clients.empty()) {
+    auto &client = const_cast<CloudClient &>(*std::prev(data->clients.end()));
+    auto ptr = client.shared_from_this();
+    data->clients.Remove(client);
+
+    auto &slot = GetSlot(ptr->key);
+    const ScopeLock protect(slot.mutex);
+    Insert(slot, *ptr);
+  }
+
+  while (!data->thermals.empty()) {
+    auto &thermal = const_cast<CloudThermal &>(*std::prev(data->thermals.end()));
+    auto ptr = thermal.shared_from_this();
+    data->thermals.Remove(thermal);
+
+    auto &shard = shards[GetShardIndex(ptr->top_location)];
+    const ScopeLock protect(shard.mutex);
+    shard.data.thermals.Insert(*ptr);
+  }
+}
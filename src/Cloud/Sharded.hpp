@@ -0,0 +1,281 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#ifndef XCSOAR_CLOUD_SHARDED_HPP
+#define XCSOAR_CLOUD_SHARDED_HPP
+
+#include "Data.hpp"
+#include "Thread/Mutex.hpp"
+#include "Tracking/SkyLines/Protocol.hpp"
+#include "Geo/Boost/RangeBox.hpp"
+#include "Compiler.h"
+
+#include <unordered_map>
+#include <memory>
+#include <atomic>
+
+#include <stdint.h>
+
+/**
+ * The #CloudData, partitioned into "shards".  The globe is divided
+ * into cells of #CELL_SIZE degrees, and the cells are hashed onto the
+ * shards, so a busy region is spread over all of them.  Each shard
+ * has its own lock and its own rtrees, so several worker threads can
+ * process requests concurrently.
+ *
+ * Lock order: a directory slot may be locked before a shard, never
+ * the other way round; no method holds two shard locks at a time.
+ */
+class ShardedCloudData {
+  struct Shard {
+    mutable Mutex mutex;
+    CloudData data;
+  };
+
+  /**
+   * Maps client keys to the index of the shard which owns the
+   * client.  The directory is partitioned by key, each slot with its
+   * own lock.  Entries of expired clients are removed lazily.
+   */
+  struct DirectorySlot {
+    Mutex mutex;
+    std::unordered_map<uint64_t, unsigned> shards;
+  };
+
+public:
+  /**
+   * The maximum number of shards, limited by the bit mask in
+   * VisitShardsWithinRange().
+   */
+  static constexpr unsigned MAX_SHARDS = 64;
+
+private:
+  /**
+   * The size of a cell in degrees.  A range query covers only a few
+   * cells, and thus locks only a few shards.
+   */
+  static constexpr unsigned CELL_SIZE = 1;
+
+  static constexpr unsigned CELL_COLUMNS = 360 / CELL_SIZE;
+  static constexpr unsigned CELL_ROWS = 180 / CELL_SIZE;
+
+  const unsigned n_shards;
+
+  const std::unique_ptr<Shard[]> shards;
+  const std::unique_ptr<DirectorySlot[]> directory;
+
+  /**
+   * The public id assigned to the next new #CloudClient.
+   */
+  std::atomic<unsigned> next_id;
+
+public:
+  /**
+   * A copy of a #CloudClient's attributes, which remains usable
+   * after its shard has been unlocked.
+   */
+  struct ClientInfo {
+    boost::asio::ip::udp::endpoint endpoint;
+    uint64_t key;
+    unsigned id;
+    GeoPoint location;
+    int altitude;
+
+    ClientInfo() = default;
+
+    explicit ClientInfo(const CloudClient &client)
+      :endpoint(client.endpoint), key(client.key), id(client.id),
+       location(client.location), altitude(client.altitude) {}
+  };
+
+  /**
+   * @param _n_shards the number of shards (at most #MAX_SHARDS)
+   */
+  explicit ShardedCloudData(unsigned _n_shards);
+  ~ShardedCloudData();
+
+  ShardedCloudData(const ShardedCloudData &) = delete;
+  ShardedCloudData &operator=(const ShardedCloudData &) = delete;
+
+  /**
+   * Create a new #CloudClient, or refresh the existing one (and
+   * move it to another shard if necessary).
+   */
+  ClientInfo Make(const boost::asio::ip::udp::endpoint &endpoint,
+                  uint64_t key, const GeoPoint &location, int altitude);
+
+  /**
+   * Look up a client by its secret key and invoke the given
+   * function with a reference to it, while its shard is locked.
+   *
+   * @return false if no such client exists
+   */
+  template<typename F>
+  bool WithClient(uint64_t key, F &&f) {
+    auto &slot = GetSlot(key);
+    const ScopeLock protect(slot.mutex);
+
+    auto i = slot.shards.find(key);
+    if (i == slot.shards.end())
+      return false;
+
+    auto &shard = shards[i->second];
+    const ScopeLock protect2(shard.mutex);
+
+    auto *client = shard.data.clients.Find(key);
+    if (client == nullptr) {
+      /* expired meanwhile */
+      slot.shards.erase(i);
+      return false;
+    }
+
+    f(*client);
+    return true;
+  }
+
+  /**
+   * Add a new #CloudThermal.
+   *
+   * @return a copy of the new thermal
+   */
+  CloudThermal MakeThermal(uint64_t client_key,
+                           const AGeoPoint &bottom_location,
+                           const AGeoPoint &top_location,
+                           double lift);
+
+  /**
+   * Apply a client record from the journal: create the client or
+   * update it, preserving its public id and time stamp.
+   */
+  void Replay(const CloudClient &record);
+
+  /**
+   * Apply a thermal record from the journal.  Thermals which are
+   * already known (because they were also in the snapshot) are
+   * ignored.
+   */
+  void Replay(const CloudThermal &record);
+
+  /**
+   * Invoke the given function for each #CloudClient within the
+   * given range.  The function is called while the client's shard is
+   * locked; it must not call other methods of this class.
+   */
+  template<typename F>
+  void VisitClientsWithinRange(GeoPoint location, double range,
+                               F &&f) const {
+    VisitShardsWithinRange(location, range, [&](const CloudData &data){
+        for (const auto &i : data.clients.QueryWithinRange(location, range))
+          f(*i);
+      });
+  }
+
+  /**
+   * Invoke the given function for each #CloudThermal within the
+   * given range.  The same restrictions as with
+   * VisitClientsWithinRange() apply.
+   */
+  template<typename F>
+  void VisitThermalsWithinRange(GeoPoint location, double range,
+                                F &&f) const {
+    VisitShardsWithinRange(location, range, [&](const CloudData &data){
+        for (const auto &i : data.thermals.QueryWithinRange(location, range))
+          f(*i);
+      });
+  }
+
+  void Expire(std::chrono::steady_clock::time_point before);
+
+  void DumpClients() const;
+
+  /**
+   * Serialise all shards in the format of CloudData::Save().
+   */
+  void Save(Serialiser &s) const;
+
+  /**
+   * Load data saved by Save() or CloudData::Save(), and distribute
+   * it among the shards.  Must be called before any other thread
+   * accesses this object.
+   */
+  void Load(Deserialiser &s);
+
+private:
+  DirectorySlot &GetSlot(uint64_t key) {
+    return directory[key % n_shards];
+  }
+
+  gcc_const
+  static unsigned GetCellColumn(Angle longitude);
+
+  gcc_const
+  static unsigned GetCellRow(Angle latitude);
+
+  /**
+   * Determine the shard which owns the specified cell.
+   */
+  gcc_pure
+  unsigned GetShardIndex(unsigned column, unsigned row) const;
+
+  gcc_pure
+  unsigned GetShardIndex(const GeoPoint &location) const {
+    return GetShardIndex(GetCellColumn(location.longitude),
+                         GetCellRow(location.latitude));
+  }
+
+  /**
+   * Determine the shards which own the cells overlapping the given
+   * range.
+   *
+   * @return a bit mask of shard indices
+   */
+  gcc_pure
+  uint64_t GetShardsWithinRange(GeoPoint location, double range) const;
+
+  /**
+   * Insert a client which is not yet in any shard.  The caller must
+   * hold the directory slot's lock.
+   */
+  void Insert(DirectorySlot &slot, CloudClient &client);
+
+  /**
+   * Invoke the given function for each shard which overlaps the
+   * given range, with the shard locked.
+   */
+  template<typename F>
+  void VisitShardsWithinRange(GeoPoint location, double range,
+                              F &&f) const {
+    const uint64_t mask = GetShardsWithinRange(location, range);
+
+    for (unsigned i = 0; i < n_shards; ++i) {
+      if ((mask & (uint64_t(1) << i)) == 0)
+        continue;
+
+      const auto &shard = shards[i];
+      const ScopeLock protect(shard.mutex);
+      f(shard.data);
+    }
+  }
+};
+
+#endif
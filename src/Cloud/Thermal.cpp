@@ -80,7 +80,8 @@ CloudThermalContainer::Expire(std::chrono::steady_clock::time_point before)
 CloudThermalContainer::query_iterator_range
 CloudThermalContainer::QueryWithinRange(GeoPoint location, double range) const
 {
-  const auto q = boost::geometry::index::intersects(BoostRangeBox(location, range));
+  const auto q = BoostRangeQuery(BoostRangeBox(location, range),
+                                 CloudThermalIndexable());
   return {rtree.qbegin(q), rtree.qend()};
 }
 
@@ -108,7 +109,7 @@ CloudThermal
 CloudThermal::Load(Deserialiser &s)
 {
   s.Read8();
-  const unsigned client_key = s.Read64();
+  const uint64_t client_key = s.Read64();
 
   std::chrono::steady_clock::time_point time;
   s >> time;
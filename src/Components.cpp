@@ -40,6 +40,7 @@ DeviceBlackboard *device_blackboard;
 
 MergeThread *merge_thread;
 CalculationThread *calculation_thread;
+ContestThread *contest_thread;
 
 Logger *logger;
 GlueFlightLogger *flight_logger;
@@ -35,6 +35,7 @@ class MultipleDevices;
 class DeviceBlackboard;
 class MergeThread;
 class CalculationThread;
+class ContestThread;
 class Waypoints;
 class Airspaces;
 class ProtectedAirspaceWarningManager;
@@ -60,6 +61,7 @@ extern MultipleDevices *devices;
 extern DeviceBlackboard *device_blackboard;
 extern MergeThread *merge_thread;
 extern CalculationThread *calculation_thread;
+extern ContestThread *contest_thread;
 
 extern Logger *logger;
 extern GlueFlightLogger *flight_logger;
@@ -28,9 +28,8 @@ Copyright_License {
 void
 ClimbAverageCalculator::Reset()
 {
-  newestValIndex = -1;
-  for (int i = 0; i < MAX_HISTORY; i++)
-    history[i].Reset();
+  newest = 0;
+  count = 0;
 }
 
 double
@@ -39,52 +38,48 @@ ClimbAverageCalculator::GetAverage(double time, double altitude,
 {
   assert(average_time <= MAX_HISTORY);
 
-  int bestHistory;
-
-  // Don't update newestValIndex if the time didn't move forward
-  if (newestValIndex < 0 ||
-      !history[newestValIndex].IsDefined() ||
-      time > history[newestValIndex].time)
-    newestValIndex = newestValIndex < MAX_HISTORY - 1 ? newestValIndex + 1 : 0;
+  if (count > 0 && time <= history[newest].time) {
+    if (time < history[newest].time)
+      /* time warp: the old samples are useless */
+      Reset();
+    else
+      /* don't add a new sample if the time didn't move forward */
+      --count;
+  } else
+    newest = newest < MAX_HISTORY - 1 ? newest + 1 : 0;
 
   // add the new sample
-  history[newestValIndex] = HistoryItem(time, altitude);
-
-  // initially bestHistory is the current...
-  bestHistory = newestValIndex;
-
-  // now run through the history and find the best sample
-  // for average period within the average time period
-  for (int i = 0; i < MAX_HISTORY; i++) {
-    if (!history[i].IsDefined())
-      continue;
-
-    // outside the period -> skip value
-    if (history[i].time + average_time < time)
-      continue;
-
-    // is the sample older (and therefore better) than the current found ?
-    if (history[i].time < history[bestHistory].time)
-      bestHistory = i;
+  history[newest] = HistoryItem(time, altitude);
+  if (count < MAX_HISTORY)
+    ++count;
+
+  /* the samples are ordered by time: find the oldest one within the
+     average time period with a binary search, counting from the
+     oldest sample (0) to the newest one (count - 1) */
+  const unsigned oldest = newest + MAX_HISTORY + 1 - count;
+  unsigned lo = 0, hi = count - 1;
+  while (lo < hi) {
+    const unsigned mid = (lo + hi) / 2;
+    if (history[(oldest + mid) % MAX_HISTORY].time + average_time < time)
+      lo = mid + 1;
+    else
+      hi = mid;
   }
 
   // calculate the average !
-  if (bestHistory != newestValIndex)
-    return (altitude - history[bestHistory].altitude) /
-           (time - history[bestHistory].time);
+  if (lo == count - 1)
+    return 0;
 
-  return 0;
+  const HistoryItem &best = history[(oldest + lo) % MAX_HISTORY];
+  return (altitude - best.altitude) / (time - best.time);
 }
 
 bool
 ClimbAverageCalculator::Expired(double now, double max_age) const
 {
-  if (newestValIndex < 0)
-    return true;
-
-  auto item = history[newestValIndex];
-  if (!item.IsDefined())
+  if (count == 0)
     return true;
 
+  const HistoryItem &item = history[newest];
   return now < item.time || now > item.time + max_age;
 }
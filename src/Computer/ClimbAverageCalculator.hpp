@@ -24,9 +24,14 @@ Copyright_License {
 #ifndef CLIMBAVERAGECALCULATOR_HPP
 #define CLIMBAVERAGECALCULATOR_HPP
 
+/**
+ * Calculates the average climb rate from a series of altitude
+ * samples.  A zero-initialised object is empty, which allows
+ * value-initialising it in a container without calling Reset().
+ */
 class ClimbAverageCalculator
 {
-  static constexpr int MAX_HISTORY = 40;
+  static constexpr unsigned MAX_HISTORY = 40;
   struct HistoryItem
   {
     double time;
@@ -36,18 +41,22 @@ class ClimbAverageCalculator
 
     constexpr HistoryItem(double _time, double _altitude)
       :time(_time), altitude(_altitude) {}
-
-    bool IsDefined() const {
-      return time >= 0;
-    }
-
-    void Reset() {
-      time = -1;
-    }
   };
 
+  /**
+   * A ring buffer of samples, ordered by strictly increasing time.
+   */
   HistoryItem history[MAX_HISTORY];
-  int newestValIndex;
+
+  /**
+   * The position of the newest sample in #history.
+   */
+  unsigned newest;
+
+  /**
+   * The number of valid samples in #history.
+   */
+  unsigned count;
 
 public:
   double GetAverage(double time, double altitude, double average_time);
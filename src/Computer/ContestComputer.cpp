@@ -26,10 +26,12 @@ Copyright_License {
 
 ContestComputer::ContestComputer(const Trace &trace_full,
                                  const Trace &trace_triangle,
-                                 const Trace &trace_sprint)
+                                 const Trace &trace_sprint,
+                                 unsigned time_budget)
   :contest_manager(Contest::OLC_SPRINT, trace_full, trace_triangle, trace_sprint, true)
 {
   contest_manager.SetIncremental(true);
+  contest_manager.SetTimeBudget(time_budget);
 }
 
 void
@@ -34,9 +34,17 @@ class ContestComputer {
   ContestManager contest_manager;
 
 public:
+  /**
+   * The default time budget of one Solve() call [us].  The solvers
+   * suspend their search when it is used up, to keep the calculation
+   * thread responsive.
+   */
+  static constexpr unsigned DEFAULT_TIME_BUDGET = 20000;
+
   ContestComputer(const Trace &trace_full,
                   const Trace &trace_triangle,
-                  const Trace &trace_sprint);
+                  const Trace &trace_sprint,
+                  unsigned time_budget=DEFAULT_TIME_BUDGET);
 
   void SetIncremental(bool incremental) {
     contest_manager.SetIncremental(incremental);
@@ -58,6 +66,10 @@ public:
 
   bool SolveExhaustive(const ContestSettings &settings_computer,
                        ContestStatistics &contest_stats);
+
+  const ContestTiming &GetTiming() const {
+    return contest_manager.GetTiming();
+  }
 };
 
 #endif
@@ -162,6 +162,30 @@ public:
     task_computer.SetContestIncremental(incremental);
   }
 
+  /**
+   * @see TaskComputer::SetContestExternal()
+   */
+  void SetContestExternal(bool external) {
+    task_computer.SetContestExternal(external);
+  }
+
+  /**
+   * Returns the input for an external contest solver (see
+   * SetContestExternal()).
+   */
+  gcc_pure
+  TracePoint GetContestPrediction() const {
+    return TaskComputer::GetContestPrediction(GetComputerSettings().contest,
+                                              Basic(), Calculated());
+  }
+
+  /**
+   * Store the results of an external contest solver.
+   */
+  void ReadContestStatistics(const ContestStatistics &stats) {
+    SetCalculated().contest_stats = stats;
+  }
+
 protected:
   void OnTakeoff();
   void OnLanding();
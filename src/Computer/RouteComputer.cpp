@@ -42,6 +42,7 @@ RouteComputer::ResetFlight()
 {
   route_clock.Reset();
   reach_clock.Reset();
+  reach_update_clock.Reset();
   protected_route_planner.Reset();
 
   last_task_type = TaskType::NONE;
@@ -144,7 +145,14 @@ RouteComputer::Reach(const MoreData &basic, DerivedInfo &calculated,
   const int h_ceiling(std::max((int)basic.nav_altitude + 500,
                                (int)calculated.common_stats.height_max_working));
 
-  if (reach_clock.CheckAdvance(basic.time, PERIOD)) {
+  /* a full calculation is throttled, but if the previous footprint
+     can be updated incrementally, do that at GPS rate */
+  const bool solve = reach_clock.CheckAdvance(basic.time, PERIOD) ||
+    (do_solve &&
+     reach_update_clock.CheckAdvance(basic.time, REACH_UPDATE_PERIOD) &&
+     route_planner.CanUpdateReach(start));
+
+  if (solve) {
     protected_route_planner.SolveReach(start, config, h_ceiling, do_solve);
 
     if (do_solve) {
@@ -40,11 +40,18 @@ class GlidePolar;
 class RouteComputer {
   static constexpr unsigned PERIOD = 5;
 
+  /**
+   * The minimum interval [s] of incremental reach updates, which
+   * are cheap enough to be done for each GPS fix.
+   */
+  static constexpr unsigned REACH_UPDATE_PERIOD = 1;
+
   RoutePlannerGlue route_planner;
   ProtectedRoutePlanner protected_route_planner;
 
   GPSClock route_clock;
   GPSClock reach_clock;
+  GPSClock reach_update_clock;
 
   const RasterTerrain *terrain;
 
@@ -43,7 +43,8 @@ TaskComputer::TaskComputer(ProtectedTaskManager &_task,
                            const ProtectedAirspaceWarningManager *warnings)
   :task(_task),
    route(airspace_database, warnings),
-   contest(trace.GetFull(), trace.GetContest(), trace.GetSprint())
+   contest(trace.GetFull(), trace.GetContest(), trace.GetSprint()),
+   contest_external(false)
 {
   task.SetRoutePlanner(&route.GetRoutePlanner());
 }
@@ -145,19 +146,29 @@ Predicted(const ContestSettings &settings,
                     0, 0);
 }
 
+TracePoint
+TaskComputer::GetContestPrediction(const ContestSettings &settings,
+                                   const MoreData &basic,
+                                   const DerivedInfo &calculated)
+{
+  return Predicted(settings, basic, calculated.task_stats.current_leg);
+}
+
 void
 TaskComputer::ProcessIdle(const MoreData &basic, DerivedInfo &calculated,
                           const ComputerSettings &settings_computer,
                           bool exhaustive)
 {
-  contest.SetPredicted(Predicted(settings_computer.contest, basic,
-                                 calculated.task_stats.current_leg));
-
-  if (exhaustive)
-    contest.SolveExhaustive(settings_computer.contest,
-                            calculated.contest_stats);
-  else
-    contest.Solve(settings_computer.contest, calculated.contest_stats);
+  if (exhaustive || !contest_external) {
+    contest.SetPredicted(Predicted(settings_computer.contest, basic,
+                                   calculated.task_stats.current_leg));
+
+    if (exhaustive)
+      contest.SolveExhaustive(settings_computer.contest,
+                              calculated.contest_stats);
+    else
+      contest.Solve(settings_computer.contest, calculated.contest_stats);
+  }
 
   const AircraftState as = ToAircraftState(basic, calculated);
 
@@ -44,6 +44,12 @@ class TaskComputer
 
   ContestComputer contest;
 
+  /**
+   * Is the contest solved by another thread?  Then ProcessIdle()
+   * skips it (unless exhaustive).
+   */
+  bool contest_external;
+
   AircraftState last_state;
   bool valid_last_state;
 
@@ -96,6 +102,23 @@ public:
     contest.SetIncremental(incremental);
   }
 
+  /**
+   * @param external true if the contest is solved by another thread,
+   * which posts its results to DerivedInfo::contest_stats
+   */
+  void SetContestExternal(bool external) {
+    contest_external = external;
+  }
+
+  /**
+   * Returns the point which shall be passed to
+   * ContestManager::SetPredicted().
+   */
+  gcc_pure
+  static TracePoint GetContestPrediction(const ContestSettings &settings,
+                                         const MoreData &basic,
+                                         const DerivedInfo &calculated);
+
   /**
    * Auto-create a task on takeoff that leads back home.
    */
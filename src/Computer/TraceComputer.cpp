@@ -42,7 +42,8 @@ static constexpr unsigned full_trace_no_thin_time =
 TraceComputer::TraceComputer()
  :full(full_trace_no_thin_time, Trace::null_time, full_trace_size),
   contest(0, Trace::null_time, contest_trace_size),
-  sprint(0, 9000, sprint_trace_size)
+  sprint(0, 9000, sprint_trace_size),
+  reset_count(0)
 {
 }
 
@@ -52,6 +53,7 @@ TraceComputer::Reset()
   {
     const ScopeLock lock(mutex);
     full.clear();
+    ++reset_count;
   }
 
   contest.clear();
@@ -75,26 +77,30 @@ TraceComputer::LockedCopyTo(TracePointVector &v, unsigned min_time,
 }
 
 void
-TraceComputer::Update(const ComputerSettings &settings_computer,
-                      const MoreData &basic, const DerivedInfo &calculated)
+TraceComputer::Append(const TracePoint &point, bool contest_enabled)
 {
-  /* time warps are handled by the Trace class */
-
-  if (!basic.time_available || !basic.location_available ||
-      !basic.NavAltitudeAvailable() ||
-      !calculated.flight.flying)
-    return;
-
-  const TracePoint point(basic);
-
   {
     const ScopeLock lock(mutex);
     full.push_back(point);
   }
 
   // only olc requires trace_sprint
-  if (settings_computer.contest.enable) {
+  if (contest_enabled) {
     sprint.push_back(point);
     contest.push_back(point);
   }
 }
+
+void
+TraceComputer::Update(const ComputerSettings &settings_computer,
+                      const MoreData &basic, const DerivedInfo &calculated)
+{
+  /* time warps are handled by the Trace class */
+
+  if (!basic.time_available || !basic.location_available ||
+      !basic.NavAltitudeAvailable() ||
+      !calculated.flight.flying)
+    return;
+
+  Append(TracePoint(basic), settings_computer.contest.enable);
+}
@@ -44,6 +44,11 @@ class TraceComputer {
 
   Trace full, contest, sprint;
 
+  /**
+   * Incremented by each Reset().  Protected by #mutex.
+   */
+  unsigned reset_count;
+
 public:
   TraceComputer();
 
@@ -79,6 +84,15 @@ public:
     return sprint;
   }
 
+  /**
+   * Returns a number which changes with each Reset().  This allows
+   * other threads to detect that the trace has been discarded.  The
+   * caller must lock the mutex.
+   */
+  unsigned GetResetCount() const {
+    return reset_count;
+  }
+
   void Reset();
 
   /**
@@ -94,6 +108,14 @@ public:
   void LockedCopyTo(TracePointVector &v, unsigned min_time,
                             const GeoPoint &location, double resolution) const;
 
+  /**
+   * Append a point to the traces.
+   *
+   * @param contest_enabled append to the contest and sprint traces as
+   * well?
+   */
+  void Append(const TracePoint &point, bool contest_enabled);
+
   void Update(const ComputerSettings &settings_computer,
               const MoreData &basic, const DerivedInfo &calculated);
 };
@@ -0,0 +1,108 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#include "ContestThread.hpp"
+#include "Blackboard/DeviceBlackboard.hpp"
+
+ContestThread::ContestThread(DeviceBlackboard &_device_blackboard,
+                             const TraceComputer &_source)
+  :WorkerThread("ContestThread", 1000, 100),
+   device_blackboard(_device_blackboard),
+   source(_source),
+   predicted(TracePoint::Invalid()),
+   contest(trace.GetFull(), trace.GetContest(), trace.GetSprint(),
+           TIME_BUDGET),
+   reset_count(0), last_time(0)
+{
+  settings.SetDefaults();
+  stats.Reset();
+}
+
+void
+ContestThread::Update(const ContestSettings &new_settings,
+                      const TracePoint &new_predicted)
+{
+  {
+    const ScopeLock protect(mutex);
+    settings = new_settings;
+    predicted = new_predicted;
+  }
+
+  Trigger();
+}
+
+void
+ContestThread::CopyTrace(bool contest_enabled)
+{
+  source.Lock();
+
+  const Trace &full = source.GetFull();
+  if (source.GetResetCount() != reset_count ||
+      (!full.empty() && full.back().GetTime() < last_time)) {
+    /* the flight has been reset, or there was a time warp: start
+       over */
+    reset_count = source.GetResetCount();
+    last_time = 0;
+    trace.Reset();
+    contest.Reset();
+  }
+
+  /* the newest points are never thinned, so nothing is missed as
+     long as this runs at least every few seconds */
+  for (const TracePoint &point : full) {
+    if (point.GetTime() > last_time || trace.GetFull().empty()) {
+      trace.Append(point, contest_enabled);
+      last_time = point.GetTime();
+    }
+  }
+
+  source.Unlock();
+}
+
+void
+ContestThread::Tick()
+{
+  ContestSettings settings;
+  TracePoint predicted;
+
+  {
+    const ScopeLock protect(mutex);
+    settings = this->settings;
+    predicted = this->predicted;
+  }
+
+  CopyTrace(settings.enable);
+
+  if (!settings.enable)
+    return;
+
+  contest.SetPredicted(predicted);
+  contest.Solve(settings, stats);
+
+  device_blackboard.contest_stats.Publish(stats);
+
+  if (contest.GetTiming().last_tick >= TIME_BUDGET)
+    /* the solvers have used up their budget and will continue on the
+       next call; don't wait for the next trigger */
+    Trigger();
+}
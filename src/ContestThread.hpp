@@ -0,0 +1,122 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#ifndef XCSOAR_CONTEST_THREAD_HPP
+#define XCSOAR_CONTEST_THREAD_HPP
+
+#include "Thread/WorkerThread.hpp"
+#include "Thread/Mutex.hpp"
+#include "Computer/TraceComputer.hpp"
+#include "Computer/ContestComputer.hpp"
+#include "Engine/Contest/Settings.hpp"
+#include "Engine/Contest/ContestStatistics.hpp"
+#include "Engine/Trace/Point.hpp"
+
+class DeviceBlackboard;
+
+/**
+ * The ContestThread runs the (slow) contest optimisation in the
+ * background, so it does not add latency to the CalculationThread.
+ *
+ * It keeps a private copy of the flight trace, which is updated from
+ * the CalculationThread's #TraceComputer at the beginning of each
+ * Tick(); the solvers run on this copy without holding any lock.
+ * The results are published to DeviceBlackboard::contest_stats.
+ */
+class ContestThread final : public WorkerThread {
+  /**
+   * The time budget of one Tick() [us].  Because nobody waits for
+   * this thread, it can be much larger than the budget of the
+   * CalculationThread; it only limits how often new results are
+   * published.
+   */
+  static constexpr unsigned TIME_BUDGET = 250000;
+
+  DeviceBlackboard &device_blackboard;
+
+  /**
+   * The source of new trace points.  Its full trace is read while
+   * holding its mutex.
+   */
+  const TraceComputer &source;
+
+  /**
+   * This mutex protects #settings and #predicted.
+   */
+  Mutex mutex;
+
+  ContestSettings settings;
+
+  TracePoint predicted;
+
+  /**
+   * The private copy of the trace.  Only used by this thread.
+   */
+  TraceComputer trace;
+
+  ContestComputer contest;
+
+  ContestStatistics stats;
+
+  /**
+   * TraceComputer::GetResetCount() of #source when the last point was
+   * copied.
+   */
+  unsigned reset_count;
+
+  /**
+   * The time stamp of the last point copied from #source.
+   */
+  unsigned last_time;
+
+public:
+  ContestThread(DeviceBlackboard &_device_blackboard,
+                const TraceComputer &_source);
+
+  bool Start(bool suspended=false) {
+    if (!WorkerThread::Start(suspended))
+      return false;
+
+    SetIdlePriority();
+    return true;
+  }
+
+  /**
+   * Submit new input and wake up the thread.  This is called by the
+   * CalculationThread after each idle run.
+   *
+   * @param predicted see ContestManager::SetPredicted()
+   */
+  void Update(const ContestSettings &settings, const TracePoint &predicted);
+
+private:
+  /**
+   * Copy new points from #source to #trace.
+   */
+  void CopyTrace(bool contest_enabled);
+
+protected:
+  void Tick() override;
+};
+
+#endif
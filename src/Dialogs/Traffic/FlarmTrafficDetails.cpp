@@ -245,23 +245,23 @@ FlarmTrafficDetailsWidget::Update()
 
   // Try to find the target in the FLARMnet database
   /// @todo: make this code a little more usable
-  const FlarmNetRecord *record = FlarmDetails::LookupRecord(target_id);
-  if (record) {
+  const FlarmNetRecord record = FlarmDetails::LookupRecord(target_id);
+  if (record.IsDefined()) {
     // Fill the pilot name field
-    SetText(PILOT, record->pilot);
+    SetText(PILOT, record.pilot);
 
     // Fill the frequency field
-    if (!StringIsEmpty(record->frequency))
-      value = UnsafeBuildString(tmp, record->frequency.c_str(), _T(" MHz"));
+    if (!StringIsEmpty(record.frequency))
+      value = UnsafeBuildString(tmp, record.frequency, _T(" MHz"));
     else
       value = _T("--");
     SetText(RADIO, value);
 
     // Fill the home airfield field
-    SetText(AIRPORT, record->airfield);
+    SetText(AIRPORT, record.airfield);
 
     // Fill the plane type field
-    SetText(PLANE, record->plane_type);
+    SetText(PLANE, record.plane_type);
   } else {
     // Fill the pilot name field
     SetText(PILOT, _T("--"));
@@ -291,8 +291,8 @@ FlarmTrafficDetailsWidget::Update()
   if (cs != nullptr && cs[0] != 0) {
     StringBuilder<TCHAR> builder(tmp, ARRAY_SIZE(tmp));
     builder.Append(cs);
-    if (record)
-      builder.Append(_T(" ("), record->registration.c_str(), _T(")"));
+    if (record.IsDefined())
+      builder.Append(_T(" ("), record.registration, _T(")"));
     value = tmp;
   } else
     value = _T("--");
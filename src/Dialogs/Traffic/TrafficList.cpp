@@ -89,11 +89,11 @@ class TrafficListWidget : public ListWidget, public DataFieldListener,
     /**
      * Were the attributes below already lazy-loaded from the
      * database?  We can't use nullptr for this, because both will be
-     * nullptr after a failed lookup.
+     * undefined after a failed lookup.
      */
     bool loaded = false;
 
-    const FlarmNetRecord *record;
+    FlarmNetRecord record;
     const TCHAR *callsign;
 
     /**
@@ -168,7 +168,7 @@ class TrafficListWidget : public ListWidget, public DataFieldListener,
         callsign = traffic_databases->FindNameById(id);
 #ifdef HAVE_SKYLINES_TRACKING
       } else if (IsSkyLines()) {
-        record = nullptr;
+        record = FlarmNetRecord::Undefined();
         callsign = nullptr;
 #endif
       } else {
@@ -578,7 +578,7 @@ TrafficListWidget::OnPaintItem(Canvas &canvas, PixelRect rc,
 
   item.AutoLoad();
 
-  const FlarmNetRecord *record = item.record;
+  const FlarmNetRecord &record = item.record;
   const TCHAR *callsign = item.callsign;
 
   const DialogLook &look = UIGlobals::GetDialogLook();
@@ -596,9 +596,9 @@ TrafficListWidget::OnPaintItem(Canvas &canvas, PixelRect rc,
   StaticString<256> tmp;
 
   if (item.IsFlarm()) {
-    if (record != nullptr)
+    if (record.IsDefined())
       tmp.Format(_T("%s - %s - %s"),
-                 callsign, record->registration.c_str(), tmp_id);
+                 callsign, record.registration, tmp_id);
     else if (callsign != nullptr)
       tmp.Format(_T("%s - %s"), callsign, tmp_id);
     else
@@ -659,24 +659,24 @@ TrafficListWidget::OnPaintItem(Canvas &canvas, PixelRect rc,
                                                FormatBearing(item.vector.bearing).c_str());
   }
 
-  if (record != nullptr) {
+  if (record.IsDefined()) {
     tmp.clear();
 
-    if (!record->pilot.empty())
-      tmp = record->pilot.c_str();
+    if (!StringIsEmpty(record.pilot))
+      tmp = record.pilot;
 
-    if (!record->plane_type.empty()) {
+    if (!StringIsEmpty(record.plane_type)) {
       if (!tmp.empty())
         tmp.append(_T(" - "));
 
-      tmp.append(record->plane_type);
+      tmp.append(record.plane_type);
     }
 
-    if (!record->airfield.empty()) {
+    if (!StringIsEmpty(record.airfield)) {
       if (!tmp.empty())
         tmp.append(_T(" - "));
 
-      tmp.append(record->airfield);
+      tmp.append(record.airfield);
     }
 
     if (!tmp.empty())
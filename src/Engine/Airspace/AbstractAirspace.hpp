@@ -239,6 +239,13 @@ public:
     days_of_operation = mask;
   }
 
+  /**
+   * Get the days on which this airspace is active
+   */
+  AirspaceActivity GetDays() const {
+    return days_of_operation;
+  }
+
   /**
    * Get type of airspace
    *
@@ -372,7 +379,7 @@ public:
 
 protected:
   /** Project border */
-  void Project(const FlatProjection &tp);
+  virtual void Project(const FlatProjection &tp);
 
 private:
   /**
@@ -51,6 +51,8 @@ AirspacePolygon::AirspacePolygon(const std::vector<GeoPoint> &pts,
   } else {
     is_convex = TriState::UNKNOWN;
   }
+
+  index.Build(m_border);
 }
 
 const GeoPoint
@@ -82,7 +84,9 @@ AirspacePolygon::GetCenter() const
 bool
 AirspacePolygon::Inside(const GeoPoint &loc) const
 {
-  return m_border.IsInside(loc);
+  return index.IsDefined()
+    ? index.IsInside(loc)
+    : m_border.IsInside(loc);
 }
 
 AirspaceIntersectionVector
@@ -94,6 +98,14 @@ AirspacePolygon::Intersects(const GeoPoint &start, const GeoPoint &end,
 
   AirspaceIntersectSort sorter(start, *this);
 
+  std::vector<double> t;
+  if (index.IsProjected() && index.FindIntersections(ray, t)) {
+    for (const double i : t)
+      sorter.add(i, projection.Unproject(ray.Parametric(i)));
+
+    return sorter.all();
+  }
+
   for (auto it = m_border.begin(); it + 1 != m_border.end(); ++it) {
 
     const FlatRay r_seg(it->GetFlatLocation(), (it + 1)->GetFlatLocation());
@@ -105,6 +117,13 @@ AirspacePolygon::Intersects(const GeoPoint &start, const GeoPoint &end,
   return sorter.all();
 }
 
+void
+AirspacePolygon::Project(const FlatProjection &projection)
+{
+  AbstractAirspace::Project(projection);
+  index.Project(m_border);
+}
+
 GeoPoint
 AirspacePolygon::ClosestPoint(const GeoPoint &loc,
                               const FlatProjection &projection) const
@@ -27,12 +27,25 @@
 #include "AirspaceIntersectionVisitor.hpp"
 #include "AirspaceAircraftPerformance.hpp"
 #include "Task/Stats/TaskStats.hpp"
+#include "Geo/Flat/FlatRay.hpp"
+
+#include <algorithm>
+
+#include <math.h>
 
 #define CRUISE_FILTER_FACT 0.5
 
+/**
+ * The margin [m] around the reach of the prediction vectors which is
+ * included in the candidate list.  The aircraft can travel this far
+ * before the list needs to be rebuilt.
+ */
+static constexpr double CANDIDATE_SKIN = 10000;
+
 AirspaceWarningManager::AirspaceWarningManager(const AirspaceWarningConfig &_config,
                                                const Airspaces &_airspaces)
-  :airspaces(_airspaces), serial(0)
+  :airspaces(_airspaces), serial(0),
+   candidates_range(0), candidates_valid(false), n_intercepts(0)
 {
   /* force filter initialisation in the first SetConfig() call */
   config.warning_time = -1;
@@ -65,6 +78,8 @@ AirspaceWarningManager::Reset(const AircraftState &state)
 {
   ++serial;
   warnings.clear();
+  candidates.clear();
+  candidates_valid = false;
   cruise_filter.Reset(state);
   circling_filter.Reset(state);
 }
@@ -116,6 +131,91 @@ AirspaceWarningManager::GetNewWarningPtr(const AbstractAirspace &airspace)
   return &warnings.back();
 }
 
+unsigned
+AirspaceWarningManager::UpdateCandidates(const GeoPoint &location,
+                                         const FlatGeoPoint &flat_location,
+                                         unsigned reach)
+{
+  if (candidates_valid && candidates_serial == airspaces.GetSerial()) {
+    /* round up to be on the safe side */
+    const unsigned moved = flat_location.Distance(candidates_location) + 1;
+    if (moved + reach <= candidates_range)
+      return moved;
+  }
+
+  const FlatProjection &projection = GetProjection();
+  const double scale = projection.ProjectRangeFloat(location, 1);
+
+  candidates_location = flat_location;
+  candidates_range = reach +
+    projection.ProjectRangeInteger(location, CANDIDATE_SKIN);
+  candidates_serial = airspaces.GetSerial();
+  candidates_valid = true;
+
+  candidates.clear();
+
+  /* the query box is a square; add some margin for rounding errors,
+     and filter by the real distance below */
+  const double range = (candidates_range + 2) / scale;
+  for (const auto &i : airspaces.QueryWithinRange(location, range)) {
+    /* round down to be on the safe side */
+    const unsigned distance = sqrt(double(i.SquareDistanceTo(flat_location)));
+    if (distance <= candidates_range)
+      candidates.emplace_back(i, distance);
+  }
+
+  std::sort(candidates.begin(), candidates.end());
+  return 0;
+}
+
+void
+AirspaceWarningManager::VisitIntersecting(const GeoPoint &location,
+                                          const GeoPoint &end,
+                                          AirspaceIntersectionVisitor &visitor)
+{
+  const FlatProjection &projection = GetProjection();
+  const FlatGeoPoint flat_location = projection.ProjectInteger(location);
+  const FlatGeoPoint flat_end = projection.ProjectInteger(end);
+  const FlatRay ray(flat_location, flat_end);
+
+  const unsigned reach = flat_location.Distance(flat_end) + 1;
+  const unsigned max_distance =
+    UpdateCandidates(location, flat_location, reach) + reach;
+
+  for (const auto &c : candidates) {
+    if (c.distance > max_distance)
+      /* this one and all following candidates cannot be reached by
+         the vector */
+      break;
+
+    const FlatBoundingBox &box = c.airspace;
+    if (box.Intersects(ray) &&
+        visitor.SetIntersections(c.airspace.Intersects(location, end,
+                                                       projection)))
+      visitor.Visit(c.airspace.GetAirspace());
+  }
+}
+
+template<typename F>
+void
+AirspaceWarningManager::VisitInside(const GeoPoint &location, F &&f)
+{
+  const FlatGeoPoint flat_location =
+    GetProjection().ProjectInteger(location);
+
+  const unsigned max_distance =
+    UpdateCandidates(location, flat_location, 0);
+
+  for (const auto &c : candidates) {
+    if (c.distance > max_distance)
+      break;
+
+    const FlatBoundingBox &box = c.airspace;
+    if (box.IsInside(flat_location) && c.airspace.IsInside(location))
+      f(c.airspace.GetAirspace());
+  }
+}
+
 bool 
 AirspaceWarningManager::Update(const AircraftState& state,
                                const GlidePolar &glide_polar,
@@ -175,6 +275,7 @@ class AirspaceIntersectionWarningVisitor final
   bool found;
   const double max_alt;
   bool mode_inside;
+  unsigned n_intercepts;
 
 public:
   /**
@@ -202,7 +303,8 @@ public:
     max_time(_max_time),
     found(false),
     max_alt(_max_alt),
-    mode_inside(false)
+    mode_inside(false),
+    n_intercepts(0)
     {      
     };
 
@@ -224,6 +326,7 @@ public:
 
       AirspaceInterceptSolution solution;
 
+      ++n_intercepts;
       if (mode_inside) {
         solution = airspace.Intercept(state, perf,
                                       state.location, state.location);
@@ -256,6 +359,10 @@ public:
     return found;
   }
 
+  unsigned GetInterceptCount() const {
+    return n_intercepts;
+  }
+
   void SetMode(bool m) {
     mode_inside = m;
   }
@@ -299,15 +406,15 @@ AirspaceWarningManager::UpdatePredicted(const AircraftState& state,
                                              warning_state, max_time_limit,
                                              ceiling);
 
-  airspaces.VisitIntersecting(state.location, location_predicted, visitor);
+  VisitIntersecting(state.location, location_predicted, visitor);
 
   visitor.SetMode(true);
 
-  for (const auto &i : airspaces.QueryInside(state.location)) {
-    const AbstractAirspace &airspace = i.GetAirspace();
-    visitor.Visit(airspace);
-  }
+  VisitInside(state.location, [&visitor](const AbstractAirspace &airspace){
+      visitor.Visit(airspace);
+    });
 
+  n_intercepts += visitor.GetInterceptCount();
   return visitor.Found();
 }
 
@@ -394,15 +501,13 @@ AirspaceWarningManager::UpdateInside(const AircraftState& state,
 
   bool found = false;
 
-  for (const auto &i : airspaces.QueryInside(state.location)) {
-    const AbstractAirspace &airspace = i.GetAirspace();
-
+  VisitInside(state.location, [&](const AbstractAirspace &airspace){
     const AltitudeState &altitude = state;
     if (// ignore inactive airspaces
         !airspace.IsActive() ||
         !config.IsClassEnabled(airspace.GetType()) ||
         !airspace.Inside(altitude))
-      continue;
+      return;
 
     AirspaceWarning *warning = GetWarningPtr(airspace);
 
@@ -412,6 +517,7 @@ AirspaceWarningManager::UpdateInside(const AircraftState& state,
       const AirspaceAircraftPerformance perf_glide(glide_polar);
       const AirspaceInterceptSolution solution =
         airspace.Intercept(state, c, GetProjection(), perf_glide);
+      ++n_intercepts;
 
       if (warning == nullptr)
         warning = GetNewWarningPtr(airspace);
@@ -419,7 +525,7 @@ AirspaceWarningManager::UpdateInside(const AircraftState& state,
       warning->UpdateSolution(AirspaceWarning::WARNING_INSIDE, solution);
       found = true;
     }
-  }
+  });
 
   return found;
 }
@@ -24,16 +24,21 @@
 
 #include "AirspaceWarning.hpp"
 #include "AirspaceWarningConfig.hpp"
+#include "Airspace.hpp"
 #include "Util/AircraftStateFilter.hpp"
+#include "Util/Serial.hpp"
+#include "Geo/Flat/FlatGeoPoint.hpp"
 #include "Compiler.h"
 
 #include <list>
+#include <vector>
 
 class TaskStats;
 class GlidePolar;
 class Airspaces;
 class FlatProjection;
 class AirspaceAircraftPerformance;
+class AirspaceIntersectionVisitor;
 
 /**
  * Class to detect and track airspace warnings
@@ -66,6 +71,49 @@ class AirspaceWarningManager {
    */
   unsigned serial;
 
+  struct Candidate {
+    Airspace airspace;
+
+    /**
+     * The flat distance of the bounding box from
+     * #candidates_location.
+     */
+    unsigned distance;
+
+    Candidate(const Airspace &_airspace, unsigned _distance)
+      :airspace(_airspace), distance(_distance) {}
+
+    bool operator<(const Candidate &other) const {
+      return distance < other.distance;
+    }
+  };
+
+  /**
+   * All airspaces whose bounding box is within #candidates_range of
+   * #candidates_location, sorted by distance.  The checks use this
+   * list instead of querying the whole #Airspaces tree; it is only
+   * rebuilt when the aircraft has moved so far that an airspace
+   * outside of it could be reached by one of the prediction vectors.
+   * Candidates which are farther away than the aircraft could have
+   * flown since then (plus the length of the prediction vector) are
+   * skipped without looking at their geometry.
+   */
+  std::vector<Candidate> candidates;
+  FlatGeoPoint candidates_location;
+  unsigned candidates_range;
+
+  /**
+   * The #Airspaces serial which #candidates was built from.
+   */
+  Serial candidates_serial;
+  bool candidates_valid;
+
+  /**
+   * Number of intercept solutions calculated so far.  For
+   * benchmarking.
+   */
+  unsigned long n_intercepts;
+
 public:
   typedef AirspaceWarningList::const_iterator const_iterator;
 
@@ -98,6 +146,10 @@ public:
     return serial;
   }
 
+  unsigned long GetInterceptCount() const {
+    return n_intercepts;
+  }
+
   /**
    * Reset warning list and filter (as in new flight)
    *
@@ -182,6 +234,8 @@ public:
   void clear() {
     ++serial;
     warnings.clear();
+    candidates.clear();
+    candidates_valid = false;
   }
 
   /**
@@ -267,6 +321,31 @@ private:
   bool UpdateGlide(const AircraftState& state, const GlidePolar &glide_polar);
   bool UpdateInside(const AircraftState& state, const GlidePolar &glide_polar);
 
+  /**
+   * Make sure #candidates contains all airspaces whose bounding box
+   * is within the specified flat distance of the given location.
+   *
+   * @return the flat distance of the location from
+   * #candidates_location
+   */
+  unsigned UpdateCandidates(const GeoPoint &location,
+                            const FlatGeoPoint &flat_location,
+                            unsigned reach);
+
+  /**
+   * Like Airspaces::VisitIntersecting(), but looks only at the
+   * #candidates.
+   */
+  void VisitIntersecting(const GeoPoint &location, const GeoPoint &end,
+                         AirspaceIntersectionVisitor &visitor);
+
+  /**
+   * Like Airspaces::QueryInside(), but looks only at the
+   * #candidates.
+   */
+  template<typename F>
+  void VisitInside(const GeoPoint &location, F &&f);
+
   bool UpdatePredicted(const AircraftState& state, 
                        const GeoPoint &location_predicted,
                        const AirspaceAircraftPerformance &perf,
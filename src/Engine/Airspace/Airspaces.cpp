@@ -100,9 +100,21 @@ Airspaces::Optimise()
     airspace_tree.clear();
   }
 
-  for (AbstractAirspace *i : tmp_as) {
-    Airspace as(*i, task_projection);
-    airspace_tree.insert(as);
+  if (airspace_tree.empty()) {
+    /* building from scratch: bulk-load the tree with the packing
+       algorithm, which is much faster than inserting one by one and
+       yields a better tree */
+    AirspaceVector v;
+    v.reserve(tmp_as.size());
+    for (AbstractAirspace *i : tmp_as)
+      v.emplace_back(*i, task_projection);
+
+    airspace_tree = AirspaceTree(v.begin(), v.end());
+  } else {
+    for (AbstractAirspace *i : tmp_as) {
+      Airspace as(*i, task_projection);
+      airspace_tree.insert(as);
+    }
   }
 
   tmp_as.clear();
@@ -157,6 +169,8 @@ Airspaces::Clear()
 
   // then delete the tree
   airspace_tree.clear();
+
+  ++serial;
 }
 
 unsigned
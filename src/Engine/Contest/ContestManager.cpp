@@ -21,6 +21,7 @@
  */
 
 #include "ContestManager.hpp"
+#include "OS/Clock.hpp"
 
 ContestManager::ContestManager(const Contest _contest,
                                const Trace &trace_full,
@@ -28,6 +29,7 @@ ContestManager::ContestManager(const Contest _contest,
                                const Trace &trace_sprint,
                                bool predict_triangle)
   :contest(_contest),
+   time_budget(0),
    olc_sprint(trace_sprint),
    olc_fai(trace_triangle, predict_triangle),
    olc_classic(trace_full),
@@ -93,11 +95,51 @@ ContestManager::SetHandicap(unsigned handicap)
   net_coupe.SetHandicap(handicap);
 }
 
+/**
+ * Splits the time budget of one UpdateIdle() call among the solvers
+ * of the selected contest.  Time left over by one solver is passed on
+ * to the next one.
+ */
+class TickBudget {
+  /**
+   * The MonotonicClockUS() value at which the whole tick ends; 0
+   * means unlimited.
+   */
+  const uint64_t end;
+
+  unsigned remaining_solvers;
+
+public:
+  TickBudget(uint64_t now, unsigned budget_us, unsigned n_solvers)
+    :end(budget_us > 0 ? now + budget_us : 0),
+     remaining_solvers(n_solvers) {}
+
+  /**
+   * Returns the deadline for the next solver (to be passed to
+   * AbstractContest::SetDeadline()).
+   */
+  uint64_t NextDeadline() {
+    if (end == 0)
+      return 0;
+
+    assert(remaining_solvers > 0);
+
+    const uint64_t now = MonotonicClockUS();
+    const uint64_t deadline = now < end
+      ? now + (end - now) / remaining_solvers
+      : now;
+    --remaining_solvers;
+    return deadline;
+  }
+};
+
 static bool
 RunContest(AbstractContest &_contest,
            ContestResult &result, ContestTraceVector &solution,
-           bool exhaustive)
+           bool exhaustive, uint64_t deadline=0)
 {
+  _contest.SetDeadline(exhaustive ? 0 : deadline);
+
   // run solver, return immediately if further processing is required
   // by subsequent calls
   SolverResult r = _contest.Solve(exhaustive);
@@ -116,33 +158,75 @@ RunContest(AbstractContest &_contest,
   return true;
 }
 
+/**
+ * How many solvers with a long-running search does the contest use?
+ * The time budget is split among them.
+ */
+gcc_const
+static unsigned
+CountSolvers(Contest contest)
+{
+  switch (contest) {
+  case Contest::NONE:
+    return 0;
+
+  case Contest::OLC_PLUS:
+  case Contest::XCONTEST:
+  case Contest::DHV_XC:
+    return 2;
+
+  default:
+    return 1;
+  }
+}
+
 bool
 ContestManager::UpdateIdle(bool exhaustive)
+{
+  const uint64_t start = MonotonicClockUS();
+
+  bool retval = RunSolvers(exhaustive, start);
+
+  timing.AddTick(unsigned(MonotonicClockUS() - start),
+                 stats.GetResult().IsDefined());
+
+  return retval;
+}
+
+bool
+ContestManager::RunSolvers(bool exhaustive, uint64_t now)
 {
   bool retval = false;
 
+  TickBudget budget(now, exhaustive ? 0 : time_budget,
+                    CountSolvers(contest));
+
   switch (contest) {
   case Contest::NONE:
     break;
 
   case Contest::OLC_SPRINT:
     retval = RunContest(olc_sprint, stats.result[0],
-                        stats.solution[0], exhaustive);
+                        stats.solution[0], exhaustive,
+                        budget.NextDeadline());
     break;
 
   case Contest::OLC_FAI:
     retval = RunContest(olc_fai, stats.result[0],
-                        stats.solution[0], exhaustive);
+                        stats.solution[0], exhaustive,
+                        budget.NextDeadline());
     break;
 
   case Contest::OLC_CLASSIC:
     retval = RunContest(olc_classic, stats.result[0],
-                        stats.solution[0], exhaustive);
+                        stats.solution[0], exhaustive,
+                        budget.NextDeadline());
     break;
 
   case Contest::OLC_LEAGUE:
     retval = RunContest(olc_classic, stats.result[1],
-                        stats.solution[1], exhaustive);
+                        stats.solution[1], exhaustive,
+                        budget.NextDeadline());
 
     olc_league.Feed(stats.solution[1]);
 
@@ -152,10 +236,12 @@ ContestManager::UpdateIdle(bool exhaustive)
 
   case Contest::OLC_PLUS:
     retval = RunContest(olc_classic, stats.result[0],
-                        stats.solution[0], exhaustive);
+                        stats.solution[0], exhaustive,
+                        budget.NextDeadline());
 
     retval |= RunContest(olc_fai, stats.result[1],
-                         stats.solution[1], exhaustive);
+                         stats.solution[1], exhaustive,
+                         budget.NextDeadline());
 
     if (retval) {
       olc_plus.Feed(stats.result[0], stats.solution[0],
@@ -169,31 +255,38 @@ ContestManager::UpdateIdle(bool exhaustive)
 
   case Contest::DMST:
     retval = RunContest(dmst_quad, stats.result[0],
-                        stats.solution[0], exhaustive);
+                        stats.solution[0], exhaustive,
+                        budget.NextDeadline());
     break;
 
   case Contest::XCONTEST:
     retval = RunContest(xcontest_free, stats.result[0],
-                        stats.solution[0], exhaustive);
+                        stats.solution[0], exhaustive,
+                        budget.NextDeadline());
     retval |= RunContest(xcontest_triangle, stats.result[1],
-                         stats.solution[1], exhaustive);
+                         stats.solution[1], exhaustive,
+                         budget.NextDeadline());
     break;
 
   case Contest::DHV_XC:
     retval = RunContest(dhv_xc_free, stats.result[0],
-                        stats.solution[0], exhaustive);
+                        stats.solution[0], exhaustive,
+                        budget.NextDeadline());
     retval |= RunContest(dhv_xc_triangle, stats.result[1],
-                         stats.solution[1], exhaustive);
+                         stats.solution[1], exhaustive,
+                         budget.NextDeadline());
     break;
 
   case Contest::SIS_AT:
     retval = RunContest(sis_at, stats.result[0],
-                        stats.solution[0], exhaustive);
+                        stats.solution[0], exhaustive,
+                        budget.NextDeadline());
     break;
 
   case Contest::NET_COUPE:
     retval = RunContest(net_coupe, stats.result[0],
-                        stats.solution[0], exhaustive);
+                        stats.solution[0], exhaustive,
+                        budget.NextDeadline());
     break;
 
   };
@@ -205,6 +298,7 @@ void
 ContestManager::Reset()
 {
   stats.Reset();
+  timing.Reset();
   olc_sprint.Reset();
   olc_fai.Reset();
   olc_classic.Reset();
@@ -35,6 +35,7 @@
 #include "Solvers/OLCSISAT.hpp"
 #include "Solvers/NetCoupe.hpp"
 #include "ContestStatistics.hpp"
+#include "ContestTiming.hpp"
 
 class Trace;
 
@@ -49,6 +50,14 @@ class ContestManager
 
   ContestStatistics stats;
 
+  ContestTiming timing;
+
+  /**
+   * The time budget of one non-exhaustive UpdateIdle() call [us].  0
+   * means the solvers use their fixed step limits instead.
+   */
+  unsigned time_budget;
+
   OLCSprint olc_sprint;
   OLCFAI olc_fai;
   OLCClassic olc_classic;
@@ -96,6 +105,19 @@ public:
 
   void SetHandicap(unsigned handicap);
 
+  /**
+   * Limit the duration of each non-exhaustive UpdateIdle() call.  The
+   * budget is split among the solvers of the selected contest; each
+   * of them suspends its search when its share is used up, and
+   * resumes it on the next call.
+   *
+   * @param budget_us the budget in microseconds; 0 restores the fixed
+   * step limits
+   */
+  void SetTimeBudget(unsigned budget_us) {
+    time_budget = budget_us;
+  }
+
   /**
    * Update internal states (non-essential) for housework,
    * or where functions are slow and would cause loss to real-time performance.
@@ -106,6 +128,11 @@ public:
    */
   bool UpdateIdle(bool exhaustive = false);
 
+private:
+  bool RunSolvers(bool exhaustive, uint64_t now);
+
+public:
+
   bool SolveExhaustive() {
     return UpdateIdle(true);
   }
@@ -130,6 +157,10 @@ public:
   const ContestStatistics &GetStats() const {
     return stats;
   }
+
+  const ContestTiming &GetTiming() const {
+    return timing;
+  }
 };
 
 #endif
@@ -0,0 +1,94 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#ifndef CONTEST_TIMING_HPP
+#define CONTEST_TIMING_HPP
+
+#include "Util/TypeTraits.hpp"
+
+#include <stdint.h>
+
+/**
+ * Run time statistics of the contest solvers, collected by
+ * ContestManager::UpdateIdle().  All durations are in microseconds.
+ */
+struct ContestTiming
+{
+  /**
+   * Number of UpdateIdle() calls since the last reset.
+   */
+  unsigned ticks;
+
+  /**
+   * Duration of the most recent and of the longest call.
+   */
+  unsigned last_tick, max_tick;
+
+  /**
+   * Accumulated duration of all calls.
+   */
+  uint64_t total;
+
+  /**
+   * Accumulated solver time and number of calls until the first
+   * valid solution was found.  Both are zero as long as there is
+   * none.
+   */
+  uint64_t first_solution;
+  unsigned first_solution_ticks;
+
+  void Reset() {
+    ticks = 0;
+    last_tick = max_tick = 0;
+    total = 0;
+    first_solution = 0;
+    first_solution_ticks = 0;
+  }
+
+  bool HasSolution() const {
+    return first_solution_ticks > 0;
+  }
+
+  unsigned GetAverageTick() const {
+    return ticks > 0
+      ? unsigned(total / ticks)
+      : 0;
+  }
+
+  void AddTick(unsigned duration, bool valid) {
+    ++ticks;
+    last_tick = duration;
+    if (duration > max_tick)
+      max_tick = duration;
+    total += duration;
+
+    if (valid && !HasSolution()) {
+      first_solution = total;
+      first_solution_ticks = ticks;
+    }
+  }
+};
+
+static_assert(is_trivial_ndebug<ContestTiming>::value, "type is not trivial");
+
+#endif
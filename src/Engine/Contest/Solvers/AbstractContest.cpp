@@ -22,10 +22,12 @@ Copyright_License {
 */
 
 #include "ContestDijkstra.hpp"
+#include "OS/Clock.hpp"
 
 AbstractContest::AbstractContest(const unsigned _finish_alt_diff)
   :handicap(100),
-   finish_alt_diff(_finish_alt_diff)
+   finish_alt_diff(_finish_alt_diff),
+   deadline_us(0)
 {
 }
 
@@ -42,6 +44,12 @@ AbstractContest::UpdateScore()
   return false;
 }
 
+bool
+AbstractContest::IsDeadlineExpired() const
+{
+  return HasDeadline() && MonotonicClockUS() >= deadline_us;
+}
+
 bool
 AbstractContest::SaveSolution()
 {
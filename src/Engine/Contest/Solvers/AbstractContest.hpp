@@ -29,6 +29,7 @@
 #include "PathSolvers/SolverResult.hpp"
 
 #include <assert.h>
+#include <stdint.h>
 
 class TracePoint;
 
@@ -42,6 +43,13 @@ class AbstractContest {
   ContestResult best_result;
   ContestTraceVector best_solution;
 
+  /**
+   * The MonotonicClockUS() value at which a non-exhaustive Solve()
+   * call shall suspend itself.  0 means there is no deadline, and
+   * the solver falls back to its fixed per-call step limit.
+   */
+  uint64_t deadline_us;
+
 public:
   /**
    * Constructor
@@ -64,6 +72,18 @@ public:
    *
    * @return True is solution was found, False otherwise
    */
+  /**
+   * Limit the duration of the following non-exhaustive Solve()
+   * calls.  The solver suspends its search when the deadline has
+   * passed, and resumes it on the next call.
+   *
+   * @param _deadline_us a MonotonicClockUS() value; 0 removes the
+   * limit
+   */
+  void SetDeadline(uint64_t _deadline_us) {
+    deadline_us = _deadline_us;
+  }
+
   const ContestResult &GetBestResult() const {
     return best_result;
   }
@@ -110,6 +130,17 @@ protected:
    */
   virtual bool UpdateScore();
 
+  bool HasDeadline() const {
+    return deadline_us != 0;
+  }
+
+  /**
+   * Has the deadline set by SetDeadline() passed?  Always returns
+   * false if there is no deadline.
+   */
+  gcc_pure
+  bool IsDeadlineExpired() const;
+
   bool IsFinishAltitudeValid(const TracePoint& start,
                              const TracePoint& finish) const;
 
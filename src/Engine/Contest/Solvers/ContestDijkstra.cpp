@@ -126,7 +126,17 @@ ContestDijkstra::Solve(bool exhaustive)
       return SolverResult::FAILED;
   }
 
-  SolverResult result = DistanceGeneral(exhaustive ? 0 - 1 : 25);
+  SolverResult result;
+  if (exhaustive)
+    result = DistanceGeneral();
+  else
+    /* continue in small steps until the deadline passes; without a
+       deadline, one step per call is all we get */
+    do {
+      result = DistanceGeneral(25);
+    } while (result == SolverResult::INCOMPLETE &&
+             HasDeadline() && !IsDeadlineExpired());
+
   if (result != SolverResult::INCOMPLETE) {
     if (incremental && continuous)
       /* enable the incremental solver, which considers the existing
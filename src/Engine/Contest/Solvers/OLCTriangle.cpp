@@ -352,6 +352,11 @@ OLCTriangle::RunBranchAndBound(unsigned from, unsigned to, unsigned worst_d, boo
   if (!exhaustive && predict)
     max_iterations = tick_iterations;
 
+  /* a suspended run keeps its tree and continues on the next call,
+     so only the predictive, non-exhaustive mode may be cut short by
+     the deadline */
+  const bool check_deadline = !exhaustive && predict && HasDeadline();
+
   while (!branch_and_bound.empty()) {
     /* now loop over the tree, branching each found candidate set, adding the branch if it's feasible.
      * remove all candidate sets with d_max smaller than d_min of the largest integral candidate set
@@ -364,6 +369,10 @@ OLCTriangle::RunBranchAndBound(unsigned from, unsigned to, unsigned worst_d, boo
     if (iterations > max_iterations || branch_and_bound.size() > max_tree_size)
       break;
 
+    // querying the clock is not free; check the deadline only every 64 iterations
+    if (check_deadline && iterations % 64 == 0 && IsDeadlineExpired())
+      break;
+
     // first clean up tree, removeing all nodes with d_max < worst_d
     branch_and_bound.erase(branch_and_bound.begin(), branch_and_bound.lower_bound(worst_d));
 
@@ -27,7 +27,23 @@
 #include "Math/ZeroFinder.hpp"
 #include "Util/Tolerances.hpp"
 
+#include <algorithm>
+
 #include <assert.h>
+#include <math.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define MACCREADY_NEON
+#endif
+
+/**
+ * The number of tasks solved per pass in SolveBatch(); the
+ * intermediate speed arrays live on the stack.
+ */
+static constexpr unsigned BATCH_SIZE = 64;
 
 MacCready::MacCready(const GlideSettings &_settings,
                      const GlidePolar &_glide_polar,
@@ -62,6 +78,7 @@ MacCready::SolveVertical(const GlideState &task) const
     result.height_climb = 0;
     result.height_glide = 0;
     result.time_elapsed = 0;
+    result.time_virtual = 0;
     result.validity = GlideResult::Validity::OK;
     return result;
   }
@@ -111,8 +128,26 @@ MacCready::SolveSink(const GlideSettings &settings,
   return mac.SolveSink(task, sink_rate);
 }
 
+double
+MacCready::GetClimbCruiseSpeed() const
+{
+  // quotient of cruise speed over resulting speed, see SolveCruise()
+  const auto rho_plus_one =
+    1 + glide_polar.GetSBestLD() * glide_polar.GetInvMC();
+  const auto inv_rho_plus_one = 1. / rho_plus_one;
+
+  return glide_polar.GetVBestLD() * cruise_efficiency * inv_rho_plus_one;
+}
+
 GlideResult
 MacCready::SolveCruise(const GlideState &task) const
+{
+  return SolveCruise(task, task.CalcAverageSpeed(GetClimbCruiseSpeed()));
+}
+
+GlideResult
+MacCready::SolveCruise(const GlideState &task,
+                       const double estimated_speed) const
 {
   // cruise speed for current MC (m/s)
   const auto mc_speed = glide_polar.GetVBestLD();
@@ -152,8 +187,6 @@ MacCready::SolveCruise(const GlideState &task) const
   // quotient of resulting speed over cruise speed (0 .. 1)
   const auto inv_rho_plus_one = 1. / rho_plus_one;
 
-  const auto estimated_speed =
-      task.CalcAverageSpeed(mc_speed * cruise_efficiency * inv_rho_plus_one);
   if (estimated_speed <= 0) {
     result.validity = GlideResult::Validity::WIND_EXCESSIVE;
     result.vector.distance = 0;
@@ -197,15 +230,24 @@ GlideResult
 MacCready::SolveGlide(const GlideState &task, const double v_set,
                       const double sink_rate, const bool allow_partial) const
 {
-  // spend a lot of time in this function, so it should be quick!
-
-  GlideResult result(task, v_set);
-
   // distance relation
   //   V*V=Vn*Vn+W*W-2*Vn*W*cos(theta)
   //     Vn*Vn-2*Vn*W*cos(theta)+W*W-V*V=0  ... (1)
 
-  const auto estimated_speed = task.CalcAverageSpeed(v_set * cruise_efficiency);
+  return SolveGlide(task, v_set, sink_rate,
+                    task.CalcAverageSpeed(v_set * cruise_efficiency),
+                    allow_partial);
+}
+
+GlideResult
+MacCready::SolveGlide(const GlideState &task, const double v_set,
+                      const double sink_rate, const double estimated_speed,
+                      const bool allow_partial) const
+{
+  // spend a lot of time in this function, so it should be quick!
+
+  GlideResult result(task, v_set);
+
   if (estimated_speed <= 0) {
     result.validity = GlideResult::Validity::WIND_EXCESSIVE;
     result.vector.distance = 0;
@@ -318,6 +360,210 @@ MacCready::Solve(const GlideState &task) const
   return result_fg;
 }
 
+/**
+ * Scalar version of GlideState::CalcAverageSpeed() with the
+ * #AverageSpeedSolver quadratic expanded.
+ */
+static inline double
+CalcAverageSpeed(double head_wind, double wind_speed, double v_eff)
+{
+  if (wind_speed <= 0)
+    return v_eff;
+
+  const double b = 2 * head_wind;
+  const double denom = b * b - 4 * (wind_speed * wind_speed - v_eff * v_eff);
+  return denom >= 0
+    ? (-b + sqrt(denom)) / 2
+    : -1;
+}
+
+#if defined(__SSE2__)
+
+static inline __m128d
+CalcAverageSpeed(__m128d head_wind, __m128d wind_speed, __m128d v_eff)
+{
+  const __m128d zero = _mm_setzero_pd();
+  const __m128d b = _mm_add_pd(head_wind, head_wind);
+  const __m128d c = _mm_sub_pd(_mm_mul_pd(wind_speed, wind_speed),
+                               _mm_mul_pd(v_eff, v_eff));
+  const __m128d denom = _mm_sub_pd(_mm_mul_pd(b, b),
+                                   _mm_mul_pd(_mm_set1_pd(4), c));
+
+  /* the square root of a negative denominator is NaN, but that lane
+     is replaced with -1 below */
+  __m128d speed = _mm_mul_pd(_mm_add_pd(_mm_sub_pd(zero, b),
+                                        _mm_sqrt_pd(denom)),
+                             _mm_set1_pd(0.5));
+
+  const __m128d real = _mm_cmpge_pd(denom, zero);
+  speed = _mm_or_pd(_mm_and_pd(real, speed),
+                    _mm_andnot_pd(real, _mm_set1_pd(-1)));
+
+  const __m128d windy = _mm_cmpgt_pd(wind_speed, zero);
+  return _mm_or_pd(_mm_and_pd(windy, speed),
+                   _mm_andnot_pd(windy, v_eff));
+}
+
+#elif defined(MACCREADY_NEON)
+
+static inline float64x2_t
+CalcAverageSpeed(float64x2_t head_wind, float64x2_t wind_speed,
+                 float64x2_t v_eff)
+{
+  const float64x2_t zero = vdupq_n_f64(0);
+  const float64x2_t b = vaddq_f64(head_wind, head_wind);
+  const float64x2_t c = vsubq_f64(vmulq_f64(wind_speed, wind_speed),
+                                  vmulq_f64(v_eff, v_eff));
+  const float64x2_t denom = vsubq_f64(vmulq_f64(b, b),
+                                      vmulq_f64(vdupq_n_f64(4), c));
+
+  float64x2_t speed = vmulq_f64(vaddq_f64(vnegq_f64(b), vsqrtq_f64(denom)),
+                                vdupq_n_f64(0.5));
+  speed = vbslq_f64(vcgeq_f64(denom, zero), speed, vdupq_n_f64(-1));
+
+  return vbslq_f64(vcgtq_f64(wind_speed, zero), speed, v_eff);
+}
+
+#endif
+
+void
+MacCready::CalcAverageSpeeds(const GlideState *tasks, unsigned n,
+                             double *glide_speed, double *cruise_speed) const
+{
+  const double v_glide = glide_polar.GetVBestLD() * cruise_efficiency;
+  const double v_cruise = cruise_speed != nullptr
+    ? GetClimbCruiseSpeed()
+    : 0;
+
+  unsigned i = 0;
+
+#if defined(__SSE2__)
+  const __m128d vv_glide = _mm_set1_pd(v_glide);
+  const __m128d vv_cruise = _mm_set1_pd(v_cruise);
+
+  for (; i + 2 <= n; i += 2) {
+    const __m128d head_wind = _mm_set_pd(tasks[i + 1].head_wind,
+                                         tasks[i].head_wind);
+    const __m128d wind_speed = _mm_set_pd(tasks[i + 1].wind.norm,
+                                          tasks[i].wind.norm);
+
+    _mm_storeu_pd(glide_speed + i,
+                  CalcAverageSpeed(head_wind, wind_speed, vv_glide));
+    if (cruise_speed != nullptr)
+      _mm_storeu_pd(cruise_speed + i,
+                    CalcAverageSpeed(head_wind, wind_speed, vv_cruise));
+  }
+#elif defined(MACCREADY_NEON)
+  const float64x2_t vv_glide = vdupq_n_f64(v_glide);
+  const float64x2_t vv_cruise = vdupq_n_f64(v_cruise);
+
+  for (; i + 2 <= n; i += 2) {
+    const double hw[2] = { tasks[i].head_wind, tasks[i + 1].head_wind };
+    const double ws[2] = { tasks[i].wind.norm, tasks[i + 1].wind.norm };
+    const float64x2_t head_wind = vld1q_f64(hw);
+    const float64x2_t wind_speed = vld1q_f64(ws);
+
+    vst1q_f64(glide_speed + i,
+              CalcAverageSpeed(head_wind, wind_speed, vv_glide));
+    if (cruise_speed != nullptr)
+      vst1q_f64(cruise_speed + i,
+                CalcAverageSpeed(head_wind, wind_speed, vv_cruise));
+  }
+#endif
+
+  for (; i < n; ++i) {
+    glide_speed[i] = ::CalcAverageSpeed(tasks[i].head_wind,
+                                        tasks[i].wind.norm, v_glide);
+    if (cruise_speed != nullptr)
+      cruise_speed[i] = ::CalcAverageSpeed(tasks[i].head_wind,
+                                           tasks[i].wind.norm, v_cruise);
+  }
+}
+
+void
+MacCready::SolveBatch(const GlideState *tasks, GlideResult *results,
+                      unsigned n) const
+{
+  if (!glide_polar.IsValid() || glide_polar.GetMC() <= 0) {
+    /* no climb-cruise: fall back to the scalar solver, which
+       iterates for the optimum glide speed */
+    for (unsigned i = 0; i < n; ++i)
+      results[i] = Solve(tasks[i]);
+    return;
+  }
+
+  const auto v_best = glide_polar.GetVBestLD();
+  const auto sink_rate = glide_polar.SinkRate(v_best);
+
+  double glide_speed[BATCH_SIZE], cruise_speed[BATCH_SIZE];
+
+  while (n > 0) {
+    const unsigned chunk = std::min(n, BATCH_SIZE);
+    CalcAverageSpeeds(tasks, chunk, glide_speed, cruise_speed);
+
+    /* the remaining logic is the same as in Solve() */
+    for (unsigned i = 0; i < chunk; ++i) {
+      const GlideState &task = tasks[i];
+      GlideResult &result = results[i];
+
+      if (task.vector.distance <= 0) {
+        result = SolveVertical(task);
+        continue;
+      }
+
+      if (task.altitude_difference < 0) {
+        result = SolveCruise(task, cruise_speed[i]);
+        continue;
+      }
+
+      result = SolveGlide(task, v_best, sink_rate, glide_speed[i], true);
+      if (result.validity == GlideResult::Validity::OK &&
+          task.vector.distance - result.vector.distance <= 0)
+        continue;
+
+      GlideState sub_task = task;
+      sub_task.vector.distance -= result.vector.distance;
+      sub_task.altitude_difference -= result.height_glide;
+
+      result.Add(SolveCruise(sub_task, cruise_speed[i]));
+    }
+
+    tasks += chunk;
+    results += chunk;
+    n -= chunk;
+  }
+}
+
+void
+MacCready::SolveStraightBatch(const GlideState *tasks, GlideResult *results,
+                              unsigned n) const
+{
+  if (!glide_polar.IsValid() || glide_polar.GetMC() <= 0) {
+    for (unsigned i = 0; i < n; ++i)
+      results[i] = SolveStraight(tasks[i]);
+    return;
+  }
+
+  const auto v_best = glide_polar.GetVBestLD();
+  const auto sink_rate = glide_polar.SinkRate(v_best);
+
+  double glide_speed[BATCH_SIZE];
+
+  while (n > 0) {
+    const unsigned chunk = std::min(n, BATCH_SIZE);
+    CalcAverageSpeeds(tasks, chunk, glide_speed, nullptr);
+
+    for (unsigned i = 0; i < chunk; ++i)
+      results[i] = tasks[i].vector.distance <= 0
+        ? SolveVertical(tasks[i])
+        : SolveGlide(tasks[i], v_best, sink_rate, glide_speed[i], false);
+
+    tasks += chunk;
+    results += chunk;
+    n -= chunk;
+  }
+}
+
 /**
  * Class used to find VOpt to optimize glide distance, for final glide
  * calculations.  Intended to be used temporarily only.
@@ -104,6 +104,25 @@ public:
                            const GlidePolar &glide_polar,
                            const GlideState &task);
 
+  /**
+   * Batch version of Solve(): calculates the glide solutions of @a n
+   * tasks which share this glide polar.  The polar lookups are done
+   * once, and the cruise speed over ground (the square root in
+   * GlideState::CalcAverageSpeed()) is calculated for several tasks
+   * at once.  The results agree with those of Solve().
+   *
+   * @param tasks An array of @a n tasks
+   * @param results An array receiving @a n solutions
+   */
+  void SolveBatch(const GlideState *tasks, GlideResult *results,
+                  unsigned n) const;
+
+  /**
+   * Batch version of SolveStraight(), see SolveBatch().
+   */
+  void SolveStraightBatch(const GlideState *tasks, GlideResult *results,
+                          unsigned n) const;
+
   /**
    * Calculates the glide solution for a classical MacCready theory task
    * with no climb component (pure glide).  This is used internally to
@@ -143,6 +162,34 @@ private:
              const double sink_rate,
              const bool allow_partial = false) const;
 
+  /**
+   * Like SolveGlide(), but with a precalculated cruise speed over
+   * ground.
+   *
+   * @param estimated_speed The return value of
+   * GlideState::CalcAverageSpeed() for the effective cruise speed
+   */
+  gcc_pure
+  GlideResult
+  SolveGlide(const GlideState &task, const double v_set,
+             const double sink_rate, const double estimated_speed,
+             const bool allow_partial) const;
+
+  /**
+   * Returns the effective speed of a climb-cruise, i.e. the cruise
+   * speed reduced by the time spent climbing, without wind.
+   */
+  gcc_pure
+  double GetClimbCruiseSpeed() const;
+
+  /**
+   * Calculate the cruise speeds over ground of the given tasks at
+   * the best LD speed (#glide_speed) and in climb-cruise
+   * (#cruise_speed, only if #cruise_speed is not nullptr).
+   */
+  void CalcAverageSpeeds(const GlideState *tasks, unsigned n,
+                         double *glide_speed, double *cruise_speed) const;
+
   /**
    * Solve a task which is known to be pure glide,
    * seeking optimal speed to fly.
@@ -180,6 +227,17 @@ private:
    */
   gcc_pure
   GlideResult SolveCruise(const GlideState &task) const;
+
+  /**
+   * Like SolveCruise(), but with a precalculated cruise speed over
+   * ground.
+   *
+   * @param estimated_speed The return value of
+   * GlideState::CalcAverageSpeed() for GetClimbCruiseSpeed()
+   */
+  gcc_pure
+  GlideResult SolveCruise(const GlideState &task,
+                          double estimated_speed) const;
 };
 
 #endif
@@ -28,68 +28,79 @@
 #include "Airspace/Predicate/AirspacePredicate.hpp"
 #include "Geo/Flat/FlatRay.hpp"
 
+/**
+ * Limit the size of the caches; if they get this big, most entries
+ * are probably stale links to previous aircraft locations.
+ */
+static constexpr size_t MAX_CACHE_SIZE = 20000;
+
 // Airspace query helpers
 
 /**
- * Find airspace and location of nearest intercept
+ * Collect all airspaces crossed by a segment, and the first
+ * intersection with each.
  */
-class AIV final : public AirspaceIntersectionVisitor {
-public:
-  typedef std::pair<const AbstractAirspace *, RoutePoint> AIVResult;
-
-private:
-  const RouteLink &link;
-  double min_distance;
-  const FlatProjection &proj;
-  const RoutePolars &rpolar;
-  AIVResult nearest;
+class ObstacleCollector final : public AirspaceIntersectionVisitor {
+  std::vector<std::pair<const AbstractAirspace *, GeoPoint>> &list;
 
 public:
-  AIV(const RouteLink &_e,
-      const FlatProjection &_proj,
-      const RoutePolars &_rpolar)
-   :link(_e),
-    min_distance(-1),
-    proj(_proj),
-    rpolar(_rpolar),
-    nearest((const AbstractAirspace *)nullptr, _e.first) {}
+  explicit ObstacleCollector(std::vector<std::pair<const AbstractAirspace *,
+                                                   GeoPoint>> &_list)
+    :list(_list) {}
 
   void Visit(const AbstractAirspace &as) override {
     assert(!intersections.empty());
 
-    GeoPoint point = intersections[0].first;
+    list.emplace_back(&as, intersections[0].first);
+  }
+};
+
+const AirspaceRoute::ObstacleList &
+AirspaceRoute::GetObstacles(const FlatGeoPoint &a, const FlatGeoPoint &b) const
+{
+  const Segment key(a, b);
+  auto i = visibility.find(key);
+  if (i != visibility.end())
+    return i->second;
+
+  if (visibility.size() >= MAX_CACHE_SIZE)
+    visibility.clear();
+
+  ObstacleList &list = visibility[key];
+  ObstacleCollector visitor(list);
+  m_airspaces.VisitIntersecting(projection.Unproject(a),
+                                projection.Unproject(b), visitor);
+  ++count_airspace;
+  return list;
+}
+
+AirspaceRoute::RouteAirspaceIntersection
+AirspaceRoute::FirstIntersecting(const RouteLink &e) const
+{
+  double min_distance = -1;
+  RouteAirspaceIntersection nearest(nullptr, e.first);
+
+  /* find the airspace and location of the nearest intercept */
+  for (const auto &i : GetObstacles(e.first, e.second)) {
+    const AbstractAirspace &as = *i.first;
 
-    RouteLink l =
-      rpolar.GenerateIntermediate(link.first,
-                                  RoutePoint(proj.ProjectInteger(point),
-                                             link.second.altitude),
-                                  proj);
+    const RouteLink l =
+      rpolars_route.GenerateIntermediate(e.first,
+                                         RoutePoint(projection.ProjectInteger(i.second),
+                                                    e.second.altitude),
+                                         projection);
 
     if (l.second.altitude < as.GetBase().altitude ||
         l.second.altitude > as.GetTop().altitude)
-      return;
+      continue;
 
     if (min_distance < 0 || l.d < min_distance) {
       min_distance = l.d;
-      nearest = std::make_pair(&as, l.second);
+      nearest = RouteAirspaceIntersection(&as, l.second);
     }
   }
 
-  AIVResult GetNearest() const {
-    return nearest;
-  }
-};
-
-AirspaceRoute::RouteAirspaceIntersection
-AirspaceRoute::FirstIntersecting(const RouteLink &e) const
-{
-  const GeoPoint origin(projection.Unproject(e.first));
-  const GeoPoint dest(projection.Unproject(e.second));
-  AIV visitor(e, projection, rpolars_route);
-  m_airspaces.VisitIntersecting(origin, dest, visitor);
-  const AIV::AIVResult res(visitor.GetNearest());
-  ++count_airspace;
-  return RouteAirspaceIntersection(res.first, res.second);
+  return nearest;
 }
 
 const AbstractAirspace *
@@ -149,12 +160,26 @@ AirspaceRoute::FindClearingPair(const SearchPointVector &spv,
 }
 
 AirspaceRoute::ClearingPair
-AirspaceRoute::GetPairs(const SearchPointVector &spv,
+AirspaceRoute::GetPairs(const AbstractAirspace &airspace,
+                        const SearchPointVector &spv,
                         const RoutePoint &start, const RoutePoint &dest) const
 {
-  SearchPointVector::const_iterator i_closest = spv.NearestIndexConvex(start);
-  SearchPointVector::const_iterator i_furthest = spv.NearestIndexConvex(dest);
-  return FindClearingPair(spv, i_closest, i_furthest, start);
+  const ClearingKey key{&airspace, Segment(start, dest)};
+  auto i = clearing_pairs.find(key);
+  if (i == clearing_pairs.end()) {
+    if (clearing_pairs.size() >= MAX_CACHE_SIZE)
+      clearing_pairs.clear();
+
+    SearchPointVector::const_iterator i_closest = spv.NearestIndexConvex(start);
+    SearchPointVector::const_iterator i_furthest = spv.NearestIndexConvex(dest);
+    const ClearingPair p = FindClearingPair(spv, i_closest, i_furthest, start);
+    i = clearing_pairs.emplace(key, Segment(p.first, p.second)).first;
+  }
+
+  /* the result depends only on the projected locations; the
+     altitude is always the one of "start" */
+  return ClearingPair(AFlatGeoPoint(i->second.first, start.altitude),
+                      AFlatGeoPoint(i->second.second, start.altitude));
 }
 
 AirspaceRoute::ClearingPair
@@ -180,7 +205,8 @@ AirspaceRoute::AirspaceSize() const
   return m_airspaces.GetSize();
 }
 
-AirspaceRoute::AirspaceRoute():m_airspaces(false)
+AirspaceRoute::AirspaceRoute()
+  :m_airspaces(false), cache_center(GeoPoint::Invalid())
 {
   Reset();
 }
@@ -195,10 +221,30 @@ void
 AirspaceRoute::Reset()
 {
   RoutePlanner::Reset();
+  ClearCache();
   m_airspaces.ClearClearances();
   m_airspaces.Clear();
 }
 
+void
+AirspaceRoute::ClearCache()
+{
+  visibility.clear();
+  clearing_pairs.clear();
+}
+
+void
+AirspaceRoute::ValidateCache()
+{
+  if (cache_serial == m_airspaces.GetSerial() &&
+      cache_center == projection.GetCenter())
+    return;
+
+  ClearCache();
+  cache_serial = m_airspaces.GetSerial();
+  cache_center = projection.GetCenter();
+}
+
 void
 AirspaceRoute::Synchronise(const Airspaces &master,
                            const AirspacePredicate &_condition,
@@ -231,7 +277,7 @@ AirspaceRoute::AddNearbyAirspace(const RouteAirspaceIntersection &inx,
 {
   const SearchPointVector &fat =
     inx.airspace->GetClearance(m_airspaces.GetProjection());
-  const ClearingPair p = GetPairs(fat, e.first, e.second);
+  const ClearingPair p = GetPairs(*inx.airspace, fat, e.first, e.second);
   const ClearingPair pb = GetBackupPairs(fat, e.first, inx.point);
 
   // process all options
@@ -301,6 +347,8 @@ AirspaceRoute::OnSolve(const AGeoPoint &origin, const AGeoPoint &destination)
   } else {
     projection = m_airspaces.GetProjection();
   }
+
+  ValidateCache();
 }
 
 /*
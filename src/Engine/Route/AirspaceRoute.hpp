@@ -25,6 +25,10 @@
 
 #include "RoutePlanner.hpp"
 #include "Airspace/Airspaces.hpp"
+#include "Util/Serial.hpp"
+
+#include <unordered_map>
+#include <vector>
 
 class AirspaceRoute : public RoutePlanner {
   Airspaces m_airspaces;
@@ -44,6 +48,62 @@ class AirspaceRoute : public RoutePlanner {
 
   mutable RouteAirspaceIntersection m_inx;
 
+  /**
+   * The airspaces crossed by a line segment, and the first
+   * intersection point with each.
+   */
+  typedef std::vector<std::pair<const AbstractAirspace *, GeoPoint>> ObstacleList;
+
+  typedef std::pair<FlatGeoPoint, FlatGeoPoint> Segment;
+
+  struct SegmentHasher {
+    gcc_const
+    size_t operator()(const Segment &s) const {
+      return (s.first.x * size_t(104729) + s.first.y) * size_t(27644437) +
+        s.second.x * size_t(104729) + s.second.y;
+    }
+  };
+
+  /**
+   * The visibility graph between the points the planner has tried so
+   * far: the airspaces crossed by each segment, in the order
+   * Airspaces::VisitIntersecting() reports them.  This is pure
+   * geometry, independent of altitudes and polars, so it remains
+   * valid across Solve() calls until the airspace set (which depends
+   * on the altitude band, see Synchronise()) or the projection
+   * changes.
+   */
+  mutable std::unordered_map<Segment, ObstacleList, SegmentHasher> visibility;
+
+  /**
+   * The result of GetPairs() for an airspace and a segment; again,
+   * only the projected locations are cached.
+   */
+  struct ClearingKey {
+    const AbstractAirspace *airspace;
+    Segment segment;
+
+    bool operator==(const ClearingKey &other) const {
+      return airspace == other.airspace && segment == other.segment;
+    }
+  };
+
+  struct ClearingKeyHasher {
+    gcc_const
+    size_t operator()(const ClearingKey &k) const {
+      return size_t(k.airspace) ^ SegmentHasher()(k.segment);
+    }
+  };
+
+  mutable std::unordered_map<ClearingKey, Segment,
+                             ClearingKeyHasher> clearing_pairs;
+
+  /**
+   * The airspace serial and projection the caches were built for.
+   */
+  Serial cache_serial;
+  GeoPoint cache_center;
+
 public:
   friend class PrintHelper;
 
@@ -76,6 +136,21 @@ private:
 
   RouteAirspaceIntersection FirstIntersecting(const RouteLink &e) const;
 
+  /**
+   * Look up the airspaces crossed by the segment in the visibility
+   * cache, querying the airspace tree on a miss.
+   */
+  const ObstacleList &GetObstacles(const FlatGeoPoint &a,
+                                   const FlatGeoPoint &b) const;
+
+  /**
+   * Discard the cached geometry if the airspace set or the projection
+   * has changed.
+   */
+  void ValidateCache();
+
+  void ClearCache();
+
   const AbstractAirspace *InsideOthers(const AGeoPoint &origin) const;
 
   ClearingPair FindClearingPair(const SearchPointVector &spv,
@@ -83,7 +158,8 @@ private:
                                 const SearchPointVector::const_iterator end,
                                 const AFlatGeoPoint &dest) const;
 
-  ClearingPair GetPairs(const SearchPointVector &spv,
+  ClearingPair GetPairs(const AbstractAirspace &airspace,
+                        const SearchPointVector &spv,
                         const RoutePoint &start,
                         const RoutePoint &dest) const;
 
@@ -26,6 +26,7 @@
 #include "ReachFanParms.hpp"
 #include "Util/GlobalSliceAllocator.hpp"
 #include "Geo/Flat/FlatProjection.hpp"
+#include "Engine/Util/TaskRunner.hpp"
 
 #define REACH_BUFFER 1
 #define REACH_SWEEP (ROUTEPOLAR_Q1-REACH_BUFFER)
@@ -34,6 +35,12 @@
 #define REACH_MIN_STEP 25
 #define REACH_MAX_VERTICES 2000
 
+/**
+ * The maximum distance [flat units] a gap may have moved for
+ * UpdateReach() to reuse the fan which fills it.
+ */
+#define REACH_REUSE_TOLERANCE 3
+
 static bool
 AlmostTheSame(const FlatGeoPoint p1, const FlatGeoPoint p2)
 {
@@ -42,6 +49,14 @@ AlmostTheSame(const FlatGeoPoint p1, const FlatGeoPoint p2)
   return dmax <= 1;
 }
 
+static bool
+IsNear(const FlatGeoPoint p1, const FlatGeoPoint p2)
+{
+  const FlatGeoPoint k = p1 - p2;
+  const int dmax = std::max(abs(k.x), abs(k.y));
+  return dmax <= REACH_REUSE_TOLERANCE;
+}
+
 static bool
 TooClose(const FlatGeoPoint p1, const FlatGeoPoint p2)
 {
@@ -50,6 +65,19 @@ TooClose(const FlatGeoPoint p1, const FlatGeoPoint p2)
   return dmax < REACH_MIN_STEP;
 }
 
+/**
+ * Is the glide arrival height at #p from #origin greater than the one
+ * at #old_p from #old_origin?
+ */
+static bool
+IsHigher(FlatGeoPoint p, const AFlatGeoPoint &origin,
+         FlatGeoPoint old_p, const AFlatGeoPoint &old_origin,
+         const ReachFanParms &parms)
+{
+  return parms.rpolars.CalcGlideArrival(origin, p, parms.projection) >
+    parms.rpolars.CalcGlideArrival(old_origin, old_p, parms.projection);
+}
+
 void
 FlatTriangleFanTree::CalcBB()
 {
@@ -63,17 +91,59 @@ FlatTriangleFanTree::CalcBB()
   }
 }
 
+static bool
+IsParallel(const ReachFanParms &parms)
+{
+  return parms.task_runner != nullptr &&
+    parms.task_runner->GetConcurrency() > 1;
+}
+
+static void
+RunJob(const ReachFanParms &parms, TaskRunner::Job &job, unsigned n)
+{
+  if (parms.task_runner != nullptr)
+    parms.task_runner->Run(job, n);
+  else
+    for (unsigned i = 0; i < n; ++i)
+      job.RunTask(i);
+}
+
 void
 FlatTriangleFanTree::FillReach(const AFlatGeoPoint &origin,
                                ReachFanParms &parms)
 {
-  gaps_filled = false;
+  assert(IsRoot());
+
+  FillRoot(origin, parms);
+
+  LeafVector no_children;
+  FillRootGaps(origin, parms, no_children, false, origin);
+
+  FillDepths(origin, parms, 1);
+}
+
+void
+FlatTriangleFanTree::FillRoot(const AFlatGeoPoint &origin,
+                              const ReachFanParms &parms)
+{
+  if (IsParallel(parms))
+    FillRootParallel(origin, parms);
+  else
+    FillReach(origin, 0, ROUTEPOLAR_POINTS, parms);
+}
 
-  FillReach(origin, 0, ROUTEPOLAR_POINTS, parms);
+void
+FlatTriangleFanTree::FillDepths(const AFlatGeoPoint &origin,
+                                ReachFanParms &parms,
+                                unsigned char first_depth)
+{
+  const bool parallel = IsParallel(parms);
 
-  for (parms.set_depth = 0; parms.set_depth < REACH_MAX_DEPTH;
+  for (parms.set_depth = first_depth; parms.set_depth < REACH_MAX_DEPTH;
       ++parms.set_depth)
-    if (!FillDepth(origin, parms))
+    if (!(parallel
+          ? FillDepthParallel(origin, parms)
+          : FillDepth(origin, parms)))
       // stop searching
       break;
 
@@ -146,6 +216,47 @@ FlatTriangleFanTree::FillReach(const AFlatGeoPoint &origin, const int index_low,
   return CommitPoints(IsRoot());
 }
 
+/**
+ * Calculates the intercepts of the root fan concurrently.
+ */
+class FlatTriangleFanTree::FillRootJob final : public TaskRunner::Job {
+  const ReachFanParms &parms;
+  const AFlatGeoPoint &origin;
+  const GeoPoint geo_origin;
+
+public:
+  FlatGeoPoint intercepts[ROUTEPOLAR_POINTS];
+
+  FillRootJob(const ReachFanParms &_parms, const AFlatGeoPoint &_origin)
+    :parms(_parms), origin(_origin),
+     geo_origin(parms.projection.Unproject(origin)) {}
+
+  void RunTask(unsigned i) override {
+    intercepts[i] = parms.ReachIntercept(i, origin, geo_origin);
+  }
+};
+
+bool
+FlatTriangleFanTree::FillRootParallel(const AFlatGeoPoint &origin,
+                                      const ReachFanParms &parms)
+{
+  assert(IsRoot());
+
+  FillRootJob job(parms, origin);
+  parms.task_runner->Run(job, ROUTEPOLAR_POINTS);
+
+  AddOrigin(origin, ROUTEPOLAR_POINTS);
+  for (FlatGeoPoint x : job.intercepts) {
+    // see FillReach()
+    if (AlmostTheSame(origin, x))
+      x = origin;
+
+    AddPoint(x);
+  }
+
+  return CommitPoints(true);
+}
+
 void
 FlatTriangleFanTree::FillGaps(const AFlatGeoPoint &origin, ReachFanParms &parms)
 {
@@ -196,10 +307,300 @@ FlatTriangleFanTree::UpdateTerrainBase(const FlatGeoPoint o,
     parms.terrain_base /= parms.terrain_counter;
 }
 
+/**
+ * Searches the gaps of all nodes of one depth concurrently.
+ */
+class FlatTriangleFanTree::FillGapsJob final : public TaskRunner::Job {
+  const ReachFanParms &parms;
+  const AFlatGeoPoint &origin;
+
+public:
+  struct Gap {
+    FlatTriangleFanTree *node;
+    RouteLink e_1, e_2;
+    FlatTriangleFanTree child;
+    bool found = false;
+
+    /**
+     * UpdateReach() moves a fan of the previous calculation here if
+     * it fills this gap; then #child is not calculated.
+     */
+    LeafVector reused;
+
+    /**
+     * Shall #child be calculated?  This is cleared by UpdateReach()
+     * if a fan was reused or if the gap was known to be empty.
+     */
+    bool calculate = true;
+
+    Gap(FlatTriangleFanTree &_node,
+        const RouteLink &_e_1, const RouteLink &_e_2)
+      :node(&_node), e_1(_e_1), e_2(_e_2), child(_node.depth + 1) {}
+  };
+
+  std::vector<Gap> gaps;
+
+  /**
+   * For each node, the index of its first gap in #gaps.
+   */
+  std::vector<unsigned> first_gap;
+
+  FillGapsJob(const ReachFanParms &_parms, const AFlatGeoPoint &_origin)
+    :parms(_parms), origin(_origin) {}
+
+  /**
+   * Add all gaps of the specified node, just like FillGaps() checks
+   * them.
+   */
+  void AddNode(FlatTriangleFanTree &node) {
+    first_gap.push_back(gaps.size());
+
+    const auto &vs = node.vs;
+    if (vs.size() <= 2 || !parms.rpolars.IsTurningReachEnabled())
+      return;
+
+    RouteLink e_last(RoutePoint(vs.front(), 0),
+                     origin, parms.projection);
+    for (auto x_last = vs.cbegin(), end = vs.cend(),
+         x = x_last + 1; x != end; x_last = x++) {
+      if (TooClose(*x, origin) || TooClose(*x_last, origin))
+        continue;
+
+      const RouteLink e(RoutePoint(*x, 0), origin, parms.projection);
+      gaps.emplace_back(node, e_last, e);
+      e_last = e;
+    }
+  }
+
+  void RunTask(unsigned i) override {
+    Gap &gap = gaps[i];
+    if (!gap.calculate)
+      return;
+
+    gap.found = gap.node->FindGapFan(origin, gap.e_1, gap.e_2, parms,
+                                     gap.child);
+  }
+};
+
+void
+FlatTriangleFanTree::CollectDepth(unsigned char set_depth,
+                                  std::vector<FlatTriangleFanTree *> &nodes)
+{
+  if (depth == set_depth) {
+    if (!gaps_filled)
+      nodes.push_back(this);
+  } else if (depth < set_depth) {
+    for (auto &child : children)
+      child.CollectDepth(set_depth, nodes);
+  }
+}
+
+bool
+FlatTriangleFanTree::FillDepthParallel(const AFlatGeoPoint &origin,
+                                       ReachFanParms &parms)
+{
+  assert(IsRoot());
+
+  std::vector<FlatTriangleFanTree *> nodes;
+  CollectDepth(parms.set_depth, nodes);
+
+  FillGapsJob job(parms, origin);
+  for (auto *node : nodes)
+    job.AddNode(*node);
+
+  parms.task_runner->Run(job, job.gaps.size());
+
+  /* commit in the order of FillDepth(); this may discard some
+     results which were calculated in vain */
+  for (unsigned i = 0; i < nodes.size(); ++i) {
+    FlatTriangleFanTree &node = *nodes[i];
+    node.gaps_filled = true;
+
+    if (parms.vertex_counter > REACH_MAX_VERTICES)
+      return false;
+    if (parms.fan_counter > REACH_MAX_FANS)
+      return false;
+
+    const unsigned end = i + 1 < nodes.size()
+      ? job.first_gap[i + 1]
+      : job.gaps.size();
+    for (unsigned j = job.first_gap[i]; j < end; ++j) {
+      auto &gap = job.gaps[j];
+      if (gap.found)
+        node.AddChild(std::move(gap.child), parms);
+    }
+  }
+
+  return true;
+}
+
+void
+FlatTriangleFanTree::UpdateReach(const AFlatGeoPoint &origin,
+                                 ReachFanParms &parms)
+{
+  assert(IsRoot());
+
+  const AFlatGeoPoint old_origin = GetOrigin();
+
+  LeafVector old_children;
+  old_children.swap(children);
+  FlatTriangleFan::Clear();
+
+  FillRoot(origin, parms);
+  FillRootGaps(origin, parms, old_children, true, old_origin);
+  FillDepths(origin, parms, 1);
+}
+
+void
+FlatTriangleFanTree::FillRootGaps(const AFlatGeoPoint &origin,
+                                  ReachFanParms &parms,
+                                  LeafVector &old_children, bool update,
+                                  const AFlatGeoPoint &old_origin)
+{
+  assert(IsRoot());
+  assert(children.empty());
+
+  /* this is the same as FillDepth() at depth 0 */
+  parms.set_depth = 0;
+  gaps_filled = true;
+
+  FillGapsJob job(parms, origin);
+  job.AddNode(*this);
+
+  if (update) {
+    /* needed by IsInside() */
+    CalcBoundingBox();
+
+    /* look up the old fan of each gap; only gaps which have changed
+       need to be calculated */
+    for (auto &gap : job.gaps) {
+      const FlatGeoPoint begin = gap.e_1.first, end = gap.e_2.first;
+
+      for (auto i = old_children.begin(), e = old_children.end();
+           i != e; ++i) {
+        if (i->FillsGap(begin, end) &&
+            CanReuse(*i, origin, old_origin, parms)) {
+          gap.reused.splice(gap.reused.end(), old_children, i);
+          gap.calculate = false;
+          break;
+        }
+      }
+
+      if (gap.calculate)
+        for (const auto &empty : empty_gaps)
+          if (IsNear(empty.first, begin) && IsNear(empty.second, end) &&
+              !IsHigher(begin, origin, empty.first, old_origin, parms) &&
+              !IsHigher(end, origin, empty.second, old_origin, parms)) {
+            gap.calculate = false;
+            break;
+          }
+    }
+  }
+
+  RunJob(parms, job, job.gaps.size());
+
+  std::vector<std::pair<FlatGeoPoint, FlatGeoPoint>> new_empty_gaps;
+
+  for (auto &gap : job.gaps) {
+    if (!gap.reused.empty()) {
+      /* the origin of the reused fan has moved relative to the root:
+         correct its height (and the heights of its children) by the
+         change of the glide arrival height, which includes the
+         horizontal movement, not just the altitude change; CanReuse()
+         has verified that this does not lower it, so the old
+         footprint is still clear of terrain */
+      FlatTriangleFanTree &child = gap.reused.front();
+      const FlatGeoPoint child_origin = child.vs.front();
+      const int delta =
+        parms.rpolars.CalcGlideArrival(origin, child_origin,
+                                       parms.projection) -
+        parms.rpolars.CalcGlideArrival(old_origin, child_origin,
+                                       parms.projection);
+      child.ShiftHeight(delta);
+      child.CountFans(parms);
+      children.splice(children.end(), gap.reused);
+    } else if (gap.found)
+      AddChild(std::move(gap.child), parms);
+    else
+      new_empty_gaps.emplace_back(gap.e_1.first, gap.e_2.first);
+  }
+
+  empty_gaps.swap(new_empty_gaps);
+}
+
+bool
+FlatTriangleFanTree::CanReuse(const FlatTriangleFanTree &child,
+                              const AFlatGeoPoint &origin,
+                              const AFlatGeoPoint &old_origin,
+                              const ReachFanParms &parms) const
+{
+  const FlatGeoPoint child_origin = child.vs.front();
+
+  /* the child's terrain clearance was only checked for its old
+     height; if it is lower now, the old footprint may be too large */
+  if (IsHigher(child_origin, old_origin, child_origin, origin, parms))
+    return false;
+
+  /* the straight glide from the new origin to the child's origin
+     must be clear of terrain, which is only known if the new root
+     fan contains it */
+  return IsInside(child_origin);
+}
+
+bool
+FlatTriangleFanTree::FillsGap(FlatGeoPoint begin, FlatGeoPoint end) const
+{
+  return IsNear(gap_begin, begin) && IsNear(gap_end, end);
+}
+
+void
+FlatTriangleFanTree::ShiftHeight(int delta)
+{
+  height += delta;
+
+  for (auto &child : children)
+    child.ShiftHeight(delta);
+}
+
+void
+FlatTriangleFanTree::CountFans(ReachFanParms &parms) const
+{
+  parms.vertex_counter += vs.size();
+  parms.fan_counter++;
+
+  for (const auto &child : children)
+    child.CountFans(parms);
+}
+
+void
+FlatTriangleFanTree::AddChild(FlatTriangleFanTree &&child,
+                              ReachFanParms &parms)
+{
+  parms.vertex_counter += child.vs.size();
+  parms.fan_counter++;
+  children.emplace_back(std::move(child));
+}
+
 bool
 FlatTriangleFanTree::CheckGap(const AFlatGeoPoint &n, const RouteLink &e_1,
                               const RouteLink &e_2, ReachFanParms &parms)
 {
+  FlatTriangleFanTree child(depth + 1);
+  if (!FindGapFan(n, e_1, e_2, parms, child))
+    return false;
+
+  AddChild(std::move(child), parms);
+  return true;
+}
+
+bool
+FlatTriangleFanTree::FindGapFan(const AFlatGeoPoint &n, const RouteLink &e_1,
+                                const RouteLink &e_2,
+                                const ReachFanParms &parms,
+                                FlatTriangleFanTree &child) const
+{
+  assert(child.depth == depth + 1);
+
   const bool side = (e_1.d > e_2.d);
   const RouteLink &e_long = (side ? e_1 : e_2);
   const RouteLink &e_short = (side ? e_2 : e_1);
@@ -236,11 +637,10 @@ FlatTriangleFanTree::CheckGap(const AFlatGeoPoint &n, const RouteLink &e_1,
     // altitude calculated from pure glide from n to x
     const AFlatGeoPoint x(px, h);
 
-    FlatTriangleFanTree child(depth + 1);
+    child.Clear();
     if (child.FillReach(x, index_left, index_right, parms)) {
-      parms.vertex_counter += child.vs.size();
-      parms.fan_counter++;
-      children.emplace_back(std::move(child));
+      child.gap_begin = e_1.first;
+      child.gap_end = e_2.first;
       return true;
     }
   }
@@ -28,6 +28,8 @@
 #include "FlatTriangleFan.hpp"
 
 #include <list>
+#include <vector>
+#include <utility>
 
 class FlatProjection;
 struct GeoPoint;
@@ -51,8 +53,25 @@ private:
   typedef std::list<FlatTriangleFanTree,
                     GlobalSliceAllocator<FlatTriangleFanTree, 128u> > LeafVector;
 
+  class FillGapsJob;
+  class FillRootJob;
+
   FlatBoundingBox bb_children;
   LeafVector children;
+
+  /**
+   * The two vertices of the parent fan enclosing the gap which this
+   * fan fills.  Used by UpdateReach() to find fans which can be
+   * reused.
+   */
+  FlatGeoPoint gap_begin, gap_end;
+
+  /**
+   * The gaps of the root fan which could not be filled (root only).
+   * Used by UpdateReach() to skip them.
+   */
+  std::vector<std::pair<FlatGeoPoint, FlatGeoPoint>> empty_gaps;
+
   const unsigned char depth;
   bool gaps_filled;
 
@@ -70,6 +89,7 @@ public:
   void Clear() {
     FlatTriangleFan::Clear();
     children.clear();
+    empty_gaps.clear();
   }
 
   void CalcBB();
@@ -82,6 +102,18 @@ public:
   void FillReach(const AFlatGeoPoint &origin, ReachFanParms &parms);
   void DummyReach(const AFlatGeoPoint &origin);
 
+  /**
+   * Like FillReach(), but reuse the children of the previous
+   * calculation if the gaps they fill have not moved, their origin
+   * is still directly reachable and the arrival height there has not
+   * decreased; only the root fan and the other gaps are calculated.
+   * Gaps which were empty are skipped only if the arrival height at
+   * their ends has not increased.  Must be called on the root.  The
+   * heights of the reused fans are corrected by the change of the
+   * glide arrival height at their origins.
+   */
+  void UpdateReach(const AFlatGeoPoint &origin, ReachFanParms &parms);
+
   /**
    * Basic check for a state created by DummyReach().  If this method
    * returns true, then calls to FindPositiveArrival() are supposed to
@@ -106,6 +138,18 @@ public:
   bool CheckGap(const AFlatGeoPoint &n, const RouteLink &e_1,
                 const RouteLink &e_2, ReachFanParms &parms);
 
+  /**
+   * Search a fan which fills the gap between the two links.  This
+   * method does not modify this object, and may be called
+   * concurrently.
+   *
+   * @param child an object of depth+1 which receives the fan
+   * @return true if a fan was found
+   */
+  bool FindGapFan(const AFlatGeoPoint &n, const RouteLink &e_1,
+                  const RouteLink &e_2, const ReachFanParms &parms,
+                  FlatTriangleFanTree &child) const;
+
   bool FindPositiveArrival(FlatGeoPoint n,
                            const ReachFanParms &parms,
                            int &arrival_height) const;
@@ -117,6 +161,72 @@ public:
 
   gcc_pure
   int DirectArrival(FlatGeoPoint dest, const ReachFanParms &parms) const;
+
+private:
+  void FillRoot(const AFlatGeoPoint &origin, const ReachFanParms &parms);
+  void FillDepths(const AFlatGeoPoint &origin, ReachFanParms &parms,
+                  unsigned char first_depth);
+
+  /**
+   * Fill the gaps of the root fan, i.e. FillDepth() at depth 0.
+   *
+   * @param old_children the children of the previous calculation
+   * @param update reuse fans from #old_children and skip gaps which
+   * were empty in the previous calculation
+   * @param old_origin the origin of the previous calculation (only
+   * used if #update is true)
+   */
+  void FillRootGaps(const AFlatGeoPoint &origin, ReachFanParms &parms,
+                    LeafVector &old_children, bool update,
+                    const AFlatGeoPoint &old_origin);
+
+  void AddChild(FlatTriangleFanTree &&child, ReachFanParms &parms);
+
+  gcc_pure
+  bool FillsGap(FlatGeoPoint begin, FlatGeoPoint end) const;
+
+  /**
+   * May the specified child of the previous calculation be reused
+   * by UpdateReach()?  This requires that the glide arrival height at
+   * its origin has not decreased, and that its origin is inside the
+   * new root fan.  Must be called on the root after its fan was
+   * filled and its bounding box was calculated.
+   */
+  gcc_pure
+  bool CanReuse(const FlatTriangleFanTree &child,
+                const AFlatGeoPoint &origin,
+                const AFlatGeoPoint &old_origin,
+                const ReachFanParms &parms) const;
+
+  void ShiftHeight(int delta);
+
+  /**
+   * Add the vertices and fans of this subtree to the counters.
+   */
+  void CountFans(ReachFanParms &parms) const;
+
+  /**
+   * Parallel version of FillReach() for the root fan, using
+   * ReachFanParms::task_runner.
+   */
+  bool FillRootParallel(const AFlatGeoPoint &origin,
+                        const ReachFanParms &parms);
+
+  /**
+   * Parallel version of FillDepth(), using
+   * ReachFanParms::task_runner.  All gaps of one depth are searched
+   * concurrently, and then the results are committed in the same
+   * order as FillDepth() does, applying the same limits; therefore
+   * the resulting tree is identical.  Must be called on the root.
+   */
+  bool FillDepthParallel(const AFlatGeoPoint &origin, ReachFanParms &parms);
+
+  /**
+   * Collect all nodes whose gaps need to be filled at the given
+   * depth, in the order FillDepth() visits them.
+   */
+  void CollectDepth(unsigned char set_depth,
+                    std::vector<FlatTriangleFanTree *> &nodes);
 };
 
 #endif
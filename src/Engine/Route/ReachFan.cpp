@@ -25,6 +25,8 @@
 #include "ReachFanParms.hpp"
 #include "ReachResult.hpp"
 
+#include <math.h>
+
 static constexpr int MIN_FLOOR_CLEARANCE = 100;
 
 void
@@ -32,38 +34,77 @@ ReachFan::Reset()
 {
   root.Clear();
   terrain_base = 0;
+  arrival_margin = 0;
+  updatable = false;
 }
 
 bool
-ReachFan::Solve(const AGeoPoint origin, const RoutePolars &rpolars,
-                const RasterMap* terrain, const bool do_solve)
+ReachFan::CanUpdate(const AGeoPoint &origin, const RoutePolars &rpolars,
+                    const RasterMap *terrain) const
 {
-  Reset();
-
-  // initialise projection
-  projection = FlatProjection(origin);
+  return updatable && terrain == solved_terrain &&
+    fabs(origin.altitude - solved_origin.altitude) <= MAX_UPDATE_HEIGHT &&
+    origin.DistanceS(solved_origin) <= MAX_UPDATE_DISTANCE &&
+    rpolars.IsReachEquivalent(solved_rpolars);
+}
 
+bool
+ReachFan::Solve(const AGeoPoint origin, const RoutePolars &rpolars,
+                const RasterMap* terrain, const bool do_solve,
+                TaskRunner *task_runner)
+{
   const auto h = terrain
     ? terrain->GetHeight(origin)
     : TerrainHeight::Invalid();
   const int h2 = h.GetValueOr0();
 
+  // immediate exit if starting below terrain, or starting below floor
+  // with some clearance (not worth scanning if too close)
+  const bool too_low = (!h.IsInvalid() &&
+                        (origin.altitude <= h2 + rpolars.GetSafetyHeight()))
+    || (origin.altitude < MIN_FLOOR_CLEARANCE + rpolars.GetFloor() + rpolars.GetSafetyHeight());
+
+  const bool update = do_solve && !too_low &&
+    CanUpdate(origin, rpolars, terrain);
+
+  if (!update) {
+    Reset();
+
+    // initialise projection
+    projection = FlatProjection(origin);
+  }
+
   ReachFanParms parms(rpolars, projection, terrain_base, terrain);
+  parms.task_runner = task_runner;
   const AFlatGeoPoint ao(projection.ProjectInteger(origin), origin.altitude);
 
-  // immediate exit if starting below terrain, or starting below floor
-  // with some clearance (not worth scanning if too close)
-  if ((!h.IsInvalid() &&
-      (origin.altitude <= h2 + rpolars.GetSafetyHeight()))
-      || (origin.altitude < MIN_FLOOR_CLEARANCE + rpolars.GetFloor() + rpolars.GetSafetyHeight())) {
+  if (too_low) {
     terrain_base = h2;
     root.DummyReach(ao);
     return false;
   }
 
-  if (do_solve)
+  if (update) {
+    root.UpdateReach(ao, parms);
+
+    /* the origin was rounded onto the grid of the previous projection
+       (unlike a full calculation, where it is the projection's
+       center), and destinations are rounded differently than in a
+       new projection (up to half a diagonal each); subtract the glide
+       height loss over these rounding errors from all arrival
+       heights, so they are never more optimistic than the ones of a
+       full calculation */
+    const double error = origin.DistanceS(projection.Unproject(ao)) +
+      projection.GetApproximateScale() * M_SQRT2;
+    arrival_margin = rpolars.CalcMaxGlideLoss(error);
+  } else if (do_solve) {
     root.FillReach(ao, parms);
-  else
+
+    updatable = true;
+    solved_origin = origin;
+    solved_rpolars = rpolars;
+    solved_terrain = terrain;
+  } else
     root.DummyReach(ao);
 
   if (!h.IsInvalid()) {
@@ -94,24 +135,26 @@ ReachFan::FindPositiveArrival(const AGeoPoint dest, const RoutePolars &rpolars,
   result_r.Clear();
 
   // first calculate direct (terrain-independent height)
-  result_r.direct = root.DirectArrival(d, parms);
+  result_r.direct = root.DirectArrival(d, parms) - arrival_margin;
 
   if (root.IsDummy())
     /* terrain reach is not available, stop here */
     return true;
 
   // if can't reach even with no terrain, exit early
-  if (std::min(root.GetHeight(), result_r.direct) < dest.altitude) {
+  if (std::min(root.GetHeight() - arrival_margin, result_r.direct)
+      < dest.altitude) {
     result_r.terrain = result_r.direct;
     result_r.terrain_valid = ReachResult::Validity::UNREACHABLE;
     return true;
   }
 
   // now calculate turning solution
-  result_r.terrain = dest.altitude - 1;
+  result_r.terrain = dest.altitude - 1 + arrival_margin;
   result_r.terrain_valid = root.FindPositiveArrival(d, parms, result_r.terrain)
     ? ReachResult::Validity::VALID
     : ReachResult::Validity::UNREACHABLE;
+  result_r.terrain -= arrival_margin;
 
   return true;
 }
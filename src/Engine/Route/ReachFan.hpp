@@ -24,19 +24,51 @@
 #define REACHFAN_HPP
 
 #include "Geo/Flat/FlatProjection.hpp"
+#include "Geo/GeoPoint.hpp"
 #include "FlatTriangleFanTree.hpp"
+#include "RoutePolars.hpp"
 
-class RoutePolars;
 class RasterMap;
 class GeoBounds;
+class TaskRunner;
 struct ReachResult;
 
 class ReachFan
 {
+  /**
+   * Solve() reuses the previous fans only if the origin is within
+   * this distance [m] of the last full calculation ...
+   */
+  static constexpr double MAX_UPDATE_DISTANCE = 500;
+
+  /**
+   * ... and its altitude differs by no more than this [m].
+   */
+  static constexpr int MAX_UPDATE_HEIGHT = 25;
+
   FlatProjection projection;
   FlatTriangleFanTree root;
   int terrain_base;
 
+  /**
+   * Subtracted from all arrival heights after an incremental update,
+   * to account for rounding errors which a full calculation does not
+   * have.
+   */
+  int arrival_margin = 0;
+
+  /**
+   * Can the current tree be updated by Solve()?
+   */
+  bool updatable = false;
+
+  /**
+   * The origin and the parameters of the last full calculation.
+   */
+  AGeoPoint solved_origin;
+  RoutePolars solved_rpolars;
+  const RasterMap *solved_terrain;
+
 public:
   ReachFan():terrain_base(0) {}
 
@@ -52,8 +84,17 @@ public:
 
   void Reset();
 
+  /**
+   * Calculate the reach footprint.  If the origin is close to the
+   * previous one, only the fans whose terrain clearance has changed
+   * are calculated, and the others are reused.
+   *
+   * @param task_runner if not nullptr, then the fans are calculated
+   * in parallel
+   */
   bool Solve(const AGeoPoint origin, const RoutePolars &rpolars,
-             const RasterMap *terrain, const bool do_solve = true);
+             const RasterMap *terrain, const bool do_solve = true,
+             TaskRunner *task_runner = nullptr);
 
   bool FindPositiveArrival(const AGeoPoint dest, const RoutePolars &rpolars,
                            ReachResult &result_r) const;
@@ -64,6 +105,14 @@ public:
   int GetTerrainBase() const {
     return terrain_base;
   }
+
+  /**
+   * Would Solve() with these parameters only update the current
+   * tree instead of calculating a new one?
+   */
+  gcc_pure
+  bool CanUpdate(const AGeoPoint &origin, const RoutePolars &rpolars,
+                 const RasterMap *terrain) const;
 };
 
 #endif
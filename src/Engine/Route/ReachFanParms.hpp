@@ -27,11 +27,18 @@
 
 class FlatProjection;
 class RasterMap;
+class TaskRunner;
 
 struct ReachFanParms {
   const RoutePolars &rpolars;
   const FlatProjection &projection;
   const RasterMap *terrain;
+
+  /**
+   * If set, then the reach is calculated in parallel.
+   */
+  TaskRunner *task_runner = nullptr;
+
   int terrain_base;
   unsigned terrain_counter = 0;
   unsigned fan_counter = 0;
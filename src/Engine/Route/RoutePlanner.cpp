@@ -62,7 +62,8 @@ RoutePlanner::SolveReachTerrain(const AGeoPoint &origin,
   rpolars_reach.SetConfig(config, origin.altitude, h_ceiling);
   reach_polar_mode = config.reach_polar_mode;
 
-  return reach_terrain.Solve(origin, rpolars_reach, terrain, do_solve);
+  return reach_terrain.Solve(origin, rpolars_reach, terrain, do_solve,
+                             task_runner);
 }
 
 bool
@@ -73,7 +74,8 @@ RoutePlanner::SolveReachWorking(const AGeoPoint &origin,
   rpolars_reach_working.SetConfig(config, origin.altitude, h_ceiling);
   // reach_polar_mode previously set by SolveReachTerrain
 
-  return reach_working.Solve(origin, rpolars_reach_working, terrain, do_solve);
+  return reach_working.Solve(origin, rpolars_reach_working, terrain, do_solve,
+                             task_runner);
 }
 
 bool
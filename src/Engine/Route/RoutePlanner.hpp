@@ -146,6 +146,9 @@ private:
   ReachFan reach_terrain;
   ReachFan reach_working;
 
+  /** Used to calculate the reach in parallel; may be nullptr */
+  TaskRunner *task_runner = nullptr;
+
   RoutePlannerConfig::Polar reach_polar_mode;
 
   mutable unsigned long count_dij;
@@ -175,6 +178,17 @@ public:
     terrain = _terrain;
   }
 
+  /**
+   * Calculate the reach footprints in parallel, using the specified
+   * #TaskRunner.  The result is the same as with the serial solver.
+   *
+   * @param _task_runner the runner to be used, or nullptr to solve
+   * serially
+   */
+  void SetTaskRunner(TaskRunner *_task_runner) {
+    task_runner = _task_runner;
+  }
+
   bool IsTerrainReachEmpty() const {
     return reach_terrain.IsEmpty();
   }
@@ -184,6 +198,17 @@ public:
    */
   void ClearReach();
 
+  /**
+   * Can both reach footprints be updated incrementally for the
+   * specified origin, with the current polars?  Such an update is
+   * much cheaper than a full calculation.
+   */
+  gcc_pure
+  bool CanUpdateReach(const AGeoPoint &origin) const {
+    return reach_terrain.CanUpdate(origin, rpolars_reach, terrain) &&
+      reach_working.CanUpdate(origin, rpolars_reach_working, terrain);
+  }
+
   /**
    * Find the optimal path.  Works in reverse time order, from the
    * origin (where you want to fly to) back to the destination (where you
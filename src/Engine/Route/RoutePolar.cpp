@@ -58,6 +58,32 @@ RoutePolar::Initialise(const GlideSettings &settings, const GlidePolar& polar,
   }
 }
 
+double
+RoutePolar::GetMaxGradient() const
+{
+  double result = 0;
+  for (const auto &point : points)
+    if (point.valid && point.gradient > result)
+      result = point.gradient;
+  return result;
+}
+
+bool
+RoutePolar::operator==(const RoutePolar &other) const
+{
+  for (unsigned i = 0; i < ROUTEPOLAR_POINTS; ++i) {
+    const RoutePolarPoint &a = points[i], &b = other.points[i];
+    if (a.valid != b.valid)
+      return false;
+
+    if (a.valid &&
+        (a.slowness != b.slowness || a.gradient != b.gradient))
+      return false;
+  }
+
+  return true;
+}
+
 static constexpr FlatGeoPoint index_to_point[] = {
   {128, 0},
   {126, 16},
@@ -107,6 +107,16 @@ public:
   gcc_const
   static FlatGeoPoint IndexToDXDY(int index);
 
+  /**
+   * Returns the steepest glide slope gradient of all valid
+   * directions (m loss / m travelled).
+   */
+  gcc_pure
+  double GetMaxGradient() const;
+
+  gcc_pure
+  bool operator==(const RoutePolar &other) const;
+
 private:
   GlideResult SolveTask(const GlideSettings &settings, const GlidePolar& polar,
                         const SpeedVector &wind,
@@ -26,6 +26,8 @@
 #include "Geo/Flat/FlatProjection.hpp"
 #include "Terrain/RasterMap.hpp"
 
+#include <math.h>
+
 #define MC_CEILING_PENALTY_FACTOR 5.0
 
 inline FlatGeoPoint
@@ -211,6 +213,12 @@ RoutePolars::CanClimb() const
   return config.allow_climb && inv_mc > 0;
 }
 
+int
+RoutePolars::CalcMaxGlideLoss(double distance) const
+{
+  return (int)ceil(polar_glide.GetMaxGradient() * distance);
+}
+
 GeoPoint
 RoutePolars::Intersection(const AGeoPoint &origin,
                           const AGeoPoint &destination,
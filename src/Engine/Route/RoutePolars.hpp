@@ -235,6 +235,13 @@ public:
                        const FlatGeoPoint& dest,
                        const FlatProjection &proj) const;
 
+  /**
+   * Calculate the maximum height loss of a glide over the specified
+   * distance [m] in any direction.
+   */
+  gcc_pure
+  int CalcMaxGlideLoss(double distance) const;
+
   int GetSafetyHeight() const {
     return config.safety_height_terrain;
   }
@@ -243,6 +250,19 @@ public:
     return height_min_working;
   }
 
+  /**
+   * Would a reach calculation with the other object yield the same
+   * result?  This compares only the attributes which are used by
+   * the reach calculation.
+   */
+  gcc_pure
+  bool IsReachEquivalent(const RoutePolars &other) const {
+    return polar_glide == other.polar_glide &&
+      height_min_working == other.height_min_working &&
+      config.safety_height_terrain == other.config.safety_height_terrain &&
+      config.reach_calc_mode == other.config.reach_calc_mode;
+  }
+
   gcc_pure
   FlatGeoPoint ReachIntercept(int index, const AFlatGeoPoint &flat_origin,
                               const GeoPoint &origin,
@@ -25,13 +25,15 @@
 #include "AlternateList.hpp"
 #include "Navigation/Aircraft.hpp"
 #include "Task/Visitors/TaskPointVisitor.hpp"
-#include "Task/Solvers/TaskSolution.hpp"
 #include "GlideSolvers/GlidePolar.hpp"
+#include "GlideSolvers/MacCready.hpp"
 #include "Waypoint/Waypoints.hpp"
 #include "Waypoint/WaypointVisitor.hpp"
 #include "Util/ReservablePriorityQueue.hpp"
 #include "Util/Clamp.hpp"
 
+#include <algorithm>
+
 /** min search range in m */
 static constexpr double min_search_range = 50000;
 
@@ -136,34 +138,53 @@ IsReachable(const GlideResult &result, bool final_glide)
     : result.IsAchievable();
 }
 
+void
+AbortTask::SolveCandidates(const AircraftState &state,
+                           AlternateList &candidates,
+                           const GlidePolar &polar)
+{
+  glide_states.clear();
+  glide_states.reserve(candidates.size());
+
+  for (const auto &c : candidates)
+    /* same as GlideState::Remaining() on an UnorderedTaskPoint */
+    glide_states.emplace_back(GeoVector(state.location,
+                                        c.waypoint->location),
+                              std::max(0., c.waypoint->elevation +
+                                       task_behaviour.safety_height_arrival),
+                              state.altitude, state.wind);
+
+  glide_results.resize(candidates.size());
+
+  const MacCready mac_cready(task_behaviour.glide, polar);
+  mac_cready.SolveBatch(glide_states.data(), glide_results.data(),
+                        candidates.size());
+
+  for (unsigned i = 0; i < candidates.size(); ++i)
+    candidates[i].solution = glide_results[i];
+}
+
 bool
 AbortTask::FillReachable(const AircraftState &state,
                          AlternateList &approx_waypoints,
-                         const GlidePolar &polar, bool only_airfield,
-                         bool final_glide, bool safety)
+                         bool only_airfield, bool final_glide)
 {
   if (IsTaskFull() || approx_waypoints.empty())
     return false;
 
-  const AGeoPoint p_start(state.location, state.altitude);
-
   bool found_final_glide = false;
   reservable_priority_queue<AlternatePoint, AlternateList, AbortRank> q;
   q.reserve(32);
 
-  for (auto v = approx_waypoints.begin(); v != approx_waypoints.end();) {
-    if (only_airfield && !v->waypoint->IsAirport()) {
-      ++v;
-      continue;
-    }
+  /* candidates which were added to the queue are removed from the
+     list by moving the others to the front */
+  auto dest = approx_waypoints.begin();
 
-    auto wp = v->waypoint;
-    UnorderedTaskPoint t(std::move(wp), task_behaviour);
-    GlideResult result =
-        TaskSolution::GlideSolutionRemaining(t, state,
-                                             task_behaviour.glide, polar);
+  for (auto v = approx_waypoints.begin(); v != approx_waypoints.end(); ++v) {
+    const GlideResult &result = v->solution;
 
-    if (IsReachable(result, final_glide)) {
+    if ((!only_airfield || v->waypoint->IsAirport()) &&
+        IsReachable(result, final_glide)) {
       bool intersects = false;
       const bool is_reachable_final = IsReachable(result, true);
 
@@ -172,21 +193,22 @@ AbortTask::FillReachable(const AircraftState &state,
             AGeoPoint(v->waypoint->location, result.min_arrival_altitude));
 
       if (!intersects) {
-        wp = v->waypoint;
-        q.push(AlternatePoint(std::move(wp), result));
-        // remove it since it's already in the list now      
-        v = approx_waypoints.erase(v);
+        q.push(std::move(*v));
 
         if (is_reachable_final)
           found_final_glide = true;
 
-        continue; // skip incrementing v since we just erased it
+        continue;
       }
-    } 
+    }
 
-    ++v;
+    if (dest != v)
+      *dest = std::move(*v);
+    ++dest;
   }
 
+  approx_waypoints.erase(dest, approx_waypoints.end());
+
   while (!q.empty() && !IsTaskFull()) {
     auto top = q.top();
     task_points.emplace_back(std::move(top.waypoint), task_behaviour,
@@ -271,19 +293,21 @@ AbortTask::UpdateSample(const AircraftState &state,
     return false;
   }
 
+  /* all passes below use the same polar, so solve all candidates
+     at once */
+  SolveCandidates(state, approx_waypoints, glide_polar);
+
   // sort by arrival time
 
   // first try with final glide only
-  reachable_landable |=  FillReachable(state, approx_waypoints, glide_polar,
-                                       true, true, true);
-  reachable_landable |=  FillReachable(state, approx_waypoints, glide_polar,
-                                       false, true, true);
+  reachable_landable |=  FillReachable(state, approx_waypoints, true, true);
+  reachable_landable |=  FillReachable(state, approx_waypoints, false, true);
 
   // inform clients that the landable reachable scan has been performed 
   ClientUpdate(state, true);
 
   // now try without final glide constraint and not preferring airports
-  FillReachable(state, approx_waypoints, glide_polar, false, false, false);
+  FillReachable(state, approx_waypoints, false, false);
 
   // inform clients that the landable unreachable scan has been performed 
   ClientUpdate(state, false);
@@ -25,6 +25,7 @@
 
 #include "UnorderedTask.hpp"
 #include "UnorderedTaskPoint.hpp"
+#include "GlideSolvers/GlideState.hpp"
 
 #include <vector>
 
@@ -80,6 +81,10 @@ private:
   unsigned active_waypoint;
   bool reachable_landable;
 
+  /** scratch buffers for SolveCandidates() */
+  std::vector<GlideState> glide_states;
+  std::vector<GlideResult> glide_results;
+
 public:
   /** 
    * Base constructor.
@@ -154,24 +159,34 @@ protected:
   double GetAbortRange(const AircraftState &state_now,
                        const GlidePolar &glide_polar) const;
 
+  /**
+   * Calculate the glide solutions of all candidates (stored in
+   * AlternatePoint::solution) with one MacCready::SolveBatch() call.
+   *
+   * @param state Aircraft state
+   * @param candidates List of candidate waypoints
+   * @param polar Polar used for tests
+   */
+  void SolveCandidates(const AircraftState &state,
+                       AlternateList &candidates,
+                       const GlidePolar &polar);
+
   /**
    * Fill abort task list with candidate waypoints given a list of
    * waypoints satisfying approximate range queries.  Can be used
    * to add airfields only, or landpoints.
    *
    * @param state Aircraft state
-   * @param approx_waypoints List of candidate waypoints
-   * @param polar Polar used for tests
+   * @param approx_waypoints List of candidate waypoints, solved by
+   * SolveCandidates()
    * @param only_airfield If true, only add waypoints that are airfields.
    * @param final_glide Whether solution must be glide only or climb allowed
-   * @param safety Whether solution uses safety polar
    *
    * @return True if a landpoint within final glide was found
    */
   bool FillReachable(const AircraftState &state,
                      AlternateList &approx_waypoints,
-                     const GlidePolar &polar, bool only_airfield,
-                     bool final_glide, bool safety);
+                     bool only_airfield, bool final_glide);
 
 protected:
   /**
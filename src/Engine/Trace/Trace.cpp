@@ -23,41 +23,160 @@ Copyright_License {
 
 #include "Trace.hpp"
 #include "Vector.hpp"
-#include "Util/GlobalSliceAllocator.hpp"
 
 #include <algorithm>
 
 Trace::Trace(const unsigned _no_thin_time, const unsigned max_time,
              const unsigned max_size)
-  :cached_size(0),
+  :nodes(new TraceDelta[max_size + 1]),
+   heap(new unsigned[max_size]),
+   suppressed(new unsigned[max_size]),
+   cached_size(0),
    max_time(max_time),
    no_thin_time(_no_thin_time),
    max_size(max_size),
    opt_size((3 * max_size) / 4)
 {
   assert(max_size >= 4);
+
+  clear();
 }
 
 void
 Trace::clear()
 {
-  assert(cached_size == delta_list.size());
-  assert(cached_size == chronological_list.size());
-
   average_delta_distance = 0;
   average_delta_time = 0;
 
-  delta_list.clear();
-  chronological_list.clear_and_dispose(MakeDisposer());
-  cached_size = 0;
+  TraceDelta &sentinel = nodes[GetSentinel()];
+  sentinel.prev = sentinel.next = GetSentinel();
 
-  assert(cached_size == delta_list.size());
-  assert(cached_size == chronological_list.size());
+  for (unsigned i = 0; i < max_size; ++i)
+    nodes[i].next = i + 1 < max_size ? i + 1 : NOT_QUEUED;
+  free_head = 0;
+
+  heap_size = 0;
+  cached_size = 0;
 
   ++modify_serial;
   ++append_serial;
 }
 
+unsigned
+Trace::AllocateBack()
+{
+  assert(free_head != NOT_QUEUED);
+
+  const unsigned i = free_head;
+  TraceDelta &td = nodes[i];
+  free_head = td.next;
+
+  TraceDelta &sentinel = nodes[GetSentinel()];
+  td.prev = sentinel.prev;
+  td.next = GetSentinel();
+  td.heap_index = NOT_QUEUED;
+  nodes[sentinel.prev].next = i;
+  sentinel.prev = i;
+
+  ++cached_size;
+  return i;
+}
+
+void
+Trace::Free(unsigned i)
+{
+  assert(cached_size > 0);
+
+  TraceDelta &td = nodes[i];
+  if (td.heap_index != NOT_QUEUED)
+    HeapRemove(i);
+
+  nodes[td.prev].next = td.next;
+  nodes[td.next].prev = td.prev;
+
+  td.next = free_head;
+  free_head = i;
+
+  --cached_size;
+}
+
+void
+Trace::HeapSiftUp(unsigned position)
+{
+  while (position > 0) {
+    const unsigned parent = (position - 1) / 2;
+    if (!HeapLess(position, parent))
+      break;
+
+    HeapSwap(position, parent);
+    position = parent;
+  }
+}
+
+void
+Trace::HeapSiftDown(unsigned position)
+{
+  while (true) {
+    const unsigned left = 2 * position + 1;
+    if (left >= heap_size)
+      break;
+
+    unsigned smallest = left;
+    const unsigned right = left + 1;
+    if (right < heap_size && HeapLess(right, left))
+      smallest = right;
+
+    if (!HeapLess(smallest, position))
+      break;
+
+    HeapSwap(position, smallest);
+    position = smallest;
+  }
+}
+
+void
+Trace::HeapPush(unsigned i)
+{
+  assert(heap_size < max_size);
+  assert(nodes[i].heap_index == NOT_QUEUED);
+
+  heap[heap_size] = i;
+  nodes[i].heap_index = heap_size;
+  HeapSiftUp(heap_size++);
+}
+
+void
+Trace::HeapRemove(unsigned i)
+{
+  const unsigned position = nodes[i].heap_index;
+  assert(position < heap_size);
+  assert(heap[position] == i);
+
+  nodes[i].heap_index = NOT_QUEUED;
+
+  if (position == --heap_size)
+    return;
+
+  heap[position] = heap[heap_size];
+  nodes[heap[position]].heap_index = position;
+  HeapUpdate(heap[position]);
+}
+
+void
+Trace::HeapUpdate(unsigned i)
+{
+  const unsigned position = nodes[i].heap_index;
+  if (position == NOT_QUEUED)
+    /* currently suppressed by EraseDelta(), will be pushed again
+       later */
+    return;
+
+  if (position > 0 && HeapLess(position, (position - 1) / 2))
+    HeapSiftUp(position);
+  else
+    HeapSiftDown(position);
+}
+
 unsigned
 Trace::GetRecentTime(const unsigned t) const
 {
@@ -72,43 +191,28 @@ Trace::GetRecentTime(const unsigned t) const
 }
 
 void
-Trace::UpdateDelta(TraceDelta &td)
+Trace::UpdateDelta(unsigned i)
 {
-  assert(cached_size == delta_list.size());
-  assert(cached_size == chronological_list.size());
-
-  if (&td == &chronological_list.front() ||
-      &td == &chronological_list.back())
+  if (i == GetFrontIndex() || i == GetBackIndex())
     return;
 
-  const auto ci = chronological_list.iterator_to(td);
-  const TraceDelta &previous = *std::prev(ci);
-  const TraceDelta &next = *std::next(ci);
-
-  delta_list.erase(delta_list.iterator_to(td));
-  td.Update(previous.point, next.point);
-  delta_list.insert(td);
+  TraceDelta &td = nodes[i];
+  td.Update(nodes[td.prev].point, nodes[td.next].point);
+  HeapUpdate(i);
 }
 
 void
-Trace::EraseInside(DeltaList::iterator it)
+Trace::EraseInside(unsigned i)
 {
   assert(cached_size > 0);
-  assert(cached_size == delta_list.size());
-  assert(cached_size == chronological_list.size());
-  assert(it != delta_list.end());
 
-  const TraceDelta &td = *it;
+  const TraceDelta &td = nodes[i];
   assert(!td.IsEdge());
 
-  const auto ci = chronological_list.iterator_to(td);
-  TraceDelta &previous = const_cast<TraceDelta &>(*std::prev(ci));
-  TraceDelta &next = const_cast<TraceDelta &>(*std::next(ci));
+  const unsigned previous = td.prev, next = td.next;
 
   // now delete the item
-  chronological_list.erase(chronological_list.iterator_to(td));
-  delta_list.erase_and_dispose(it, MakeDisposer());
-  --cached_size;
+  Free(i);
 
   // and update the deltas
   UpdateDelta(previous);
@@ -118,9 +222,6 @@ Trace::EraseInside(DeltaList::iterator it)
 bool
 Trace::EraseDelta(const unsigned target_size, const unsigned recent)
 {
-  assert(cached_size == delta_list.size());
-  assert(cached_size == chronological_list.size());
-
   if (size() <= 2)
     return false;
 
@@ -128,45 +229,44 @@ Trace::EraseDelta(const unsigned target_size, const unsigned recent)
 
   const unsigned recent_time = GetRecentTime(recent);
 
-  auto candidate = delta_list.begin();
-  while (size() > target_size) {
-    const TraceDelta &td = *candidate;
+  /* pop candidates from the heap until one may be erased; the
+     suppressed ones (edges and recent points) stay suppressed until
+     the end of this method, because erasing their neighbours can
+     change their rank but not that */
+  unsigned n_suppressed = 0;
+  while (size() > target_size && heap_size > 0) {
+    const unsigned i = heap[0];
+    const TraceDelta &td = nodes[i];
     if (!td.IsEdge() && td.point.GetTime() < recent_time) {
-      EraseInside(candidate);
-      candidate = delta_list.begin(); // find new top
+      EraseInside(i);
       modified = true;
     } else {
-      ++candidate;
-      // suppressed removal, skip it.
+      HeapRemove(i);
+      suppressed[n_suppressed++] = i;
     }
   }
 
+  for (unsigned j = 0; j < n_suppressed; ++j)
+    HeapPush(suppressed[j]);
+
   return modified;
 }
 
 bool
 Trace::EraseEarlierThan(const unsigned p_time)
 {
-  if (p_time == 0 || empty() || GetFront().point.GetTime() >= p_time)
+  if (p_time == 0 || empty() || front().GetTime() >= p_time)
     // there will be nothing to remove
     return false;
 
   do {
-    auto ci = chronological_list.begin();
-    TraceDelta &td = *ci;
-    chronological_list.erase(ci);
-
-    auto i = delta_list.find(td);
-    assert(i != delta_list.end());
-    delta_list.erase_and_dispose(i, MakeDisposer());
-
-    --cached_size;
-  } while (!empty() && GetFront().point.GetTime() < p_time);
+    Free(GetFrontIndex());
+  } while (!empty() && front().GetTime() < p_time);
 
   // need to set deltas for first point, only one of these
   // will occur (have to search for this point)
   if (!empty())
-    EraseStart(GetFront());
+    EraseStart(GetFrontIndex());
 
   ++modify_serial;
   ++append_serial;
@@ -179,44 +279,31 @@ Trace::EraseLaterThan(const unsigned min_time)
   assert(min_time > 0);
   assert(!empty());
 
-  while (!empty() && GetBack().point.GetTime() > min_time) {
-    TraceDelta &td = GetBack();
-
-    chronological_list.erase(chronological_list.iterator_to(td));
-
-    auto i = delta_list.find(td);
-    assert(i != delta_list.end());
-    delta_list.erase_and_dispose(i, MakeDisposer());
-
-    --cached_size;
-  }
+  while (!empty() && back().GetTime() > min_time)
+    Free(GetBackIndex());
 
   /* need to set deltas for first point, only one of these will occur
      (have to search for this point) */
   if (!empty())
-    EraseStart(GetBack());
+    EraseStart(GetBackIndex());
 }
 
 /**
  * Update start node (and neighbour) after min time pruning
  */
 void
-Trace::EraseStart(TraceDelta &td)
+Trace::EraseStart(unsigned i)
 {
-  delta_list.erase(delta_list.iterator_to(td));
-
+  TraceDelta &td = nodes[i];
   td.elim_distance = null_delta;
   td.elim_time = null_time;
 
-  delta_list.insert(td);
+  HeapUpdate(i);
 }
 
 void
 Trace::push_back(const TracePoint &point)
 {
-  assert(cached_size == delta_list.size());
-  assert(cached_size == chronological_list.size());
-
   if (empty()) {
     // first point determines origin for flat projection
     task_projection.Reset(point.GetLocation());
@@ -244,17 +331,14 @@ Trace::push_back(const TracePoint &point)
 
   assert(size() < max_size);
 
-  TraceDelta *td = allocator.allocate(1);
-  allocator.construct(td, point);
-  td->point.Project(task_projection);
-
-  delta_list.insert(*td);
-  chronological_list.push_back(*td);
-
-  ++cached_size;
+  const unsigned i = AllocateBack();
+  TraceDelta &td = nodes[i];
+  td.Set(point);
+  td.point.Project(task_projection);
+  HeapPush(i);
 
-  if (td != &chronological_list.front())
-    UpdateDelta(*std::prev(chronological_list.iterator_to(*td)));
+  if (i != GetFrontIndex())
+    UpdateDelta(td.prev);
 
   ++append_serial;
 }
@@ -266,10 +350,10 @@ Trace::CalcAverageDeltaDistance(const unsigned no_thin) const
   unsigned acc = 0;
   unsigned counter = 0;
 
-  const auto end = chronological_list.end();
-  for (auto it = chronological_list.begin();
-       it != end && it->point.GetTime() < r; ++it, ++counter)
-    acc += it->delta_distance;
+  for (unsigned i = GetFrontIndex();
+       i != GetSentinel() && nodes[i].point.GetTime() < r;
+       i = nodes[i].next, ++counter)
+    acc += nodes[i].delta_distance;
 
   if (counter)
     return acc / counter;
@@ -284,9 +368,8 @@ Trace::CalcAverageDeltaTime(const unsigned no_thin) const
   unsigned counter = 0;
 
   /* find the last item before the "r" timestamp */
-  const auto end = chronological_list.end();
-  ChronologicalList::const_iterator it;
-  for (it = chronological_list.begin(); it != end && it->point.GetTime() < r; ++it)
+  const_iterator it = begin();
+  for (; it != end() && it->GetTime() < r; ++it)
     ++counter;
 
   if (counter < 2)
@@ -296,7 +379,7 @@ Trace::CalcAverageDeltaTime(const unsigned no_thin) const
   --counter;
 
   unsigned start_time = front().GetTime();
-  unsigned end_time = it->point.GetTime();
+  unsigned end_time = it->GetTime();
   return (end_time - start_time) / counter;
 }
 
@@ -337,8 +420,6 @@ Trace::Thin2()
 void
 Trace::Thin()
 {
-  assert(cached_size == delta_list.size());
-  assert(cached_size == chronological_list.size());
   assert(size() == max_size);
 
   Thin2();
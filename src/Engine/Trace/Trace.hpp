@@ -26,17 +26,16 @@ Copyright_License {
 
 #include "Point.hpp"
 #include "Util/NonCopyable.hpp"
-#include "Util/SliceAllocator.hpp"
 #include "Util/Serial.hpp"
 #include "Geo/Flat/TaskProjection.hpp"
 #include "Compiler.h"
 
-#include <boost/intrusive/list.hpp>
-#include <boost/intrusive/set.hpp>
-
 #include <algorithm>
+#include <iterator>
+#include <memory>
 
 #include <assert.h>
+#include <stddef.h>
 #include <stdlib.h>
 
 class TracePointVector;
@@ -51,12 +50,16 @@ class TracePointerVector;
  * the candidate point removed.  In this version, time differences is also a
  * secondary factor, such that thinning attempts to remove points such that,
  * for equal distance ranking, smaller time step details are removed first.
+ *
+ * All points live in one array which is allocated by the constructor;
+ * a slot's address never changes while the point is stored.  The
+ * chronological order is a doubly linked list of slot indices, and
+ * the thinning candidates are kept in an indexed binary heap ordered
+ * by TraceDelta::DeltaRank().
  */
 class Trace : private NonCopyable
 {
-  struct TraceDelta
-    : boost::intrusive::set_base_hook<boost::intrusive::link_mode<boost::intrusive::normal_link>>,
-      boost::intrusive::list_base_hook<boost::intrusive::link_mode<boost::intrusive::normal_link>> {
+  struct TraceDelta {
 
     /**
      * Function used to points for sorting by deltas.
@@ -90,32 +93,30 @@ class Trace : private NonCopyable
       return false;
     }
 
-    struct DeltaRankOp {
-      gcc_pure
-      bool operator()(const TraceDelta &s1, const TraceDelta &s2) const {
-        return DeltaRank(s1, s2);
-      }
-    };
-
     TracePoint point;
 
     unsigned elim_time;
     unsigned elim_distance;
     unsigned delta_distance;
 
-    explicit TraceDelta(const TracePoint &p)
-      :point(p),
-       elim_time(null_time), elim_distance(null_delta),
-       delta_distance(0) {}
-
-    TraceDelta(const TracePoint &p_last, const TracePoint &p,
-               const TracePoint &p_next)
-      :point(p),
-       elim_time(TimeMetric(p_last, p, p_next)),
-       elim_distance(DistanceMetric(p_last, p, p_next)),
-       delta_distance(p.FlatDistanceTo(p_last))
-    {
-      assert(elim_distance != null_delta);
+    /**
+     * The neighbours in the chronological list (slot indices).  For a
+     * free slot, #next links the free list.
+     */
+    unsigned prev, next;
+
+    /**
+     * The position in #heap, or #NOT_QUEUED.
+     */
+    unsigned heap_index;
+
+    TraceDelta() = default;
+
+    void Set(const TracePoint &p) {
+      point = p;
+      elim_time = null_time;
+      elim_distance = null_delta;
+      delta_distance = 0;
     }
 
     /**
@@ -168,19 +169,34 @@ class Trace : private NonCopyable
     }
   };
 
-  /* using multiset, not because we need multiple values (we don't),
-     but to avoid set's overhead for duplicate elimination */
-  typedef boost::intrusive::multiset<TraceDelta,
-                                     boost::intrusive::compare<TraceDelta::DeltaRankOp>,
-                                     boost::intrusive::constant_time_size<false>> DeltaList;
+  static constexpr unsigned NOT_QUEUED = 0 - 1;
+
+  /**
+   * The point storage: #max_size slots plus the sentinel at index
+   * #max_size, which is the list head; its #next is the oldest and
+   * its #prev the newest point.
+   */
+  const std::unique_ptr<TraceDelta[]> nodes;
+
+  /**
+   * An indexed binary min-heap of slot indices; the top is the best
+   * candidate for thinning.
+   */
+  const std::unique_ptr<unsigned[]> heap;
+  unsigned heap_size;
 
-  typedef boost::intrusive::list<TraceDelta,
-                                 boost::intrusive::constant_time_size<false>> ChronologicalList;
+  /**
+   * Scratch space for EraseDelta(): candidates which were popped from
+   * the heap because they may not be erased right now.
+   */
+  const std::unique_ptr<unsigned[]> suppressed;
 
-  SliceAllocator<TraceDelta, 128u> allocator;
+  /**
+   * The first free slot; the free list is linked through
+   * TraceDelta::next.
+   */
+  unsigned free_head;
 
-  DeltaList delta_list;
-  ChronologicalList chronological_list;
   unsigned cached_size;
 
   TaskProjection task_projection;
@@ -195,25 +211,6 @@ class Trace : private NonCopyable
 
   Serial append_serial, modify_serial;
 
-  template<typename Alloc>
-  struct Disposer {
-    Alloc &alloc;
-
-    void operator()(typename Alloc::pointer td) {
-      alloc.destroy(td);
-      alloc.deallocate(td, 1);
-    }
-  };
-
-  template<typename Alloc>
-  static Disposer<Alloc> MakeDisposer(Alloc &alloc) {
-    return {alloc};
-  }
-
-  Disposer<decltype(allocator)> MakeDisposer() {
-    return MakeDisposer(allocator);
-  }
-
 public:
   /**
    * Constructor.  Task projection is updated after first call to append().
@@ -227,10 +224,6 @@ public:
                  const unsigned max_time = null_time,
                  const unsigned max_size = 1000);
 
-  ~Trace() {
-    clear();
-  }
-
 protected:
   /**
    * Find recent time after which points should not be culled
@@ -244,25 +237,20 @@ protected:
   unsigned GetRecentTime(const unsigned t) const;
 
   /**
-   * Update delta values for specified item in the delta list and the
-   * tree.  This repositions the item after into its sorted position.
+   * Update delta values for specified item and reposition it in the
+   * heap.
    *
-   * @param it Item to update
-   * @param tree Tree containing leaf
-   *
-   * @return Iterator to updated item
+   * @param i Slot index of the item to update
    */
-  void UpdateDelta(TraceDelta &td);
+  void UpdateDelta(unsigned i);
 
   /**
-   * Erase a non-edge item from delta list and tree, updating
-   * deltas in the process.  This Invalidates the calling iterator.
-   *
-   * @param it Item to erase
-   * @param tree Tree to remove from
+   * Erase a non-edge item, updating the deltas of its neighbours in
+   * the process.
    *
+   * @param i Slot index of the item to erase
    */
-  void EraseInside(DeltaList::iterator it);
+  void EraseInside(unsigned i);
 
   /**
    * Erase elements based on delta metric until the size is
@@ -301,7 +289,7 @@ protected:
   /**
    * Update start node (and neighbour) after min time pruning
    */
-  void EraseStart(TraceDelta &td_start);
+  void EraseStart(unsigned i);
 
 public:
   /**
@@ -400,13 +388,13 @@ public:
   const TracePoint &front() const {
     assert(!empty());
 
-    return chronological_list.front().point;
+    return nodes[GetFrontIndex()].point;
   }
 
   const TracePoint &back() const {
     assert(!empty());
 
-    return chronological_list.back().point;
+    return nodes[GetBackIndex()].point;
   }
 
 private:
@@ -433,18 +421,56 @@ private:
    */
   void Thin();
 
-  TraceDelta &GetFront() {
-    assert(!empty());
+  /**
+   * The index of the sentinel slot, see #nodes.
+   */
+  unsigned GetSentinel() const {
+    return max_size;
+  }
 
-    return chronological_list.front();
+  unsigned GetFrontIndex() const {
+    return nodes[GetSentinel()].next;
   }
 
-  TraceDelta &GetBack() {
-    assert(!empty());
+  unsigned GetBackIndex() const {
+    return nodes[GetSentinel()].prev;
+  }
 
-    return chronological_list.back();
+  /**
+   * Take a slot from the free list and append it to the
+   * chronological list.
+   */
+  unsigned AllocateBack();
+
+  /**
+   * Remove a slot from the chronological list and from the heap, and
+   * return it to the free list.
+   */
+  void Free(unsigned i);
+
+  gcc_pure
+  bool HeapLess(unsigned a, unsigned b) const {
+    return TraceDelta::DeltaRank(nodes[heap[a]], nodes[heap[b]]);
   }
 
+  void HeapSwap(unsigned a, unsigned b) {
+    std::swap(heap[a], heap[b]);
+    nodes[heap[a]].heap_index = a;
+    nodes[heap[b]].heap_index = b;
+  }
+
+  void HeapSiftUp(unsigned position);
+  void HeapSiftDown(unsigned position);
+
+  void HeapPush(unsigned i);
+  void HeapRemove(unsigned i);
+
+  /**
+   * Restore the heap order after the rank of the given slot has
+   * changed.
+   */
+  void HeapUpdate(unsigned i);
+
   gcc_pure
   unsigned CalcAverageDeltaDistance(const unsigned no_thin) const;
 
@@ -465,15 +491,18 @@ public:
   }
 
 public:
-  class const_iterator : public ChronologicalList::const_iterator {
+  class const_iterator {
     friend class Trace;
 
-    const_iterator(ChronologicalList::const_iterator &&_iterator)
-      :ChronologicalList::const_iterator(std::move(_iterator)) {}
+    const TraceDelta *nodes;
+    unsigned index;
+
+    const_iterator(const TraceDelta *_nodes, unsigned _index)
+      :nodes(_nodes), index(_index) {}
 
   public:
-    using ChronologicalList::const_iterator::iterator_category;
-    using ChronologicalList::const_iterator::difference_type;
+    typedef std::bidirectional_iterator_tag iterator_category;
+    typedef ptrdiff_t difference_type;
     typedef const TracePoint value_type;
     typedef const TracePoint *pointer;
     typedef const TracePoint &reference;
@@ -481,13 +510,29 @@ public:
     const_iterator() = default;
 
     const TracePoint &operator*() const {
-      const TraceDelta &td = ChronologicalList::const_iterator::operator*();
-      return td.point;
+      return nodes[index].point;
     }
 
     const TracePoint *operator->() const {
-      const TraceDelta &td = ChronologicalList::const_iterator::operator*();
-      return &td.point;
+      return &nodes[index].point;
+    }
+
+    const_iterator &operator++() {
+      index = nodes[index].next;
+      return *this;
+    }
+
+    const_iterator &operator--() {
+      index = nodes[index].prev;
+      return *this;
+    }
+
+    bool operator==(const const_iterator &other) const {
+      return index == other.index;
+    }
+
+    bool operator!=(const const_iterator &other) const {
+      return index != other.index;
     }
 
     const_iterator &NextSquareRange(unsigned sq_resolution,
@@ -499,19 +544,18 @@ public:
         if (*this == end)
           return *this;
 
-        const TraceDelta &td = (const TraceDelta &)**this;
-        if (td.point.FlatSquareDistanceTo(previous) >= sq_resolution)
+        if ((**this).FlatSquareDistanceTo(previous) >= sq_resolution)
           return *this;
       }
     }
   };
 
   const_iterator begin() const {
-    return chronological_list.begin();
+    return const_iterator(nodes.get(), GetFrontIndex());
   }
 
   const_iterator end() const {
-    return chronological_list.end();
+    return const_iterator(nodes.get(), GetSentinel());
   }
 
   const TaskProjection &GetProjection() const {
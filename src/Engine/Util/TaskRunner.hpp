@@ -0,0 +1,64 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#ifndef XCSOAR_ENGINE_TASK_RUNNER_HPP
+#define XCSOAR_ENGINE_TASK_RUNNER_HPP
+
+/**
+ * An interface for running a number of independent tasks, possibly
+ * in parallel.  Libraries which do not want to depend on threads
+ * (e.g. the task engine) accept a pointer to this interface; nullptr
+ * means "run serially".
+ */
+class TaskRunner {
+public:
+  class Job {
+  public:
+    /**
+     * Execute one task.  This may be called from any thread, and
+     * concurrently with other tasks of the same job.
+     *
+     * @param i the task index, 0..n-1
+     */
+    virtual void RunTask(unsigned i) = 0;
+  };
+
+  /**
+   * Returns the number of tasks which may run at the same time.
+   */
+  virtual unsigned GetConcurrency() const = 0;
+
+  /**
+   * Run the tasks 0..n-1 of the specified job and wait until all of
+   * them have finished.  The calling thread participates.
+   *
+   * Implementations are not required to be reentrant: this must not
+   * be called concurrently from two threads, and a task must not
+   * call Run() on the same runner.  A runner must therefore not be
+   * shared between callers which may run at the same time; each of
+   * them owns its own instance.
+   */
+  virtual void Run(Job &job, unsigned n) = 0;
+};
+
+#endif
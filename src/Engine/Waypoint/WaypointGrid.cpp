@@ -0,0 +1,159 @@
+/* Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+ */
+
+#include "WaypointGrid.hpp"
+#include "Waypoint.hpp"
+
+#include <algorithm>
+
+#include <assert.h>
+#include <math.h>
+
+/**
+ * The desired average number of waypoints per cell.
+ */
+static constexpr unsigned WAYPOINTS_PER_CELL = 4;
+
+void
+WaypointGrid::Clear()
+{
+  offsets.clear();
+  xs.clear();
+  ys.clear();
+  items.clear();
+}
+
+size_t
+WaypointGrid::GetMemoryUsage() const
+{
+  return offsets.capacity() * sizeof(offsets.front()) +
+    xs.capacity() * sizeof(xs.front()) +
+    ys.capacity() * sizeof(ys.front()) +
+    items.capacity() * sizeof(items.front());
+}
+
+unsigned
+WaypointGrid::GetColumn(int x) const
+{
+  assert(x >= x_min);
+
+  return unsigned(x - x_min) / cell_size;
+}
+
+unsigned
+WaypointGrid::GetRow(int y) const
+{
+  assert(y >= y_min);
+
+  return unsigned(y - y_min) / cell_size;
+}
+
+void
+WaypointGrid::Build(std::vector<const WaypointPtr *> &&v)
+{
+  Clear();
+
+  if (v.empty())
+    return;
+
+  int x_max, y_max;
+  x_min = x_max = (*v.front())->flat_location.x;
+  y_min = y_max = (*v.front())->flat_location.y;
+  for (const auto i : v) {
+    const FlatGeoPoint &p = (*i)->flat_location;
+    x_min = std::min(x_min, p.x);
+    x_max = std::max(x_max, p.x);
+    y_min = std::min(y_min, p.y);
+    y_max = std::max(y_max, p.y);
+  }
+
+  const unsigned n = v.size();
+  const double width = double(x_max - x_min) + 1;
+  const double height = double(y_max - y_min) + 1;
+
+  const unsigned n_cells = std::max(n / WAYPOINTS_PER_CELL, 1u);
+  cell_size = std::max(unsigned(ceil(sqrt(width * height / n_cells))), 1u);
+
+  /* avoid lots of empty cells if the waypoints are on a line */
+  while (true) {
+    columns = unsigned(x_max - x_min) / cell_size + 1;
+    rows = unsigned(y_max - y_min) / cell_size + 1;
+    if (uint64_t(columns) * rows <= 4 * uint64_t(n_cells) + 16)
+      break;
+
+    cell_size *= 2;
+  }
+
+  /* counting sort by cell */
+
+  std::vector<uint32_t> cells;
+  cells.reserve(n);
+  offsets.assign(columns * rows + 1, 0);
+  for (const auto i : v) {
+    const FlatGeoPoint &p = (*i)->flat_location;
+    const uint32_t cell = GetRow(p.y) * columns + GetColumn(p.x);
+    cells.push_back(cell);
+    ++offsets[cell];
+  }
+
+  uint32_t total = 0;
+  for (auto &i : offsets) {
+    const uint32_t count = i;
+    i = total;
+    total += count;
+  }
+
+  xs.resize(n);
+  ys.resize(n);
+  items.resize(n);
+
+  std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+  for (unsigned i = 0; i < n; ++i) {
+    const uint32_t j = fill[cells[i]]++;
+    xs[j] = (*v[i])->flat_location.x;
+    ys[j] = (*v[i])->flat_location.y;
+    items[j] = v[i];
+  }
+}
+
+bool
+WaypointGrid::GetCells(FlatGeoPoint location, unsigned range,
+                       unsigned &col_begin, unsigned &col_end,
+                       unsigned &row_begin, unsigned &row_end) const
+{
+  const int64_t left = int64_t(location.x) - range;
+  const int64_t right = int64_t(location.x) + range;
+  const int64_t bottom = int64_t(location.y) - range;
+  const int64_t top = int64_t(location.y) + range;
+
+  const int64_t x_max = x_min + int64_t(columns) * cell_size - 1;
+  const int64_t y_max = y_min + int64_t(rows) * cell_size - 1;
+
+  if (right < x_min || left > x_max || top < y_min || bottom > y_max)
+    return false;
+
+  col_begin = left > x_min ? GetColumn(int(left)) : 0;
+  col_end = right < x_max ? GetColumn(int(right)) + 1 : columns;
+  row_begin = bottom > y_min ? GetRow(int(bottom)) : 0;
+  row_end = top < y_max ? GetRow(int(top)) + 1 : rows;
+  return true;
+}
@@ -0,0 +1,142 @@
+/* Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+ */
+
+#ifndef XCSOAR_WAYPOINT_GRID_HPP
+#define XCSOAR_WAYPOINT_GRID_HPP
+
+#include "Ptr.hpp"
+#include "Geo/Flat/FlatGeoPoint.hpp"
+#include "Compiler.h"
+
+#include <vector>
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * A compact read-only spatial index of waypoints.  The projected
+ * locations are sorted into the cells of a uniform grid and stored
+ * as contiguous arrays ("structure of arrays"), which makes range
+ * queries much more cache friendly than walking the #QuadTree and
+ * dereferencing each #WaypointPtr.
+ *
+ * It is built by Waypoints::Optimise() and discarded on every
+ * modification.
+ */
+class WaypointGrid {
+  int x_min, y_min;
+
+  /** size of a (square) cell in flat units */
+  unsigned cell_size;
+
+  unsigned columns, rows;
+
+  /**
+   * The index of the first waypoint of each cell (row by row), plus
+   * the end of the last cell.
+   */
+  std::vector<uint32_t> offsets;
+
+  std::vector<int32_t> xs, ys;
+
+  /**
+   * Pointers to the #WaypointPtr instances in the container this
+   * grid was built from.  They are only valid until that container
+   * is modified, which must clear the grid.
+   */
+  std::vector<const WaypointPtr *> items;
+
+public:
+  bool IsDefined() const {
+    return !offsets.empty();
+  }
+
+  /**
+   * Build the grid from a range of projected waypoints.  The
+   * iterators must refer to #WaypointPtr instances which are not
+   * moved or destroyed until Clear() is called.
+   */
+  template<typename I>
+  void Build(I begin, I end) {
+    std::vector<const WaypointPtr *> v;
+    for (I i = begin; i != end; ++i)
+      v.push_back(&*i);
+    Build(std::move(v));
+  }
+
+  void Build(std::vector<const WaypointPtr *> &&v);
+
+  void Clear();
+
+  /**
+   * Calculate the approximate number of bytes allocated by this
+   * object (not including the waypoints).
+   */
+  gcc_pure
+  size_t GetMemoryUsage() const;
+
+  /**
+   * Invoke the visitor for each waypoint within the given range.
+   * The distance calculation is the same as in QuadTree, but the
+   * order is different.
+   */
+  template<typename V>
+  void VisitWithinRange(FlatGeoPoint location, unsigned range,
+                        V &visitor) const {
+    unsigned col_begin, col_end, row_begin, row_end;
+    if (!GetCells(location, range, col_begin, col_end, row_begin, row_end))
+      return;
+
+    const unsigned square_range = range * range;
+
+    for (unsigned row = row_begin; row < row_end; ++row) {
+      /* the cells of a row are adjacent in the arrays */
+      const unsigned begin = offsets[row * columns + col_begin];
+      const unsigned end = offsets[row * columns + col_end];
+
+      for (unsigned i = begin; i < end; ++i) {
+        const int dx = xs[i] - location.x, dy = ys[i] - location.y;
+        if (unsigned(dx * dx) + unsigned(dy * dy) <= square_range)
+          visitor(*items[i]);
+      }
+    }
+  }
+
+private:
+  gcc_pure
+  unsigned GetColumn(int x) const;
+
+  gcc_pure
+  unsigned GetRow(int y) const;
+
+  /**
+   * Determine the range of cells which overlaps the square around
+   * the given location.
+   *
+   * @return false if there is no overlap
+   */
+  bool GetCells(FlatGeoPoint location, unsigned range,
+                unsigned &col_begin, unsigned &col_end,
+                unsigned &row_begin, unsigned &row_end) const;
+};
+
+#endif
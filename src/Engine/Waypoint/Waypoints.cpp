@@ -125,19 +125,23 @@ Waypoints::Waypoints()
 void
 Waypoints::Optimise()
 {
-  if (waypoint_tree.IsEmpty() || waypoint_tree.HaveBounds())
-    /* empty or already optimised */
+  if (waypoint_tree.IsEmpty())
     return;
 
-  task_projection.Update();
+  if (!waypoint_tree.HaveBounds()) {
+    task_projection.Update();
 
-  for (auto &i : waypoint_tree) {
-    // TODO: eliminate this const_cast hack
-    Waypoint &w = const_cast<Waypoint &>(*i);
-    w.Project(task_projection);
+    for (auto &i : waypoint_tree) {
+      // TODO: eliminate this const_cast hack
+      Waypoint &w = const_cast<Waypoint &>(*i);
+      w.Project(task_projection);
+    }
+
+    waypoint_tree.Optimise();
   }
 
-  waypoint_tree.Optimise();
+  if (!grid.IsDefined())
+    grid.Build(waypoint_tree.begin(), waypoint_tree.end());
 }
 
 void
@@ -160,6 +164,7 @@ Waypoints::Append(WaypointPtr wp)
 
   waypoint_tree.Add(wp);
   name_tree.Add(wp);
+  grid.Clear();
 
   ++serial;
 }
@@ -283,7 +288,10 @@ Waypoints::VisitWithinRange(const GeoPoint &loc, const double range,
 
   WaypointEnvelopeVisitor wve(&visitor);
 
-  waypoint_tree.VisitWithinRange(point, mrange, wve);
+  if (grid.IsDefined())
+    grid.VisitWithinRange(flat_location, mrange, wve);
+  else
+    waypoint_tree.VisitWithinRange(point, mrange, wve);
 }
 
 void
@@ -300,6 +308,7 @@ Waypoints::Clear()
   home = nullptr;
   name_tree.Clear();
   waypoint_tree.clear();
+  grid.Clear();
   next_id = 1;
 }
 
@@ -317,6 +326,7 @@ Waypoints::Erase(WaypointPtr &&wp)
 
   name_tree.Remove(std::move(wp));
   waypoint_tree.erase(f.first);
+  grid.Clear();
   ++serial;
 }
 
@@ -330,6 +340,7 @@ Waypoints::EraseUserMarkers()
           home = nullptr;
 
         name_tree.Remove(wp);
+        grid.Clear();
         ++serial;
         return true;
       } else
@@ -355,8 +366,9 @@ Waypoints::Replace(const WaypointPtr &orig, Waypoint &&replacement)
       ScheduleOptimise();
   }
 
-  WaypointPtr new_ptr(new Waypoint(std::move(replacement)));
+  WaypointPtr new_ptr = std::make_shared<Waypoint>(std::move(replacement));
   name_tree.Add(new_ptr);
+  grid.Clear();
 
   auto f = waypoint_tree.FindNearestIf(waypoint_tree.GetPosition(orig), 0,
                                        [&orig](const WaypointPtr &ptr){
@@ -25,6 +25,7 @@
 #include "Util/RadixTree.hpp"
 #include "Util/QuadTree.hpp"
 #include "Util/Serial.hpp"
+#include "WaypointGrid.hpp"
 #include "Ptr.hpp"
 #include "Waypoint.hpp"
 #include "Geo/Flat/TaskProjection.hpp"
@@ -76,6 +77,12 @@ class Waypoints {
 
   WaypointTree waypoint_tree;
   WaypointNameTree name_tree;
+
+  /**
+   * A compact copy of #waypoint_tree for range queries, built by
+   * Optimise() and cleared on every modification.
+   */
+  WaypointGrid grid;
   TaskProjection task_projection;
 
   WaypointPtr home;
@@ -116,7 +123,7 @@ public:
    * @param wp Waypoint to add to internal store
    */
   WaypointPtr Append(Waypoint &&wp) {
-    WaypointPtr ptr(new Waypoint(std::move(wp)));
+    WaypointPtr ptr = std::make_shared<Waypoint>(std::move(wp));
     Append(ptr);
     return ptr;
   }
@@ -169,6 +176,7 @@ public:
    * Prepare and enable the next Optimise() call.
    */
   void ScheduleOptimise() {
+    grid.Clear();
     waypoint_tree.Flatten();
     waypoint_tree.ClearBounds();
   }
@@ -189,6 +197,15 @@ public:
     return waypoint_tree.size();
   }
 
+  /**
+   * Calculate the approximate number of bytes allocated by the
+   * spatial index (not including the waypoints).
+   */
+  gcc_pure
+  size_t GetIndexMemoryUsage() const {
+    return grid.GetMemoryUsage();
+  }
+
   /**
    * Whether waypoints store is empty
    *
@@ -27,12 +27,19 @@ Copyright_License {
 #include "FLARM/FlarmId.hpp"
 #include "Computer/ClimbAverageCalculator.hpp"
 
-#include <map>
+#include <unordered_map>
 
 class FlarmCalculations
 {
 private:
-  typedef std::map<FlarmId, ClimbAverageCalculator> AverageCalculatorMap;
+  struct FlarmIdHash {
+    size_t operator()(FlarmId id) const {
+      return id.Hash();
+    }
+  };
+
+  typedef std::unordered_map<FlarmId, ClimbAverageCalculator,
+                             FlarmIdHash> AverageCalculatorMap;
   AverageCalculatorMap averageCalculatorMap;
 
 public:
@@ -29,12 +29,12 @@ Copyright_License {
 
 #include <assert.h>
 
-const FlarmNetRecord *
+FlarmNetRecord
 FlarmDetails::LookupRecord(FlarmId id)
 {
   // try to find flarm from FlarmNet.org File
   if (traffic_databases == nullptr)
-    return NULL;
+    return FlarmNetRecord::Undefined();
 
   return traffic_databases->flarm_net.FindRecordById(id);
 }
@@ -23,10 +23,11 @@ Copyright_License {
 #ifndef XCSOAR_UTILS_FLARM_HPP
 #define XCSOAR_UTILS_FLARM_HPP
 
+#include "FlarmNetRecord.hpp"
+
 #include <tchar.h>
 
 class FlarmId;
-struct FlarmNetRecord;
 
 namespace FlarmDetails
 {
@@ -34,9 +35,10 @@ namespace FlarmDetails
    * Looks up the FLARM id in the FLARMNet Database
    * and returns the FLARMNet Record
    * @param id FLARM id
-   * @return The corresponding FLARMNet Record if found, otherwise NULL
+   * @return The corresponding FLARMNet Record (check
+   * FlarmNetRecord::IsDefined())
    */
-  const FlarmNetRecord *
+  FlarmNetRecord
   LookupRecord(FlarmId id);
 
   /**
@@ -65,6 +65,18 @@ public:
     return value < other.value;
   }
 
+  /**
+   * Returns a hash code for hash tables.  The bits are mixed, so
+   * tables may use only the lowest ones.
+   */
+  constexpr uint32_t Hash() const {
+    uint32_t h = value;
+    h ^= h >> 16;
+    h *= 0x45d9f3b;
+    h ^= h >> 16;
+    return h;
+  }
+
   static FlarmId Parse(const char *input, char **endptr_r);
 #ifdef _UNICODE
   static FlarmId Parse(const TCHAR *input, TCHAR **endptr_r);
@@ -22,48 +22,250 @@ Copyright_License {
 */
 
 #include "FlarmNetDatabase.hpp"
-#include "Util/StringUtil.hpp"
+#include "OS/FileMapping.hpp"
+#include "Util/StringAPI.hxx"
+#include "Util/StringCompare.hxx"
+
+#include <algorithm>
 
 #include <assert.h>
+#include <string.h>
+
+gcc_const
+static size_t
+Align(size_t position, size_t align)
+{
+  return (position + align - 1) / align * align;
+}
+
+/**
+ * Check whether the specified section fits into the image.
+ */
+gcc_pure
+static bool
+CheckSection(uint32_t offset, size_t count, size_t element_size,
+             size_t align, size_t image_size)
+{
+  return offset % align == 0 && offset <= image_size &&
+    count <= (image_size - offset) / element_size;
+}
+
+FlarmNetDatabase::FlarmNetDatabase()
+  :image(nullptr), image_size(0),
+   records(nullptr), num_records(0),
+   hash(nullptr), hash_mask(0),
+   callsign_index(nullptr), strings(nullptr) {}
+
+FlarmNetDatabase::~FlarmNetDatabase() = default;
 
 void
-FlarmNetDatabase::Insert(const FlarmNetRecord &record)
+FlarmNetDatabase::Clear()
 {
-  FlarmId id = record.GetId();
-  if (!id.IsDefined())
-    /* ignore malformed records */
-    return;
+  mapping.reset();
+  std::vector<uint8_t>().swap(buffer);
 
-  map.insert(std::make_pair(id, record));
+  image = nullptr;
+  image_size = 0;
+  records = nullptr;
+  num_records = 0;
+  hash = nullptr;
+  hash_mask = 0;
+  callsign_index = nullptr;
+  strings = nullptr;
 }
 
-const FlarmNetRecord *
-FlarmNetDatabase::FindFirstRecordByCallSign(const TCHAR *cn) const
+void
+FlarmNetDatabase::Load(const FlarmNetDatabaseBuilder &builder)
+{
+  Clear();
+
+  builder.Build(buffer);
+  if (!Open(buffer.data(), buffer.size())) {
+    assert(false);
+    Clear();
+  }
+}
+
+bool
+FlarmNetDatabase::Open(std::unique_ptr<FileMapping> &&_mapping,
+                       size_t offset)
+{
+  Clear();
+
+  assert(_mapping);
+  assert(!_mapping->error());
+  assert(offset <= _mapping->size());
+
+  /* Save() has padded the image to the file alignment */
+  offset = Align(offset, ALIGNMENT);
+  if (offset > _mapping->size() ||
+      !Open((const uint8_t *)_mapping->at(offset),
+            _mapping->size() - offset)) {
+    Clear();
+    return false;
+  }
+
+  mapping = std::move(_mapping);
+  return true;
+}
+
+bool
+FlarmNetDatabase::Open(const uint8_t *p, size_t size)
 {
-  for (const auto &i : map) {
-    assert(i.first.IsDefined());
+  if (size < sizeof(Header) || (uintptr_t)p % ALIGNMENT != 0)
+    return false;
 
-    const FlarmNetRecord &record = i.second;
-    if (StringIsEqual(record.callsign, cn))
-      return &record;
+  Header header;
+  memcpy(&header, p, sizeof(header));
+  if (header.magic != MAGIC || header.version != VERSION ||
+      header.tchar_size != sizeof(TCHAR) ||
+      header.hash_size == 0 ||
+      (header.hash_size & (header.hash_size - 1)) != 0 ||
+      header.hash_size <= header.num_records ||
+      !CheckSection(header.records_offset, header.num_records,
+                    sizeof(Record), alignof(Record), size) ||
+      !CheckSection(header.hash_offset, header.hash_size,
+                    sizeof(uint32_t), alignof(uint32_t), size) ||
+      !CheckSection(header.callsign_offset, header.num_records,
+                    sizeof(uint32_t), alignof(uint32_t), size) ||
+      header.strings_length == 0 ||
+      !CheckSection(header.strings_offset, header.strings_length,
+                    sizeof(TCHAR), alignof(TCHAR), size))
+    return false;
+
+  const TCHAR *const _strings = (const TCHAR *)(p + header.strings_offset);
+  if (_strings[header.strings_length - 1] != _T('\0'))
+    return false;
+
+  /* validate all references once, so lookups don't need to */
+
+  const Record *const _records = (const Record *)(p + header.records_offset);
+  for (unsigned i = 0; i < header.num_records; ++i) {
+    if (!_records[i].id.IsDefined())
+      return false;
+
+    for (const auto position : _records[i].strings)
+      if (position >= header.strings_length)
+        return false;
   }
 
-  return NULL;
+  const uint32_t *const _hash = (const uint32_t *)(p + header.hash_offset);
+  for (unsigned i = 0; i < header.hash_size; ++i)
+    if (_hash[i] != NONE && _hash[i] >= header.num_records)
+      return false;
+
+  const uint32_t *const _callsign_index =
+    (const uint32_t *)(p + header.callsign_offset);
+  for (unsigned i = 0; i < header.num_records; ++i)
+    if (_callsign_index[i] >= header.num_records)
+      return false;
+
+  image = p;
+  image_size = size;
+  records = _records;
+  num_records = header.num_records;
+  hash = _hash;
+  hash_mask = header.hash_size - 1;
+  callsign_index = _callsign_index;
+  strings = _strings;
+  return true;
+}
+
+bool
+FlarmNetDatabase::Save(FILE *file) const
+{
+  if (image == nullptr)
+    return false;
+
+  static constexpr uint8_t zero[ALIGNMENT] = {};
+  const long start = ftell(file);
+  if (start < 0)
+    return false;
+
+  const size_t padding = Align(start, ALIGNMENT) - start;
+  return (padding == 0 || fwrite(zero, 1, padding, file) == padding) &&
+    fwrite(image, 1, image_size, file) == image_size;
+}
+
+FlarmNetRecord
+FlarmNetDatabase::GetRecord(unsigned i) const
+{
+  assert(i < num_records);
+
+  const Record &record = records[i];
+  return {
+    GetString(record, ID),
+    GetString(record, PILOT),
+    GetString(record, AIRFIELD),
+    GetString(record, PLANE_TYPE),
+    GetString(record, REGISTRATION),
+    GetString(record, CALLSIGN),
+    GetString(record, FREQUENCY),
+  };
+}
+
+FlarmNetRecord
+FlarmNetDatabase::FindRecordById(FlarmId id) const
+{
+  if (IsEmpty())
+    return FlarmNetRecord::Undefined();
+
+  /* linear probing; the table is at most half full */
+  unsigned slot = id.Hash() & hash_mask;
+  for (unsigned n = 0; n <= hash_mask; ++n) {
+    const uint32_t i = hash[slot];
+    if (i == NONE)
+      break;
+
+    if (records[i].id == id)
+      return GetRecord(i);
+
+    slot = (slot + 1) & hash_mask;
+  }
+
+  return FlarmNetRecord::Undefined();
+}
+
+unsigned
+FlarmNetDatabase::LowerBoundCallSign(const TCHAR *cn) const
+{
+  const auto end = callsign_index + num_records;
+  const auto i = std::lower_bound(callsign_index, end, cn,
+                                  [this](uint32_t index, const TCHAR *b){
+                                    return _tcscmp(GetString(records[index],
+                                                             CALLSIGN),
+                                                   b) < 0;
+                                  });
+  return i - callsign_index;
+}
+
+FlarmNetRecord
+FlarmNetDatabase::FindFirstRecordByCallSign(const TCHAR *cn) const
+{
+  const unsigned i = LowerBoundCallSign(cn);
+  if (i < num_records) {
+    const unsigned index = callsign_index[i];
+    if (StringIsEqual(GetString(records[index], CALLSIGN), cn))
+      return GetRecord(index);
+  }
+
+  return FlarmNetRecord::Undefined();
 }
 
 unsigned
 FlarmNetDatabase::FindRecordsByCallSign(const TCHAR *cn,
-                                        const FlarmNetRecord *array[],
+                                        FlarmNetRecord array[],
                                         unsigned size) const
 {
   unsigned count = 0;
 
-  for (const auto &i : map) {
-    assert(i.first.IsDefined());
+  for (unsigned i = LowerBoundCallSign(cn);
+       i < num_records && count < size; ++i) {
+    const unsigned index = callsign_index[i];
+    if (!StringIsEqual(GetString(records[index], CALLSIGN), cn))
+      break;
 
-    const FlarmNetRecord &record = i.second;
-    if (StringIsEqual(record.callsign, cn))
-      array[count++] = &record;
+    array[count++] = GetRecord(index);
   }
 
   return count;
@@ -75,13 +277,159 @@ FlarmNetDatabase::FindIdsByCallSign(const TCHAR *cn, FlarmId array[],
 {
   unsigned count = 0;
 
-  for (const auto &i : map) {
-    assert(i.first.IsDefined());
+  for (unsigned i = LowerBoundCallSign(cn);
+       i < num_records && count < size; ++i) {
+    const Record &record = records[callsign_index[i]];
+    if (!StringIsEqual(GetString(record, CALLSIGN), cn))
+      break;
 
-    const FlarmNetRecord &record = i.second;
-    if (StringIsEqual(record.callsign, cn))
-      array[count++] = i.first;
+    array[count++] = record.id;
   }
 
   return count;
 }
+
+unsigned
+FlarmNetDatabase::FindIdsByCallSignPrefix(const TCHAR *prefix,
+                                          FlarmId array[],
+                                          unsigned size) const
+{
+  /* all callsigns beginning with the prefix sort right after the
+     prefix itself */
+  unsigned count = 0;
+
+  for (unsigned i = LowerBoundCallSign(prefix);
+       i < num_records && count < size; ++i) {
+    const Record &record = records[callsign_index[i]];
+    if (!StringStartsWith(GetString(record, CALLSIGN), prefix))
+      break;
+
+    array[count++] = record.id;
+  }
+
+  return count;
+}
+
+FlarmNetDatabaseBuilder::FlarmNetDatabaseBuilder()
+  :strings(1, _T('\0'))
+{
+  positions.emplace(tstring(), 0);
+}
+
+uint32_t
+FlarmNetDatabaseBuilder::Intern(const TCHAR *value)
+{
+  assert(value != nullptr);
+
+  const auto result = positions.emplace(value, strings.length());
+  if (result.second) {
+    strings.append(value);
+    strings.push_back(_T('\0'));
+  }
+
+  return result.first->second;
+}
+
+void
+FlarmNetDatabaseBuilder::Add(const FlarmNetRecord &src)
+{
+  assert(src.IsDefined());
+
+  FlarmNetDatabase::Record record;
+  record.id = src.GetId();
+  if (!record.id.IsDefined())
+    /* ignore malformed records */
+    return;
+
+  record.strings[FlarmNetDatabase::ID] = Intern(src.id);
+  record.strings[FlarmNetDatabase::PILOT] = Intern(src.pilot);
+  record.strings[FlarmNetDatabase::AIRFIELD] = Intern(src.airfield);
+  record.strings[FlarmNetDatabase::PLANE_TYPE] = Intern(src.plane_type);
+  record.strings[FlarmNetDatabase::REGISTRATION] = Intern(src.registration);
+  record.strings[FlarmNetDatabase::CALLSIGN] = Intern(src.callsign);
+  record.strings[FlarmNetDatabase::FREQUENCY] = Intern(src.frequency);
+  records.push_back(record);
+}
+
+void
+FlarmNetDatabaseBuilder::Build(std::vector<uint8_t> &image) const
+{
+  typedef FlarmNetDatabase::Record Record;
+
+  /* sort by id; the stable sort keeps the first of duplicate ids
+     first, so std::unique() drops the later ones */
+  std::vector<Record> sorted(records);
+  std::stable_sort(sorted.begin(), sorted.end(),
+                   [](const Record &a, const Record &b){
+                     return a.id < b.id;
+                   });
+  sorted.erase(std::unique(sorted.begin(), sorted.end(),
+                           [](const Record &a, const Record &b){
+                             return a.id == b.id;
+                           }),
+               sorted.end());
+
+  const unsigned n = sorted.size();
+
+  /* keep the hash table at most half full */
+  unsigned hash_size = 1;
+  while (hash_size < 2 * n)
+    hash_size <<= 1;
+
+  const unsigned hash_mask = hash_size - 1;
+  std::vector<uint32_t> hash(hash_size);
+  for (auto &i : hash)
+    i = FlarmNetDatabase::NONE;
+  for (unsigned i = 0; i < n; ++i) {
+    unsigned slot = sorted[i].id.Hash() & hash_mask;
+    while (hash[slot] != FlarmNetDatabase::NONE)
+      slot = (slot + 1) & hash_mask;
+    hash[slot] = i;
+  }
+
+  const TCHAR *const pool = strings.c_str();
+  std::vector<uint32_t> callsign_index(n);
+  for (unsigned i = 0; i < n; ++i)
+    callsign_index[i] = i;
+  std::sort(callsign_index.begin(), callsign_index.end(),
+            [&sorted, pool](uint32_t a, uint32_t b){
+              const int cmp =
+                _tcscmp(pool + sorted[a].strings[FlarmNetDatabase::CALLSIGN],
+                        pool + sorted[b].strings[FlarmNetDatabase::CALLSIGN]);
+              return cmp < 0 || (cmp == 0 && a < b);
+            });
+
+  FlarmNetDatabase::Header header;
+  memset(&header, 0, sizeof(header));
+  header.magic = FlarmNetDatabase::MAGIC;
+  header.version = FlarmNetDatabase::VERSION;
+  header.tchar_size = sizeof(TCHAR);
+  header.num_records = n;
+  header.hash_size = hash_size;
+
+  size_t position = sizeof(header);
+  position = Align(position, alignof(Record));
+  header.records_offset = position;
+  position += n * sizeof(Record);
+  position = Align(position, alignof(uint32_t));
+  header.hash_offset = position;
+  position += hash_size * sizeof(uint32_t);
+  header.callsign_offset = position;
+  position += n * sizeof(uint32_t);
+  position = Align(position, alignof(TCHAR));
+  header.strings_offset = position;
+  header.strings_length = strings.length();
+  position += header.strings_length * sizeof(TCHAR);
+
+  image.assign(position, 0);
+  memcpy(image.data(), &header, sizeof(header));
+  if (n > 0) {
+    memcpy(&image[header.records_offset], sorted.data(), n * sizeof(Record));
+    memcpy(&image[header.callsign_offset], callsign_index.data(),
+           n * sizeof(uint32_t));
+  }
+  memcpy(&image[header.hash_offset], hash.data(),
+         hash_size * sizeof(uint32_t));
+  memcpy(&image[header.strings_offset], pool,
+         header.strings_length * sizeof(TCHAR));
+}
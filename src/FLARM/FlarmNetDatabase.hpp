@@ -26,63 +26,242 @@ Copyright_License {
 
 #include "FlarmId.hpp"
 #include "FlarmNetRecord.hpp"
+#include "Util/tstring.hpp"
 #include "Compiler.h"
 
 #include <map>
+#include <memory>
+#include <vector>
+
 #include <tchar.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+class FileMapping;
+class FlarmNetDatabaseBuilder;
 
 /**
  * An in-memory representation of the FlarmNet.org database.
+ *
+ * The database is an immutable image which is either built from a
+ * #FlarmNetDatabaseBuilder or mapped from a file written by Save().
+ * It consists of a #Header, one #Record per FLARM id (the strings
+ * are interned in a pool), an open-addressing hash table on the
+ * FLARM id and an index of all records sorted by callsign.
  */
 class FlarmNetDatabase {
-  typedef std::map<FlarmId, FlarmNetRecord> RecordMap;
-  RecordMap map;
+public:
+  static constexpr uint32_t MAGIC = 0x464e4442;
+  static constexpr uint32_t VERSION = 1;
+
+  /**
+   * Marks an empty hash table slot.
+   */
+  static constexpr uint32_t NONE = 0xffffffff;
+
+  /**
+   * The alignment of the image within a file.
+   */
+  static constexpr size_t ALIGNMENT = 8;
+
+  enum Field {
+    ID,
+    PILOT,
+    AIRFIELD,
+    PLANE_TYPE,
+    REGISTRATION,
+    CALLSIGN,
+    FREQUENCY,
+    NUM_FIELDS
+  };
+
+  struct Header {
+    uint32_t magic;
+    uint32_t version;
+
+    uint8_t tchar_size;
+    uint8_t reserved[3];
+
+    uint32_t num_records;
+
+    /**
+     * The number of hash table slots (a power of two).
+     */
+    uint32_t hash_size;
+
+    /**
+     * Positions of the sections, relative to the start of the image.
+     */
+    uint32_t records_offset, hash_offset, callsign_offset, strings_offset;
+
+    /**
+     * The number of characters in the string pool.
+     */
+    uint32_t strings_length;
+  };
+
+  struct Record {
+    FlarmId id;
+
+    /**
+     * The position of each string in the pool (in characters).
+     */
+    uint32_t strings[NUM_FIELDS];
+  };
+
+private:
+  std::unique_ptr<FileMapping> mapping;
+
+  /**
+   * The image, if it was built in memory.
+   */
+  std::vector<uint8_t> buffer;
+
+  const uint8_t *image;
+  size_t image_size;
+
+  const Record *records;
+  unsigned num_records;
+
+  const uint32_t *hash;
+  unsigned hash_mask;
+
+  /**
+   * The record numbers, sorted by callsign and FLARM id.
+   */
+  const uint32_t *callsign_index;
+
+  const TCHAR *strings;
 
 public:
+  FlarmNetDatabase();
+  ~FlarmNetDatabase();
+
+  FlarmNetDatabase(const FlarmNetDatabase &) = delete;
+  FlarmNetDatabase &operator=(const FlarmNetDatabase &) = delete;
+
   bool IsEmpty() const {
-    return map.empty();
+    return num_records == 0;
   }
 
-  void Clear() {
-    map.clear();
+  unsigned GetCount() const {
+    return num_records;
   }
 
-  void Insert(const FlarmNetRecord &record);
+  void Clear();
+
+  /**
+   * Replace the contents with the records collected by the builder.
+   */
+  void Load(const FlarmNetDatabaseBuilder &builder);
+
+  /**
+   * Take over the specified mapping and validate it.
+   *
+   * @param offset the position of the image within the mapping
+   * (before the alignment padding)
+   * @return false if the file is malformed
+   */
+  bool Open(std::unique_ptr<FileMapping> &&_mapping, size_t offset);
+
+  /**
+   * Write the image (with alignment padding) to the file, to be
+   * loaded with Open() later.
+   *
+   * @return false on error
+   */
+  bool Save(FILE *file) const;
+
+  /**
+   * Returns the record with the specified index (in FLARM id order).
+   */
+  gcc_pure
+  FlarmNetRecord GetRecord(unsigned i) const;
 
   /**
    * Finds a FLARMNetRecord object based on the given FLARM id
    * @param id FLARM id
-   * @return FLARMNetRecord object
+   * @return FLARMNetRecord object (check FlarmNetRecord::IsDefined())
    */
   gcc_pure
-  const FlarmNetRecord *FindRecordById(FlarmId id) const {
-    auto i = map.find(id);
-    return i != map.end()
-      ? &i->second
-      : NULL;
-  }
+  FlarmNetRecord FindRecordById(FlarmId id) const;
 
   /**
    * Finds a FLARMNetRecord object based on the given Callsign
    * @param cn Callsign
-   * @return FLARMNetRecord object
+   * @return FLARMNetRecord object (check FlarmNetRecord::IsDefined())
    */
   gcc_pure
-  const FlarmNetRecord *FindFirstRecordByCallSign(const TCHAR *cn) const;
+  FlarmNetRecord FindFirstRecordByCallSign(const TCHAR *cn) const;
 
   unsigned FindRecordsByCallSign(const TCHAR *cn,
-                                 const FlarmNetRecord *array[],
+                                 FlarmNetRecord array[],
                                  unsigned size) const;
   unsigned FindIdsByCallSign(const TCHAR *cn, FlarmId array[],
                              unsigned size) const;
 
-  RecordMap::const_iterator begin() const {
-    return map.begin();
+  /**
+   * Finds the FLARM ids of all records whose callsign begins with
+   * the given prefix, ordered by callsign.
+   *
+   * @return the number of ids written to the array
+   */
+  unsigned FindIdsByCallSignPrefix(const TCHAR *prefix, FlarmId array[],
+                                   unsigned size) const;
+
+private:
+  bool Open(const uint8_t *_image, size_t size);
+
+  /**
+   * Returns the first position in #callsign_index whose callsign is
+   * not less than the given one.
+   */
+  gcc_pure
+  unsigned LowerBoundCallSign(const TCHAR *cn) const;
+
+  gcc_pure
+  const TCHAR *GetString(const Record &record, Field field) const {
+    return strings + record.strings[field];
   }
+};
 
-  RecordMap::const_iterator end() const {
-    return map.end();
+/**
+ * Collects records for a #FlarmNetDatabase.
+ */
+class FlarmNetDatabaseBuilder {
+  std::vector<FlarmNetDatabase::Record> records;
+
+  /**
+   * The string pool; position 0 is the empty string.
+   */
+  tstring strings;
+
+  /**
+   * Maps each string in the pool to its position.
+   */
+  std::map<tstring, uint32_t> positions;
+
+public:
+  FlarmNetDatabaseBuilder();
+
+  bool IsEmpty() const {
+    return records.empty();
   }
+
+  /**
+   * Add a record.  Records with a malformed id are ignored, and if
+   * an id is added more than once, only the first record is used.
+   */
+  void Add(const FlarmNetRecord &record);
+
+  /**
+   * Generate the #FlarmNetDatabase image.
+   */
+  void Build(std::vector<uint8_t> &image) const;
+
+private:
+  uint32_t Intern(const TCHAR *value);
 };
 
 #endif
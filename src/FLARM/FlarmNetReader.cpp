@@ -25,6 +25,7 @@ Copyright_License {
 #include "FlarmNetRecord.hpp"
 #include "FlarmNetDatabase.hpp"
 #include "Util/StringUtil.hpp"
+#include "Util/StaticString.hxx"
 #include "Util/CharUtil.hpp"
 #include "IO/LineReader.hpp"
 #include "IO/FileLineReader.hpp"
@@ -36,6 +37,46 @@ Copyright_License {
 #include <stdio.h>
 #include <stdlib.h>
 
+constexpr
+static inline size_t
+LatinBufferSize(size_t size)
+{
+#ifdef _UNICODE
+/* with wide characters, the exact size of the FLARMNet database field
+   (plus one for the terminator) is just right, ... */
+  return size;
+#else
+/* ..., but when we convert Latin-1 to UTF-8, we need a little bit
+   more buffer */
+  return size * 3 / 2 + 1;
+#endif
+}
+
+/**
+ * The decoded strings of one FlarmNet.org file entry.
+ */
+struct FlarmNetRecordBuffer {
+  StaticString<LatinBufferSize(7)> id;
+  StaticString<LatinBufferSize(22)> pilot;
+  StaticString<LatinBufferSize(22)> airfield;
+  StaticString<LatinBufferSize(22)> plane_type;
+  StaticString<LatinBufferSize(8)> registration;
+  StaticString<LatinBufferSize(4)> callsign;
+  StaticString<LatinBufferSize(8)> frequency;
+
+  FlarmNetRecord ToRecord() const {
+    return {
+      id.c_str(),
+      pilot.c_str(),
+      airfield.c_str(),
+      plane_type.c_str(),
+      registration.c_str(),
+      callsign.c_str(),
+      frequency.c_str(),
+    };
+  }
+};
+
 /**
  * Decodes the FlarmNet.org file and puts the wanted
  * characters into the res pointer
@@ -95,13 +136,12 @@ LoadString(const char *bytes, size_t length, StaticString<size> &dest)
 }
 
 /**
- * Reads next FlarmNet.org file entry and returns the pointer to
- * a new FlarmNetRecord instance or NULL on error.
+ * Decodes the next FlarmNet.org file entry.
  *
- * The caller is responsible for deleting the object again!
+ * @return false on error
  */
 static bool
-LoadRecord(FlarmNetRecord &record, const char *line)
+LoadRecord(FlarmNetRecordBuffer &record, const char *line)
 {
   if (strlen(line) < 172)
     return false;
@@ -130,15 +170,18 @@ FlarmNetReader::LoadFile(NLineReader &reader, FlarmNetDatabase &database)
   if (line == NULL)
     return 0;
 
+  FlarmNetDatabaseBuilder builder;
+
   int itemCount = 0;
   while ((line = reader.ReadLine()) != NULL) {
-    FlarmNetRecord record;
+    FlarmNetRecordBuffer record;
     if (LoadRecord(record, line)) {
-      database.Insert(record);
+      builder.Add(record.ToRecord());
       itemCount++;
     }
   }
 
+  database.Load(builder);
   return itemCount;
 }
 
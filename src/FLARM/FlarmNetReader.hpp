@@ -34,7 +34,8 @@ class NLineReader;
 namespace FlarmNetReader
 {
   /**
-   * Reads all records from the FlarmNet.org file
+   * Reads all records from the FlarmNet.org file, replacing the
+   * contents of the database
    *
    * @param reader A NLineReader instance to read from
    * @return the number of records read from the file
@@ -42,7 +43,8 @@ namespace FlarmNetReader
   unsigned LoadFile(NLineReader &reader, FlarmNetDatabase &database);
 
   /**
-   * Reads all records from the FlarmNet.org file
+   * Reads all records from the FlarmNet.org file, replacing the
+   * contents of the database
    *
    * @param path the path of the file
    * @return the number of records read from the file
@@ -24,50 +24,50 @@ Copyright_License {
 #ifndef XCSOAR_FLARM_NET_RECORD_HPP
 #define XCSOAR_FLARM_NET_RECORD_HPP
 
-#include "Util/StaticString.hxx"
 #include "Compiler.h"
 
-class FlarmId;
+#include <tchar.h>
 
-constexpr
-static inline size_t
-LatinBufferSize(size_t size)
-{
-#ifdef _UNICODE
-/* with wide characters, the exact size of the FLARMNet database field
-   (plus one for the terminator) is just right, ... */
-  return size;
-#else
-/* ..., but when we convert Latin-1 to UTF-8, we need a little bit
-   more buffer */
-  return size * 3 / 2 + 1;
-#endif
-}
+class FlarmId;
 
 /**
- * FlarmNet.org file entry
+ * FlarmNet.org file entry.  This is a lightweight view; the strings
+ * are owned by the #FlarmNetDatabase (or by the #FlarmNetReader while
+ * a file is being parsed).
  */
 struct FlarmNetRecord {
   /**< FLARM id 6 bytes */
-  StaticString<LatinBufferSize(7)> id;
+  const TCHAR *id;
 
   /**< Name 15 bytes */
-  StaticString<LatinBufferSize(22)> pilot;
+  const TCHAR *pilot;
 
   /**< Airfield 4 bytes */
-  StaticString<LatinBufferSize(22)> airfield;
+  const TCHAR *airfield;
 
   /**< Aircraft type 1 byte */
-  StaticString<LatinBufferSize(22)> plane_type;
+  const TCHAR *plane_type;
 
   /**< Registration 7 bytes */
-  StaticString<LatinBufferSize(8)> registration;
+  const TCHAR *registration;
 
   /**< Callsign 3 bytes */
-  StaticString<LatinBufferSize(4)> callsign;
+  const TCHAR *callsign;
 
   /**< Radio frequency 6 bytes */
-  StaticString<LatinBufferSize(8)> frequency;
+  const TCHAR *frequency;
+
+  static constexpr FlarmNetRecord Undefined() {
+    return { nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr };
+  }
+
+  /**
+   * Was this record found in the database?  All strings are valid
+   * (but may be empty) if this returns true.
+   */
+  bool IsDefined() const {
+    return id != nullptr;
+  }
 
   gcc_pure
   FlarmId GetId() const;
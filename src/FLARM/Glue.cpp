@@ -33,21 +33,65 @@ Copyright_License {
 #include "IO/LineReader.hpp"
 #include "IO/FileOutputStream.hxx"
 #include "IO/BufferedOutputStream.hxx"
+#include "IO/FileCache.hpp"
+#include "OS/FileMapping.hpp"
 #include "Profile/FlarmProfile.hpp"
 #include "Profile/Current.hpp"
 #include "LogFile.hpp"
 
+static constexpr TCHAR FLARMNET_CACHE_NAME[] = _T("flarmnet");
+
+static bool
+OpenFLARMnetCache(FileCache &cache, Path path, FlarmNetDatabase &db)
+{
+  size_t offset;
+  auto mapping = cache.Map(FLARMNET_CACHE_NAME, path, offset);
+  if (!mapping)
+    return false;
+
+  if (!db.Open(std::move(mapping), offset)) {
+    cache.Flush(FLARMNET_CACHE_NAME);
+    return false;
+  }
+
+  return true;
+}
+
+static void
+SaveFLARMnetCache(FileCache &cache, Path path, const FlarmNetDatabase &db)
+{
+  FILE *file = cache.Save(FLARMNET_CACHE_NAME, path);
+  if (file == nullptr)
+    return;
+
+  if (db.Save(file))
+    cache.Commit(FLARMNET_CACHE_NAME, file);
+  else
+    cache.Cancel(FLARMNET_CACHE_NAME, file);
+}
+
 /**
- * Loads the FLARMnet file
+ * Loads the FLARMnet file, or its compiled form from the file cache
  */
 static void
 LoadFLARMnet(FlarmNetDatabase &db)
 try {
+  const auto path = LocalPath(_T("data.fln"));
+
+  if (file_cache != nullptr && OpenFLARMnetCache(*file_cache, path, db)) {
+    LogFormat("%u FLARMnet ids found in cache", db.GetCount());
+    return;
+  }
+
   auto reader = OpenDataTextFileA(_T("data.fln"));
 
   unsigned num_records = FlarmNetReader::LoadFile(*reader, db);
-  if (num_records > 0)
+  if (num_records > 0) {
     LogFormat("%u FLARMnet ids found", num_records);
+
+    if (file_cache != nullptr)
+      SaveFLARMnetCache(*file_cache, path, db);
+  }
 } catch (const std::runtime_error &e) {
   LogError(e);
 }
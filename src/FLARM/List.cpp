@@ -23,6 +23,63 @@ Copyright_License {
 
 #include "List.hpp"
 
+#include <assert.h>
+
+int
+TrafficList::FindIndex(FlarmId id) const
+{
+  static constexpr unsigned mask = INDEX_SIZE - 1;
+
+  for (unsigned slot = id.Hash() & mask;; slot = (slot + 1) & mask) {
+    const unsigned i = index[slot];
+    if (i == 0)
+      return -1;
+
+    assert(i <= list.size());
+
+    if (list[i - 1].id == id)
+      return i - 1;
+  }
+}
+
+void
+TrafficList::AddToIndex(unsigned i)
+{
+  static constexpr unsigned mask = INDEX_SIZE - 1;
+
+  assert(i < list.size());
+
+  unsigned slot = list[i].id.Hash() & mask;
+  while (index[slot] != 0)
+    slot = (slot + 1) & mask;
+
+  index[slot] = i + 1;
+}
+
+void
+TrafficList::RebuildIndex()
+{
+  std::fill_n(index, INDEX_SIZE, 0);
+
+  for (unsigned i = 0; i < list.size(); ++i)
+    AddToIndex(i);
+}
+
+FlarmTraffic *
+TrafficList::AllocateTraffic(FlarmId id)
+{
+  assert(FindTraffic(id) == NULL);
+
+  if (list.full())
+    return NULL;
+
+  FlarmTraffic &traffic = list.append();
+  traffic.Clear();
+  traffic.id = id;
+  AddToIndex(list.size() - 1);
+  return &traffic;
+}
+
 const FlarmTraffic *
 TrafficList::FindMaximumAlert() const
 {
@@ -27,9 +27,13 @@ Copyright_License {
 #include "Traffic.hpp"
 #include "NMEA/Validity.hpp"
 #include "Util/TrivialArray.hxx"
+#include "Compiler.h"
 
+#include <algorithm>
 #include <type_traits>
 
+#include <stdint.h>
+
 /**
  * This class keeps track of the traffic objects received from a
  * FLARM.
@@ -37,6 +41,12 @@ Copyright_License {
 struct TrafficList {
   static constexpr size_t MAX_COUNT = 25;
 
+  /**
+   * The number of slots in #index (a power of two, at least twice
+   * #MAX_COUNT, so the table is at most half full).
+   */
+  static constexpr size_t INDEX_SIZE = 64;
+
   /**
    * Time stamp of the latest modification to this object.
    */
@@ -50,10 +60,21 @@ struct TrafficList {
   /** Flarm traffic information */
   TrivialArray<FlarmTraffic, MAX_COUNT> list;
 
+  /**
+   * An open-addressing hash table on the FLARM id, which makes
+   * FindTraffic(FlarmId) cheap even with many targets.  Each slot
+   * contains a position in #list plus one; zero is an empty slot.
+   * The table is maintained by AllocateTraffic() and Expire(), which
+   * is why items must not be added to or removed from #list
+   * directly.
+   */
+  uint8_t index[INDEX_SIZE];
+
   void Clear() {
     modified.Clear();
     new_traffic.Clear();
     list.clear();
+    std::fill_n(index, INDEX_SIZE, 0);
   }
 
   bool IsEmpty() const {
@@ -73,9 +94,16 @@ struct TrafficList {
     modified.Expire(clock, 300);
     new_traffic.Expire(clock, 60);
 
-    for (unsigned i = list.size(); i-- > 0;)
-      if (!list[i].Refresh(clock))
+    bool removed = false;
+    for (unsigned i = list.size(); i-- > 0;) {
+      if (!list[i].Refresh(clock)) {
         list.quick_remove(i);
+        removed = true;
+      }
+    }
+
+    if (removed)
+      RebuildIndex();
   }
 
   unsigned GetActiveTrafficCount() const {
@@ -89,11 +117,8 @@ struct TrafficList {
    * @return the FLARM_TRAFFIC pointer, NULL if not found
    */
   FlarmTraffic *FindTraffic(FlarmId id) {
-    for (auto &traffic : list)
-      if (traffic.id == id)
-        return &traffic;
-
-    return NULL;
+    const int i = FindIndex(id);
+    return i >= 0 ? &list[i] : NULL;
   }
 
   /**
@@ -103,11 +128,8 @@ struct TrafficList {
    * @return the FLARM_TRAFFIC pointer, NULL if not found
    */
   const FlarmTraffic *FindTraffic(FlarmId id) const {
-    for (const auto &traffic : list)
-      if (traffic.id == id)
-        return &traffic;
-
-    return NULL;
+    const int i = FindIndex(id);
+    return i >= 0 ? &list[i] : NULL;
   }
 
   /**
@@ -139,15 +161,13 @@ struct TrafficList {
   }
 
   /**
-   * Allocates a new FLARM_TRAFFIC object from the array.
+   * Allocates a new (cleared) FLARM_TRAFFIC object from the array.
    *
+   * @param id the FLARM id of the new object; it must not be in the
+   * list already
    * @return the FLARM_TRAFFIC pointer, NULL if the array is full
    */
-  FlarmTraffic *AllocateTraffic() {
-    return list.full()
-      ? NULL
-      : &list.append();
-  }
+  FlarmTraffic *AllocateTraffic(FlarmId id);
 
   /**
    * Search for the previous traffic in the ordered list.
@@ -190,8 +210,24 @@ struct TrafficList {
   unsigned TrafficIndex(const FlarmTraffic *t) const {
     return t - list.begin();
   }
+
+private:
+  /**
+   * @return the position in #list or -1 if not found
+   */
+  gcc_pure
+  int FindIndex(FlarmId id) const;
+
+  void AddToIndex(unsigned i);
+  void RebuildIndex();
 };
 
+static_assert(TrafficList::MAX_COUNT < 256, "index slots are too small");
+static_assert((TrafficList::INDEX_SIZE & (TrafficList::INDEX_SIZE - 1)) == 0,
+              "index size is not a power of two");
+static_assert(TrafficList::INDEX_SIZE >= 2 * TrafficList::MAX_COUNT,
+              "index is too small");
+
 static_assert(std::is_trivial<TrafficList>::value, "type is not trivial");
 
 #endif
@@ -33,9 +33,9 @@ TrafficDatabases::FindNameById(FlarmId id) const
     return name;
 
   // try to find flarm from FlarmNet.org File
-  const FlarmNetRecord *record = flarm_net.FindRecordById(id);
-  if (record != nullptr)
-    return record->callsign;
+  const FlarmNetRecord record = flarm_net.FindRecordById(id);
+  if (record.IsDefined())
+    return record.callsign;
 
   return nullptr;
 }
@@ -51,9 +51,9 @@ TrafficDatabases::FindIdByName(const TCHAR *name) const
     return id;
 
   // try to find flarm from FlarmNet.org File
-  const FlarmNetRecord *record = flarm_net.FindFirstRecordByCallSign(name);
-  if (record != NULL)
-    return record->GetId();
+  const FlarmNetRecord record = flarm_net.FindFirstRecordByCallSign(name);
+  if (record.IsDefined())
+    return record.GetId();
 
   return FlarmId::Undefined();
 }
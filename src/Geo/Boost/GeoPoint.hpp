@@ -34,10 +34,13 @@ namespace geometry {
 namespace traits {
 
 /* these declarations allow using GeoPoint as a boost::geometry
-   point */
+   point; it is a point in the flat longitude/latitude plane, because
+   the rtree mishandles points on the poles and boxes crossing the
+   date line in boost's geographic coordinate system, and fails to
+   remove such points again; see BoostRangeBox() */
 
 BOOST_GEOMETRY_DETAIL_SPECIALIZE_POINT_TRAITS(GeoPoint, 2, double,
-                                              boost::geometry::cs::geographic<boost::geometry::radian>)
+                                              boost::geometry::cs::cartesian)
 
 template<> struct access<GeoPoint, 0> {
   static inline double get(const GeoPoint &p) {
@@ -34,11 +34,31 @@ BoostRangeBox(const GeoPoint location, double range)
   Angle south = std::max(location.latitude - latitude_delta,
                          -Angle::QuarterCircle());
 
-  auto c = std::max(location.latitude.cos(), 0.01);
-  Angle longitude_delta = std::min(latitude_delta / c, Angle::QuarterCircle());
+  Angle west = -Angle::HalfCircle(), east = Angle::HalfCircle();
+  if (north < Angle::QuarterCircle() && south > -Angle::QuarterCircle()) {
+    /* the range does not include a pole; this is the largest
+       longitude difference within it */
+    Angle longitude_delta = Angle::asin(latitude_delta.sin() /
+                                        location.latitude.cos());
 
-  Angle west = (location.longitude - longitude_delta).AsDelta();
-  Angle east = (location.longitude + longitude_delta).AsDelta();
+    west = (location.longitude - longitude_delta).AsDelta();
+    east = (location.longitude + longitude_delta).AsDelta();
+  }
 
   return {GeoPoint(west, south), GeoPoint(east, north)};
 }
+
+bool
+IsInsideRangeBox(const boost::geometry::model::box<GeoPoint> &box,
+                 const GeoPoint &point)
+{
+  const GeoPoint &sw = box.min_corner(), &ne = box.max_corner();
+
+  if (point.latitude < sw.latitude || point.latitude > ne.latitude)
+    return false;
+
+  return sw.longitude <= ne.longitude
+    ? point.longitude >= sw.longitude && point.longitude <= ne.longitude
+    /* the box crosses the date line */
+    : point.longitude >= sw.longitude || point.longitude <= ne.longitude;
+}
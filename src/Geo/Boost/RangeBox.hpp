@@ -27,12 +27,49 @@ Copyright_License {
 #include "GeoPoint.hpp"
 
 #include <boost/geometry/geometries/box.hpp>
+#include <boost/geometry/index/predicates.hpp>
 
 /**
- * Create a boost::geometry box which covers the given range.
+ * Create a boost::geometry box which covers the given range.  If the
+ * range crosses the date line, the western longitude is greater than
+ * the eastern one; if it includes a pole, the box covers all
+ * longitudes.
  */
 gcc_const
 boost::geometry::model::box<GeoPoint>
 BoostRangeBox(const GeoPoint location, double range);
 
+/**
+ * Is the point inside the box created by BoostRangeBox()?
+ */
+gcc_pure
+bool
+IsInsideRangeBox(const boost::geometry::model::box<GeoPoint> &box,
+                 const GeoPoint &point);
+
+/**
+ * Create a boost::geometry::index::rtree query predicate which
+ * matches all values inside the box created by BoostRangeBox().
+ * Unlike a plain intersects() predicate, it handles boxes crossing
+ * the date line, by searching the whole latitude band.
+ *
+ * @param indexable the rtree's indexable function
+ */
+template<typename I>
+auto
+BoostRangeQuery(const boost::geometry::model::box<GeoPoint> &box,
+                I indexable)
+{
+  auto search = box;
+  if (box.min_corner().longitude > box.max_corner().longitude) {
+    search.min_corner().longitude = -Angle::HalfCircle();
+    search.max_corner().longitude = Angle::HalfCircle();
+  }
+
+  return boost::geometry::index::intersects(search) &&
+    boost::geometry::index::satisfies([box, indexable](const auto &value){
+        return IsInsideRangeBox(box, indexable(value));
+      });
+}
+
 #endif
@@ -0,0 +1,433 @@
+/* Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+ */
+
+#include "PolygonEdgeIndex.hpp"
+#include "Flat/FlatRay.hpp"
+
+#include <algorithm>
+
+#include <assert.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * The average number of edges per band.
+ */
+static constexpr unsigned EDGES_PER_BAND = 8;
+
+static constexpr unsigned MAX_BANDS = 1024;
+
+/**
+ * Scanning an edge copy in a band is much cheaper than
+ * FlatRay::DistinctIntersection().  If a ray covers more copies per
+ * polygon edge than this, FindIntersections() gives up.
+ */
+static constexpr unsigned MAX_COPIES_PER_EDGE = 4;
+
+static unsigned
+CountBands(unsigned n_edges)
+{
+  return std::min(std::max(n_edges / EDGES_PER_BAND, 1u), MAX_BANDS);
+}
+
+/**
+ * Convert per-band counters to offsets (in place), and return the
+ * total.
+ */
+static uint32_t
+CountsToOffsets(std::vector<uint32_t> &offsets)
+{
+  uint32_t total = 0;
+  for (auto &i : offsets) {
+    const uint32_t n = i;
+    i = total;
+    total += n;
+  }
+
+  return total;
+}
+
+/**
+ * The contribution of one edge to the winding number; the same
+ * calculation as PolygonInterior().
+ */
+gcc_always_inline
+static inline int
+Winding(double ax, double ay, double bx, double by, double px, double py)
+{
+  const double left = (bx - ax) * (py - ay) - (px - ax) * (by - ay);
+
+  if (ay <= py)
+    return by > py && left > 0 ? 1 : 0;
+  else
+    return by <= py && left < 0 ? -1 : 0;
+}
+
+/**
+ * Sum the winding number contributions of the given edges.
+ */
+static int
+Winding(const double *x0, const double *y0,
+        const double *x1, const double *y1, unsigned n,
+        double px, double py)
+{
+  int wn = 0;
+  unsigned i = 0;
+
+#if defined(__SSE2__)
+  const __m128d vpx = _mm_set1_pd(px), vpy = _mm_set1_pd(py);
+  const __m128d zero = _mm_setzero_pd();
+  __m128i sum = _mm_setzero_si128();
+
+  for (; i + 2 <= n; i += 2) {
+    const __m128d ax = _mm_loadu_pd(x0 + i), ay = _mm_loadu_pd(y0 + i);
+    const __m128d bx = _mm_loadu_pd(x1 + i), by = _mm_loadu_pd(y1 + i);
+
+    const __m128d left =
+      _mm_sub_pd(_mm_mul_pd(_mm_sub_pd(bx, ax), _mm_sub_pd(vpy, ay)),
+                 _mm_mul_pd(_mm_sub_pd(vpx, ax), _mm_sub_pd(by, ay)));
+
+    /* the comparison masks are -1 where true */
+    const __m128d up = _mm_and_pd(_mm_and_pd(_mm_cmple_pd(ay, vpy),
+                                             _mm_cmpgt_pd(by, vpy)),
+                                  _mm_cmpgt_pd(left, zero));
+    const __m128d down = _mm_and_pd(_mm_and_pd(_mm_cmpgt_pd(ay, vpy),
+                                               _mm_cmple_pd(by, vpy)),
+                                    _mm_cmplt_pd(left, zero));
+
+    sum = _mm_sub_epi64(sum, _mm_castpd_si128(up));
+    sum = _mm_add_epi64(sum, _mm_castpd_si128(down));
+  }
+
+  int64_t lanes[2];
+  _mm_storeu_si128((__m128i *)lanes, sum);
+  wn = int(lanes[0] + lanes[1]);
+#endif
+
+  for (; i < n; ++i)
+    wn += Winding(x0[i], y0[i], x1[i], y1[i], px, py);
+
+  return wn;
+}
+
+/**
+ * Is the bounding box of the edge disjoint from the given box?
+ */
+gcc_always_inline
+static inline bool
+IsDisjoint(int ax, int ay, int bx, int by,
+           int x_min, int y_min, int x_max, int y_max)
+{
+  return (ax < x_min && bx < x_min) || (ax > x_max && bx > x_max) ||
+    (ay < y_min && by < y_min) || (ay > y_max && by > y_max);
+}
+
+/**
+ * Calculate a bit mask of the edges [i, i+4) whose bounding box
+ * overlaps the given box, and which are to be checked in this band.
+ */
+#if defined(__SSE2__)
+
+gcc_always_inline
+static inline unsigned
+Match4(const int32_t *x0, const int32_t *y0,
+       const int32_t *x1, const int32_t *y1, const int32_t *first,
+       __m128i x_min, __m128i y_min, __m128i x_max, __m128i y_max,
+       __m128i band)
+{
+  const __m128i ax = _mm_loadu_si128((const __m128i *)x0);
+  const __m128i ay = _mm_loadu_si128((const __m128i *)y0);
+  const __m128i bx = _mm_loadu_si128((const __m128i *)x1);
+  const __m128i by = _mm_loadu_si128((const __m128i *)y1);
+
+  __m128i disjoint =
+    _mm_and_si128(_mm_cmplt_epi32(ax, x_min), _mm_cmplt_epi32(bx, x_min));
+  disjoint = _mm_or_si128(disjoint,
+                          _mm_and_si128(_mm_cmpgt_epi32(ax, x_max),
+                                        _mm_cmpgt_epi32(bx, x_max)));
+  disjoint = _mm_or_si128(disjoint,
+                          _mm_and_si128(_mm_cmplt_epi32(ay, y_min),
+                                        _mm_cmplt_epi32(by, y_min)));
+  disjoint = _mm_or_si128(disjoint,
+                          _mm_and_si128(_mm_cmpgt_epi32(ay, y_max),
+                                        _mm_cmpgt_epi32(by, y_max)));
+
+  /* in the ray's first band, "band" is -1 and matches every edge */
+  const __m128i f = _mm_loadu_si128((const __m128i *)first);
+  const __m128i here = _mm_or_si128(_mm_cmpeq_epi32(f, band),
+                                    _mm_cmpeq_epi32(band,
+                                                    _mm_set1_epi32(-1)));
+
+  return _mm_movemask_ps(_mm_castsi128_ps(_mm_andnot_si128(disjoint, here)));
+}
+
+#endif
+
+unsigned
+PolygonEdgeIndex::GeoBands::GetBand(double y) const
+{
+  const double b = (y - y_min) * scale;
+  const unsigned last = offsets.size() - 2;
+
+  /* this is monotonic in y, which is all Build() and IsInside()
+     need */
+  if (!(b > 0))
+    return 0;
+  if (b >= last)
+    return last;
+  return unsigned(b);
+}
+
+void
+PolygonEdgeIndex::Clear()
+{
+  geo.offsets.clear();
+  geo.x0.clear();
+  geo.y0.clear();
+  geo.x1.clear();
+  geo.y1.clear();
+
+  flat.offsets.clear();
+  flat.x0.clear();
+  flat.y0.clear();
+  flat.x1.clear();
+  flat.y1.clear();
+  flat.first.clear();
+}
+
+void
+PolygonEdgeIndex::Build(const SearchPointVector &points)
+{
+  Clear();
+
+  if (points.size() < MIN_POINTS)
+    return;
+
+  const unsigned n_edges = points.size() - 1;
+
+  geo.y_min = geo.y_max = points.front().GetLocation().latitude.Native();
+  for (const auto &i : points) {
+    const double y = i.GetLocation().latitude.Native();
+    geo.y_min = std::min(geo.y_min, y);
+    geo.y_max = std::max(geo.y_max, y);
+  }
+
+  const unsigned n_bands = geo.y_max > geo.y_min ? CountBands(n_edges) : 1;
+  geo.scale = geo.y_max > geo.y_min
+    ? n_bands / (geo.y_max - geo.y_min)
+    : 0;
+
+  geo.offsets.assign(n_bands + 1, 0);
+
+  /* first pass: count the edges in each band; horizontal edges never
+     contribute to the winding number and are omitted */
+  for (unsigned i = 0; i < n_edges; ++i) {
+    const double a = points[i].GetLocation().latitude.Native();
+    const double b = points[i + 1].GetLocation().latitude.Native();
+    if (a == b)
+      continue;
+
+    const unsigned last = geo.GetBand(std::max(a, b));
+    for (unsigned band = geo.GetBand(std::min(a, b)); band <= last; ++band)
+      ++geo.offsets[band];
+  }
+
+  const uint32_t total = CountsToOffsets(geo.offsets);
+  geo.x0.resize(total);
+  geo.y0.resize(total);
+  geo.x1.resize(total);
+  geo.y1.resize(total);
+
+  /* second pass: copy the edges */
+  std::vector<uint32_t> fill(geo.offsets.begin(), geo.offsets.end() - 1);
+  for (unsigned i = 0; i < n_edges; ++i) {
+    const GeoPoint &a = points[i].GetLocation();
+    const GeoPoint &b = points[i + 1].GetLocation();
+    if (a.latitude == b.latitude)
+      continue;
+
+    const unsigned last = geo.GetBand(std::max(a.latitude.Native(),
+                                               b.latitude.Native()));
+    for (unsigned band = geo.GetBand(std::min(a.latitude.Native(),
+                                              b.latitude.Native()));
+         band <= last; ++band) {
+      const uint32_t j = fill[band]++;
+      geo.x0[j] = a.longitude.Native();
+      geo.y0[j] = a.latitude.Native();
+      geo.x1[j] = b.longitude.Native();
+      geo.y1[j] = b.latitude.Native();
+    }
+  }
+}
+
+void
+PolygonEdgeIndex::Project(const SearchPointVector &points)
+{
+  flat.offsets.clear();
+
+  if (!IsDefined())
+    return;
+
+  assert(points.size() >= MIN_POINTS);
+
+  const unsigned n_edges = points.size() - 1;
+
+  const FlatGeoPoint &p0 = points.front().GetFlatLocation();
+  flat.x_min = flat.x_max = p0.x;
+  flat.y_min = flat.y_max = p0.y;
+  for (const auto &i : points) {
+    const FlatGeoPoint &p = i.GetFlatLocation();
+    flat.x_min = std::min(flat.x_min, p.x);
+    flat.x_max = std::max(flat.x_max, p.x);
+    flat.y_min = std::min(flat.y_min, p.y);
+    flat.y_max = std::max(flat.y_max, p.y);
+  }
+
+  const unsigned n_bands = CountBands(n_edges);
+  flat.n_edges = n_edges;
+  flat.height = (flat.y_max - flat.y_min) / n_bands + 1;
+  flat.offsets.assign(n_bands + 1, 0);
+
+  for (unsigned i = 0; i < n_edges; ++i) {
+    const int a = points[i].GetFlatLocation().y;
+    const int b = points[i + 1].GetFlatLocation().y;
+
+    const unsigned last = flat.GetBand(std::max(a, b));
+    for (unsigned band = flat.GetBand(std::min(a, b)); band <= last; ++band)
+      ++flat.offsets[band];
+  }
+
+  const uint32_t total = CountsToOffsets(flat.offsets);
+  flat.x0.resize(total);
+  flat.y0.resize(total);
+  flat.x1.resize(total);
+  flat.y1.resize(total);
+  flat.first.resize(total);
+
+  std::vector<uint32_t> fill(flat.offsets.begin(), flat.offsets.end() - 1);
+  for (unsigned i = 0; i < n_edges; ++i) {
+    const FlatGeoPoint &a = points[i].GetFlatLocation();
+    const FlatGeoPoint &b = points[i + 1].GetFlatLocation();
+
+    const unsigned first = flat.GetBand(std::min(a.y, b.y));
+    const unsigned last = flat.GetBand(std::max(a.y, b.y));
+    for (unsigned band = first; band <= last; ++band) {
+      const uint32_t j = fill[band]++;
+      flat.x0[j] = a.x;
+      flat.y0[j] = a.y;
+      flat.x1[j] = b.x;
+      flat.y1[j] = b.y;
+      flat.first[j] = first;
+    }
+  }
+}
+
+bool
+PolygonEdgeIndex::IsInside(const GeoPoint &p) const
+{
+  assert(IsDefined());
+
+  const double py = p.latitude.Native();
+
+  /* outside of the latitude range, no edge can be crossed (this
+     check also rejects NaN) */
+  if (!(py >= geo.y_min && py < geo.y_max))
+    return false;
+
+  const unsigned band = geo.GetBand(py);
+  const unsigned begin = geo.offsets[band], end = geo.offsets[band + 1];
+
+  return Winding(geo.x0.data() + begin, geo.y0.data() + begin,
+                 geo.x1.data() + begin, geo.y1.data() + begin,
+                 end - begin, p.longitude.Native(), py) != 0;
+}
+
+bool
+PolygonEdgeIndex::FindIntersections(const FlatRay &ray,
+                                    std::vector<double> &result) const
+{
+  assert(IsProjected());
+
+  const FlatGeoPoint end = ray.point + ray.vector;
+  const int x_min = std::min(ray.point.x, end.x);
+  const int x_max = std::max(ray.point.x, end.x);
+  const int y_min = std::min(ray.point.y, end.y);
+  const int y_max = std::max(ray.point.y, end.y);
+
+  if (x_max < flat.x_min || x_min > flat.x_max ||
+      y_max < flat.y_min || y_min > flat.y_max)
+    return true;
+
+  const unsigned first_band = flat.GetBand(std::max(y_min, flat.y_min));
+  const unsigned last_band = flat.GetBand(std::min(y_max, flat.y_max));
+
+  /* edges spanning many bands are copied into each of them; if the
+     ray covers too many copies, checking all edges once is cheaper */
+  if (flat.offsets[last_band + 1] - flat.offsets[first_band] >
+      MAX_COPIES_PER_EDGE * flat.n_edges)
+    return false;
+
+  const auto check = [&ray, &result, this](unsigned i){
+    const FlatRay edge(FlatGeoPoint(flat.x0[i], flat.y0[i]),
+                       FlatGeoPoint(flat.x1[i], flat.y1[i]));
+    const double t = ray.DistinctIntersection(edge);
+    if (t >= 0)
+      result.push_back(t);
+  };
+
+  for (unsigned band = first_band; band <= last_band; ++band) {
+    /* an edge spanning several bands is checked only in the first
+       band it shares with the ray */
+    const int match_band = band == first_band ? -1 : int(band);
+
+    unsigned i = flat.offsets[band];
+    const unsigned end_i = flat.offsets[band + 1];
+
+#if defined(__SSE2__)
+    const __m128i vx_min = _mm_set1_epi32(x_min);
+    const __m128i vy_min = _mm_set1_epi32(y_min);
+    const __m128i vx_max = _mm_set1_epi32(x_max);
+    const __m128i vy_max = _mm_set1_epi32(y_max);
+    const __m128i vband = _mm_set1_epi32(match_band);
+
+    for (; i + 4 <= end_i; i += 4) {
+      unsigned mask = Match4(flat.x0.data() + i, flat.y0.data() + i,
+                             flat.x1.data() + i, flat.y1.data() + i,
+                             flat.first.data() + i,
+                             vx_min, vy_min, vx_max, vy_max, vband);
+      for (unsigned j = i; mask != 0; ++j, mask >>= 1)
+        if (mask & 1)
+          check(j);
+    }
+#endif
+
+    for (; i < end_i; ++i)
+      if ((match_band < 0 || flat.first[i] == match_band) &&
+          !IsDisjoint(flat.x0[i], flat.y0[i], flat.x1[i], flat.y1[i],
+                      x_min, y_min, x_max, y_max))
+        check(i);
+  }
+
+  return true;
+}
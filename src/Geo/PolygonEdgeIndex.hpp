@@ -0,0 +1,147 @@
+/* Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+ */
+
+#ifndef XCSOAR_GEO_POLYGON_EDGE_INDEX_HPP
+#define XCSOAR_GEO_POLYGON_EDGE_INDEX_HPP
+
+#include "SearchPointVector.hpp"
+#include "Compiler.h"
+
+#include <vector>
+
+#include <stdint.h>
+
+class FlatRay;
+
+/**
+ * An index of the edges of a large closed polygon, for fast hit
+ * tests.  The edges are sorted into horizontal bands; each band holds
+ * a copy of all edges which overlap it.  The copies are stored as
+ * "structure of arrays", and the bands are scanned with SSE2
+ * instructions if available.
+ *
+ * The results are exactly the same as those of PolygonInterior() and
+ * of FlatRay::DistinctIntersection() on each edge.
+ *
+ * The geographic part is built once by Build(); the projected part
+ * must be rebuilt by Project() after the polygon has been projected.
+ */
+class PolygonEdgeIndex {
+  /**
+   * Edges in geographic coordinates (longitude and latitude in
+   * radians), for IsInside().
+   */
+  struct GeoBands {
+    double y_min, y_max;
+
+    /** number of bands per radian */
+    double scale;
+
+    /**
+     * The first edge of each band in the following arrays, plus the
+     * end of the last band.
+     */
+    std::vector<uint32_t> offsets;
+
+    std::vector<double> x0, y0, x1, y1;
+
+    gcc_pure
+    unsigned GetBand(double y) const;
+  } geo;
+
+  /**
+   * Edges in projected coordinates, for FindIntersections().
+   */
+  struct FlatBands {
+    int x_min, x_max, y_min, y_max;
+
+    /** the number of edges of the polygon */
+    unsigned n_edges;
+
+    /** height of a band */
+    int height;
+
+    std::vector<uint32_t> offsets;
+
+    std::vector<int32_t> x0, y0, x1, y1;
+
+    /**
+     * The first band containing the edge, to report edges which
+     * span several bands only once.
+     */
+    std::vector<int32_t> first;
+
+    unsigned GetBand(int y) const {
+      return unsigned(y - y_min) / unsigned(height);
+    }
+  } flat;
+
+public:
+  /**
+   * Polygons with fewer points are not worth indexing.
+   */
+  static constexpr unsigned MIN_POINTS = 32;
+
+  bool IsDefined() const {
+    return !geo.offsets.empty();
+  }
+
+  bool IsProjected() const {
+    return !flat.offsets.empty();
+  }
+
+  /**
+   * Index the geographic locations of the given polygon.
+   *
+   * @param points the closed polygon (the last point equals the
+   * first one)
+   */
+  void Build(const SearchPointVector &points);
+
+  /**
+   * Index the projected locations of the given polygon.  Must be
+   * called after Build() and after SearchPointVector::Project().
+   */
+  void Project(const SearchPointVector &points);
+
+  void Clear();
+
+  /**
+   * Winding number test, equivalent to PolygonInterior().
+   */
+  gcc_pure
+  bool IsInside(const GeoPoint &p) const;
+
+  /**
+   * Find all edges which intersect with the ray away from their
+   * nodes, and append the ray parameter of each intersection (see
+   * FlatRay::DistinctIntersection()) to the given vector.  The order
+   * is unspecified.
+   *
+   * @return false if the bands covered by the ray hold too many
+   * edge copies (nothing has been appended then); the caller should
+   * check all edges instead
+   */
+  bool FindIntersections(const FlatRay &ray, std::vector<double> &t) const;
+};
+
+#endif
@@ -192,6 +192,18 @@ namespace CommonInterface {
     Private::blackboard.ReadBlackboardCalculated(derived_info);
   }
 
+  static inline void BorrowBlackboardBasic(const MoreData &nmea_info) {
+    assert(InMainThread());
+
+    Private::blackboard.BorrowBlackboardBasic(nmea_info);
+  }
+
+  static inline void BorrowBlackboardCalculated(const DerivedInfo &derived_info) {
+    assert(InMainThread());
+
+    Private::blackboard.BorrowBlackboardCalculated(derived_info);
+  }
+
   static inline void ReadCommonStats(const CommonStats &common_stats) {
     assert(InMainThread());
 
@@ -130,13 +130,13 @@ GlueMapWindow::SetUIState(const UIState &new_value)
 void
 GlueMapWindow::ExchangeBlackboard()
 {
-  /* copy device_blackboard to MapWindow */
+  /* borrow the latest device_blackboard snapshots; they remain
+     valid until the next Update() call */
 
-  {
-    const ScopeLock lock(device_blackboard->mutex);
-    ReadBlackboard(device_blackboard->Basic(),
-                   device_blackboard->Calculated());
-  }
+  if (device_blackboard->map_basic.Update() |
+      device_blackboard->map_calculated.Update())
+    BorrowBlackboard(device_blackboard->map_basic.GetFront(),
+                     device_blackboard->map_calculated.GetFront());
 
 #ifndef ENABLE_OPENGL
   {
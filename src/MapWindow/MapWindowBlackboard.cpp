@@ -43,5 +43,7 @@ MapWindowBlackboard::ReadBlackboard(const MoreData &nmea_info,
 {
   gps_info = nmea_info;
   calculated_info = derived_info;
+  basic = &gps_info;
+  calculated = &calculated_info;
 }
 
@@ -42,19 +42,26 @@ class MapWindowBlackboard:
 {
   UIState ui_state;
 
+  /**
+   * The data returned by Basic() and Calculated(): either the local
+   * copies or snapshots borrowed with BorrowBlackboard().
+   */
+  const MoreData *basic = &gps_info;
+  const DerivedInfo *calculated = &calculated_info;
+
 protected:
   gcc_const
   const MoreData &Basic() const {
     assert(InDrawThread());
 
-    return BaseBlackboard::Basic();
+    return *basic;
   }
 
   gcc_const
   const DerivedInfo &Calculated() const {
     assert(InDrawThread());
 
-    return BaseBlackboard::Calculated();
+    return *calculated;
   }
 
   gcc_const
@@ -80,6 +87,18 @@ protected:
 
   void ReadBlackboard(const MoreData &nmea_info,
                       const DerivedInfo &derived_info);
+
+  /**
+   * Like ReadBlackboard(), but don't copy the data.  The caller must
+   * keep the referenced objects valid and unmodified until the next
+   * ReadBlackboard() or BorrowBlackboard() call.
+   */
+  void BorrowBlackboard(const MoreData &nmea_info,
+                        const DerivedInfo &derived_info) {
+    basic = &nmea_info;
+    calculated = &derived_info;
+  }
+
   void ReadComputerSettings(const ComputerSettings &settings);
   void ReadMapSettings(const MapSettings &settings);
 
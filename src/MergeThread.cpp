@@ -99,6 +99,8 @@ MergeThread::Tick()
          (!last_fix.time_available || basic.time != last_fix.time)) ||
         basic.location_available != last_fix.location_available)
       last_fix = basic;
+
+    device_blackboard.PublishBasic();
   }
 
 #ifdef HAVE_PCM_PLAYER
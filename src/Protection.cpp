@@ -27,6 +27,7 @@ Copyright_License {
 #include "Components.hpp"
 #include "Computer/GlideComputer.hpp"
 #include "CalculationThread.hpp"
+#include "ContestThread.hpp"
 #include "MergeThread.hpp"
 #include "Blackboard/DeviceBlackboard.hpp"
 
@@ -104,9 +105,15 @@ CreateCalculationThread()
 
   /* copy GlideComputer results to DeviceBlackboard */
   device_blackboard->ReadBlackboard(glide_computer->Calculated());
+  device_blackboard->PublishCalculated(glide_computer->Calculated());
 
   calculation_thread = new CalculationThread(*glide_computer);
   calculation_thread->SetComputerSettings(CommonInterface::GetComputerSettings());
+
+  /* move the contest optimisation out of the CalculationThread */
+  contest_thread = new ContestThread(*device_blackboard,
+                                     glide_computer->GetTraceComputer());
+  glide_computer->SetContestExternal(true);
 }
 
 void
@@ -115,8 +122,8 @@ SuspendAllThreads()
   assert(CommonInterface::main_window != nullptr);
   assert(calculation_thread != nullptr);
 
-  /* not suspending MergeThread, because it does not access shared
-     unprotected data structures */
+  /* not suspending MergeThread and ContestThread, because they do
+     not access shared unprotected data structures */
 
   CommonInterface::main_window->SuspendThreads();
   calculation_thread->Suspend();
@@ -339,11 +339,11 @@ Draw(Canvas &canvas, PixelRect rc,
   rc.left += line_height + text_padding;
 
   // Now render the text information
-  const FlarmNetRecord *record = FlarmDetails::LookupRecord(item.id);
+  const FlarmNetRecord record = FlarmDetails::LookupRecord(item.id);
 
   StaticString<256> title_string;
-  if (record && !StringIsEmpty(record->pilot))
-    title_string = record->pilot.c_str();
+  if (record.IsDefined() && !StringIsEmpty(record.pilot))
+    title_string = record.pilot;
   else
     title_string = _("FLARM Traffic");
 
@@ -357,8 +357,8 @@ Draw(Canvas &canvas, PixelRect rc,
   row_renderer.DrawFirstRow(canvas, rc, title_string);
 
   StaticString<256> info_string;
-  if (record && !StringIsEmpty(record->plane_type))
-    info_string = record->plane_type;
+  if (record.IsDefined() && !StringIsEmpty(record.plane_type))
+    info_string = record.plane_type;
   else if (traffic != nullptr)
     info_string = FlarmTraffic::GetTypeString(traffic->type);
   else
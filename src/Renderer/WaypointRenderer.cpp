@@ -51,6 +51,8 @@ Copyright_License {
 #include "Engine/Route/ReachResult.hpp"
 #include "Look/WaypointLook.hpp"
 
+#include <vector>
+
 #include <assert.h>
 #include <stdio.h>
 
@@ -82,19 +84,23 @@ struct VisibleWaypoint {
       reachable == WaypointRenderer::ReachableTerrain;
   }
 
-  void CalculateReachabilityDirect(const MoreData &basic,
-                                   const SpeedVector &wind,
-                                   const MacCready &mac_cready,
-                                   const TaskBehaviour &task_behaviour) {
+  /**
+   * Returns the direct glide to this waypoint, to be solved by
+   * MacCready::SolveStraightBatch().
+   */
+  GlideState GetDirectGlideState(const MoreData &basic,
+                                 const SpeedVector &wind,
+                                 const TaskBehaviour &task_behaviour) const {
     assert(basic.location_available);
     assert(basic.NavAltitudeAvailable());
 
     const auto elevation = waypoint->elevation +
       task_behaviour.safety_height_arrival;
-    const GlideState state(GeoVector(basic.location, waypoint->location),
-                           elevation, basic.nav_altitude, wind);
+    return GlideState(GeoVector(basic.location, waypoint->location),
+                      elevation, basic.nav_altitude, wind);
+  }
 
-    const GlideResult result = mac_cready.SolveStraight(state);
+  void SetReachabilityDirect(const GlideResult &result) {
     if (!result.IsOk())
       return;
 
@@ -411,14 +417,30 @@ public:
       ? polar_settings.glide_polar_task
       : calculated.glide_polar_safety;
     const MacCready mac_cready(task_behaviour.glide, glide_polar);
+    const SpeedVector wind = calculated.GetWindOrZero();
+
+    /* collect all glides first, and solve them in one batch */
+    std::vector<VisibleWaypoint *> targets;
+    std::vector<GlideState> states;
+    targets.reserve(waypoints.size());
+    states.reserve(waypoints.size());
 
     for (VisibleWaypoint &vwp : waypoints) {
       const Waypoint &way_point = *vwp.waypoint;
 
-      if (way_point.IsLandable() || way_point.flags.watched)
-        vwp.CalculateReachabilityDirect(basic, calculated.GetWindOrZero(),
-                                        mac_cready, task_behaviour);
+      if (way_point.IsLandable() || way_point.flags.watched) {
+        targets.push_back(&vwp);
+        states.push_back(vwp.GetDirectGlideState(basic, wind,
+                                                 task_behaviour));
+      }
     }
+
+    std::vector<GlideResult> results(states.size());
+    mac_cready.SolveStraightBatch(states.data(), results.data(),
+                                  states.size());
+
+    for (unsigned i = 0; i < targets.size(); ++i)
+      targets[i]->SetReachabilityDirect(results[i]);
   }
 
   void Calculate(const ProtectedRoutePlanner *route_planner,
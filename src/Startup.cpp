@@ -65,6 +65,7 @@ Copyright_License {
 #include "Monitor/AllMonitors.hpp"
 #include "MergeThread.hpp"
 #include "CalculationThread.hpp"
+#include "ContestThread.hpp"
 #include "Replay/Replay.hpp"
 #include "LocalPath.hpp"
 #include "IO/FileCache.hpp"
@@ -332,7 +333,7 @@ Startup()
 
   // Read the topography file(s)
   topography = new TopographyStore();
-  LoadConfiguredTopography(*topography, operation);
+  LoadConfiguredTopography(*topography, file_cache, operation);
 
   // Read the waypoint files
   WaypointGlue::LoadWaypoints(way_points, terrain, operation);
@@ -347,8 +348,12 @@ Startup()
                         device_blackboard, false);
 
   // ReSynchronise the blackboards here since SetHome touches them
-  device_blackboard->Merge();
-  CommonInterface::ReadBlackboardBasic(device_blackboard->Basic());
+  {
+    ScopeLock protect(device_blackboard->mutex);
+    device_blackboard->Merge();
+    device_blackboard->PublishBasic();
+    CommonInterface::ReadBlackboardBasic(device_blackboard->Basic());
+  }
 
   // Scan for weather forecast
   LogFormat("RASP load");
@@ -356,8 +361,8 @@ Startup()
   rasp->ScanAll();
 
   // Reads the airspace files
-  ReadAirspace(airspace_database, terrain, computer_settings.pressure,
-               operation);
+  ReadAirspace(airspace_database, file_cache, terrain,
+               computer_settings.pressure, operation);
 
   {
     const AircraftState aircraft_state =
@@ -452,6 +457,7 @@ Startup()
   // Start calculation thread
   merge_thread->Start();
   calculation_thread->Start();
+  contest_thread->Start();
 
   PageActions::Update();
 
@@ -547,6 +553,9 @@ Shutdown()
   if (merge_thread != nullptr)
     merge_thread->BeginStop();
 
+  if (contest_thread != nullptr)
+    contest_thread->BeginStop();
+
   // Wait for the calculations thread to finish
   LogFormat("Waiting for calculation thread");
 
@@ -562,6 +571,12 @@ Shutdown()
     calculation_thread = nullptr;
   }
 
+  if (contest_thread != nullptr) {
+    contest_thread->Join();
+    delete contest_thread;
+    contest_thread = nullptr;
+  }
+
   //  Wait for the drawing thread to finish
 #ifndef ENABLE_OPENGL
   LogFormat("Waiting for draw thread");
@@ -25,6 +25,16 @@
 #include "Airspace/ActivePredicate.hpp"
 #include "Engine/Airspace/Predicate/AirspacePredicate.hpp"
 
+#include <algorithm>
+
+RoutePlannerGlue::RoutePlannerGlue()
+  :terrain(nullptr),
+   reach_pool(std::min(WorkStealingPool::GetProcessorCount(),
+                       unsigned(MAX_REACH_THREADS)))
+{
+  planner.SetTaskRunner(&reach_pool);
+}
+
 void
 RoutePlannerGlue::SetTerrain(const RasterTerrain *_terrain)
 {
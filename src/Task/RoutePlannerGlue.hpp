@@ -24,17 +24,25 @@
 #define ROUTE_PLANNER_GLUE_HPP
 
 #include "Route/AirspaceRoute.hpp"
+#include "Thread/WorkStealingPool.hpp"
 
 struct GlideSettings;
 class RasterTerrain;
 class ProtectedAirspaceWarningManager;
 
 class RoutePlannerGlue {
+  /**
+   * The maximum number of threads used to calculate the reach.
+   */
+  static constexpr unsigned MAX_REACH_THREADS = 4;
+
   const RasterTerrain *terrain;
   AirspaceRoute planner;
 
+  WorkStealingPool reach_pool;
+
 public:
-  RoutePlannerGlue():terrain(nullptr) {}
+  RoutePlannerGlue();
 
   void SetTerrain(const RasterTerrain *terrain);
 
@@ -76,6 +84,11 @@ public:
   void SolveReach(const AGeoPoint &origin, const RoutePlannerConfig &config,
                   int h_ceiling, bool do_solve);
 
+  gcc_pure
+  bool CanUpdateReach(const AGeoPoint &origin) const {
+    return planner.CanUpdateReach(origin);
+  }
+
   bool FindPositiveArrival(const AGeoPoint &dest, ReachResult &result_r) const;
 
   const FlatProjection &GetTerrainReachProjection() const {
@@ -30,7 +30,10 @@ Copyright_License {
 #include "Projection/WindowProjection.hpp"
 #endif
 
+#include <algorithm>
+
 #include <assert.h>
+#include <stdlib.h>
 
 void
 HeightMatrix::SetSize(size_t _size)
@@ -64,11 +67,20 @@ HeightMatrix::Fill(const RasterMap &map, const GeoBounds &bounds,
                    unsigned width, unsigned height, bool interpolate)
 {
   SetSize(width, height);
+  FillRows(map, bounds, 0, height, interpolate);
+}
+
+void
+HeightMatrix::FillRows(const RasterMap &map, const GeoBounds &bounds,
+                       unsigned y_begin, unsigned y_end, bool interpolate)
+{
+  assert(y_begin <= y_end);
+  assert(y_end <= height);
 
   const Angle delta_y = bounds.GetHeight() / height;
-  Angle latitude = bounds.GetNorth();
-  for (auto p = data.begin(), end = p + width * height;
-       p != end; p += width, latitude -= delta_y) {
+  auto p = data.begin() + y_begin * width;
+  for (unsigned y = y_begin; y < y_end; ++y, p += width) {
+    const Angle latitude = bounds.GetNorth() - delta_y * y;
     map.ScanLine(GeoPoint(bounds.GetWest(), latitude),
                  GeoPoint(bounds.GetEast(), latitude),
                  p, width, interpolate);
@@ -81,19 +93,42 @@ void
 HeightMatrix::Fill(const RasterMap &map, const WindowProjection &projection,
                    unsigned quantisation_pixels, bool interpolate)
 {
-  const unsigned screen_width = projection.GetScreenWidth();
-  const unsigned screen_height = projection.GetScreenHeight();
+  SetSize(projection.GetScreenWidth(), projection.GetScreenHeight(),
+          quantisation_pixels);
+  FillRows(map, projection, quantisation_pixels, 0, height, interpolate);
+}
 
-  SetSize((screen_width + quantisation_pixels - 1) / quantisation_pixels,
-          (screen_height + quantisation_pixels - 1) / quantisation_pixels);
+void
+HeightMatrix::FillRows(const RasterMap &map,
+                       const WindowProjection &projection,
+                       unsigned quantisation_pixels,
+                       unsigned y_begin, unsigned y_end, bool interpolate)
+{
+  assert(y_begin <= y_end);
+  assert(y_end <= height);
+
+  const unsigned screen_width = projection.GetScreenWidth();
 
-  auto p = data.begin();
-  for (unsigned y = 0; y < screen_height;
-       y += quantisation_pixels, p += width) {
-    map.ScanLine(projection.ScreenToGeo(0, y),
-                 projection.ScreenToGeo(screen_width, y),
+  auto p = data.begin() + y_begin * width;
+  for (unsigned y = y_begin; y < y_end; ++y, p += width) {
+    const int screen_y = y * quantisation_pixels;
+    map.ScanLine(projection.ScreenToGeo(0, screen_y),
+                 projection.ScreenToGeo(screen_width, screen_y),
                  p, width, interpolate);
   }
 }
 
 #endif
+
+void
+HeightMatrix::ScrollRows(int dy)
+{
+  assert(unsigned(abs(dy)) < height);
+
+  const unsigned n = height - abs(dy);
+  if (dy > 0)
+    std::copy_n(data.begin() + dy * width, n * width, data.begin());
+  else if (dy < 0)
+    std::copy_backward(data.begin(), data.begin() + n * width,
+                       data.begin() + height * width);
+}
@@ -57,14 +57,42 @@ public:
    */
   void Fill(const RasterMap &map, const GeoBounds &bounds,
             unsigned _width, unsigned _height, bool interpolate);
+
+  /**
+   * Copy values from the #RasterMap to the rows [y_begin, y_end) of
+   * the buffer.  The result is the same as with a Fill() call with
+   * the same bounds and the current size.
+   */
+  void FillRows(const RasterMap &map, const GeoBounds &bounds,
+                unsigned y_begin, unsigned y_end, bool interpolate);
 #else
   /**
    * @param interpolate true enables interpolation of sub-pixel values
    */
   void Fill(const RasterMap &map, const WindowProjection &map_projection,
             unsigned quantisation_pixels, bool interpolate);
+
+  /**
+   * Copy values from the #RasterMap to the rows [y_begin, y_end) of
+   * the buffer.  The result is the same as with a Fill() call with
+   * the same parameters.
+   */
+  void FillRows(const RasterMap &map, const WindowProjection &map_projection,
+                unsigned quantisation_pixels,
+                unsigned y_begin, unsigned y_end, bool interpolate);
 #endif
 
+  /**
+   * Move the rows of the buffer: row y receives the values of row
+   * y + dy.  The rows without a source are undefined; they must be
+   * filled by the caller with FillRows().
+   *
+   * Only whole rows can be moved: RasterMap::ScanLine() derives its
+   * sampling points from the whole line, and scanning a part of a
+   * row would not reproduce them exactly.
+   */
+  void ScrollRows(int dy);
+
   unsigned GetWidth() const {
     return width;
   }
@@ -0,0 +1,137 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#include "InterpolationBatch.hpp"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/**
+ * Values at or below this threshold are "special" (water or
+ * invalid) and disable interpolation; see TerrainHeight::IsSpecial().
+ */
+static constexpr int32_t SPECIAL_THRESHOLD = -30000;
+
+#ifdef __SSE2__
+
+/**
+ * Interpolate four samples.
+ *
+ * The calculation is split into a horizontal and a vertical pass,
+ * each using _mm_madd_epi16() on pairs of 16 bit integers.  The
+ * horizontal results need up to 24 bits; they are split into a high
+ * and a low part for the vertical pass.  All of this is exact, and
+ * yields the same bits as the scalar formula.
+ */
+gcc_always_inline
+static inline void
+Interpolate4(const int16_t *ab, const int16_t *cd,
+             const int16_t *x_weights, const int16_t *y_weights,
+             TerrainHeight *dest)
+{
+  const __m128i vab = _mm_load_si128((const __m128i *)ab);
+  const __m128i vcd = _mm_load_si128((const __m128i *)cd);
+  const __m128i vxw = _mm_load_si128((const __m128i *)x_weights);
+  const __m128i vyw = _mm_load_si128((const __m128i *)y_weights);
+
+  /* horizontal: a*kx + b*ix and c*kx + d*ix */
+  const __m128i top = _mm_madd_epi16(vab, vxw);
+  const __m128i bottom = _mm_madd_epi16(vcd, vxw);
+
+  /* vertical, upper 16 bits: pack (top >> 8, bottom >> 8) into pairs
+     and multiply with (ky, iy) */
+  const __m128i mask16 = _mm_set1_epi32(0xffff);
+  const __m128i high =
+    _mm_madd_epi16(_mm_or_si128(_mm_and_si128(_mm_srai_epi32(top, 8),
+                                              mask16),
+                                _mm_slli_epi32(_mm_srai_epi32(bottom, 8),
+                                               16)),
+                   vyw);
+
+  /* vertical, lower 8 bits */
+  const __m128i mask8 = _mm_set1_epi32(0xff);
+  const __m128i low =
+    _mm_madd_epi16(_mm_or_si128(_mm_and_si128(top, mask8),
+                                _mm_slli_epi32(_mm_and_si128(bottom, mask8),
+                                               16)),
+                   vyw);
+
+  const __m128i sum = _mm_add_epi32(_mm_slli_epi32(high, 8), low);
+
+  /* unsigned shift, then sign-extend the lower 16 bits, just like
+     the conversion to int16_t does */
+  __m128i result = _mm_srli_epi32(sum, 16);
+  result = _mm_srai_epi32(_mm_slli_epi32(result, 16), 16);
+
+  /* if any neighbour is "special", return the top left value */
+  const __m128i threshold = _mm_set1_epi16(SPECIAL_THRESHOLD + 1);
+  const __m128i special16 = _mm_or_si128(_mm_cmplt_epi16(vab, threshold),
+                                         _mm_cmplt_epi16(vcd, threshold));
+  const __m128i special =
+    _mm_xor_si128(_mm_cmpeq_epi32(special16, _mm_setzero_si128()),
+                  _mm_set1_epi32(-1));
+  const __m128i a = _mm_srai_epi32(_mm_slli_epi32(vab, 16), 16);
+  result = _mm_or_si128(_mm_and_si128(special, a),
+                        _mm_andnot_si128(special, result));
+
+  /* all values are in the int16_t range now, so saturation does not
+     occur */
+  _mm_storel_epi64((__m128i *)dest, _mm_packs_epi32(result, result));
+}
+
+#endif
+
+void
+TerrainInterpolationBatch::ComputePortable(unsigned start,
+                                           TerrainHeight *dest) const
+{
+  for (unsigned i = start * 2, end = size * 2; i < end; i += 2) {
+    const int a = ab[i], b = ab[i + 1], c = cd[i], d = cd[i + 1];
+    if (a <= SPECIAL_THRESHOLD || b <= SPECIAL_THRESHOLD ||
+        c <= SPECIAL_THRESHOLD || d <= SPECIAL_THRESHOLD) {
+      dest[i / 2] = TerrainHeight(a);
+      continue;
+    }
+
+    const unsigned kx = x_weights[i], ix = x_weights[i + 1];
+    const unsigned ky = y_weights[i], iy = y_weights[i + 1];
+
+    dest[i / 2] = TerrainHeight((a * kx * ky + b * ix * ky
+                                 + c * kx * iy + d * ix * iy) >> 16);
+  }
+}
+
+void
+TerrainInterpolationBatch::Compute(TerrainHeight *dest) const
+{
+  unsigned i = 0;
+
+#ifdef __SSE2__
+  for (; i + 4 <= size; i += 4)
+    Interpolate4(ab + i * 2, cd + i * 2,
+                 x_weights + i * 2, y_weights + i * 2, dest + i);
+#endif
+
+  ComputePortable(i, dest);
+}
@@ -0,0 +1,148 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#ifndef XCSOAR_TERRAIN_INTERPOLATION_BATCH_HPP
+#define XCSOAR_TERRAIN_INTERPOLATION_BATCH_HPP
+
+#include "Height.hpp"
+#include "Compiler.h"
+
+#include <assert.h>
+#include <stdint.h>
+
+/**
+ * A batch of bilinear terrain height interpolations.  The callers
+ * collect the four neighbouring height values and the sub-pixel
+ * position of each sample (which involves random memory accesses),
+ * and Compute() does the arithmetic on all of them at once, using
+ * SIMD instructions if available.
+ *
+ * The data is stored as "structure of arrays"; each array holds
+ * pairs of 16 bit integers, to allow aligned vector loads and SSE2's
+ * "multiply and add" instruction.
+ */
+class TerrainInterpolationBatch {
+public:
+  static constexpr unsigned CAPACITY = 64;
+
+private:
+  unsigned size = 0;
+
+  /**
+   * The four neighbours: pairs of top left and top right, pairs of
+   * bottom left and bottom right.
+   */
+  alignas(16) int16_t ab[CAPACITY * 2];
+  alignas(16) int16_t cd[CAPACITY * 2];
+
+  /**
+   * The horizontal weights (0x100 - ix, ix) and the vertical weights
+   * (0x100 - iy, iy), where ix and iy are the sub-pixel position
+   * (0..255).
+   */
+  alignas(16) int16_t x_weights[CAPACITY * 2];
+  alignas(16) int16_t y_weights[CAPACITY * 2];
+
+public:
+  unsigned GetSize() const {
+    return size;
+  }
+
+  bool IsEmpty() const {
+    return size == 0;
+  }
+
+  bool IsFull() const {
+    return size == CAPACITY;
+  }
+
+  void Clear() {
+    size = 0;
+  }
+
+  /**
+   * Add a sample.
+   *
+   * @param tm pointer to the top left neighbour
+   * @param dx offset of the right neighbour (0 at the right edge)
+   * @param dy offset of the bottom neighbour (0 at the bottom edge)
+   * @param ix the sub-pixel column (0..255)
+   * @param iy the sub-pixel row (0..255)
+   */
+  void Append(const TerrainHeight *tm, unsigned dx, unsigned dy,
+              unsigned ix, unsigned iy) {
+    assert(!IsFull());
+    assert(ix < 0x100);
+    assert(iy < 0x100);
+
+    const unsigned i = size++ * 2;
+    ab[i] = tm->GetValue();
+    ab[i + 1] = tm[dx].GetValue();
+    cd[i] = tm[dy].GetValue();
+    cd[i + 1] = tm[dx + dy].GetValue();
+    x_weights[i] = 0x100 - ix;
+    x_weights[i + 1] = ix;
+    y_weights[i] = 0x100 - iy;
+    y_weights[i + 1] = iy;
+  }
+
+  /**
+   * Add a sample whose result is already known (e.g. out of range).
+   * Compute() will copy it as-is.
+   */
+  void AppendValue(TerrainHeight value) {
+    assert(!IsFull());
+
+    /* an "invalid" neighbour disables interpolation, and the top
+       left value is returned */
+    const unsigned i = size++ * 2;
+    ab[i] = value.GetValue();
+    ab[i + 1] = cd[i] = cd[i + 1] = TerrainHeight::Invalid().GetValue();
+    x_weights[i] = y_weights[i] = 0x100;
+    x_weights[i + 1] = y_weights[i + 1] = 0;
+  }
+
+  /**
+   * Calculate all samples and write them to the specified buffer.
+   * The results are the same as RasterBuffer::GetInterpolated().
+   */
+  void Compute(TerrainHeight *dest) const;
+
+  /**
+   * Call Compute() and clear the batch.
+   *
+   * @return the end of the values written to #dest
+   */
+  TerrainHeight *Flush(TerrainHeight *dest) {
+    Compute(dest);
+    dest += size;
+    Clear();
+    return dest;
+  }
+
+private:
+  gcc_hot
+  void ComputePortable(unsigned start, TerrainHeight *dest) const;
+};
+
+#endif
@@ -23,6 +23,7 @@ Copyright_License {
 
 #include "Loader.hpp"
 #include "RasterTileCache.hpp"
+#include "RasterTileStore.hpp"
 #include "RasterProjection.hpp"
 #include "ZzipStream.hpp"
 #include "WorldFile.hpp"
@@ -164,6 +165,9 @@ TerrainLoader::SetSize(unsigned _width, unsigned _height,
   if (scan_overview)
     raster_tile_cache.SetSize(_width, _height, _tile_width, _tile_height,
                               tile_columns, tile_rows);
+
+  if (store_writer != nullptr)
+    store_writer->SetSize(_width, _height, tile_columns * tile_rows);
 }
 
 void
@@ -176,6 +180,9 @@ TerrainLoader::PutTileData(unsigned index,
     raster_tile_cache.PutOverviewTile(index, start_x, start_y,
                                       end_x, end_y, m);
 
+  if (store_writer != nullptr)
+    store_writer->PutTile(index, m);
+
   if (scan_tiles) {
     const ScopeExclusiveLock lock(mutex);
     raster_tile_cache.PutTileData(index, m);
@@ -295,12 +302,14 @@ LoadTerrainOverview(struct zzip_dir *dir,
                     const char *path, const char *world_file,
                     RasterTileCache &raster_tile_cache,
                     bool all,
-                    OperationEnvironment &env)
+                    OperationEnvironment &env,
+                    RasterTileStoreWriter *store_writer)
 {
   /* fake a mutex - we don't need it for LoadTerrainOverview() */
   SharedMutex mutex;
 
-  TerrainLoader loader(mutex, raster_tile_cache, true, all, env);
+  TerrainLoader loader(mutex, raster_tile_cache, true, all, env,
+                       store_writer);
   return loader.LoadOverview(dir, path, world_file);
 }
 
@@ -22,6 +22,7 @@ Copyright_License {
 */
 
 #include "Terrain/RasterBuffer.hpp"
+#include "Terrain/InterpolationBatch.hpp"
 #include "Math/FastMath.hpp"
 
 #include <algorithm>
@@ -34,6 +35,22 @@ RasterBuffer::Resize(unsigned _width, unsigned _height)
   assert(_width > 0 && _height > 0);
 
   data.GrowDiscard(_width, _height);
+  view = data.begin();
+  width = _width;
+  height = _height;
+}
+
+void
+RasterBuffer::Map(const TerrainHeight *_data,
+                  unsigned _width, unsigned _height)
+{
+  assert(_data != nullptr);
+  assert(_width > 0 && _height > 0);
+
+  data.Reset();
+  view = _data;
+  width = _width;
+  height = _height;
 }
 
 TerrainHeight
@@ -80,6 +97,32 @@ RasterBuffer::GetInterpolated(unsigned lx, unsigned ly) const
   return GetInterpolated(lx, ly, ix, iy);
 }
 
+void
+RasterBuffer::AppendInterpolated(TerrainInterpolationBatch &batch,
+                                 unsigned lx, unsigned ly,
+                                 unsigned ix, unsigned iy) const
+{
+  assert(IsDefined());
+  assert(lx < GetWidth());
+  assert(ly < GetHeight());
+
+  const unsigned int dx = (lx == GetWidth() - 1) ? 0 : 1;
+  const unsigned int dy = (ly == GetHeight() - 1) ? 0 : GetWidth();
+  batch.Append(GetDataAt(lx, ly), dx, dy, ix, iy);
+}
+
+void
+RasterBuffer::AppendInterpolated(TerrainInterpolationBatch &batch,
+                                 unsigned lx, unsigned ly) const
+{
+  const unsigned int ix = CombinedDivAndMod(lx);
+  const unsigned int iy = CombinedDivAndMod(ly);
+  if (lx >= GetWidth() || ly >= GetHeight())
+    batch.AppendValue(TerrainHeight::Invalid());
+  else
+    AppendInterpolated(batch, lx, ly, ix, iy);
+}
+
 /**
  * This class implements an algorithm to traverse pixels quickly with
  * only integer addition, no multiplication and division.
@@ -146,13 +189,19 @@ RasterBuffer::ScanHorizontalLine(unsigned ax, unsigned bx, unsigned y,
     unsigned cy = y;
     const unsigned int iy = CombinedDivAndMod(cy);
 
+    TerrainInterpolationBatch batch;
+
     --size;
     for (int i = 0; (unsigned)i <= size; ++i) {
       unsigned cx = ax + (i * dx) / (int)size;
       const unsigned int ix = CombinedDivAndMod(cx);
 
-      *buffer++ = GetInterpolated(cx, cy, ix, iy);
+      AppendInterpolated(batch, cx, cy, ix, iy);
+      if (batch.IsFull())
+        buffer = batch.Flush(buffer);
     }
+
+    batch.Flush(buffer);
   } else if (gcc_likely(dx > 0)) {
     /* no interpolation needed, forward scan */
 
@@ -216,6 +265,8 @@ RasterBuffer::ScanLine(unsigned ax, unsigned ay, unsigned bx, unsigned by,
       (unsigned)(abs(dx) + abs(dy)) < (2 * size << RasterTraits::SUBPIXEL_BITS)) {
     /* interpolate */
 
+    TerrainInterpolationBatch batch;
+
     for (int i = 0; (unsigned)i <= size; ++i) {
       unsigned cx = ax + (i * dx) / (int)size;
       unsigned cy = ay + (i * dy) / (int)size;
@@ -223,8 +274,12 @@ RasterBuffer::ScanLine(unsigned ax, unsigned ay, unsigned bx, unsigned by,
       const unsigned int ix = CombinedDivAndMod(cx);
       const unsigned int iy = CombinedDivAndMod(cy);
 
-      *buffer++ = GetInterpolated(cx, cy, ix, iy);
+      AppendInterpolated(batch, cx, cy, ix, iy);
+      if (batch.IsFull())
+        buffer = batch.Flush(buffer);
     }
+
+    batch.Flush(buffer);
   } else {
     /* no interpolation needed */
 
@@ -263,7 +318,7 @@ TerrainHeight
 RasterBuffer::GetMaximum() const
 {
   return IsDefined()
-    ? *std::max_element(data.begin(), data.end(),
+    ? *std::max_element(view, view + width * height,
                         [](TerrainHeight a, TerrainHeight b) {
                           return a.GetValue() < b.GetValue();
                         })
@@ -29,29 +29,49 @@ Copyright_License {
 #include "Util/AllocatedGrid.hxx"
 #include "Compiler.h"
 
+#include <assert.h>
 #include <stdint.h>
 
+class TerrainInterpolationBatch;
+
 class RasterBuffer {
   AllocatedGrid<TerrainHeight> data;
 
+  /**
+   * Pointer to the first height value.  This points either into
+   * #data or into externally owned read-only memory (see Map()).
+   */
+  const TerrainHeight *view = nullptr;
+
+  unsigned width = 0, height = 0;
+
 public:
   RasterBuffer() = default;
   RasterBuffer(unsigned _width, unsigned _height)
-    :data(_width, _height) {}
+    :data(_width, _height), view(data.begin()),
+     width(_width), height(_height) {}
 
   RasterBuffer(const RasterBuffer &) = delete;
   RasterBuffer &operator=(const RasterBuffer &) = delete;
 
   bool IsDefined() const {
-    return data.IsDefined();
+    return view != nullptr;
+  }
+
+  /**
+   * Does this object refer to external memory instead of owning a
+   * buffer?
+   */
+  bool IsMapped() const {
+    return view != nullptr && !data.IsDefined();
   }
 
   unsigned GetWidth() const {
-    return data.GetWidth();
+    return width;
   }
 
   unsigned GetHeight() const {
-    return data.GetHeight();
+    return height;
   }
 
   unsigned GetFineWidth() const {
@@ -63,23 +83,37 @@ public:
   }
 
   TerrainHeight *GetData() {
+    assert(!IsMapped());
+
     return data.begin();
   }
 
   const TerrainHeight *GetData() const {
-    return data.begin();
+    return view;
   }
 
   const TerrainHeight *GetDataAt(unsigned x, unsigned y) const {
-    return data.GetPointerAt(x, y);
+    assert(x < width);
+    assert(y < height);
+
+    return view + y * width + x;
   }
 
   void Reset() {
     data.Reset();
+    view = nullptr;
+    width = height = 0;
   }
 
   void Resize(unsigned _width, unsigned _height);
 
+  /**
+   * Refer to an external read-only buffer (e.g. a file mapping)
+   * instead of allocating memory.  The caller is responsible for
+   * keeping the memory alive until Reset() or Resize() is called.
+   */
+  void Map(const TerrainHeight *_data, unsigned _width, unsigned _height);
+
   gcc_pure
   TerrainHeight GetInterpolated(unsigned lx, unsigned ly,
                                 unsigned ix, unsigned iy) const;
@@ -87,6 +121,21 @@ public:
   gcc_pure
   TerrainHeight GetInterpolated(unsigned lx, unsigned ly) const;
 
+  /**
+   * Like GetInterpolated(), but only collect the input values into
+   * the #TerrainInterpolationBatch.
+   */
+  void AppendInterpolated(TerrainInterpolationBatch &batch,
+                          unsigned lx, unsigned ly,
+                          unsigned ix, unsigned iy) const;
+
+  /**
+   * Like GetInterpolated(), but only collect the input values into
+   * the #TerrainInterpolationBatch.
+   */
+  void AppendInterpolated(TerrainInterpolationBatch &batch,
+                          unsigned lx, unsigned ly) const;
+
   gcc_pure
   TerrainHeight Get(unsigned x, unsigned y) const {
     return *GetDataAt(x, y);
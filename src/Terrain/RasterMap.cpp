@@ -60,6 +60,26 @@ RasterMap::GetInterpolatedHeight(const GeoPoint &location) const
   return raster_tile_cache.GetInterpolatedHeight(pt.x, pt.y);
 }
 
+void
+RasterMap::GetInterpolatedHeights(const GeoPoint *locations,
+                                  TerrainHeight *buffer, unsigned n) const
+{
+  constexpr unsigned CHUNK = 64;
+  RasterLocation pts[CHUNK];
+
+  while (n > 0) {
+    const unsigned chunk = std::min(n, CHUNK);
+    for (unsigned i = 0; i < chunk; ++i)
+      pts[i] = projection.ProjectFine(locations[i]);
+
+    raster_tile_cache.GetInterpolatedHeights(pts, buffer, chunk);
+
+    locations += chunk;
+    buffer += chunk;
+    n -= chunk;
+  }
+}
+
 void
 RasterMap::ScanLine(const GeoPoint &start, const GeoPoint &end,
                     TerrainHeight *buffer, unsigned size,
@@ -111,6 +111,16 @@ public:
   gcc_pure
   TerrainHeight GetInterpolatedHeight(const GeoPoint &location) const;
 
+  /**
+   * Determine the interpolated terrain height at many locations at
+   * once.  This is faster than calling GetInterpolatedHeight() for
+   * each of them.
+   *
+   * @param buffer the destination buffer, one element per location
+   */
+  void GetInterpolatedHeights(const GeoPoint *locations,
+                              TerrainHeight *buffer, unsigned n) const;
+
   /**
    * Scan a straight line and fill the buffer with the specified
    * number of samples along the line.
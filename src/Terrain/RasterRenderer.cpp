@@ -23,6 +23,7 @@ Copyright_License {
 
 #include "Terrain/RasterRenderer.hpp"
 #include "Terrain/RasterMap.hpp"
+#include "Terrain/SlopeShading.hpp"
 #include "Math/FastMath.hpp"
 #include "Util/Clamp.hpp"
 #include "Screen/Ramp.hpp"
@@ -31,11 +32,18 @@ Copyright_License {
 #include "Screen/RawBitmap.hpp"
 #include "Renderer/GeoBitmapRenderer.hpp"
 #include "Projection/WindowProjection.hpp"
+#include "Math/Util.hpp"
 #include "Asset.hpp"
 #include "Event/Idle.hpp"
 
+#ifndef ENABLE_OPENGL
+#include "Projection/CompareProjection.hpp"
+#endif
+
 #include <assert.h>
+#include <math.h>
 #include <stdint.h>
+#include <stdlib.h>
 
 /**
  * Interpolate between x and y with i/128, i.e. i/(1 << 7).
@@ -82,23 +90,6 @@ TerrainShading(const int illum, RGB8Color color)
     return RawColor(color.Red(), color.Green(), color.Blue());
 }
 
-gcc_const
-static unsigned
-ContourInterval(const unsigned h, const unsigned contour_height_scale)
-{
-  return std::min(254u, h >> contour_height_scale);
-}
-
-gcc_const
-static unsigned
-ContourInterval(const TerrainHeight h, const unsigned contour_height_scale)
-{
-  if (gcc_unlikely(h.IsSpecial()) || h.GetValue() <= 0)
-    return 0;
-
-  return ContourInterval(h.GetValue(), contour_height_scale);
-}
-
 RasterRenderer::RasterRenderer()
 {
   // scale quantisation_pixels so resolution is not too high on old hardware
@@ -197,7 +188,129 @@ RasterRenderer::ScanMap(const RasterMap &map, const WindowProjection &projection
   last_quantisation_pixels = quantisation_pixels;
 #else
   height_matrix.Fill(map, projection, quantisation_pixels, true);
+
+  this->projection = projection;
 #endif
+
+  dirty.clear();
+}
+
+#ifdef ENABLE_OPENGL
+
+/**
+ * Is the size of the two angles equal within 10%?
+ */
+gcc_const
+static bool
+IsSimilarSize(Angle a, Angle b)
+{
+  return fabs(a.Native() - b.Native()) <= 0.1 * b.Native();
+}
+
+#endif
+
+bool
+RasterRenderer::ScrollMap(const RasterMap &map,
+                          const WindowProjection &new_projection)
+{
+  const unsigned width = height_matrix.GetWidth();
+  const unsigned height = height_matrix.GetHeight();
+  if (image == nullptr || width == 0 || height == 0)
+    return false;
+
+#ifdef ENABLE_OPENGL
+  if (!bounds.IsValid() ||
+      quantisation_pixels != last_quantisation_pixels ||
+      new_projection.GetScreenWidth() / quantisation_pixels != width ||
+      new_projection.GetScreenHeight() / quantisation_pixels != height)
+    return false;
+
+  /* the texture is north-up; a different size means that the map
+     was zoomed (or rotated, which changes the bounding box) */
+  const GeoBounds screen_bounds = new_projection.GetScreenBounds();
+  const GeoBounds wanted_bounds = screen_bounds.Scale(1.5);
+  if (!IsSimilarSize(wanted_bounds.GetWidth(), bounds.GetWidth()) ||
+      !IsSimilarSize(wanted_bounds.GetHeight(), bounds.GetHeight()))
+    return false;
+
+  const Angle cell_height = bounds.GetHeight() / height;
+
+  /* only whole rows can be moved (see HeightMatrix::ScrollRows());
+     the texture is larger than the screen, so it can still be used
+     if the map was moved a bit to the east or west */
+  const int dy = iround((bounds.GetCenter().latitude -
+                         wanted_bounds.GetCenter().latitude)
+                        .Native() / cell_height.Native());
+
+  const GeoBounds new_bounds(GeoPoint(bounds.GetWest(),
+                                      bounds.GetNorth() - cell_height * dy),
+                             GeoPoint(bounds.GetEast(),
+                                      bounds.GetSouth() - cell_height * dy));
+
+  GeoBounds visible = screen_bounds;
+  if (!visible.IntersectWith(map.GetBounds()) ||
+      !new_bounds.IsInside(visible))
+    return false;
+#else
+  if (!projection.IsValid() ||
+      new_projection.GetScreenWidth() != projection.GetScreenWidth() ||
+      new_projection.GetScreenHeight() != projection.GetScreenHeight() ||
+      new_projection.GetScreenOrigin() != projection.GetScreenOrigin() ||
+      new_projection.GetScale() != projection.GetScale() ||
+      new_projection.GetScreenAngle() != projection.GetScreenAngle())
+    return false;
+
+  /* the distance of two rows in screen pixels (see
+     HeightMatrix::Fill()) */
+  const unsigned step_y = quantisation_pixels;
+
+  /* where is the old top left corner on the new screen? */
+  const PixelPoint corner =
+    new_projection.GeoToScreen(projection.ScreenToGeo(0, 0));
+  const int dy = -iround(double(corner.y) / step_y);
+
+  /* the projection which is reached by moving whole rows (see
+     HeightMatrix::ScrollRows()); a horizontal move is only accepted
+     within the tolerance of #CompareProjection */
+  WindowProjection scrolled = projection;
+  const PixelPoint origin = projection.GetScreenOrigin();
+  scrolled.SetGeoLocation(projection.ScreenToGeo(origin.x,
+                                                 origin.y + dy * int(step_y)));
+  scrolled.UpdateScreenBounds();
+
+  if (!CompareProjection(scrolled).Compare(new_projection))
+    return false;
+#endif
+
+  if (dy == 0)
+    /* nothing to do (this can only happen when the caller did not
+       check whether the previous image is still valid) */
+    return true;
+
+  /* moving by more than half of the image is not worth it */
+  if (2 * unsigned(abs(dy)) > height)
+    return false;
+
+  height_matrix.ScrollRows(dy);
+
+  RawColor *top_row = image->GetTopRow();
+  ScrollSlopeImage(top_row, image->GetNextRow(top_row) - top_row,
+                   width, height, dy, quantisation_effective, dirty);
+
+  /* the rows which have no source */
+  const unsigned y_begin = dy > 0 ? height - dy : 0;
+  const unsigned y_end = dy > 0 ? height : -dy;
+
+#ifdef ENABLE_OPENGL
+  bounds = new_bounds;
+  height_matrix.FillRows(map, bounds, y_begin, y_end, true);
+#else
+  projection = scrolled;
+  height_matrix.FillRows(map, projection, quantisation_pixels,
+                         y_begin, y_end, true);
+#endif
+
+  return true;
 }
 
 void
@@ -215,6 +328,8 @@ RasterRenderer::GenerateImage(bool do_shading,
 
     delete[] contour_column_base;
     contour_column_base = new unsigned char[height_matrix.GetWidth()];
+
+    dirty.clear();
   }
 
   if (quantisation_effective == 0) {
@@ -224,14 +339,16 @@ RasterRenderer::GenerateImage(bool do_shading,
 
   const unsigned contour_height_scale = do_contour? height_scale * 2 : 16;
 
-  ContourStart(contour_height_scale);
-
   if (do_shading)
     GenerateSlopeImage(height_scale, contrast, brightness,
                        sunazimuth, contour_height_scale);
-  else
+  else {
+    /* this is cheap enough to be always done for the whole image */
+    ContourStart(contour_height_scale);
     GenerateUnshadedImage(height_scale, contour_height_scale);
+  }
 
+  dirty.clear();
   image->SetDirty();
 }
 
@@ -280,26 +397,6 @@ RasterRenderer::GenerateUnshadedImage(unsigned height_scale,
   }
 }
 
-/**
- * Clip the difference between two adjacent terrain height values to
- * sane bounds.  This works around integer overflows in the
- * GenerateSlopeImage() formula when the map file is broken, avoiding
- * the sqrt() call with a negative argument.
- */
-gcc_const
-static int
-ClipHeightDelta(int d)
-{
-  return Clamp(d, -512, 512);
-}
-
-gcc_const
-static int
-ClipHeightDelta(TerrainHeight a, TerrainHeight b)
-{
-  return ClipHeightDelta(a.GetValue() - b.GetValue());
-}
-
 // JMW: if zoomed right in (e.g. one unit is larger than terrain
 // grid), then increase the step size to be equal to the terrain
 // grid for purposes of calculating slope, to avoid shading problems
@@ -313,127 +410,34 @@ RasterRenderer::GenerateSlopeImage(unsigned height_scale,
 {
   assert(quantisation_effective > 0);
 
-  PixelRect border;
-  border.left = quantisation_effective;
-  border.top = quantisation_effective;
-  border.right = height_matrix.GetWidth() - quantisation_effective;
-  border.bottom = height_matrix.GetHeight() - quantisation_effective;
-
-  const unsigned height_slope_factor =
+  SlopeShadingParameters shading;
+  shading.colors = color_table + 64 * 256;
+  shading.height_scale = height_scale;
+  shading.contour_height_scale = contour_height_scale;
+  shading.quantisation = quantisation_effective;
+  shading.height_slope_factor =
     Clamp((unsigned)pixel_size, 1u,
           /* this upper limit avoids integer overflows in the "mag"
              formula; it effectively limits "dd2" so calculating its
              square will not overflow */
           8192u / (quantisation_effective * quantisation_effective));
-
-  const auto *src = height_matrix.GetData();
-  const RawColor *oColorBuf = color_table + 64 * 256;
-
-  RawColor *dest = image->GetTopRow();
-
-  for (unsigned y = 0; y < height_matrix.GetHeight(); ++y) {
-    const unsigned row_plus_index = y < (unsigned)border.bottom
-      ? quantisation_effective
-      : height_matrix.GetHeight() - 1 - y;
-    const unsigned row_plus_offset = height_matrix.GetWidth() * row_plus_index;
-
-    const unsigned row_minus_index = y >= quantisation_effective
-      ? quantisation_effective : y;
-    const unsigned row_minus_offset = height_matrix.GetWidth() * row_minus_index;
-
-    const unsigned p31 = row_plus_index + row_minus_index;
-
-    RawColor *p = dest;
-    dest = image->GetNextRow(dest);
-
-    unsigned contour_row_base = ContourInterval(*src, contour_height_scale);
-    unsigned char *contour_this_column_base = contour_column_base;
-
-    for (unsigned x = 0; x < height_matrix.GetWidth(); ++x, ++src) {
-      const auto e = *src;
-      if (gcc_likely(!e.IsSpecial())) {
-        unsigned h = std::max(0, (int)e.GetValue());
-
-        const unsigned contour_interval =
-          ContourInterval(h, contour_height_scale);
-
-        h = std::min(254u, h >> height_scale);
-
-        // no need to calculate slope if undefined height or sea level
-
-        // Y direction
-        assert(src - row_minus_offset >= height_matrix.GetData());
-        assert(src + row_plus_offset >= height_matrix.GetData());
-        assert(src - row_minus_offset < height_matrix.GetDataEnd());
-        assert(src + row_plus_offset < height_matrix.GetDataEnd());
-
-        // X direction
-
-        const unsigned column_plus_index = x < (unsigned)border.right
-          ? quantisation_effective
-          : height_matrix.GetWidth() - 1 - x;
-        const unsigned column_minus_index = x >= (unsigned)border.left
-          ? quantisation_effective : x;
-
-        assert(src - column_minus_index >= height_matrix.GetData());
-        assert(src + column_plus_index >= height_matrix.GetData());
-        assert(src - column_minus_index < height_matrix.GetDataEnd());
-        assert(src + column_plus_index < height_matrix.GetDataEnd());
-
-        const auto h_above = src[-(int)row_minus_offset];
-        const auto h_below = src[row_plus_offset];
-        const auto h_left = src[-(int)column_minus_index];
-        const auto h_right = src[column_plus_index];
-
-        if (gcc_unlikely(h_above.IsSpecial() ||
-                         h_below.IsSpecial() ||
-                         h_left.IsSpecial() ||
-                         h_right.IsSpecial())) {
-          /* some "special" terrain value surrounding us (water or
-             invalid), skip slope calculation */
-          *p++ = oColorBuf[h];
-          contour_this_column_base++;
-          continue;
-        }
-
-        if (gcc_unlikely((contour_interval != contour_row_base)
-                         || (contour_interval != *contour_this_column_base))) {
-
-          *contour_this_column_base++ = contour_row_base = contour_interval;
-          *p++ = oColorBuf[int(h) - 64 * 256];
-          continue;
-        }
-
-        const int p32 = ClipHeightDelta(h_above, h_below);
-        const int p22 = ClipHeightDelta(h_right, h_left);
-
-        const unsigned p20 = column_plus_index + column_minus_index;
-
-        const int dd0 = p22 * int(p31);
-        const int dd1 = int(p20) * p32;
-        const unsigned dd2 = p20 * p31 * height_slope_factor;
-        const int num = (int(dd2) * sz + dd0 * sx + dd1 * sy);
-        const unsigned square_mag = dd0 * dd0 + dd1 * dd1 + dd2 * dd2;
-        const unsigned mag = (unsigned)sqrt(square_mag);
-        /* this is a workaround for a SIGFPE (division by zero)
-           observed by our users on some Android devices (e.g. Nexus
-           7), even though we did our best to make sure that the
-           integer arithmetics above can't overflow */
-        /* TODO: debug this problem and replace this workaround */
-        const int sval = num / int(mag|1);
-        const int sindex = (sval - sz) * contrast / 128;
-        *p++ = oColorBuf[int(h) + 256 * Clamp(sindex, -63, 63)];
-      } else if (e.IsWater()) {
-        // we're in the water, so look up the color for water
-        *p++ = oColorBuf[255];
-      } else {
-        /* outside the terrain file bounds: white background */
-        *p++ = RawColor(0xff, 0xff, 0xff);
-      }
-      contour_this_column_base++;
-
-    }
-  }
+  shading.contrast = contrast;
+  shading.sx = sx;
+  shading.sy = sy;
+  shading.sz = sz;
+
+  RawColor *top_row = image->GetTopRow();
+  const int row_step = image->GetNextRow(top_row) - top_row;
+
+  if (dirty.empty())
+    ::GenerateSlopeImage(height_matrix, top_row, row_step, shading,
+                         PixelRect(0, 0, height_matrix.GetWidth(),
+                                   height_matrix.GetHeight()),
+                         task_runner);
+  else
+    for (const auto &rect : dirty)
+      ::GenerateSlopeImage(height_matrix, top_row, row_step, shading,
+                           rect, task_runner);
 }
 
 void
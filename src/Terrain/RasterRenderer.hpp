@@ -25,15 +25,20 @@ Copyright_License {
 #define XCSOAR_RASTER_RENDERER_HPP
 
 #include "Terrain/HeightMatrix.hpp"
+#include "Screen/Point.hpp"
+#include "Util/TrivialArray.hxx"
 
 #ifdef ENABLE_OPENGL
 #include "Geo/GeoBounds.hpp"
+#else
+#include "Projection/WindowProjection.hpp"
 #endif
 
 #define NUM_COLOR_RAMP_LEVELS 13
 
 class Angle;
 class Canvas;
+class TaskRunner;
 class RasterMap;
 class WindowProjection;
 class RawBitmap;
@@ -69,9 +74,23 @@ class RasterRenderer {
    * texture has to be redrawn.
    */
   GeoBounds bounds = GeoBounds::Invalid();
+#else
+  /**
+   * The projection of the #HeightMatrix and the #RawBitmap.  This
+   * attribute is used to decide whether the previous image can be
+   * scrolled.
+   */
+  WindowProjection projection;
 #endif
 
   HeightMatrix height_matrix;
+
+  /**
+   * The rectangles (in matrix cells) which have to be rendered by
+   * the next GenerateImage() call after ScrollMap().  An empty list
+   * means the whole image.
+   */
+  TrivialArray<PixelRect, 2> dirty;
   RawBitmap *image = nullptr;
 
   unsigned char *contour_column_base = nullptr;
@@ -80,6 +99,12 @@ class RasterRenderer {
 
   RawColor *color_table = nullptr;
 
+  /**
+   * Used to render the slope shading in parallel; nullptr renders
+   * serially.
+   */
+  TaskRunner *task_runner = nullptr;
+
 public:
   RasterRenderer();
   ~RasterRenderer();
@@ -87,6 +112,10 @@ public:
   RasterRenderer(const RasterRenderer &) = delete;
   RasterRenderer &operator=(const RasterRenderer &) = delete;
 
+  void SetTaskRunner(TaskRunner *_task_runner) {
+    task_runner = _task_runner;
+  }
+
   const HeightMatrix &GetHeightMatrix() const {
     return height_matrix;
   }
@@ -99,11 +128,19 @@ public:
     return height_matrix.GetHeight();
   }
 
-#ifdef ENABLE_OPENGL
+  /**
+   * Forget the previous image, i.e. the next ScrollMap() call will
+   * fail.
+   */
   void Invalidate() {
+#ifdef ENABLE_OPENGL
     bounds.SetInvalid();
+#else
+    projection = WindowProjection();
+#endif
   }
 
+#ifdef ENABLE_OPENGL
   /**
    * Calculate a new #quantisation_pixels value.
    *
@@ -117,6 +154,14 @@ public:
   }
 
   const GLTexture &BindAndGetTexture() const;
+#else
+  /**
+   * Returns the projection of the image, which may differ slightly
+   * from the one passed to ScrollMap().
+   */
+  const WindowProjection &GetProjection() const {
+    return projection;
+  }
 #endif
 
   /**
@@ -132,6 +177,21 @@ public:
    */
   void ScanMap(const RasterMap &map, const WindowProjection &projection);
 
+  /**
+   * Attempt to reuse the previous height matrix and image for the
+   * given projection, which differs from the previous one only by a
+   * vertical translation.  The rows are moved, and only the newly
+   * exposed rows are scanned; the following GenerateImage() call
+   * (which must have the same parameters as the previous one)
+   * renders only the affected parts of the image.  The result is the
+   * same as with ScanMap() on the scrolled projection.
+   *
+   * @return false if the projection cannot be reached by scrolling
+   * (e.g. it was rotated, zoomed or moved horizontally); ScanMap()
+   * must be called then
+   */
+  bool ScrollMap(const RasterMap &map, const WindowProjection &projection);
+
   /**
    * Convert the height matrix into the image.
    */
@@ -170,7 +230,6 @@ protected:
                           const unsigned contour_height_scale);
 
 private:
-
   void ContourStart(const unsigned contour_height_scale);
 };
 
@@ -26,11 +26,24 @@ Copyright_License {
 #include "Profile/Profile.hpp"
 #include "IO/ZipArchive.hpp"
 #include "IO/FileCache.hpp"
+#include "OS/FileMapping.hpp"
 #include "OS/ConvertPathName.hpp"
 #include "Operation/Operation.hpp"
 #include "Util/ConvertString.hpp"
 
 static const TCHAR *const terrain_cache_name = _T("terrain");
+static const TCHAR *const tile_store_name = _T("terrain_tiles");
+
+/**
+ * The maximum size of the #RasterTileStore file.  Larger terrain
+ * files are decoded on demand.  #FileMapping refuses files larger
+ * than 1 GB, and Android devices have a small address space.
+ */
+#ifdef ANDROID
+static constexpr size_t MAX_TILE_STORE_SIZE = 256 * 1024 * 1024;
+#else
+static constexpr size_t MAX_TILE_STORE_SIZE = 1024 * 1024 * 1024;
+#endif
 
 inline bool
 RasterTerrain::LoadCache(FileCache &cache, Path path)
@@ -63,21 +76,60 @@ RasterTerrain::SaveCache(FileCache &cache, Path path) const
   return success;
 }
 
+inline bool
+RasterTerrain::LoadTileStore(FileCache &cache, Path path)
+{
+  size_t offset;
+  auto mapping = cache.Map(tile_store_name, path, offset);
+  if (!mapping || !tile_store.Open(std::move(mapping), offset))
+    return false;
+
+  if (!map.GetTileCache().MapTiles(tile_store)) {
+    tile_store.Close();
+    return false;
+  }
+
+  return true;
+}
+
 inline bool
 RasterTerrain::Load(Path path, FileCache *cache,
                     OperationEnvironment &operation)
 {
-  if (LoadCache(cache, path))
+  if (LoadCache(cache, path)) {
+    /* if there is no tile store, tiles will be decoded on demand */
+    LoadTileStore(*cache, path);
     return true;
+  }
 
-  if (!LoadTerrainOverview(archive.get(), map.GetTileCache(), operation))
+  /* the overview scan decodes all tiles anyway; write them to the
+     tile store while we're at it */
+  FILE *store_file = cache != nullptr
+    ? cache->Save(tile_store_name, path)
+    : nullptr;
+  RasterTileStoreWriter store_writer(store_file, MAX_TILE_STORE_SIZE);
+
+  if (!LoadTerrainOverview(archive.get(), "terrain.jp2", "terrain.j2w",
+                           map.GetTileCache(), false, operation,
+                           store_file != nullptr ? &store_writer : nullptr)) {
+    if (store_file != nullptr)
+      cache->Cancel(tile_store_name, store_file);
     return false;
+  }
 
   map.UpdateProjection();
 
-  if (cache != nullptr)
+  if (cache != nullptr) {
     SaveCache(*cache, path);
 
+    if (store_file != nullptr) {
+      if (!store_writer.Finish())
+        cache->Cancel(tile_store_name, store_file);
+      else if (cache->Commit(tile_store_name, store_file))
+        LoadTileStore(*cache, path);
+    }
+  }
+
   return true;
 }
 
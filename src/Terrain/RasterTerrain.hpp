@@ -25,6 +25,7 @@ Copyright_License {
 #define XCSOAR_TERRAIN_RASTER_TERRAIN_HPP
 
 #include "RasterMap.hpp"
+#include "RasterTileStore.hpp"
 #include "Geo/GeoPoint.hpp"
 #include "Thread/Guard.hpp"
 #include "OS/Path.hpp"
@@ -47,6 +48,12 @@ public:
 private:
   ZipArchive archive;
 
+  /**
+   * The pre-decoded tiles; this must be declared before #map,
+   * because the tiles refer to its memory.
+   */
+  RasterTileStore tile_store;
+
   RasterMap map;
 
 private:
@@ -91,6 +98,12 @@ private:
 
   bool SaveCache(FileCache &cache, Path path) const;
 
+  /**
+   * Map the #RasterTileStore from the cache and enable all tiles
+   * from it.
+   */
+  bool LoadTileStore(FileCache &cache, Path path);
+
   bool Load(Path path, FileCache *cache,
             OperationEnvironment &operation);
 };
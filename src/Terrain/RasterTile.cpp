@@ -22,6 +22,7 @@ Copyright_License {
 */
 
 #include "Terrain/RasterTile.hpp"
+#include "Terrain/InterpolationBatch.hpp"
 
 #include "jasper/jas_seq.h"
 
@@ -107,6 +108,19 @@ RasterTile::GetInterpolatedHeight(unsigned lx, unsigned ly,
   return buffer.GetInterpolated(lx, ly, ix, iy);
 }
 
+void
+RasterTile::AppendInterpolatedHeight(TerrainInterpolationBatch &batch,
+                                     unsigned lx, unsigned ly,
+                                     unsigned ix, unsigned iy) const
+{
+  assert(IsEnabled());
+
+  if ((lx -= xstart) >= width || (ly -= ystart) >= height)
+    batch.AppendValue(TerrainHeight::Invalid());
+  else
+    buffer.AppendInterpolated(batch, lx, ly, ix, iy);
+}
+
 inline unsigned
 RasterTile::CalcDistanceTo(int x, int y) const
 {
@@ -27,6 +27,7 @@ Copyright_License {
 #include "RasterTraits.hpp"
 #include "RasterBuffer.hpp"
 
+#include <assert.h>
 #include <stdio.h>
 
 struct jas_matrix;
@@ -115,6 +116,16 @@ public:
 
   void CopyFrom(const struct jas_matrix &m);
 
+  /**
+   * Enable this tile by referring to pre-decoded height values in
+   * external memory (see #RasterTileStore) instead of copying them.
+   */
+  void Map(const TerrainHeight *data) {
+    assert(IsDefined());
+
+    buffer.Map(data, width, height);
+  }
+
   /**
    * Determine the non-interpolated height at the specified pixel
    * location.
@@ -138,6 +149,14 @@ public:
   TerrainHeight GetInterpolatedHeight(unsigned x, unsigned y,
                                       unsigned ix, unsigned iy) const;
 
+  /**
+   * Like GetInterpolatedHeight(), but only collect the input values
+   * into the #TerrainInterpolationBatch.
+   */
+  void AppendInterpolatedHeight(TerrainInterpolationBatch &batch,
+                                unsigned x, unsigned y,
+                                unsigned ix, unsigned iy) const;
+
   bool VisibilityChanged(int view_x, int view_y, unsigned view_radius);
 
   void ScanLine(unsigned ax, unsigned ay, unsigned bx, unsigned by,
@@ -22,6 +22,8 @@ Copyright_License {
 */
 
 #include "RasterTileCache.hpp"
+#include "RasterTileStore.hpp"
+#include "InterpolationBatch.hpp"
 #include "Math/Angle.hpp"
 #include "Math/FastMath.hpp"
 
@@ -40,38 +42,57 @@ CopyOverviewRow(TerrainHeight *gcc_restrict dest, const jas_seqent_t *gcc_restri
     *dest++ = TerrainHeight(*src);
 }
 
-void
-RasterTileCache::PutOverviewTile(unsigned index,
-                                 unsigned start_x, unsigned start_y,
-                                 unsigned end_x, unsigned end_y,
-                                 const struct jas_matrix &m)
+/**
+ * Copy every (2^bits)th height value of a tile into a downsampled
+ * buffer.
+ */
+static void
+PutLevelTile(RasterBuffer &buffer, unsigned bits,
+             unsigned start_x, unsigned start_y,
+             const struct jas_matrix &m)
 {
-  tiles.GetLinear(index).Set(start_x, start_y, end_x, end_y);
+  if (!buffer.IsDefined())
+    return;
 
-  const unsigned dest_pitch = overview.GetWidth();
+  const unsigned dest_pitch = buffer.GetWidth();
+  const unsigned mask = (1u << bits) - 1;
 
-  start_x = RasterTraits::ToOverview(start_x);
-  start_y = RasterTraits::ToOverview(start_y);
+  start_x >>= bits;
+  start_y >>= bits;
 
-  if (start_x >= overview.GetWidth() || start_y >= overview.GetHeight())
+  if (start_x >= buffer.GetWidth() || start_y >= buffer.GetHeight())
     return;
 
-  unsigned width = RasterTraits::ToOverviewCeil(m.numcols_);
-  if (start_x + width > overview.GetWidth())
-    width = overview.GetWidth() - start_x;
-  unsigned height = RasterTraits::ToOverviewCeil(m.numrows_);
-  if (start_y + height > overview.GetHeight())
-    height = overview.GetHeight() - start_y;
+  unsigned width = (m.numcols_ + mask) >> bits;
+  if (start_x + width > buffer.GetWidth())
+    width = buffer.GetWidth() - start_x;
+  unsigned height = (m.numrows_ + mask) >> bits;
+  if (start_y + height > buffer.GetHeight())
+    height = buffer.GetHeight() - start_y;
 
-  const unsigned skip = 1 << OVERVIEW_BITS;
+  const unsigned skip = 1 << bits;
 
-  auto *gcc_restrict dest = overview.GetData()
+  auto *gcc_restrict dest = buffer.GetData()
     + start_y * dest_pitch + start_x;
 
   for (unsigned i = 0, y = 0; i < height; ++i, y += skip, dest += dest_pitch)
     CopyOverviewRow(dest, m.rows_[y], width, skip);
 }
 
+void
+RasterTileCache::PutOverviewTile(unsigned index,
+                                 unsigned start_x, unsigned start_y,
+                                 unsigned end_x, unsigned end_y,
+                                 const struct jas_matrix &m)
+{
+  tiles.GetLinear(index).Set(start_x, start_y, end_x, end_y);
+
+  PutLevelTile(overview, OVERVIEW_BITS, start_x, start_y, m);
+
+  for (unsigned i = 0; i < PYRAMID_LEVELS; ++i)
+    PutLevelTile(pyramid[i], i + 1, start_x, start_y, m);
+}
+
 void
 RasterTileCache::PutTileData(unsigned index,
                              const struct jas_matrix &m)
@@ -99,6 +120,16 @@ struct RTDistanceSort {
 bool
 RasterTileCache::PollTiles(int x, int y, unsigned radius)
 {
+  if (mapped) {
+    /* all tiles are already available */
+    dirty = false;
+    return false;
+  }
+
+  if (pyramid[0].IsDefined() && radius > MAX_FINE_RADIUS)
+    /* the 1/2 level is good enough for everything farther away */
+    radius = MAX_FINE_RADIUS;
+
   /* tiles are usually 256 pixels wide; with a radius smaller than
      that, the (optimized) tile distance calculations may fail;
      additionally, this ensures that tiles which are slightly out of
@@ -169,9 +200,9 @@ RasterTileCache::GetHeight(unsigned px, unsigned py) const
   if (tile.IsEnabled())
     return tile.GetHeight(px, py);
 
-  // still not found, so go to overview
-  return overview.GetInterpolated(px << (RasterTraits::SUBPIXEL_BITS - RasterTraits::OVERVIEW_BITS),
-                                  py << (RasterTraits::SUBPIXEL_BITS - RasterTraits::OVERVIEW_BITS));
+  // still not found, so go to the pyramid
+  return GetFallbackLevel().GetInterpolated(px << (RasterTraits::SUBPIXEL_BITS - fallback_bits),
+                                            py << (RasterTraits::SUBPIXEL_BITS - fallback_bits));
 }
 
 TerrainHeight
@@ -189,9 +220,43 @@ RasterTileCache::GetInterpolatedHeight(unsigned int lx, unsigned int ly) const
   if (tile.IsEnabled())
     return tile.GetInterpolatedHeight(px, py, ix, iy);
 
-  // still not found, so go to overview
-  return overview.GetInterpolated(RasterTraits::ToOverview(lx),
-                                  RasterTraits::ToOverview(ly));
+  // still not found, so go to the pyramid
+  return GetFallbackLevel().GetInterpolated(lx >> fallback_bits,
+                                            ly >> fallback_bits);
+}
+
+void
+RasterTileCache::GetInterpolatedHeights(const RasterLocation *locations,
+                                        TerrainHeight *buffer,
+                                        unsigned n) const
+{
+  TerrainInterpolationBatch batch;
+
+  for (unsigned i = 0; i < n; ++i) {
+    const unsigned lx = locations[i].x, ly = locations[i].y;
+
+    if (lx >= overview_width_fine || ly >= overview_height_fine) {
+      // outside overall bounds
+      batch.AppendValue(TerrainHeight::Invalid());
+    } else {
+      unsigned px = lx, py = ly;
+      const unsigned int ix = CombinedDivAndMod(px);
+      const unsigned int iy = CombinedDivAndMod(py);
+
+      const RasterTile &tile = tiles.Get(px / tile_width, py / tile_height);
+      if (tile.IsEnabled())
+        tile.AppendInterpolatedHeight(batch, px, py, ix, iy);
+      else
+        // still not found, so go to the pyramid
+        GetFallbackLevel().AppendInterpolated(batch, lx >> fallback_bits,
+                                              ly >> fallback_bits);
+    }
+
+    if (batch.IsFull())
+      buffer = batch.Flush(buffer);
+  }
+
+  batch.Flush(buffer);
 }
 
 void
@@ -206,6 +271,22 @@ RasterTileCache::SetSize(unsigned _width, unsigned _height,
 
   overview.Resize(RasterTraits::ToOverview(width),
                   RasterTraits::ToOverview(height));
+
+  fallback_bits = OVERVIEW_BITS;
+  for (unsigned i = PYRAMID_LEVELS; i > 0;) {
+    --i;
+
+    const unsigned bits = i + 1;
+    const unsigned level_width = width >> bits;
+    const unsigned level_height = height >> bits;
+    if (level_width > 0 && level_height > 0 &&
+        size_t(level_width) * level_height <= MAX_PYRAMID_SIZE) {
+      pyramid[i].Resize(level_width, level_height);
+      fallback_bits = bits;
+    } else
+      /* finer levels would be even larger */
+      break;
+  }
   overview_width_fine = width << RasterTraits::SUBPIXEL_BITS;
   overview_height_fine = height << RasterTraits::SUBPIXEL_BITS;
 
@@ -232,10 +313,14 @@ RasterTileCache::Reset()
 {
   width = 0;
   height = 0;
+  mapped = false;
   bounds.SetInvalid();
   segments.clear();
 
   overview.Reset();
+  for (auto &level : pyramid)
+    level.Reset();
+  fallback_bits = OVERVIEW_BITS;
 
   for (auto it = tiles.begin(), end = tiles.end(); it != end; ++it)
     it->Disable();
@@ -267,6 +352,37 @@ RasterTileCache::FinishTileUpdate()
   ++serial;
 }
 
+bool
+RasterTileCache::MapTiles(const RasterTileStore &store)
+{
+  assert(IsValid());
+  assert(store.IsDefined());
+
+  if (store.GetTileCount() != tiles.GetSize())
+    return false;
+
+  for (unsigned i = 0; i < tiles.GetSize(); ++i) {
+    RasterTile &tile = tiles.GetLinear(i);
+    if (!tile.IsDefined())
+      continue;
+
+    const TerrainHeight *data = store.GetTile(i, tile.width, tile.height);
+    if (data == nullptr) {
+      /* roll back */
+      for (auto &t : tiles)
+        t.Disable();
+      return false;
+    }
+
+    tile.Map(data);
+  }
+
+  mapped = true;
+  dirty = false;
+  ++serial;
+  return true;
+}
+
 bool
 RasterTileCache::SaveCache(FILE *file) const
 {
@@ -314,6 +430,17 @@ RasterTileCache::SaveCache(FILE *file) const
              overview_size, file) != overview_size)
     return false;
 
+  /* save pyramid */
+  for (const auto &level : pyramid) {
+    if (!level.IsDefined())
+      continue;
+
+    const size_t level_size = level.GetWidth() * level.GetHeight();
+    if (fwrite(level.GetData(), sizeof(*level.GetData()),
+               level_size, file) != level_size)
+      return false;
+  }
+
   /* done */
   return true;
 }
@@ -370,5 +497,16 @@ RasterTileCache::LoadCache(FILE *file)
             overview_size, file) != overview_size)
     return false;
 
+  /* load pyramid (the levels have been allocated by SetSize()) */
+  for (auto &level : pyramid) {
+    if (!level.IsDefined())
+      continue;
+
+    const size_t level_size = level.GetWidth() * level.GetHeight();
+    if (fread(level.GetData(), sizeof(*level.GetData()),
+              level_size, file) != level_size)
+      return false;
+  }
+
   return true;
 }
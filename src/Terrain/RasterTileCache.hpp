@@ -39,6 +39,7 @@ Copyright_License {
 
 struct jas_matrix;
 struct GridLocation;
+class RasterTileStore;
 
 class RasterTileCache {
   static constexpr unsigned MAX_RTC_TILES = 4096;
@@ -62,6 +63,30 @@ class RasterTileCache {
 
   static constexpr unsigned OVERVIEW_MASK = (~0u) << OVERVIEW_BITS;
 
+  /**
+   * The number of #pyramid levels between the full resolution and
+   * the overview (1/2, 1/4 and 1/8).
+   */
+  static constexpr unsigned PYRAMID_LEVELS = OVERVIEW_BITS - 1;
+
+  /**
+   * #pyramid levels with more height values than this are not
+   * built, because the amount of memory is finite.
+   */
+#if defined(ANDROID)
+  static constexpr unsigned MAX_PYRAMID_SIZE = 4 * 1024 * 1024;
+#else
+  static constexpr unsigned MAX_PYRAMID_SIZE = 16 * 1024 * 1024;
+#endif
+
+  /**
+   * If the 1/2 #pyramid level exists, tiles which are farther away
+   * (in pixels) are not loaded.  When zoomed out that far, the map
+   * is rendered from the pyramid anyway, and calculations fall back
+   * to it.
+   */
+  static constexpr unsigned MAX_FINE_RADIUS = 1024;
+
   /**
    * Target number of steps in intersection searches; total distance
    * is shifted by this number of bits
@@ -101,7 +126,7 @@ protected:
   };
 
   struct CacheHeader {
-    static constexpr unsigned VERSION = 0xb;
+    static constexpr unsigned VERSION = 0xc;
 
     unsigned version;
     unsigned width, height;
@@ -113,6 +138,12 @@ protected:
 
   bool dirty;
 
+  /**
+   * Are all tiles mapped from a #RasterTileStore?  If yes, then
+   * PollTiles() has nothing to do.
+   */
+  bool mapped;
+
   /**
    * This serial gets updated each time the tiles get loaded or
    * discarded.
@@ -123,6 +154,21 @@ protected:
   unsigned short tile_width, tile_height;
 
   RasterBuffer overview;
+
+  /**
+   * Downsampled copies of the map: element #i has 1/2^(i+1) of the
+   * full resolution, and the #overview is the coarsest level.  A
+   * level is not defined if it would be larger than
+   * #MAX_PYRAMID_SIZE.
+   */
+  RasterBuffer pyramid[PYRAMID_LEVELS];
+
+  /**
+   * The resolution shift (see GetLevel()) of the finest level which
+   * is defined.  It is used where a tile is not loaded.
+   */
+  unsigned fallback_bits;
+
   unsigned int width, height;
   unsigned int overview_width_fine, overview_height_fine;
 
@@ -152,6 +198,31 @@ public:
   }
 
 protected:
+  /**
+   * Returns the pyramid level whose resolution is shifted by the
+   * given number of bits (1 to #OVERVIEW_BITS).  It may be undefined.
+   */
+  const RasterBuffer &GetLevel(unsigned bits) const {
+    assert(bits > 0 && bits <= OVERVIEW_BITS);
+
+    return bits < OVERVIEW_BITS ? pyramid[bits - 1] : overview;
+  }
+
+  const RasterBuffer &GetFallbackLevel() const {
+    return GetLevel(fallback_bits);
+  }
+
+  /**
+   * Determine the coarsest pyramid level which is sufficient for
+   * scanning the given line.
+   *
+   * @return the resolution shift (see GetLevel()), or 0 if the tiles
+   * are needed
+   */
+  gcc_pure
+  unsigned GetScanLevel(RasterLocation start, RasterLocation end,
+                        unsigned size) const;
+
   void ScanTileLine(GridLocation start, GridLocation end,
                     TerrainHeight *buffer, unsigned size,
                     bool interpolate) const;
@@ -178,6 +249,18 @@ public:
   TerrainHeight GetInterpolatedHeight(unsigned lx,
                                       unsigned ly) const;
 
+  /**
+   * Determine the interpolated height at many sub-pixel locations at
+   * once.  This is faster than calling GetInterpolatedHeight() for
+   * each of them, because the arithmetic is vectorised.
+   *
+   * @param locations the sub-pixel locations within the map; may be
+   * out of range
+   * @param buffer the destination buffer, one element per location
+   */
+  void GetInterpolatedHeights(const RasterLocation *locations,
+                              TerrainHeight *buffer, unsigned n) const;
+
   /**
    * Scan a straight line and fill the buffer with the specified
    * number of samples along the line.
@@ -221,6 +304,20 @@ public:
   bool SaveCache(FILE *file) const;
   bool LoadCache(FILE *file);
 
+  /**
+   * Enable all tiles by referring to the pre-decoded height values in
+   * the specified #RasterTileStore.  The store must remain open
+   * until Reset() is called.
+   *
+   * @return false if the store does not match this object (no tile
+   * is enabled in this case)
+   */
+  bool MapTiles(const RasterTileStore &store);
+
+  bool IsMapped() const {
+    return mapped;
+  }
+
   /**
    * Determines if there are still tiles scheduled to be loaded.  Call
    * this after UpdateTiles() to determine if UpdateTiles() should be
@@ -269,6 +366,9 @@ public:
   void SetLatLonBounds(double lon_min, double lon_max,
                        double lat_min, double lat_max);
 
+  /**
+   * Copy a tile into the #overview and the #pyramid.
+   */
   void PutOverviewTile(unsigned index,
                        unsigned start_x, unsigned start_y,
                        unsigned end_x, unsigned end_y,
@@ -0,0 +1,175 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#include "RasterTileStore.hpp"
+#include "OS/FileMapping.hpp"
+
+extern "C" {
+#include "jasper/jas_seq.h"
+}
+
+#include <algorithm>
+
+#include <assert.h>
+#include <string.h>
+
+RasterTileStore::RasterTileStore()
+  :payload(nullptr), payload_size(0), index(nullptr), num_tiles(0) {}
+
+RasterTileStore::~RasterTileStore() = default;
+
+bool
+RasterTileStore::Open(std::unique_ptr<FileMapping> &&_mapping, size_t offset)
+{
+  Close();
+
+  assert(_mapping);
+  assert(!_mapping->error());
+  assert(offset <= _mapping->size());
+
+  const uint8_t *p = (const uint8_t *)_mapping->at(offset);
+  const size_t size = _mapping->size() - offset;
+
+  /* the payload must be aligned for the Entry and TerrainHeight
+     pointers we are going to hand out */
+  if (size < sizeof(Footer) || (uintptr_t)p % alignof(Entry) != 0)
+    return false;
+
+  Footer footer;
+  memcpy(&footer, p + size - sizeof(footer), sizeof(footer));
+  if (footer.magic != MAGIC || footer.version != VERSION ||
+      footer.index_offset % alignof(Entry) != 0 ||
+      footer.index_offset > size - sizeof(footer) ||
+      footer.num_tiles > (size - sizeof(footer) - footer.index_offset)
+      / sizeof(Entry))
+    return false;
+
+  mapping = std::move(_mapping);
+  payload = p;
+  payload_size = footer.index_offset;
+  index = (const Entry *)(p + footer.index_offset);
+  num_tiles = footer.num_tiles;
+  return true;
+}
+
+void
+RasterTileStore::Close()
+{
+  mapping.reset();
+  payload = nullptr;
+  payload_size = 0;
+  index = nullptr;
+  num_tiles = 0;
+}
+
+const TerrainHeight *
+RasterTileStore::GetTile(unsigned i, unsigned width, unsigned height) const
+{
+  assert(IsDefined());
+
+  if (i >= num_tiles)
+    return nullptr;
+
+  const Entry &entry = index[i];
+  if (entry.width == 0 || entry.width != width || entry.height != height ||
+      entry.offset % alignof(TerrainHeight) != 0 ||
+      entry.offset > payload_size ||
+      size_t(width) * height > (payload_size - entry.offset)
+      / sizeof(TerrainHeight))
+    return nullptr;
+
+  return (const TerrainHeight *)(payload + entry.offset);
+}
+
+void
+RasterTileStoreWriter::SetSize(unsigned width, unsigned height,
+                               unsigned num_tiles)
+{
+  if (size_t(width) * height * sizeof(TerrainHeight)
+      + num_tiles * sizeof(RasterTileStore::Entry)
+      + sizeof(RasterTileStore::Footer) > max_size) {
+    failed = true;
+    return;
+  }
+
+  index.ResizeDiscard(num_tiles);
+  std::fill(index.begin(), index.end(), RasterTileStore::Entry{0, 0, 0});
+}
+
+void
+RasterTileStoreWriter::PutTile(unsigned i, const struct jas_matrix &m)
+{
+  if (failed || i >= index.size())
+    return;
+
+  const unsigned width = m.numcols_, height = m.numrows_;
+  if (width == 0 || height == 0 || width > 0xffff || height > 0xffff)
+    return;
+
+  auto &entry = index[i];
+  entry.offset = position;
+  entry.width = width;
+  entry.height = height;
+
+  row.GrowDiscard(width);
+
+  for (unsigned y = 0; y != height; ++y) {
+    const jas_seqent_t *gcc_restrict src = m.rows_[y];
+    TerrainHeight *gcc_restrict dest = row.begin();
+
+    for (unsigned x = 0; x < width; ++x)
+      dest[x] = TerrainHeight(src[x]);
+
+    if (fwrite(dest, sizeof(*dest), width, file) != width) {
+      failed = true;
+      return;
+    }
+  }
+
+  position += width * height * sizeof(TerrainHeight);
+}
+
+bool
+RasterTileStoreWriter::Finish()
+{
+  if (failed || index.empty())
+    return false;
+
+  /* pad to the alignment of the tile index */
+  static constexpr uint8_t zero[alignof(RasterTileStore::Entry)] = {};
+  const unsigned padding = (alignof(RasterTileStore::Entry)
+                            - position % alignof(RasterTileStore::Entry))
+    % alignof(RasterTileStore::Entry);
+  if (padding > 0 && fwrite(zero, 1, padding, file) != padding)
+    return false;
+
+  RasterTileStore::Footer footer;
+  footer.magic = RasterTileStore::MAGIC;
+  footer.version = RasterTileStore::VERSION;
+  footer.num_tiles = index.size();
+  footer.index_offset = position + padding;
+
+  return fwrite(index.begin(), sizeof(*index.begin()), index.size(),
+                file) == index.size() &&
+    fwrite(&footer, sizeof(footer), 1, file) == 1;
+}
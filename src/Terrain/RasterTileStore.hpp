@@ -0,0 +1,165 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#ifndef XCSOAR_RASTER_TILE_STORE_HPP
+#define XCSOAR_RASTER_TILE_STORE_HPP
+
+#include "Height.hpp"
+#include "Util/AllocatedArray.hxx"
+#include "Compiler.h"
+
+#include <memory>
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct jas_matrix;
+class FileMapping;
+
+/**
+ * A file containing all tiles of a terrain file, already decoded to
+ * raw #TerrainHeight values.  It is generated as a by-product of
+ * scanning the JPEG2000 file for the overview, and is later mapped
+ * into memory, which allows #RasterTile to refer to the mapped pages
+ * instead of decoding the JPEG2000 tiles on demand.  Loading and
+ * evicting pages is left to the kernel.
+ *
+ * File layout (after the #FileCache header): the height values of
+ * all tiles, followed by the tile index (one #Entry per tile) and
+ * the #Footer.
+ */
+class RasterTileStore {
+public:
+  static constexpr uint32_t MAGIC = 0x52545354;
+  static constexpr uint32_t VERSION = 1;
+
+  struct Entry {
+    /**
+     * Position of the first height value, relative to the start of
+     * the payload.
+     */
+    uint32_t offset;
+
+    /**
+     * The dimensions of the tile.  Zero if the tile was not stored.
+     */
+    uint16_t width, height;
+  };
+
+  struct Footer {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_tiles;
+
+    /**
+     * Position of the #Entry array, relative to the start of the
+     * payload.
+     */
+    uint32_t index_offset;
+  };
+
+private:
+  std::unique_ptr<FileMapping> mapping;
+
+  const uint8_t *payload;
+  size_t payload_size;
+
+  const Entry *index;
+  unsigned num_tiles;
+
+public:
+  RasterTileStore();
+  ~RasterTileStore();
+
+  RasterTileStore(const RasterTileStore &) = delete;
+  RasterTileStore &operator=(const RasterTileStore &) = delete;
+
+  bool IsDefined() const {
+    return index != nullptr;
+  }
+
+  unsigned GetTileCount() const {
+    return num_tiles;
+  }
+
+  /**
+   * Take over the specified mapping and validate its contents.
+   *
+   * @param offset the position of the payload within the mapping
+   * @return false if the file is malformed
+   */
+  bool Open(std::unique_ptr<FileMapping> &&_mapping, size_t offset);
+
+  void Close();
+
+  /**
+   * Obtain a pointer to the height values of the specified tile.
+   *
+   * @return nullptr if the tile is not stored or its dimensions do
+   * not match
+   */
+  gcc_pure
+  const TerrainHeight *GetTile(unsigned i,
+                               unsigned width, unsigned height) const;
+};
+
+/**
+ * Writes a #RasterTileStore file while the JPEG2000 file is being
+ * decoded.
+ */
+class RasterTileStoreWriter {
+  FILE *const file;
+
+  /**
+   * The maximum size of the file.  If the terrain is larger, the
+   * writer gives up.
+   */
+  const size_t max_size;
+
+  AllocatedArray<RasterTileStore::Entry> index;
+
+  AllocatedArray<TerrainHeight> row;
+
+  uint32_t position = 0;
+
+  bool failed = false;
+
+public:
+  RasterTileStoreWriter(FILE *_file, size_t _max_size)
+    :file(_file), max_size(_max_size) {}
+
+  void SetSize(unsigned width, unsigned height, unsigned num_tiles);
+
+  void PutTile(unsigned i, const struct jas_matrix &m);
+
+  /**
+   * Write the tile index and the footer.  The caller is responsible
+   * for closing the file.
+   *
+   * @return false on error
+   */
+  bool Finish();
+};
+
+#endif
@@ -24,6 +24,8 @@ Copyright_License {
 #include "Terrain/RasterTileCache.hpp"
 #include "Terrain/RasterLocation.hpp"
 
+#include <algorithm>
+
 #include <stdlib.h>
 
 struct GridLocation : public RasterLocation {
@@ -302,14 +304,32 @@ RasterTileCache::ScanTileLine(GridLocation start, GridLocation end,
                   buffer + start.index, end.index - start.index,
                   interpolate);
   else
-    /* need range checking in the overview buffer because its size may
+    /* need range checking in the pyramid buffer because its size may
        be rounded down, and then the "fine" location may exceed its
        bounds */
-    overview.ScanLineChecked(start.x >> OVERVIEW_BITS,
-                             start.y >> OVERVIEW_BITS,
-                             end.x >> OVERVIEW_BITS, end.y >> OVERVIEW_BITS,
-                             buffer + start.index, end.index - start.index,
-                             interpolate);
+    GetFallbackLevel().ScanLineChecked(start.x >> fallback_bits,
+                                       start.y >> fallback_bits,
+                                       end.x >> fallback_bits,
+                                       end.y >> fallback_bits,
+                                       buffer + start.index,
+                                       end.index - start.index,
+                                       interpolate);
+}
+
+unsigned
+RasterTileCache::GetScanLevel(RasterLocation start, RasterLocation end,
+                              unsigned size) const
+{
+  /* the distance between two samples (in pixels) */
+  const unsigned distance = std::max(abs(int(end.x - start.x)),
+                                     abs(int(end.y - start.y)));
+  const unsigned step = (distance / size) >> RasterTraits::SUBPIXEL_BITS;
+
+  for (unsigned bits = OVERVIEW_BITS; bits > 0; --bits)
+    if (step >= (1u << bits) && GetLevel(bits).IsDefined())
+      return bits;
+
+  return 0;
 }
 
 void
@@ -324,6 +344,16 @@ RasterTileCache::ScanLine(const RasterLocation _start,
   assert(_end.y < GetFineHeight());
   assert(size >= 2);
 
+  const unsigned bits = GetScanLevel(_start, _end, size);
+  if (bits > 0) {
+    /* the samples are so far apart that a pyramid level is good
+       enough; this doesn't need the tiles to be loaded */
+    GetLevel(bits).ScanLineChecked(_start.x >> bits, _start.y >> bits,
+                                   _end.x >> bits, _end.y >> bits,
+                                   buffer, size, interpolate);
+    return;
+  }
+
   const GridRay ray(GetFineTileWidth(), GetFineTileHeight(),
                     _start, _end, size);
   assert(ray.size == size);
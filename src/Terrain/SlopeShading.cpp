@@ -0,0 +1,575 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#include "SlopeShading.hpp"
+#include "HeightMatrix.hpp"
+#include "Screen/RawBitmap.hpp"
+#include "Engine/Util/TaskRunner.hpp"
+#include "Util/Clamp.hpp"
+
+#include <memory>
+
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/**
+ * The minimum number of rows in a band; smaller bands are not worth
+ * the overhead.
+ */
+static constexpr unsigned MIN_BAND_ROWS = 16;
+
+/**
+ * The number of bands per thread; more than one allows the
+ * #TaskRunner to balance the load.
+ */
+static constexpr unsigned BANDS_PER_THREAD = 4;
+
+/**
+ * Marks a column of a band which does not modify the contour column
+ * base.  ContourInterval() never returns this value.
+ */
+static constexpr uint8_t NO_CONTOUR = 0xff;
+
+/**
+ * Clip the difference between two adjacent terrain height values to
+ * sane bounds.  This works around integer overflows in the
+ * GenerateSlopeImage() formula when the map file is broken, avoiding
+ * the sqrt() call with a negative argument.
+ */
+gcc_const
+static int
+ClipHeightDelta(int d)
+{
+  return Clamp(d, -512, 512);
+}
+
+gcc_const
+static int
+ClipHeightDelta(TerrainHeight a, TerrainHeight b)
+{
+  return ClipHeightDelta(a.GetValue() - b.GetValue());
+}
+
+/**
+ * The vertical neighbours used for the slope calculation of one row.
+ */
+struct SlopeRow {
+  unsigned minus_offset, plus_offset;
+
+  /**
+   * The vertical distance between the two neighbours.
+   */
+  unsigned p31;
+
+  SlopeRow(unsigned width, unsigned height, unsigned q, unsigned y) {
+    const unsigned plus_index = y + q < height ? q : height - 1 - y;
+    const unsigned minus_index = y >= q ? q : y;
+
+    plus_offset = width * plus_index;
+    minus_offset = width * minus_index;
+    p31 = plus_index + minus_index;
+  }
+};
+
+/**
+ * The scalar slope shading formula.
+ *
+ * @return the shading index (-63..63)
+ */
+gcc_const
+static int
+SlopeIndex(int p22, int p32, unsigned p20, unsigned p31,
+           const SlopeShadingParameters &s)
+{
+  const int dd0 = p22 * int(p31);
+  const int dd1 = int(p20) * p32;
+  const unsigned dd2 = p20 * p31 * s.height_slope_factor;
+  const int num = (int(dd2) * s.sz + dd0 * s.sx + dd1 * s.sy);
+  const unsigned square_mag = dd0 * dd0 + dd1 * dd1 + dd2 * dd2;
+  const unsigned mag = (unsigned)sqrt(square_mag);
+  /* this is a workaround for a SIGFPE (division by zero)
+     observed by our users on some Android devices (e.g. Nexus
+     7), even though we did our best to make sure that the
+     integer arithmetics above can't overflow */
+  /* TODO: debug this problem and replace this workaround */
+  const int sval = num / int(mag|1);
+  const int sindex = (sval - s.sz) * s.contrast / 128;
+  return Clamp(sindex, -63, 63);
+}
+
+/**
+ * Calculate SlopeIndex() for a range of pixels whose horizontal
+ * neighbours are #q cells away.  Special height values produce
+ * garbage which must be ignored by the caller.
+ *
+ * All intermediate values are integers below 2^53, therefore the
+ * double precision vector code yields exactly the same results as
+ * the integer formula.
+ */
+static void
+SlopeIndices(const TerrainHeight *src, unsigned n, const SlopeRow &row,
+             unsigned q, const SlopeShadingParameters &s, int8_t *dest)
+{
+  const unsigned p20 = 2 * q;
+  unsigned i = 0;
+
+#ifdef __SSE2__
+  const double dd2 = double(p20 * row.p31 * s.height_slope_factor);
+  const double num0 = dd2 * s.sz, square_dd2 = dd2 * dd2;
+  const double p31 = row.p31, p20d = p20;
+  const double sx = s.sx, sy = s.sy, sz = s.sz, contrast = s.contrast;
+
+  const __m128d v_p31 = _mm_set1_pd(p31), v_p20 = _mm_set1_pd(p20d);
+  const __m128d v_num0 = _mm_set1_pd(num0);
+  const __m128d v_square_dd2 = _mm_set1_pd(square_dd2);
+  const __m128d v_sx = _mm_set1_pd(sx), v_sy = _mm_set1_pd(sy);
+  const __m128d v_sz = _mm_set1_pd(sz);
+  const __m128d v_contrast = _mm_set1_pd(contrast * (1. / 128));
+  const __m128d v_clip_min = _mm_set1_pd(-512), v_clip_max = _mm_set1_pd(512);
+  const __m128d v_min = _mm_set1_pd(-63), v_max = _mm_set1_pd(63);
+  const __m128i v_one = _mm_set1_epi32(1);
+
+  /* load 4 heights and convert them to 2x2 doubles */
+  const auto load = [](const TerrainHeight *p, __m128d &lo, __m128d &hi){
+    __m128i v = _mm_loadl_epi64((const __m128i *)p);
+    v = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+    lo = _mm_cvtepi32_pd(v);
+    hi = _mm_cvtepi32_pd(_mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+  };
+
+  const auto shade = [&](__m128d above, __m128d below,
+                         __m128d left, __m128d right){
+    const __m128d p32 = _mm_min_pd(_mm_max_pd(_mm_sub_pd(above, below),
+                                              v_clip_min), v_clip_max);
+    const __m128d p22 = _mm_min_pd(_mm_max_pd(_mm_sub_pd(right, left),
+                                              v_clip_min), v_clip_max);
+    const __m128d dd0 = _mm_mul_pd(p22, v_p31);
+    const __m128d dd1 = _mm_mul_pd(v_p20, p32);
+    const __m128d num = _mm_add_pd(v_num0,
+                                   _mm_add_pd(_mm_mul_pd(dd0, v_sx),
+                                              _mm_mul_pd(dd1, v_sy)));
+    const __m128d square_mag =
+      _mm_add_pd(_mm_add_pd(_mm_mul_pd(dd0, dd0), _mm_mul_pd(dd1, dd1)),
+                 v_square_dd2);
+    const __m128i mag =
+      _mm_or_si128(_mm_cvttpd_epi32(_mm_sqrt_pd(square_mag)), v_one);
+    const __m128d sval =
+      _mm_cvtepi32_pd(_mm_cvttpd_epi32(_mm_div_pd(num,
+                                                  _mm_cvtepi32_pd(mag))));
+    const __m128d sindex = _mm_mul_pd(_mm_sub_pd(sval, v_sz), v_contrast);
+    return _mm_cvttpd_epi32(_mm_min_pd(_mm_max_pd(sindex, v_min), v_max));
+  };
+
+  for (; i + 4 <= n; i += 4) {
+    const TerrainHeight *p = src + i;
+    __m128d above_lo, above_hi, below_lo, below_hi;
+    __m128d left_lo, left_hi, right_lo, right_hi;
+    load(p - row.minus_offset, above_lo, above_hi);
+    load(p + row.plus_offset, below_lo, below_hi);
+    load(p - q, left_lo, left_hi);
+    load(p + q, right_lo, right_hi);
+
+    const __m128i lo = shade(above_lo, below_lo, left_lo, right_lo);
+    const __m128i hi = shade(above_hi, below_hi, left_hi, right_hi);
+
+    /* the results are in the lower halves */
+    __m128i r = _mm_unpacklo_epi64(lo, hi);
+    r = _mm_packs_epi32(r, r);
+    r = _mm_packs_epi16(r, r);
+    const int32_t packed = _mm_cvtsi128_si32(r);
+    memcpy(dest + i, &packed, sizeof(packed));
+  }
+#endif
+
+  for (; i < n; ++i) {
+    const TerrainHeight *p = src + i;
+    const int p32 = ClipHeightDelta(p[-(int)row.minus_offset],
+                                    p[row.plus_offset]);
+    const int p22 = ClipHeightDelta(p[q], p[-(int)q]);
+    dest[i] = SlopeIndex(p22, p32, p20, row.p31, s);
+  }
+}
+
+/**
+ * Does the given pixel update the contour column base, i.e. does it
+ * reach the contour check?
+ */
+gcc_pure
+static bool
+UpdatesContour(const TerrainHeight *src, unsigned x,
+               unsigned width, unsigned q, const SlopeRow &row)
+{
+  if (src->IsSpecial())
+    return false;
+
+  const unsigned column_plus_index = x + q < width ? q : width - 1 - x;
+  const unsigned column_minus_index = x >= q ? q : x;
+
+  return !src[-(int)row.minus_offset].IsSpecial() &&
+    !src[row.plus_offset].IsSpecial() &&
+    !src[-(int)column_minus_index].IsSpecial() &&
+    !src[column_plus_index].IsSpecial();
+}
+
+/**
+ * Determine how the rows [y_begin, y_end) modify the contour column
+ * base of the columns [x_begin, x_end): the contour interval of the
+ * bottom-most pixel which reaches the contour check, or #NO_CONTOUR.
+ */
+static void
+ScanContourBand(const HeightMatrix &matrix, unsigned q,
+                unsigned x_begin, unsigned x_end,
+                unsigned y_begin, unsigned y_end,
+                unsigned contour_height_scale,
+                uint8_t *columns)
+{
+  const unsigned width = matrix.GetWidth();
+  std::fill_n(columns, x_end - x_begin, NO_CONTOUR);
+
+  unsigned remaining = x_end - x_begin;
+  for (unsigned y = y_end; remaining > 0 && y > y_begin;) {
+    --y;
+
+    const SlopeRow row(width, matrix.GetHeight(), q, y);
+    const TerrainHeight *src = matrix.GetRow(y);
+    for (unsigned x = x_begin; x < x_end; ++x) {
+      if (columns[x - x_begin] == NO_CONTOUR &&
+          UpdatesContour(src + x, x, width, q, row)) {
+        const unsigned h = std::max(0, (int)src[x].GetValue());
+        columns[x - x_begin] = ContourInterval(h, contour_height_scale);
+        --remaining;
+      }
+    }
+  }
+}
+
+/**
+ * Determine the contour row base at the given column: the contour
+ * interval of the right-most pixel left of it which reaches the
+ * contour check.
+ */
+gcc_pure
+static unsigned
+ContourRowBase(const TerrainHeight *src, unsigned x_begin,
+               unsigned width, unsigned q, const SlopeRow &row,
+               unsigned contour_height_scale)
+{
+  for (unsigned x = x_begin; x > 0;) {
+    --x;
+
+    if (UpdatesContour(src + x, x, width, q, row))
+      return ContourInterval(std::max(0, (int)src[x].GetValue()),
+                             contour_height_scale);
+  }
+
+  return ContourInterval(src[0], contour_height_scale);
+}
+
+/**
+ * Render the rows [y_begin, y_end) of the columns [x_begin, x_end).
+ *
+ * @param contour_column_base the contour interval of the previous
+ * row for each column; will be updated
+ * @param slope a buffer for SlopeIndices() (one value per column)
+ */
+static void
+GenerateSlopeRows(const HeightMatrix &matrix,
+                  RawColor *top_row, int row_step,
+                  const SlopeShadingParameters &s,
+                  unsigned x_begin, unsigned x_end,
+                  unsigned y_begin, unsigned y_end,
+                  uint8_t *contour_column_base, int8_t *slope)
+{
+  const unsigned width = matrix.GetWidth(), height = matrix.GetHeight();
+  const unsigned q = s.quantisation;
+  const RawColor *const colors = s.colors;
+
+  /* pixels whose horizontal neighbours are not clipped */
+  const unsigned interior_begin = std::max(x_begin, q);
+  const unsigned interior_end = width > q ? std::min(x_end, width - q) : 0;
+
+  /* make the buffers indexable by the matrix column */
+  contour_column_base -= x_begin;
+  slope -= x_begin;
+
+  for (unsigned y = y_begin; y < y_end; ++y) {
+    const SlopeRow row(width, height, q, y);
+    const TerrainHeight *const src = matrix.GetRow(y);
+    RawColor *p = top_row + int(y) * row_step + x_begin;
+
+    if (interior_end > interior_begin)
+      SlopeIndices(src + interior_begin, interior_end - interior_begin,
+                   row, q, s, slope + interior_begin);
+
+    unsigned contour_row_base = ContourRowBase(src, x_begin, width, q, row,
+                                               s.contour_height_scale);
+
+    for (unsigned x = x_begin; x < x_end; ++x) {
+      const auto e = src[x];
+      if (gcc_likely(!e.IsSpecial())) {
+        unsigned h = std::max(0, (int)e.GetValue());
+
+        const unsigned contour_interval =
+          ContourInterval(h, s.contour_height_scale);
+
+        h = std::min(254u, h >> s.height_scale);
+
+        // no need to calculate slope if undefined height or sea level
+
+        const TerrainHeight *const pixel = src + x;
+        assert(pixel - row.minus_offset >= matrix.GetData());
+        assert(pixel + row.plus_offset < matrix.GetDataEnd());
+
+        const unsigned column_plus_index = x + q < width
+          ? q
+          : width - 1 - x;
+        const unsigned column_minus_index = x >= q ? q : x;
+
+        const auto h_above = pixel[-(int)row.minus_offset];
+        const auto h_below = pixel[row.plus_offset];
+        const auto h_left = pixel[-(int)column_minus_index];
+        const auto h_right = pixel[column_plus_index];
+
+        if (gcc_unlikely(h_above.IsSpecial() ||
+                         h_below.IsSpecial() ||
+                         h_left.IsSpecial() ||
+                         h_right.IsSpecial())) {
+          /* some "special" terrain value surrounding us (water or
+             invalid), skip slope calculation */
+          *p++ = colors[h];
+          continue;
+        }
+
+        if (gcc_unlikely((contour_interval != contour_row_base)
+                         || (contour_interval != contour_column_base[x]))) {
+          contour_column_base[x] = contour_row_base = contour_interval;
+          *p++ = colors[int(h) - 64 * 256];
+          continue;
+        }
+
+        int sindex;
+        if (column_minus_index == q && column_plus_index == q)
+          sindex = slope[x];
+        else
+          sindex = SlopeIndex(ClipHeightDelta(h_right, h_left),
+                              ClipHeightDelta(h_above, h_below),
+                              column_plus_index + column_minus_index,
+                              row.p31, s);
+
+        *p++ = colors[int(h) + 256 * sindex];
+      } else if (e.IsWater()) {
+        // we're in the water, so look up the color for water
+        *p++ = colors[255];
+      } else {
+        /* outside the terrain file bounds: white background */
+        *p++ = RawColor(0xff, 0xff, 0xff);
+      }
+    }
+  }
+}
+
+class SlopeImageJob final : public TaskRunner::Job {
+  const HeightMatrix &matrix;
+  RawColor *const top_row;
+  const int row_step;
+  const SlopeShadingParameters &shading;
+  const PixelRect rect;
+
+  const unsigned n_bands;
+
+  /**
+   * The contour column base of each band (#n_bands rows of the
+   * rectangle width), followed by one scratch row.
+   */
+  uint8_t *const columns;
+
+  /**
+   * A SlopeIndices() buffer for each band.
+   */
+  int8_t *const slope;
+
+  bool scan = true;
+
+public:
+  SlopeImageJob(const HeightMatrix &_matrix,
+                RawColor *_top_row, int _row_step,
+                const SlopeShadingParameters &_shading,
+                const PixelRect &_rect, unsigned _n_bands,
+                uint8_t *_columns, int8_t *_slope)
+    :matrix(_matrix), top_row(_top_row), row_step(_row_step),
+     shading(_shading), rect(_rect), n_bands(_n_bands),
+     columns(_columns), slope(_slope) {}
+
+  unsigned GetRectWidth() const {
+    return rect.right - rect.left;
+  }
+
+  unsigned GetBandBegin(unsigned band) const {
+    return rect.top + (rect.bottom - rect.top) * band / n_bands;
+  }
+
+  /**
+   * Switch from the first phase (ScanContourBand()) to the second
+   * phase (GenerateSlopeRows()).  Calculates the initial contour
+   * column base of each band.
+   */
+  void FinishScan() {
+    const unsigned width = GetRectWidth();
+
+    /* initialise column to first row */
+    const TerrainHeight *src = matrix.GetData() + rect.left;
+    for (unsigned x = 0; x < width; ++x)
+      columns[x] = ContourInterval(src[x], shading.contour_height_scale);
+
+    if (rect.top > 0) {
+      /* apply the rows above the rectangle */
+      uint8_t *scratch = columns + n_bands * width;
+      ScanContourBand(matrix, shading.quantisation, rect.left, rect.right,
+                      0, rect.top, shading.contour_height_scale, scratch);
+      for (unsigned x = 0; x < width; ++x)
+        if (scratch[x] != NO_CONTOUR)
+          columns[x] = scratch[x];
+    }
+
+    /* the first phase has stored the result of band #i in row #i+1;
+       replace unmodified columns with the result of the previous
+       band */
+    for (unsigned band = 1; band < n_bands; ++band) {
+      const uint8_t *previous = columns + (band - 1) * width;
+      uint8_t *current = columns + band * width;
+      for (unsigned x = 0; x < width; ++x)
+        if (current[x] == NO_CONTOUR)
+          current[x] = previous[x];
+    }
+
+    scan = false;
+  }
+
+  /* virtual methods from class TaskRunner::Job */
+  void RunTask(unsigned band) override {
+    const unsigned width = GetRectWidth();
+    const unsigned y_begin = GetBandBegin(band);
+    const unsigned y_end = GetBandBegin(band + 1);
+
+    if (scan)
+      ScanContourBand(matrix, shading.quantisation, rect.left, rect.right,
+                      y_begin, y_end, shading.contour_height_scale,
+                      columns + (band + 1) * width);
+    else
+      GenerateSlopeRows(matrix, top_row, row_step, shading,
+                        rect.left, rect.right, y_begin, y_end,
+                        columns + band * width, slope + band * width);
+  }
+};
+
+void
+GenerateSlopeImage(const HeightMatrix &matrix,
+                   RawColor *top_row, int row_step,
+                   const SlopeShadingParameters &shading,
+                   const PixelRect &rect,
+                   TaskRunner *task_runner)
+{
+  assert(shading.quantisation > 0);
+  assert(rect.left >= 0 && rect.top >= 0);
+  assert(unsigned(rect.right) <= matrix.GetWidth());
+  assert(unsigned(rect.bottom) <= matrix.GetHeight());
+
+  if (rect.left >= rect.right || rect.top >= rect.bottom)
+    return;
+
+  const unsigned width = rect.right - rect.left;
+  const unsigned height = rect.bottom - rect.top;
+
+  unsigned n_bands = 1;
+  if (task_runner != nullptr && task_runner->GetConcurrency() > 1)
+    n_bands = Clamp(height / MIN_BAND_ROWS, 1u,
+                    task_runner->GetConcurrency() * BANDS_PER_THREAD);
+
+  const std::unique_ptr<uint8_t[]> columns(new uint8_t[(n_bands + 1) * width]);
+  const std::unique_ptr<int8_t[]> slope(new int8_t[n_bands * width]);
+
+  SlopeImageJob job(matrix, top_row, row_step, shading, rect, n_bands,
+                    columns.get(), slope.get());
+
+  if (n_bands > 1)
+    /* the last band's contour columns are not needed */
+    task_runner->Run(job, n_bands - 1);
+
+  job.FinishScan();
+
+  if (n_bands > 1)
+    task_runner->Run(job, n_bands);
+  else
+    job.RunTask(0);
+}
+
+void
+ScrollSlopeImage(RawColor *top_row, int row_step,
+                 unsigned _width, unsigned _height,
+                 int dy, unsigned quantisation,
+                 TrivialArray<PixelRect, 2> &dirty)
+{
+  const int width = _width, height = _height;
+  assert(abs(dy) < height);
+
+  const size_t row_size = width * sizeof(RawColor);
+
+  const auto move_row = [&](int y){
+    RawColor *row = top_row + y * row_step;
+    memcpy(row, row + dy * row_step, row_size);
+  };
+
+  if (dy > 0)
+    for (int y = 0; y < height - dy; ++y)
+      move_row(y);
+  else
+    for (int y = height - 1; y >= -dy; --y)
+      move_row(y);
+
+  /* the slope of a pixel depends on its neighbours #quantisation
+     cells away; this affects the pixels next to the exposed ones,
+     and the ones at the opposite border, which have lost their
+     neighbours */
+  const int margin = std::max(quantisation, 1u);
+
+  dirty.clear();
+
+  if (dy != 0) {
+    const int n = std::min(abs(dy) + margin, height);
+    const int m = std::min(margin, height);
+    if (dy > 0) {
+      dirty.append(PixelRect(0, height - n, width, height));
+      dirty.append(PixelRect(0, 0, width, m));
+    } else {
+      dirty.append(PixelRect(0, 0, width, n));
+      dirty.append(PixelRect(0, height - m, width, height));
+    }
+  }
+}
@@ -0,0 +1,123 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#ifndef XCSOAR_TERRAIN_SLOPE_SHADING_HPP
+#define XCSOAR_TERRAIN_SLOPE_SHADING_HPP
+
+#include "Height.hpp"
+#include "Screen/Point.hpp"
+#include "Util/TrivialArray.hxx"
+#include "Compiler.h"
+
+#include <algorithm>
+
+class HeightMatrix;
+class TaskRunner;
+struct RawColor;
+
+gcc_const
+static inline unsigned
+ContourInterval(const unsigned h, const unsigned contour_height_scale)
+{
+  return std::min(254u, h >> contour_height_scale);
+}
+
+gcc_const
+static inline unsigned
+ContourInterval(const TerrainHeight h, const unsigned contour_height_scale)
+{
+  if (gcc_unlikely(h.IsSpecial()) || h.GetValue() <= 0)
+    return 0;
+
+  return ContourInterval(h.GetValue(), contour_height_scale);
+}
+
+/**
+ * Parameters for GenerateSlopeImage().
+ */
+struct SlopeShadingParameters {
+  /**
+   * The color table prepared by RasterRenderer::PrepareColorTable(),
+   * pointing to the unshaded row.
+   */
+  const RawColor *colors;
+
+  unsigned height_scale;
+  unsigned contour_height_scale;
+
+  /**
+   * Step size (in matrix cells) used for slope calculations.
+   */
+  unsigned quantisation;
+
+  unsigned height_slope_factor;
+
+  int contrast;
+
+  /**
+   * The light vector.
+   */
+  int sx, sy, sz;
+};
+
+/**
+ * Convert a rectangle of the height matrix into an image with slope
+ * shading and contour lines.  The pixels outside of the rectangle
+ * are not modified; the result inside it is the same as if the
+ * whole image had been rendered.
+ *
+ * The rectangle is split into horizontal bands which are rendered in
+ * parallel by the given #TaskRunner (nullptr renders serially); the
+ * result does not depend on the number of bands.
+ *
+ * @param top_row the first pixel of the top-most image row
+ * @param row_step the distance between two image rows (in pixels;
+ * may be negative)
+ * @param rect the rectangle to be rendered (in matrix cells)
+ */
+void
+GenerateSlopeImage(const HeightMatrix &matrix,
+                   RawColor *top_row, int row_step,
+                   const SlopeShadingParameters &shading,
+                   const PixelRect &rect,
+                   TaskRunner *task_runner);
+
+/**
+ * Move the rows of an image along with HeightMatrix::ScrollRows(),
+ * and determine the rectangles which have to be rendered again by
+ * GenerateSlopeImage(): the exposed rows, and the ones whose slope
+ * neighbours have changed.
+ *
+ * @param width the width of the image (in pixels)
+ * @param height the height of the image (in pixels)
+ * @param quantisation the slope step size
+ * (SlopeShadingParameters::quantisation)
+ * @param dirty receives the rectangles to be rendered
+ */
+void
+ScrollSlopeImage(RawColor *top_row, int row_step,
+                 unsigned width, unsigned height,
+                 int dy, unsigned quantisation,
+                 TrivialArray<PixelRect, 2> &dirty);
+
+#endif
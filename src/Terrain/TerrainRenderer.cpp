@@ -42,6 +42,8 @@ Copyright_License {
 #endif
 #endif
 
+#include <algorithm>
+
 #include <assert.h>
 
 static constexpr ColorRamp terrain_colors[][NUM_COLOR_RAMP_LEVELS] = {
@@ -290,9 +292,13 @@ static_assert(ARRAY_SIZE(terrain_colors) == TerrainRendererSettings::NUM_RAMPS,
 //
 // this is for TerrainInfo.StepSize = 0.0025;
 TerrainRenderer::TerrainRenderer(const RasterTerrain &_terrain)
-  :terrain(_terrain)
+  :terrain(_terrain),
+   shading_pool(std::min(WorkStealingPool::GetProcessorCount(),
+                         unsigned(MAX_SHADING_THREADS)))
 {
   settings.SetDefaults();
+  last_settings.SetDefaults();
+  raster_renderer.SetTaskRunner(&shading_pool);
 }
 
 #ifdef ENABLE_OPENGL
@@ -342,14 +348,8 @@ TerrainRenderer::Generate(const WindowProjection &map_projection,
       sunazimuth.CompareRoughly(last_sun_azimuth))
     /* no change since previous frame */
     return true;
-
-  compare_projection = CompareProjection(map_projection);
 #endif
 
-  terrain_serial = terrain.GetSerial();
-
-  last_sun_azimuth = sunazimuth;
-
   const bool do_water = true;
   const unsigned height_scale = 4;
   const int interp_levels = 2;
@@ -366,14 +366,37 @@ TerrainRenderer::Generate(const WindowProjection &map_projection,
     last_color_ramp = color_ramp;
   }
 
+  /* if only the map position has changed, the previous image can
+     be scrolled, and only the newly exposed parts are rendered */
+  const bool may_scroll = terrain_serial == terrain.GetSerial() &&
+    sunazimuth.CompareRoughly(last_sun_azimuth) &&
+    settings == last_settings;
+
+  bool scrolled = false;
+
   {
     RasterTerrain::Lease map(terrain);
-    raster_renderer.ScanMap(map, map_projection);
+    if (may_scroll)
+      scrolled = raster_renderer.ScrollMap(map, map_projection);
+    if (!scrolled)
+      raster_renderer.ScanMap(map, map_projection);
+  }
+
+#ifndef ENABLE_OPENGL
+  compare_projection = CompareProjection(raster_renderer.GetProjection());
+#endif
+
+  if (!scrolled) {
+    terrain_serial = terrain.GetSerial();
+    last_sun_azimuth = sunazimuth;
+    last_settings = settings;
   }
 
+  /* the scrolled parts of the image have been rendered with
+     #last_sun_azimuth; keep using it for a consistent image */
   raster_renderer.GenerateImage(do_shading, height_scale,
                                 settings.contrast, settings.brightness,
-                                sunazimuth,
+                                last_sun_azimuth,
                                 do_contour);
   return true;
 }
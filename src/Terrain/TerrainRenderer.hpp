@@ -25,6 +25,7 @@ Copyright_License {
 #define XCSOAR_TERRAIN_RENDERER_HPP
 
 #include "RasterRenderer.hpp"
+#include "Thread/WorkStealingPool.hpp"
 #include "Util/Serial.hpp"
 #include "Terrain/TerrainSettings.hpp"
 
@@ -38,6 +39,11 @@ class RasterTerrain;
 struct ColorRamp;
 
 class TerrainRenderer {
+  /**
+   * The maximum number of threads used to render the slope shading.
+   */
+  static constexpr unsigned MAX_SHADING_THREADS = 4;
+
   const RasterTerrain &terrain;
 
   Serial terrain_serial;
@@ -45,6 +51,11 @@ class TerrainRenderer {
 protected:
   struct TerrainRendererSettings settings;
 
+  /**
+   * The settings which were used to render the current image.
+   */
+  struct TerrainRendererSettings last_settings;
+
 #ifndef ENABLE_OPENGL
   CompareProjection compare_projection;
 #endif
@@ -53,6 +64,8 @@ protected:
 
   const ColorRamp *last_color_ramp = nullptr;
 
+  WorkStealingPool shading_pool;
+
   RasterRenderer raster_renderer;
 
 public:
@@ -66,9 +79,8 @@ public:
    * Flush the cache.
    */
   void Flush() {
-#ifdef ENABLE_OPENGL
     raster_renderer.Invalidate();
-#else
+#ifndef ENABLE_OPENGL
     compare_projection.Clear();
 #endif
   }
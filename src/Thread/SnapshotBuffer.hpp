@@ -0,0 +1,234 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#ifndef XCSOAR_THREAD_SNAPSHOT_BUFFER_HPP
+#define XCSOAR_THREAD_SNAPSHOT_BUFFER_HPP
+
+#include "Compiler.h"
+
+#include <atomic>
+
+#include <assert.h>
+
+/**
+ * A lock-free single-producer/multiple-consumer channel which
+ * publishes snapshots of a value.  Each snapshot is copied only
+ * once, no matter how many readers there are: each #Reader borrows
+ * the most recently published buffer, which remains valid and
+ * immutable until the same #Reader calls Update() again.
+ *
+ * There may be more than one producer thread, but the caller must
+ * ensure that they never publish at the same time (e.g. by holding a
+ * lock); debug builds assert that.
+ *
+ * A buffer is pinned by a reference counter while it is borrowed.
+ * The producer writes only into buffers which are neither pinned nor
+ * the latest one; with two more buffers than readers, there is
+ * always one, so neither side ever blocks.
+ *
+ * @param N_READERS the maximum number of #Reader objects
+ */
+template<typename T, unsigned N_READERS>
+class SnapshotBuffer {
+  static constexpr unsigned N_BUFFERS = N_READERS + 2;
+
+  /**
+   * A buffer index meaning "no buffer".
+   */
+  static constexpr unsigned NONE = N_BUFFERS;
+
+  T buffers[N_BUFFERS];
+
+  /**
+   * The number of #Reader objects which have pinned each buffer.
+   */
+  std::atomic<unsigned> refs[N_BUFFERS];
+
+  /**
+   * The index of the most recently published buffer, or #NONE if
+   * nothing was published yet.
+   */
+  std::atomic<unsigned> latest;
+
+  /**
+   * The buffer owned by the producer.
+   */
+  unsigned back;
+
+#ifndef NDEBUG
+  std::atomic<unsigned> n_readers;
+
+  /**
+   * Is a producer currently inside Publish()?
+   */
+  std::atomic<bool> publishing;
+#endif
+
+public:
+  SnapshotBuffer():latest(NONE), back(0) {
+    for (auto &i : refs)
+      i.store(0, std::memory_order_relaxed);
+
+#ifndef NDEBUG
+    n_readers.store(0, std::memory_order_relaxed);
+    publishing.store(false, std::memory_order_relaxed);
+#endif
+  }
+
+  SnapshotBuffer(const SnapshotBuffer &) = delete;
+  SnapshotBuffer &operator=(const SnapshotBuffer &) = delete;
+
+  /**
+   * Returns the buffer which may be filled by the producer.  Its
+   * contents are undefined; it does not necessarily contain the
+   * previously published value.
+   */
+  T &GetBack() {
+    return buffers[back];
+  }
+
+  /**
+   * Publish the back buffer.  May only be called by the producer.
+   */
+  void Publish() {
+#ifndef NDEBUG
+    /* two producers must never publish concurrently */
+    assert(!publishing.exchange(true));
+#endif
+
+    latest.store(back);
+
+    /* pick a new back buffer; a reader may still pin a buffer which
+       is not the latest one, but only for a moment, because it
+       checks #latest again after incrementing its counter */
+    for (unsigned i = 0; i < N_BUFFERS; ++i) {
+      if (i != back && refs[i].load() == 0) {
+        back = i;
+#ifndef NDEBUG
+        publishing.store(false);
+#endif
+        return;
+      }
+    }
+
+    assert(false);
+    gcc_unreachable();
+  }
+
+  /**
+   * Copy the given value into the back buffer and publish it.
+   */
+  void Publish(const T &value) {
+    GetBack() = value;
+    Publish();
+  }
+
+  /**
+   * One consumer of the #SnapshotBuffer.  Each thread which reads
+   * the snapshots needs its own #Reader.
+   */
+  class Reader {
+    SnapshotBuffer &buffer;
+
+    /**
+     * The buffer pinned by this reader, or #NONE.
+     */
+    unsigned front = NONE;
+
+  public:
+    explicit Reader(SnapshotBuffer &_buffer):buffer(_buffer) {
+#ifndef NDEBUG
+      assert(buffer.n_readers < N_READERS);
+      buffer.n_readers.fetch_add(1, std::memory_order_relaxed);
+#endif
+    }
+
+    ~Reader() {
+      if (front != NONE)
+        buffer.refs[front].fetch_sub(1, std::memory_order_release);
+
+#ifndef NDEBUG
+      buffer.n_readers.fetch_sub(1, std::memory_order_relaxed);
+#endif
+    }
+
+    Reader(const Reader &) = delete;
+    Reader &operator=(const Reader &) = delete;
+
+    /**
+     * Has a snapshot been published that was not yet acquired by
+     * Update()?
+     */
+    gcc_pure
+    bool IsFresh() const {
+      return buffer.latest.load(std::memory_order_relaxed) != front;
+    }
+
+    /**
+     * Borrow the most recently published snapshot as the new front
+     * buffer and release the previous one.
+     *
+     * @return true if a new snapshot was acquired, false if nothing
+     * was published since the last call (the front buffer remains
+     * unchanged)
+     */
+    bool Update() {
+      unsigned i = buffer.latest.load();
+      if (i == front)
+        return false;
+
+      if (front != NONE)
+        buffer.refs[front].fetch_sub(1, std::memory_order_release);
+
+      while (true) {
+        buffer.refs[i].fetch_add(1);
+
+        /* the producer may have picked this buffer as its back buffer
+           before we pinned it; that is only safe if it is still the
+           latest one */
+        const unsigned check = buffer.latest.load();
+        if (check == i)
+          break;
+
+        buffer.refs[i].fetch_sub(1, std::memory_order_relaxed);
+        i = check;
+      }
+
+      front = i;
+      return true;
+    }
+
+    /**
+     * Returns the snapshot acquired by the last successful Update()
+     * call.  May only be called by the owner of this object, after
+     * Update() has succeeded at least once.
+     */
+    const T &GetFront() const {
+      assert(front != NONE);
+
+      return buffer.buffers[front];
+    }
+  };
+};
+
+#endif
@@ -0,0 +1,211 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#include "Thread/WorkStealingPool.hpp"
+
+#ifdef HAVE_POSIX
+#include <unistd.h>
+#else
+#include <windows.h>
+#endif
+
+#include <assert.h>
+
+WorkStealingPool::WorkStealingPool(unsigned _n_threads)
+  :n_threads(_n_threads > 0 ? _n_threads : 1),
+   queues(new Queue[n_threads])
+{
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+  if (!started)
+    return;
+
+  {
+    const ScopeLock protect(mutex);
+    quit = true;
+    start_cond.broadcast();
+  }
+
+  for (unsigned i = 1; i < n_threads; ++i)
+    if (workers[i - 1].IsDefined())
+      workers[i - 1].Join();
+}
+
+unsigned
+WorkStealingPool::GetProcessorCount()
+{
+#ifdef HAVE_POSIX
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? (unsigned)n : 1;
+#else
+  SYSTEM_INFO si;
+  GetSystemInfo(&si);
+  return si.dwNumberOfProcessors > 0 ? si.dwNumberOfProcessors : 1;
+#endif
+}
+
+void
+WorkStealingPool::StartWorkers()
+{
+  assert(!started);
+
+  started = true;
+  workers.reset(new Worker[n_threads - 1]);
+
+  for (unsigned i = 1; i < n_threads; ++i) {
+    workers[i - 1].Init(*this, i);
+    /* if a thread fails to start, the others (and the calling
+       thread) steal its share */
+    if (workers[i - 1].Start())
+      ++n_workers;
+  }
+}
+
+void
+WorkStealingPool::Run(Job &_job, unsigned n)
+{
+  if (n_threads == 1 || n < 2) {
+    for (unsigned i = 0; i < n; ++i)
+      _job.RunTask(i);
+    return;
+  }
+
+  if (!started)
+    StartWorkers();
+
+  /* distribute the tasks evenly */
+  for (unsigned i = 0; i < n_threads; ++i) {
+    Queue &queue = queues[i];
+    const ScopeLock protect(queue.mutex);
+    queue.begin = n * i / n_threads;
+    queue.end = n * (i + 1) / n_threads;
+  }
+
+  {
+    const ScopeLock protect(mutex);
+    job = &_job;
+    ++generation;
+    busy = n_workers;
+    start_cond.broadcast();
+  }
+
+  Work(_job, 0);
+
+  const ScopeLock protect(mutex);
+  while (busy > 0)
+    done_cond.wait(mutex);
+
+  job = nullptr;
+}
+
+void
+WorkStealingPool::Worker::Run()
+{
+  pool->WorkerRun(index);
+}
+
+void
+WorkStealingPool::WorkerRun(unsigned index)
+{
+  unsigned last_generation = 0;
+
+  const ScopeLock protect(mutex);
+
+  while (true) {
+    while (!quit && generation == last_generation)
+      start_cond.wait(mutex);
+
+    if (quit)
+      break;
+
+    last_generation = generation;
+    Job &current = *job;
+
+    {
+      const ScopeUnlock unlock(mutex);
+      Work(current, index);
+    }
+
+    assert(busy > 0);
+    if (--busy == 0)
+      done_cond.signal();
+  }
+}
+
+void
+WorkStealingPool::Work(Job &_job, unsigned index)
+{
+  unsigned task;
+  while (Pop(index, task) || Steal(index, task))
+    _job.RunTask(task);
+}
+
+bool
+WorkStealingPool::Pop(unsigned index, unsigned &task_r)
+{
+  Queue &queue = queues[index];
+  const ScopeLock protect(queue.mutex);
+  if (queue.begin == queue.end)
+    return false;
+
+  task_r = queue.begin++;
+  return true;
+}
+
+bool
+WorkStealingPool::Steal(unsigned index, unsigned &task_r)
+{
+  for (unsigned i = 1; i < n_threads; ++i) {
+    Queue &victim = queues[(index + i) % n_threads];
+
+    unsigned begin, end;
+
+    {
+      const ScopeLock protect(victim.mutex);
+      const unsigned remaining = victim.end - victim.begin;
+      if (remaining == 0)
+        continue;
+
+      /* take the back half */
+      end = victim.end;
+      victim.end -= (remaining + 1) / 2;
+      begin = victim.end;
+    }
+
+    task_r = begin++;
+
+    if (begin < end) {
+      Queue &queue = queues[index];
+      const ScopeLock protect(queue.mutex);
+      assert(queue.begin == queue.end);
+      queue.begin = begin;
+      queue.end = end;
+    }
+
+    return true;
+  }
+
+  return false;
+}
@@ -0,0 +1,145 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#ifndef XCSOAR_THREAD_WORK_STEALING_POOL_HPP
+#define XCSOAR_THREAD_WORK_STEALING_POOL_HPP
+
+#include "Engine/Util/TaskRunner.hpp"
+#include "Thread/Thread.hpp"
+#include "Thread/Mutex.hpp"
+#include "Thread/Cond.hxx"
+
+#include <memory>
+
+/**
+ * A small pool of threads which executes the tasks of a
+ * #TaskRunner::Job in parallel.  Each thread starts with an equal
+ * share of the task indices; a thread which runs out of work steals
+ * half of the remaining tasks of another thread.
+ *
+ * The threads are launched on the first Run() call and live until
+ * the pool is destructed.  Run() must not be called concurrently.
+ */
+class WorkStealingPool final : public TaskRunner {
+  /**
+   * A range of task indices owned by one thread.  The owner takes
+   * tasks from the front, thieves take them from the back.
+   */
+  struct Queue {
+    Mutex mutex;
+    unsigned begin = 0, end = 0;
+  };
+
+  class Worker final : public Thread {
+    WorkStealingPool *pool;
+    unsigned index;
+
+  public:
+    Worker():Thread("WorkStealing") {}
+
+    void Init(WorkStealingPool &_pool, unsigned _index) {
+      pool = &_pool;
+      index = _index;
+    }
+
+  protected:
+    void Run() override;
+  };
+
+  /**
+   * The number of threads, including the one calling Run().
+   */
+  const unsigned n_threads;
+
+  std::unique_ptr<Queue[]> queues;
+
+  /**
+   * The helper threads; the calling thread uses queue 0.
+   */
+  std::unique_ptr<Worker[]> workers;
+
+  /**
+   * The number of helper threads which were started successfully.
+   */
+  unsigned n_workers = 0;
+
+  /**
+   * Protects the following attributes.
+   */
+  Mutex mutex;
+  Cond start_cond, done_cond;
+
+  bool started = false, quit = false;
+
+  Job *job = nullptr;
+
+  /**
+   * Incremented by Run() for each job; a worker compares this with
+   * its own counter to detect new jobs.
+   */
+  unsigned generation = 0;
+
+  /**
+   * The number of workers still busy with the current job.
+   */
+  unsigned busy = 0;
+
+public:
+  /**
+   * @param n_threads the total number of threads, including the
+   * calling thread; 1 means all tasks run serially
+   */
+  explicit WorkStealingPool(unsigned n_threads);
+
+  ~WorkStealingPool();
+
+  WorkStealingPool(const WorkStealingPool &) = delete;
+  WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+  /**
+   * Returns the number of processors available to this process,
+   * but at least 1.
+   */
+  static unsigned GetProcessorCount();
+
+  /* virtual methods from class TaskRunner */
+  unsigned GetConcurrency() const override {
+    return n_threads;
+  }
+
+  void Run(Job &job, unsigned n) override;
+
+private:
+  void StartWorkers();
+  void WorkerRun(unsigned index);
+
+  /**
+   * Execute tasks until all queues are empty.
+   */
+  void Work(Job &job, unsigned index);
+
+  bool Pop(unsigned index, unsigned &task_r);
+  bool Steal(unsigned index, unsigned &task_r);
+};
+
+#endif
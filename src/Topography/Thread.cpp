@@ -24,10 +24,14 @@ Copyright_License {
 #include "Thread.hpp"
 #include "TopographyStore.hpp"
 
+#include <algorithm>
+
 TopographyThread::TopographyThread(TopographyStore &_store,
                                    std::function<void()> &&_callback)
   :StandbyThread("Topography"),
    store(_store),
+   update_pool(std::min(WorkStealingPool::GetProcessorCount(),
+                        unsigned(MAX_UPDATE_THREADS))),
    callback(std::move(_callback)),
    last_bounds(GeoBounds::Invalid()) {}
 
@@ -73,7 +77,7 @@ TopographyThread::Tick()
     const WindowProjection projection = next_projection;
 
     const ScopeUnlock unlock(mutex);
-    again = store.ScanVisibility(projection, 1) > 0;
+    again = store.ScanVisibility(projection, update_pool) > 0;
   }
 
   /* notify the client that we have updated the topography cache */
@@ -25,6 +25,7 @@ Copyright_License {
 #define XCSOAR_TOPOGRAPHY_THREAD_HPP
 
 #include "Thread/StandbyThread.hpp"
+#include "Thread/WorkStealingPool.hpp"
 #include "Projection/WindowProjection.hpp"
 #include "Geo/GeoBounds.hpp"
 
@@ -36,8 +37,20 @@ class TopographyStore;
  * A thread that loads topography files asynchronously.
  */
 class TopographyThread final : private StandbyThread {
+  /**
+   * The maximum number of threads used to update the topography
+   * files.
+   */
+  static constexpr unsigned MAX_UPDATE_THREADS = 4;
+
   TopographyStore &store;
 
+  /**
+   * Updates the files in parallel.  Its threads are launched lazily
+   * by this thread, and on Linux, they inherit its idle priority.
+   */
+  WorkStealingPool update_pool;
+
   const std::function<void()> callback;
 
   WindowProjection next_projection;
@@ -25,6 +25,9 @@ Copyright_License {
 #include "Topography/XShape.hpp"
 #include "Convert.hpp"
 #include "Projection/WindowProjection.hpp"
+#include "IO/FileCache.hpp"
+#include "OS/FileMapping.hpp"
+#include "OS/Path.hpp"
 
 #include <zzip/lib.h>
 
@@ -38,7 +41,7 @@ TopographyFile::TopographyFile(zzip_dir *_dir, const char *filename,
                                int _label_field,
                                ResourceId _icon, ResourceId _big_icon,
                                unsigned _pen_width)
-  :dir(_dir), first(nullptr),
+  :dir(_dir), first(nullptr), shape_cache(nullptr),
    label_field(_label_field), icon(_icon), big_icon(_big_icon),
    pen_width(_pen_width),
    color(_color), scale_threshold(_threshold),
@@ -90,18 +93,51 @@ void
 TopographyFile::ClearCache()
 {
   for (auto i = shapes.begin(), end = shapes.end(); i != end; ++i) {
+    if (!i->listed && shape_cache != nullptr)
+      shape_cache->Remove(*i);
+
     delete i->shape;
     i->shape = nullptr;
+    i->listed = false;
   }
 
   first = nullptr;
 }
 
-static XShape *
-LoadShape(shapefileObj *file, const GeoPoint &center, int i,
-          int label_field)
+XShape *
+TopographyFile::LoadShape(int i)
+{
+  if (store.IsDefined()) {
+    XShapeStore::Shape shape;
+    if (store.GetShape(i, shape))
+      return new XShape(shape);
+  }
+
+  return new XShape(&file, center, i, label_field);
+}
+
+int
+TopographyFile::WhichShapes(const GeoBounds &bounds)
 {
-  return new XShape(file, center, i, label_field);
+  assert(store.IsDefined());
+
+  free(file.status);
+  file.status = nullptr;
+
+  if (!ImportRect(file.bounds).Overlaps(bounds))
+    return MS_DONE;
+
+  file.status = msAllocBitArray(file.numshapes);
+  if (file.status == nullptr)
+    return MS_FAILURE;
+
+  const unsigned n = file.numshapes;
+  store.VisitShapes(bounds, [this, n](unsigned i){
+      if (i < n)
+        msSetBit(file.status, i, 1);
+    });
+
+  return MS_SUCCESS;
 }
 
 bool
@@ -126,7 +162,9 @@ TopographyFile::Update(const WindowProjection &map_projection)
 
   // Test which shapes are inside the given bounds and save the
   // status to file.status
-  switch (msShapefileWhichShapes(&file, dir, deg_bounds, 0)) {
+  switch (store.IsDefined()
+          ? WhichShapes(cache_bounds)
+          : msShapefileWhichShapes(&file, dir, deg_bounds, 0)) {
   case MS_FAILURE:
     ClearCache();
     return false;
@@ -148,7 +186,7 @@ TopographyFile::Update(const WindowProjection &map_projection)
     if (!msGetBit(file.status, i)) {
       // If the shape is outside the bounds
       // delete the shape from the cache
-      if (it->shape != nullptr) {
+      if (it->listed) {
         assert(*current == it);
 
         /* remove from linked list (protected) */
@@ -158,18 +196,25 @@ TopographyFile::Update(const WindowProjection &map_projection)
           ++serial;
         }
 
-        /* now it's unreachable, and we can delete the XShape without
-           holding a lock */
-        delete it->shape;
-        it->shape = nullptr;
+        /* now it's unreachable, and we can delete the XShape (or
+           pass it to the shape cache) without holding a lock */
+        it->listed = false;
+        if (shape_cache != nullptr)
+          shape_cache->Retain(*it);
+        else {
+          delete it->shape;
+          it->shape = nullptr;
+        }
       }
     } else {
       // is inside the bounds
-      if (it->shape == nullptr) {
+      if (!it->listed) {
         assert(*current != it);
 
         // shape isn't cached yet -> cache the shape
-        it->shape = LoadShape(&file, center, i, label_field);
+        if (shape_cache == nullptr || !shape_cache->Acquire(*it))
+          it->shape = LoadShape(i);
+        it->listed = true;
         it->next = *current;
 
         /* insert into linked list (protected) */
@@ -196,9 +241,12 @@ TopographyFile::LoadAll()
   const ShapeList **current = &first;
   auto it = shapes.begin();
   for (int i = 0; i < file.numshapes; ++i, ++it) {
+    if (!it->listed && shape_cache != nullptr)
+      shape_cache->Remove(*it);
     if (it->shape == nullptr)
       // shape isn't cached yet -> cache the shape
-      it->shape = LoadShape(&file, center, i, label_field);
+      it->shape = LoadShape(i);
+    it->listed = true;
     // update list pointer
     *current = it;
     current = &it->next;
@@ -221,6 +269,77 @@ TopographyFile::GetSkipSteps(double map_scale) const
   return 1;
 }
 
+bool
+TopographyFile::OpenStore(FileCache &cache, const TCHAR *name,
+                          Path original_path, const float *min_distance)
+{
+  size_t offset;
+  auto mapping = cache.Map(name, original_path, offset);
+  if (!mapping)
+    return false;
+
+  bool valid = store.Open(std::move(mapping), offset) &&
+    store.GetShapeCount() == unsigned(file.numshapes) &&
+    store.GetCenter() == center;
+
+  /* the indices must have been built for the current display */
+  for (unsigned i = 0; valid && i < XShapeStore::MAX_LEVELS; ++i)
+    valid = store.GetMinimumPointDistance(i) == min_distance[i];
+
+  if (!valid) {
+    store.Close();
+    cache.Flush(name);
+    return false;
+  }
+
+  return true;
+}
+
+bool
+TopographyFile::SaveStore(FileCache &cache, const TCHAR *name,
+                          Path original_path, const float *min_distance)
+{
+  FILE *out = cache.Save(name, original_path);
+  if (out == nullptr)
+    return false;
+
+  XShapeStoreWriter writer(out, center, min_distance);
+  for (int i = 0; i < file.numshapes; ++i) {
+    const XShape shape(&file, center, i, label_field);
+    writer.Add(shape);
+  }
+
+  if (!writer.Finish()) {
+    cache.Cancel(name, out);
+    return false;
+  }
+
+  return cache.Commit(name, out);
+}
+
+bool
+TopographyFile::LoadStore(FileCache &cache, const TCHAR *name,
+                          Path original_path, int layout_scale)
+{
+  assert(first == nullptr);
+
+  if (IsEmpty())
+    return false;
+
+  float min_distance[XShapeStore::MAX_LEVELS];
+#ifdef ENABLE_OPENGL
+  for (unsigned i = 0; i < XShapeStore::MAX_LEVELS; ++i)
+    min_distance[i] = GetMinimumPointDistance(i, layout_scale);
+#else
+  (void)layout_scale;
+  std::fill_n(min_distance, XShapeStore::MAX_LEVELS, 0.f);
+#endif
+
+  return OpenStore(cache, name, original_path, min_distance) ||
+    (SaveStore(cache, name, original_path, min_distance) &&
+     OpenStore(cache, name, original_path, min_distance));
+}
+
 #ifdef ENABLE_OPENGL
 
 unsigned
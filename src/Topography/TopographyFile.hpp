@@ -26,6 +26,8 @@ Copyright_License {
 #define TOPOGRAPHY_HPP
 
 #include "shapelib/mapserver.h"
+#include "Topography/XShapeStore.hpp"
+#include "Topography/XShapeCache.hpp"
 #include "Geo/GeoBounds.hpp"
 #include "Util/AllocatedArray.hxx"
 #include "Util/Serial.hpp"
@@ -35,22 +37,33 @@ Copyright_License {
 
 #ifdef ENABLE_OPENGL
 #include "XShapePoint.hpp"
+#include "Geo/FAISphere.hpp"
 #endif
 
 #include <assert.h>
+#include <tchar.h>
 
 class WindowProjection;
 class XShape;
+class FileCache;
+class Path;
 struct zzip_dir;
 
 class TopographyFile {
-  struct ShapeList {
+  struct ShapeList : XShapeCache::Item {
     const ShapeList *next;
 
-    const XShape *shape;
+    /**
+     * Is the shape loaded and in the linked list (i.e. not just
+     * retained by the #XShapeCache)?  Unlike the #XShapeCache::Item
+     * attributes, this flag is owned by the thread which updates this
+     * file, and may be read without locking the cache.
+     */
+    bool listed;
 
     ShapeList() {}
-    ShapeList(const XShape *_shape):shape(_shape) {}
+    ShapeList(const XShape *_shape)
+      :XShapeCache::Item(_shape), listed(false) {}
   };
 
   /**
@@ -62,6 +75,12 @@ class TopographyFile {
 
   shapefileObj file;
 
+  /**
+   * The compiled shapes from the #FileCache.  If this is defined,
+   * shapes are loaded from here instead of from #file.
+   */
+  XShapeStore store;
+
   /**
    * The center of shapefileObj::bounds.
    */
@@ -70,6 +89,12 @@ class TopographyFile {
   AllocatedArray<ShapeList> shapes;
   const ShapeList *first;
 
+  /**
+   * Shapes which leave the cache bounds are passed to this cache
+   * instead of being deleted.  May be nullptr.
+   */
+  XShapeCache *shape_cache;
+
   const int label_field;
 
   const ResourceId icon, big_icon;
@@ -275,8 +300,48 @@ public:
    */
   gcc_pure
   unsigned GetMinimumPointDistance(unsigned level) const;
+
+  /**
+   * @param layout_scale the value of Layout::Scale(1)
+   * @return the minimum distance between points of the given
+   * thinning level in #ShapePoint units
+   */
+  gcc_pure
+  ShapeScalar GetMinimumPointDistance(unsigned level,
+                                      int layout_scale) const {
+    return ShapeScalar(GetMinimumPointDistance(level))
+      / (layout_scale * FAISphere::REARTH);
+  }
 #endif
 
+  /**
+   * Keep shapes which leave the cache bounds in the given cache.
+   * Call this before the first Update().
+   */
+  void SetShapeCache(XShapeCache *_shape_cache) {
+    assert(first == nullptr);
+
+    shape_cache = _shape_cache;
+  }
+
+  bool HasStore() const {
+    return store.IsDefined();
+  }
+
+  /**
+   * Map the compiled shapes of this file from the cache.  If there is
+   * no valid cache file, compile the shapefile first (which
+   * triangulates all polygons).  Call this before the first Update().
+   *
+   * @param name the name of the cache file
+   * @param original_path the file the shapefile was read from
+   * @param layout_scale the value of Layout::Scale(1), which
+   * determines the thinning distances of the stored indices
+   * @return true if the compiled shapes are used
+   */
+  bool LoadStore(FileCache &cache, const TCHAR *name, Path original_path,
+                 int layout_scale);
+
   /**
    * @return true if new data from the topography file has been loaded
    */
@@ -289,6 +354,20 @@ public:
 
 protected:
   void ClearCache();
+
+private:
+  XShape *LoadShape(int i);
+
+  bool OpenStore(FileCache &cache, const TCHAR *name, Path original_path,
+                 const float *min_distance);
+
+  bool SaveStore(FileCache &cache, const TCHAR *name, Path original_path,
+                 const float *min_distance);
+
+  /**
+   * Like msShapefileWhichShapes(), but query #store.
+   */
+  int WhichShapes(const GeoBounds &bounds);
 };
 
 #endif
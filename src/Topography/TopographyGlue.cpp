@@ -25,18 +25,20 @@ Copyright_License {
 #include "Topography/TopographyStore.hpp"
 #include "Language/Language.hpp"
 #include "Profile/Profile.hpp"
+#include "Profile/ProfileKeys.hpp"
 #include "LogFile.hpp"
 #include "Operation/Operation.hpp"
 #include "IO/MapFile.hpp"
 #include "IO/ZipArchive.hpp"
 #include "IO/ZipLineReader.hpp"
+#include "Screen/Layout.hpp"
 
 /**
  * Load topography from the map file (ZIP), load the other files from
  * the same ZIP file.
  */
 static bool
-LoadConfiguredTopographyZip(TopographyStore &store,
+LoadConfiguredTopographyZip(TopographyStore &store, FileCache *cache,
                             OperationEnvironment &operation)
 try {
   auto archive = OpenMapFile();
@@ -44,7 +46,9 @@ try {
     return false;
 
   ZipLineReaderA reader(archive->get(), "topology.tpl");
-  store.Load(operation, reader, nullptr, archive->get());
+  store.Load(operation, reader, nullptr, archive->get(),
+             cache, Profile::GetPath(ProfileKeys::MapFile),
+             Layout::Scale(1));
   return true;
 } catch (const std::runtime_error &e) {
   LogError("No topography in map file", e);
@@ -52,11 +56,11 @@ try {
 }
 
 bool
-LoadConfiguredTopography(TopographyStore &store,
+LoadConfiguredTopography(TopographyStore &store, FileCache *cache,
                          OperationEnvironment &operation)
 {
   LogFormat("Loading Topography File...");
   operation.SetText(_("Loading Topography File..."));
 
-  return LoadConfiguredTopographyZip(store, operation);
+  return LoadConfiguredTopographyZip(store, cache, operation);
 }
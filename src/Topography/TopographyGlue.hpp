@@ -25,10 +25,15 @@ Copyright_License {
 #define TOPOGRAPHY_GLUE_H
 
 class TopographyStore;
+class FileCache;
 class OperationEnvironment;
 
+/**
+ * @param cache if not nullptr, then the compiled shapes are mapped
+ * from this cache
+ */
 bool
-LoadConfiguredTopography(TopographyStore &store,
+LoadConfiguredTopography(TopographyStore &store, FileCache *cache,
                          OperationEnvironment &operation);
 
 #endif
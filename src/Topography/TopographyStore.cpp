@@ -26,13 +26,20 @@ Copyright_License {
 #include "Util/StringAPI.hxx"
 #include "Util/StringCompare.hxx"
 #include "Util/ConvertString.hpp"
+#include "Engine/Util/TaskRunner.hpp"
+#include "OS/ConvertPathName.hpp"
 #include "IO/LineReader.hpp"
 #include "Operation/Operation.hpp"
 #include "Compatibility/path.h"
 #include "Asset.hpp"
 #include "Resources.hpp"
 
+#include <zzip/lib.h>
+
+#include <algorithm>
+
 #include <stdint.h>
+#include <stdio.h>
 #include <windef.h> // for MAX_PATH
 
 static bool
@@ -92,6 +99,21 @@ static constexpr LOOKUP_ICON icon_list[] = {
   { nullptr, ResourceId::Null(), ResourceId::Null() }
 };
 
+/**
+ * The default byte budget of the #XShapeCache.
+ */
+static constexpr size_t
+GetDefaultShapeCacheBudget()
+{
+  return HasLittleMemory()
+    ? 2 * 1024 * 1024
+    : 16 * 1024 * 1024;
+}
+
+TopographyStore::TopographyStore()
+  :shape_cache(GetDefaultShapeCacheBudget()), shared_archive(false),
+   serial(0) {}
+
 double
 TopographyStore::GetNextScaleThreshold(double map_scale) const
 {
@@ -127,6 +149,39 @@ TopographyStore::ScanVisibility(const WindowProjection &m_projection,
   return num_updated;
 }
 
+unsigned
+TopographyStore::ScanVisibility(const WindowProjection &m_projection,
+                                TaskRunner &runner)
+{
+  if (shared_archive)
+    /* zzip is not thread-safe */
+    return ScanVisibility(m_projection);
+
+  class UpdateJob final : public TaskRunner::Job {
+    TopographyFile *const *const files;
+    const WindowProjection &projection;
+
+  public:
+    bool updated[MAXTOPOGRAPHY];
+
+    UpdateJob(TopographyFile *const *_files,
+              const WindowProjection &_projection)
+      :files(_files), projection(_projection) {}
+
+    void RunTask(unsigned i) override {
+      updated[i] = files[i]->Update(projection);
+    }
+  };
+
+  UpdateJob job(files.begin(), m_projection);
+  runner.Run(job, files.size());
+
+  const unsigned num_updated =
+    std::count(job.updated, job.updated + files.size(), true);
+  serial += num_updated;
+  return num_updated;
+}
+
 void
 TopographyStore::LoadAll()
 {
@@ -143,7 +198,9 @@ TopographyStore::~TopographyStore()
 
 void
 TopographyStore::Load(OperationEnvironment &operation, NLineReader &reader,
-                      const TCHAR *directory, struct zzip_dir *zdir)
+                      const TCHAR *directory, struct zzip_dir *zdir,
+                      FileCache *cache, Path original_path,
+                      int layout_scale)
 {
   Reset();
 
@@ -195,7 +252,8 @@ TopographyStore::Load(OperationEnvironment &operation, NLineReader &reader,
     }
 
     // Extract filename and append it to the shape_filename buffer
-    memcpy(shape_filename_end, line, p - line);
+    const size_t name_length = p - line;
+    memcpy(shape_filename_end, line, name_length);
     // Append ".shp" file extension to the shape_filename buffer
     strcpy(shape_filename_end + (p - line), ".shp");
 
@@ -279,8 +337,19 @@ TopographyStore::Load(OperationEnvironment &operation, NLineReader &reader,
 #endif
     }
 
+    /* give each file its own handle on the ZIP archive, because zzip
+       is not thread-safe, and ScanVisibility() may update the files
+       concurrently */
+    struct zzip_dir *file_zdir = zdir;
+    if (zdir != nullptr && !original_path.IsNull()) {
+      struct zzip_dir *own_zdir =
+        zzip_dir_open(NarrowPathName(original_path), nullptr);
+      if (own_zdir != nullptr)
+        file_zdir = own_zdir;
+    }
+
     // Create TopographyFile instance from parsed line
-    TopographyFile *file = new TopographyFile(zdir, shape_filename,
+    TopographyFile *file = new TopographyFile(file_zdir, shape_filename,
                                               shape_range, label_range,
                                               labelImportantRange,
 #ifdef ENABLE_OPENGL
@@ -290,12 +359,36 @@ TopographyStore::Load(OperationEnvironment &operation, NLineReader &reader,
 #endif
                                               shape_field, icon, big_icon,
                                               pen_width);
-    if (file->IsEmpty())
+    if (file->IsEmpty()) {
       // If the shape file could not be read -> skip this line/file
       delete file;
-    else
-      // .. otherwise append it to our list of shape files
-      files.append(file);
+      if (file_zdir != zdir)
+        zzip_dir_close(file_zdir);
+      continue;
+    }
+
+    if (file_zdir != zdir)
+      /* the TopographyFile holds a reference, and frees the handle
+         when it gets deleted */
+      zzip_dir_close(file_zdir);
+    else if (zdir != nullptr)
+      shared_archive = true;
+
+    file->SetShapeCache(&shape_cache);
+
+    if (cache != nullptr) {
+      // Use the compiled shapes from the cache (compile them if needed)
+      char cache_name[MAX_PATH];
+      snprintf(cache_name, sizeof(cache_name), "topography-%.*s",
+               (int)name_length, shape_filename_end);
+
+      const UTF8ToWideConverter tcache_name(cache_name);
+      if (tcache_name.IsValid())
+        file->LoadStore(*cache, tcache_name, original_path, layout_scale);
+    }
+
+    // .. otherwise append it to our list of shape files
+    files.append(file);
 
     // Update progress bar
     operation.SetProgressPosition((reader.Tell() * 100) / filesize);
@@ -309,4 +402,5 @@ TopographyStore::Reset()
     delete file;
 
   files.clear();
+  shared_archive = false;
 }
@@ -26,6 +26,8 @@ Copyright_License {
 
 #include "Util/NonCopyable.hpp"
 #include "Util/StaticArray.hxx"
+#include "Topography/XShapeCache.hpp"
+#include "OS/Path.hpp"
 #include "Compiler.h"
 
 #include <tchar.h>
@@ -34,6 +36,8 @@ class WindowProjection;
 class TopographyFile;
 class NLineReader;
 class OperationEnvironment;
+class FileCache;
+class TaskRunner;
 struct zzip_dir;
 
 /**
@@ -47,13 +51,25 @@ public:
 private:
   StaticArray<TopographyFile *, MAXTOPOGRAPHY> files;
 
+  /**
+   * Shapes which have left the visible area of their file, shared by
+   * all files.
+   */
+  XShapeCache shape_cache;
+
+  /**
+   * Do some files use the #zzip_dir passed to Load()?  They must not
+   * be updated concurrently, because zzip is not thread-safe.
+   */
+  bool shared_archive;
+
   /**
    * This number is incremented each time this object is modified.
    */
   unsigned serial;
 
 public:
-  TopographyStore():serial(0) {}
+  TopographyStore();
   ~TopographyStore();
 
   /**
@@ -72,6 +88,21 @@ public:
     return *files[i];
   }
 
+  /**
+   * Returns the shape cache, which provides the hit/miss counters.
+   */
+  const XShapeCache &GetShapeCache() const {
+    return shape_cache;
+  }
+
+  /**
+   * Change the byte budget of the shape cache.  Zero deletes shapes
+   * as soon as they leave the visible area.
+   */
+  void SetShapeCacheBudget(size_t budget) {
+    shape_cache.SetBudget(budget);
+  }
+
   /**
    * @see TopographyFile::GetNextScaleThreshold()
    */
@@ -86,14 +117,35 @@ public:
   unsigned ScanVisibility(const WindowProjection &m_projection,
                           unsigned max_update=1024);
 
+  /**
+   * Update all files, spread over the threads of the given
+   * #TaskRunner.  Each file is locked individually, so the renderer
+   * sees partial progress.  Falls back to a serial update if the
+   * files share one ZIP archive handle.
+   *
+   * @return the number of files which were updated
+   */
+  unsigned ScanVisibility(const WindowProjection &m_projection,
+                          TaskRunner &runner);
+
   /**
    * Load all shapes of all files into memory.  For debugging
    * purposes.
    */
   void LoadAll();
 
+  /**
+   * @param cache if not nullptr, then the shapes of each file are
+   * compiled into this cache and mapped from there
+   * @param original_path the file the topography is read from (for
+   * validating the cache); if #zdir is set, each file opens its own
+   * handle on this archive
+   * @param layout_scale the value of Layout::Scale(1)
+   */
   void Load(OperationEnvironment &operation, NLineReader &reader,
-            const TCHAR *directory, struct zzip_dir *zdir = nullptr);
+            const TCHAR *directory, struct zzip_dir *zdir = nullptr,
+            FileCache *cache = nullptr, Path original_path = nullptr,
+            int layout_scale = 1);
   void Reset();
 };
 
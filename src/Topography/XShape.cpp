@@ -27,6 +27,7 @@ Copyright_License {
 #include "Util/UTF8.hpp"
 #include "Util/StringUtil.hpp"
 #include "Util/ScopeExit.hxx"
+#include "Util/AllocatedString.hxx"
 
 #ifdef ENABLE_OPENGL
 #include "Projection/Projection.hpp"
@@ -89,7 +90,7 @@ GetMinPointsForShapeType(int shapelib_type)
 
 XShape::XShape(shapefileObj *shpfile, const GeoPoint &file_center, int i,
                int label_field)
-  :label(nullptr)
+  :mapped(false), label(nullptr)
 {
 #ifdef ENABLE_OPENGL
   std::fill_n(index_count, THINNING_LEVELS, nullptr);
@@ -136,13 +137,13 @@ XShape::XShape(shapefileObj *shpfile, const GeoPoint &file_center, int i,
   /* OpenGL: convert GeoPoints to ShapePoints, make them relative to
      the map's boundary center */
 
-  points = new ShapePoint[num_points];
-  ShapePoint *p = points;
+  ShapePoint *p = new ShapePoint[num_points];
+  points = p;
 #else // !ENABLE_OPENGL
   /* convert all points of all lines to GeoPoints */
 
-  points = new GeoPoint[num_points];
-  GeoPoint *p = points;
+  GeoPoint *p = new GeoPoint[num_points];
+  points = p;
 #endif
   for (unsigned l = 0; l < num_lines; ++l) {
     const pointObj *src = shape.line[l].point;
@@ -163,13 +164,36 @@ XShape::XShape(shapefileObj *shpfile, const GeoPoint &file_center, int i,
 
   if (label_field >= 0) {
     const char *src = msDBFReadStringAttribute(shpfile->hDBF, i, label_field);
-    label = ImportLabel(src);
+    label = ImportLabel(src).Steal();
   }
 }
 
+XShape::XShape(const XShapeStore::Shape &shape)
+  :bounds(shape.bounds), mapped(true),
+   type(shape.type), num_lines(shape.num_lines),
+   points(shape.points), label(shape.label)
+{
+  assert(num_lines <= MAX_LINES);
+
+  std::copy_n(shape.lines, num_lines, lines);
+
+#ifdef ENABLE_OPENGL
+  for (unsigned i = 0; i < THINNING_LEVELS; ++i) {
+    index_count[i] = shape.index_count[i];
+    indices[i] = index_count[i] != nullptr
+      ? index_count[i] + (type == MS_SHAPE_LINE ? num_lines : 1)
+      : nullptr;
+  }
+#endif
+}
+
 XShape::~XShape()
 {
+  if (mapped)
+    return;
+
   delete[] points;
+  delete[] label;
 #ifdef ENABLE_OPENGL
   // Note: index_count and indices share one buffer
   for (unsigned i = 0; i < THINNING_LEVELS; i++)
@@ -177,6 +201,35 @@ XShape::~XShape()
 #endif
 }
 
+size_t
+XShape::GetMemoryUsage() const
+{
+  size_t result = sizeof(*this);
+  if (mapped || points == nullptr)
+    return result;
+
+  unsigned num_points = 0;
+  for (unsigned i = 0; i < num_lines; ++i)
+    num_points += lines[i];
+
+  result += num_points * sizeof(*points);
+
+  if (label != nullptr)
+    result += (_tcslen(label) + 1) * sizeof(*label);
+
+#ifdef ENABLE_OPENGL
+  /* the buffer sizes allocated by BuildIndices() */
+  const size_t index_size = type == MS_SHAPE_LINE
+    ? num_lines + num_points
+    : 1 + 3 * (num_points - 2) + 2 * (num_lines - 1);
+  for (unsigned i = 0; i < THINNING_LEVELS; ++i)
+    if (index_count[i] != nullptr)
+      result += index_size * sizeof(*index_count[i]);
+#endif
+
+  return result;
+}
+
 #ifdef ENABLE_OPENGL
 
 bool
@@ -254,6 +307,10 @@ XShape::GetIndices(int thinning_level, ShapeScalar min_distance,
                    const uint16_t *&count) const
 {
   if (indices[thinning_level] == nullptr) {
+    if (mapped)
+      /* the store contains all indices which could be built */
+      return nullptr;
+
     XShape &deconst = const_cast<XShape &>(*this);
     if (!deconst.BuildIndices(thinning_level, min_distance))
       return nullptr;
@@ -26,8 +26,8 @@ Copyright_License {
 #define TOPOGRAPHY_XSHAPE_HPP
 
 #include "Util/ConstBuffer.hxx"
-#include "Util/AllocatedString.hxx"
 #include "Geo/GeoBounds.hpp"
+#include "Topography/XShapeStore.hpp"
 #include "shapelib/mapserver.h"
 #include "shapelib/mapshape.h"
 #ifdef ENABLE_OPENGL
@@ -35,18 +35,25 @@ Copyright_License {
 #endif
 
 #include <tchar.h>
+#include <stddef.h>
 #include <stdint.h>
 
 struct GeoPoint;
 
 class XShape {
-  static constexpr unsigned MAX_LINES = 32;
+  static constexpr unsigned MAX_LINES = XShapeStore::MAX_LINES;
 #ifdef ENABLE_OPENGL
-  static constexpr unsigned THINNING_LEVELS = 4;
+  static constexpr unsigned THINNING_LEVELS = XShapeStore::MAX_LEVELS;
 #endif
 
   GeoBounds bounds;
 
+  /**
+   * If true, then #points, #indices, #index_count and #label refer
+   * to a mapped #XShapeStore and are not owned by this object.
+   */
+  bool mapped;
+
   uint8_t type;
 
   /**
@@ -65,12 +72,12 @@ class XShape {
    * All points of all lines.
    */
 #ifdef ENABLE_OPENGL
-  ShapePoint *points;
+  const ShapePoint *points;
 
   /**
    * Indices of polygon triangles or lines with reduced number of vertices.
    */
-  uint16_t *indices[THINNING_LEVELS];
+  const uint16_t *indices[THINNING_LEVELS];
 
   /**
    * For polygons this will contain the total number of triangle vertices
@@ -78,7 +85,7 @@ class XShape {
    * For lines there will be an array of size num_lines for each thinning
    * level, which contains the number of points for each line.
    */
-  uint16_t *index_count[THINNING_LEVELS];
+  const uint16_t *index_count[THINNING_LEVELS];
 
   /**
    * The start offset in the #GLArrayBuffer (vertex buffer object).
@@ -86,15 +93,22 @@ class XShape {
    */
   mutable unsigned offset;
 #else // !ENABLE_OPENGL
-  GeoPoint *points;
+  const GeoPoint *points;
 #endif
 
-  AllocatedString<TCHAR> label;
+  const TCHAR *label;
 
 public:
   XShape(shapefileObj *shpfile, const GeoPoint &file_center, int i,
          int label_field=-1);
 
+  /**
+   * Construct an object which refers to a shape in a mapped
+   * #XShapeStore.  Its indices of all thinning levels have been
+   * built already.
+   */
+  explicit XShape(const XShapeStore::Shape &shape);
+
   XShape(const XShape &) = delete;
 
   ~XShape();
@@ -138,8 +152,15 @@ public:
   }
 
   const TCHAR *GetLabel() const {
-    return label.c_str();
+    return label;
   }
+
+  /**
+   * Estimate the memory occupied by this object, including the
+   * buffers it owns.
+   */
+  gcc_pure
+  size_t GetMemoryUsage() const;
 };
 
 #endif
@@ -0,0 +1,95 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#include "Topography/XShapeCache.hpp"
+#include "Topography/XShape.hpp"
+
+void
+XShapeCache::Retain(Item &item)
+{
+  assert(item.shape != nullptr);
+
+  const size_t item_size = item.shape->GetMemoryUsage();
+
+  const ScopeLock protect(mutex);
+  assert(!item.retained);
+
+  item.size = item_size;
+  item.retained = true;
+  lru.push_front(item);
+  size += item.size;
+
+  Trim();
+}
+
+bool
+XShapeCache::Acquire(Item &item)
+{
+  const ScopeLock protect(mutex);
+
+  if (!item.retained) {
+    assert(item.shape == nullptr);
+
+    ++misses;
+    return false;
+  }
+
+  Unlink(item);
+  ++hits;
+  return true;
+}
+
+void
+XShapeCache::Remove(Item &item)
+{
+  const ScopeLock protect(mutex);
+
+  if (item.retained)
+    Unlink(item);
+}
+
+void
+XShapeCache::Unlink(Item &item)
+{
+  assert(item.retained);
+  assert(size >= item.size);
+
+  lru.erase(lru.iterator_to(item));
+  item.retained = false;
+  size -= item.size;
+}
+
+void
+XShapeCache::Trim()
+{
+  while (size > budget) {
+    assert(!lru.empty());
+
+    Item &item = lru.back();
+    Unlink(item);
+
+    delete item.shape;
+    item.shape = nullptr;
+    ++evictions;
+  }
+}
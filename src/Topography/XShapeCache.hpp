@@ -0,0 +1,201 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#ifndef TOPOGRAPHY_XSHAPE_CACHE_HPP
+#define TOPOGRAPHY_XSHAPE_CACHE_HPP
+
+#include "Thread/Mutex.hpp"
+
+#include <boost/intrusive/list.hpp>
+
+#include <assert.h>
+#include <stddef.h>
+
+class XShape;
+
+/**
+ * Keeps shapes in memory after they have left the cache bounds of
+ * their #TopographyFile, so zooming out and back in or flying along
+ * the edge of the cache bounds does not load and triangulate the
+ * same shapes again.  The least recently used shapes are deleted when
+ * the byte budget is exceeded.  One instance is shared by all files
+ * of a #TopographyStore, whose files may be updated concurrently.
+ *
+ * All methods are thread-safe.
+ */
+class XShapeCache {
+public:
+  /**
+   * A slot of a #TopographyFile which may hold a shape.
+   */
+  struct Item
+    : boost::intrusive::list_base_hook<boost::intrusive::link_mode<boost::intrusive::normal_link>> {
+    /**
+     * While the item is retained, this attribute is protected by the
+     * cache's mutex, because the cache may delete the shape.
+     */
+    const XShape *shape;
+
+    /**
+     * The size accounted for this shape while it is retained.
+     */
+    size_t size;
+
+    /**
+     * Is this item in the LRU list (i.e. loaded, but outside of the
+     * cache bounds)?  Protected by the cache's mutex.
+     */
+    bool retained;
+
+    Item():shape(nullptr), size(0), retained(false) {}
+    Item(const XShape *_shape):shape(_shape), size(0), retained(false) {}
+
+    /* only the shape pointer is copied; the copy is never in a
+       list */
+    Item(const Item &other)
+      :shape(other.shape), size(0), retained(false) {
+      assert(!other.retained);
+    }
+
+    Item &operator=(const Item &other) {
+      assert(!retained);
+      assert(!other.retained);
+
+      shape = other.shape;
+      return *this;
+    }
+  };
+
+private:
+  typedef boost::intrusive::list<Item,
+                                 boost::intrusive::constant_time_size<false>> ItemList;
+
+  /**
+   * Protects all following attributes and the items in #lru.
+   */
+  mutable Mutex mutex;
+
+  /**
+   * The retained items, the most recently used first.
+   */
+  ItemList lru;
+
+  size_t budget;
+
+  /**
+   * The total size of all retained shapes.
+   */
+  size_t size = 0;
+
+  unsigned hits = 0, misses = 0, evictions = 0;
+
+public:
+  explicit XShapeCache(size_t _budget):budget(_budget) {}
+
+  ~XShapeCache() {
+    assert(lru.empty());
+  }
+
+  XShapeCache(const XShapeCache &) = delete;
+  XShapeCache &operator=(const XShapeCache &) = delete;
+
+  size_t GetBudget() const {
+    const ScopeLock protect(mutex);
+    return budget;
+  }
+
+  /**
+   * Change the byte budget; shapes are evicted if the new budget is
+   * exceeded.  Zero disables the cache.
+   */
+  void SetBudget(size_t _budget) {
+    const ScopeLock protect(mutex);
+    budget = _budget;
+    Trim();
+  }
+
+  size_t GetSize() const {
+    const ScopeLock protect(mutex);
+    return size;
+  }
+
+  /**
+   * The number of shapes which were found in the cache when they
+   * entered the cache bounds again.
+   */
+  unsigned GetHits() const {
+    const ScopeLock protect(mutex);
+    return hits;
+  }
+
+  /**
+   * The number of shapes which had to be loaded.
+   */
+  unsigned GetMisses() const {
+    const ScopeLock protect(mutex);
+    return misses;
+  }
+
+  unsigned GetEvictions() const {
+    const ScopeLock protect(mutex);
+    return evictions;
+  }
+
+  void ResetCounters() {
+    const ScopeLock protect(mutex);
+    hits = misses = evictions = 0;
+  }
+
+  /**
+   * The shape of this item has left the cache bounds.  The caller
+   * must ensure that it is no longer being rendered.  The item may be
+   * evicted (and its shape deleted) right away.
+   */
+  void Retain(Item &item);
+
+  /**
+   * The item has entered the cache bounds.  If its shape is still
+   * retained, take it out of the LRU list and count a hit; otherwise
+   * count a miss, and the caller must load the shape.
+   *
+   * @return true if the shape is available
+   */
+  bool Acquire(Item &item);
+
+  /**
+   * Take the item out of the LRU list without counting (e.g. before
+   * its file is discarded), if it is retained.  The shape is not
+   * deleted.
+   */
+  void Remove(Item &item);
+
+private:
+  void Unlink(Item &item);
+
+  /**
+   * Delete the least recently used shapes until the budget is met.
+   */
+  void Trim();
+};
+
+#endif
@@ -0,0 +1,529 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#include "Topography/XShapeStore.hpp"
+#include "Topography/XShape.hpp"
+#include "OS/FileMapping.hpp"
+#include "shapelib/mapserver.h"
+
+#include <algorithm>
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+/**
+ * Determine the grid cell (row or column) of a position.
+ *
+ * @param delta the distance from the grid origin
+ * @param extent the size of the grid
+ */
+gcc_const
+static unsigned
+ToCell(double delta, double extent, unsigned n)
+{
+  if (!(extent > 0) || !(delta > 0))
+    return 0;
+
+  const double cell = delta / extent * n;
+  return cell < n ? unsigned(cell) : n - 1;
+}
+
+static GeoBounds
+ImportBounds(double west, double north, double east, double south)
+{
+  return GeoBounds(GeoPoint(Angle::Native(west), Angle::Native(north)),
+                   GeoPoint(Angle::Native(east), Angle::Native(south)));
+}
+
+XShapeStore::XShapeStore()
+  :payload(nullptr), payload_size(0), entries(nullptr), num_shapes(0),
+   grid_cells(nullptr), grid_items(nullptr),
+   grid_width(0), grid_height(0), num_grid_items(0),
+   grid_bounds(GeoBounds::Invalid()), center(GeoPoint::Invalid())
+{
+  std::fill_n(min_distance, MAX_LEVELS, 0.f);
+}
+
+XShapeStore::~XShapeStore() = default;
+
+bool
+XShapeStore::Open(std::unique_ptr<FileMapping> &&_mapping, size_t offset)
+{
+  Close();
+
+  assert(_mapping);
+  assert(!_mapping->error());
+  assert(offset <= _mapping->size());
+
+  /* the writer has padded the payload to the file alignment */
+  offset = (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+  if (offset > _mapping->size())
+    return false;
+
+  const uint8_t *p = (const uint8_t *)_mapping->at(offset);
+  const size_t size = _mapping->size() - offset;
+
+  if (size < sizeof(Footer) || (uintptr_t)p % ALIGNMENT != 0)
+    return false;
+
+  Footer footer;
+  memcpy(&footer, p + size - sizeof(footer), sizeof(footer));
+  const size_t body_size = size - sizeof(footer);
+  if (footer.magic != MAGIC || footer.version != VERSION ||
+      footer.point_format != POINT_FORMAT ||
+      footer.tchar_size != sizeof(TCHAR) ||
+      footer.entries_offset % alignof(Entry) != 0 ||
+      footer.entries_offset > body_size ||
+      footer.num_shapes > (body_size - footer.entries_offset)
+      / sizeof(Entry))
+    return false;
+
+  const size_t num_cells = size_t(footer.grid_width) * footer.grid_height;
+  if (num_cells == 0 ||
+      footer.grid_offset % alignof(uint32_t) != 0 ||
+      footer.grid_offset > body_size ||
+      num_cells + 1 + footer.num_grid_items >
+      (body_size - footer.grid_offset) / sizeof(uint32_t))
+    return false;
+
+  const uint32_t *cells = (const uint32_t *)(p + footer.grid_offset);
+  if (cells[0] != 0 || cells[num_cells] != footer.num_grid_items)
+    return false;
+
+  for (size_t i = 0; i < num_cells; ++i)
+    if (cells[i] > cells[i + 1])
+      return false;
+
+  mapping = std::move(_mapping);
+  payload = p;
+  payload_size = footer.entries_offset;
+  entries = (const Entry *)(p + footer.entries_offset);
+  num_shapes = footer.num_shapes;
+  grid_cells = cells;
+  grid_items = cells + num_cells + 1;
+  grid_width = footer.grid_width;
+  grid_height = footer.grid_height;
+  num_grid_items = footer.num_grid_items;
+  grid_bounds = ImportBounds(footer.grid_west, footer.grid_north,
+                             footer.grid_east, footer.grid_south);
+  center = GeoPoint(Angle::Native(footer.center_longitude),
+                    Angle::Native(footer.center_latitude));
+  std::copy_n(footer.min_distance, MAX_LEVELS, min_distance);
+  return true;
+}
+
+void
+XShapeStore::Close()
+{
+  mapping.reset();
+  payload = nullptr;
+  payload_size = 0;
+  entries = nullptr;
+  num_shapes = 0;
+  grid_cells = grid_items = nullptr;
+  grid_width = grid_height = num_grid_items = 0;
+}
+
+bool
+XShapeStore::GetCellRange(const GeoBounds &rect,
+                          unsigned &x0, unsigned &y0,
+                          unsigned &x1, unsigned &y1) const
+{
+  assert(IsDefined());
+
+  if (!grid_bounds.Overlaps(rect))
+    return false;
+
+  const double west = grid_bounds.GetWest().Native();
+  const double north = grid_bounds.GetNorth().Native();
+  const double width = grid_bounds.GetEast().Native() - west;
+  const double height = north - grid_bounds.GetSouth().Native();
+
+  x0 = ToCell(rect.GetWest().Native() - west, width, grid_width);
+  x1 = ToCell(rect.GetEast().Native() - west, width, grid_width);
+  if (x0 > x1) {
+    /* crosses the date line */
+    x0 = 0;
+    x1 = grid_width - 1;
+  }
+
+  y0 = ToCell(north - rect.GetNorth().Native(), height, grid_height);
+  y1 = ToCell(north - rect.GetSouth().Native(), height, grid_height);
+  return true;
+}
+
+GeoBounds
+XShapeStore::GetBounds(unsigned i) const
+{
+  assert(i < num_shapes);
+
+  const Entry &entry = entries[i];
+  return ImportBounds(entry.west, entry.north, entry.east, entry.south);
+}
+
+const void *
+XShapeStore::GetSection(uint32_t offset, size_t size, size_t align) const
+{
+  if (offset == NONE || offset % align != 0 || offset > payload_size ||
+      size > payload_size - offset)
+    return nullptr;
+
+  return payload + offset;
+}
+
+const uint16_t *
+XShapeStore::GetIndexBlock(uint32_t offset, const Shape &shape,
+                           unsigned num_points) const
+{
+  const unsigned num_counts = shape.type == MS_SHAPE_LINE
+    ? shape.num_lines
+    : 1;
+
+  /* the counts and the indices are one section */
+  const uint16_t *count = (const uint16_t *)
+    GetSection(offset, num_counts * sizeof(uint16_t), alignof(uint16_t));
+  if (count == nullptr)
+    return nullptr;
+
+  size_t num_indices = 0;
+  for (unsigned i = 0; i < num_counts; ++i)
+    num_indices += count[i];
+
+  const uint16_t *indices = (const uint16_t *)
+    GetSection(offset, (num_counts + num_indices) * sizeof(uint16_t),
+               alignof(uint16_t));
+  if (indices == nullptr)
+    return nullptr;
+
+  indices += num_counts;
+  for (size_t i = 0; i < num_indices; ++i)
+    if (indices[i] >= num_points)
+      return nullptr;
+
+  return count;
+}
+
+bool
+XShapeStore::GetShape(unsigned i, Shape &shape) const
+{
+  assert(IsDefined());
+
+  if (i >= num_shapes)
+    return false;
+
+  const Entry &entry = entries[i];
+  if (entry.num_lines == 0 || entry.num_lines > MAX_LINES)
+    return false;
+
+  shape.bounds = GetBounds(i);
+  if (!shape.bounds.Check())
+    return false;
+
+  shape.type = entry.type;
+  shape.num_lines = entry.num_lines;
+
+  shape.lines = (const uint16_t *)
+    GetSection(entry.lines_offset, entry.num_lines * sizeof(uint16_t),
+               alignof(uint16_t));
+  if (shape.lines == nullptr)
+    return false;
+
+  unsigned num_points = 0;
+  for (unsigned l = 0; l < shape.num_lines; ++l)
+    num_points += shape.lines[l];
+
+  shape.points = (const Point *)
+    GetSection(entry.points_offset, num_points * sizeof(Point),
+               alignof(Point));
+  if (shape.points == nullptr)
+    return false;
+
+  for (unsigned level = 0; level < MAX_LEVELS; ++level) {
+    if (entry.index_offset[level] == NONE) {
+#ifdef ENABLE_OPENGL
+      /* polygons can't be drawn without triangles */
+      if (shape.type == MS_SHAPE_POLYGON)
+        return false;
+#endif
+
+      shape.index_count[level] = nullptr;
+      continue;
+    }
+
+    shape.index_count[level] =
+      GetIndexBlock(entry.index_offset[level], shape, num_points);
+    if (shape.index_count[level] == nullptr)
+      return false;
+  }
+
+  if (entry.label_offset != NONE) {
+    shape.label = (const TCHAR *)
+      GetSection(entry.label_offset, sizeof(TCHAR), alignof(TCHAR));
+    if (shape.label == nullptr)
+      return false;
+
+    /* the label must be null-terminated within the payload */
+    const TCHAR *end = (const TCHAR *)(payload + payload_size);
+    if (std::find(shape.label, end, TCHAR(0)) == end)
+      return false;
+  } else
+    shape.label = nullptr;
+
+  return true;
+}
+
+XShapeStoreWriter::XShapeStoreWriter(FILE *_file, const GeoPoint &center,
+                                     const float *min_distance)
+  :file(_file)
+{
+  memset(&footer, 0, sizeof(footer));
+  footer.magic = XShapeStore::MAGIC;
+  footer.version = XShapeStore::VERSION;
+  footer.point_format = XShapeStore::POINT_FORMAT;
+  footer.tchar_size = sizeof(TCHAR);
+  footer.center_longitude = center.longitude.Native();
+  footer.center_latitude = center.latitude.Native();
+  if (min_distance != nullptr)
+    std::copy_n(min_distance, XShapeStore::MAX_LEVELS, footer.min_distance);
+
+  /* align the payload within the file (and thus within the
+     mapping) */
+  static constexpr uint8_t zero[XShapeStore::ALIGNMENT] = {};
+  const long start = ftell(file);
+  const unsigned padding = start >= 0
+    ? (XShapeStore::ALIGNMENT - start % XShapeStore::ALIGNMENT)
+    % XShapeStore::ALIGNMENT
+    : 0;
+  if (start < 0 ||
+      (padding > 0 && fwrite(zero, 1, padding, file) != padding))
+    failed = true;
+}
+
+bool
+XShapeStoreWriter::Pad(size_t align)
+{
+  static constexpr uint8_t zero[XShapeStore::ALIGNMENT] = {};
+  assert(align <= sizeof(zero));
+
+  const unsigned padding = (align - position % align) % align;
+  if (padding > 0 && fwrite(zero, 1, padding, file) != padding)
+    return false;
+
+  position += padding;
+  return true;
+}
+
+uint32_t
+XShapeStoreWriter::Write(const void *data, size_t size, size_t align)
+{
+  if (failed ||
+      size + XShapeStore::ALIGNMENT >= XShapeStore::NONE - position ||
+      !Pad(align) ||
+      (size > 0 && fwrite(data, 1, size, file) != size)) {
+    failed = true;
+    return XShapeStore::NONE;
+  }
+
+  const uint32_t offset = position;
+  position += size;
+  return offset;
+}
+
+void
+XShapeStoreWriter::Add(const XShape &shape)
+{
+  XShapeStore::Entry entry;
+  memset(&entry, 0, sizeof(entry));
+  entry.points_offset = entry.lines_offset = entry.label_offset =
+    XShapeStore::NONE;
+  for (auto &i : entry.index_offset)
+    i = XShapeStore::NONE;
+
+  /* shapes with malformed bounds or of an unsupported type don't
+     have points; they are stored as empty entries */
+  const auto lines = shape.GetPoints() != nullptr
+    ? shape.GetLines()
+    : ConstBuffer<uint16_t>(nullptr);
+  if (lines.IsEmpty()) {
+    entries.push_back(entry);
+    return;
+  }
+
+  const GeoBounds &bounds = shape.get_bounds();
+  entry.west = bounds.GetWest().Native();
+  entry.north = bounds.GetNorth().Native();
+  entry.east = bounds.GetEast().Native();
+  entry.south = bounds.GetSouth().Native();
+  entry.type = shape.get_type();
+  entry.num_lines = lines.size;
+
+  unsigned num_points = 0;
+  for (auto n : lines)
+    num_points += n;
+
+  entry.lines_offset = Write(lines.data, lines.size * sizeof(uint16_t),
+                             alignof(uint16_t));
+  entry.points_offset = Write(shape.GetPoints(),
+                              num_points * sizeof(XShapeStore::Point),
+                              alignof(XShapeStore::Point));
+
+#ifdef ENABLE_OPENGL
+  /* only lines and polygons have indices */
+  const bool has_indices = entry.type == MS_SHAPE_LINE ||
+    entry.type == MS_SHAPE_POLYGON;
+  for (unsigned level = 0; has_indices && level < XShapeStore::MAX_LEVELS;
+       ++level) {
+    const uint16_t *count;
+    const uint16_t *indices =
+      shape.GetIndices(level, footer.min_distance[level], count);
+    if (indices == nullptr)
+      continue;
+
+    const unsigned num_counts = entry.type == MS_SHAPE_LINE
+      ? entry.num_lines
+      : 1;
+    assert(indices == count + num_counts);
+
+    unsigned num_indices = 0;
+    for (unsigned i = 0; i < num_counts; ++i)
+      num_indices += count[i];
+
+    entry.index_offset[level] =
+      Write(count, (num_counts + num_indices) * sizeof(uint16_t),
+            alignof(uint16_t));
+  }
+#endif
+
+  const TCHAR *label = shape.GetLabel();
+  if (label != nullptr)
+    entry.label_offset = Write(label, (_tcslen(label) + 1) * sizeof(TCHAR),
+                               alignof(TCHAR));
+
+  entries.push_back(entry);
+}
+
+/**
+ * Invoke the function with each grid cell overlapped by each
+ * non-empty shape.
+ */
+template<typename F>
+static void
+VisitCells(const std::vector<XShapeStore::Entry> &entries,
+           const XShapeStore::Footer &footer, F &&f)
+{
+  const double width = footer.grid_east - footer.grid_west;
+  const double height = footer.grid_north - footer.grid_south;
+
+  for (unsigned i = 0; i < entries.size(); ++i) {
+    const auto &entry = entries[i];
+    if (entry.num_lines == 0)
+      continue;
+
+    unsigned x0 = ToCell(entry.west - footer.grid_west, width,
+                         footer.grid_width);
+    unsigned x1 = ToCell(entry.east - footer.grid_west, width,
+                         footer.grid_width);
+    if (x0 > x1) {
+      /* crosses the date line */
+      x0 = 0;
+      x1 = footer.grid_width - 1;
+    }
+
+    const unsigned y0 = ToCell(footer.grid_north - entry.north, height,
+                               footer.grid_height);
+    const unsigned y1 = ToCell(footer.grid_north - entry.south, height,
+                               footer.grid_height);
+
+    for (unsigned y = y0; y <= y1; ++y)
+      for (unsigned x = x0; x <= x1; ++x)
+        f(y * footer.grid_width + x, i);
+  }
+}
+
+bool
+XShapeStoreWriter::Finish()
+{
+  if (failed || entries.empty())
+    return false;
+
+  footer.num_shapes = entries.size();
+  footer.entries_offset =
+    Write(&entries.front(), entries.size() * sizeof(entries.front()),
+          alignof(XShapeStore::Entry));
+  if (failed)
+    return false;
+
+  /* the grid covers all non-empty shapes, with about four shapes per
+     cell */
+  unsigned num_indexed = 0;
+  double west = 0, north = 0, east = 0, south = 0;
+  for (const auto &entry : entries) {
+    if (entry.num_lines == 0)
+      continue;
+
+    if (num_indexed++ == 0) {
+      west = entry.west;
+      north = entry.north;
+      east = entry.east;
+      south = entry.south;
+    } else {
+      west = std::min(west, entry.west);
+      north = std::max(north, entry.north);
+      east = std::max(east, entry.east);
+      south = std::min(south, entry.south);
+    }
+  }
+
+  const unsigned grid_size =
+    std::max(std::min(unsigned(sqrt(num_indexed / 4.)), 256u), 1u);
+  footer.grid_west = west;
+  footer.grid_north = north;
+  footer.grid_east = east;
+  footer.grid_south = south;
+  footer.grid_width = footer.grid_height = grid_size;
+
+  std::vector<uint32_t> cells(grid_size * grid_size + 1, 0);
+  VisitCells(entries, footer, [&cells](unsigned cell, unsigned){
+      ++cells[cell + 1];
+    });
+
+  for (unsigned i = 1; i < cells.size(); ++i)
+    cells[i] += cells[i - 1];
+
+  std::vector<uint32_t> items(cells.back());
+  std::vector<uint32_t> cursor(cells.begin(), cells.end() - 1);
+  VisitCells(entries, footer, [&items, &cursor](unsigned cell, unsigned i){
+      items[cursor[cell]++] = i;
+    });
+
+  footer.grid_offset = Write(&cells.front(),
+                             cells.size() * sizeof(cells.front()),
+                             alignof(uint32_t));
+  footer.num_grid_items = items.size();
+  if (!items.empty())
+    Write(&items.front(), items.size() * sizeof(items.front()),
+          alignof(uint32_t));
+
+  return !failed && fwrite(&footer, sizeof(footer), 1, file) == 1;
+}
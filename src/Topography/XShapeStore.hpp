@@ -0,0 +1,324 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#ifndef TOPOGRAPHY_XSHAPE_STORE_HPP
+#define TOPOGRAPHY_XSHAPE_STORE_HPP
+
+#include "Geo/GeoBounds.hpp"
+#include "Compiler.h"
+
+#ifdef ENABLE_OPENGL
+#include "Topography/XShapePoint.hpp"
+#endif
+
+#include <memory>
+#include <vector>
+
+#include <tchar.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+class FileMapping;
+class XShape;
+
+/**
+ * A file containing all shapes of one topography layer in the form
+ * #XShape uses at runtime: converted points, the triangulated and
+ * thinned indices of all thinning levels (OpenGL only) and the
+ * labels.  It is generated once from the shapefile and is later
+ * mapped into memory, which allows #XShape to refer to the mapped
+ * pages instead of parsing and triangulating the shapes on demand.
+ *
+ * File layout (after the #FileCache header, padded to 8 bytes): the
+ * data of all shapes, the shape index (one #Entry per shape), a
+ * uniform grid which maps cells to the shapes overlapping them, and
+ * the #Footer.
+ */
+class XShapeStore {
+public:
+  static constexpr uint32_t MAGIC = 0x58535354;
+  static constexpr uint32_t VERSION = 1;
+
+  static constexpr unsigned MAX_LINES = 32;
+  static constexpr unsigned MAX_LEVELS = 4;
+
+  /**
+   * Marks an absent section in #Entry.
+   */
+  static constexpr uint32_t NONE = 0xffffffff;
+
+  /**
+   * The alignment of the payload and of all sections within.
+   */
+  static constexpr size_t ALIGNMENT = 8;
+
+#ifdef ENABLE_OPENGL
+  typedef ShapePoint Point;
+  static constexpr uint8_t POINT_FORMAT = 1;
+#else
+  typedef GeoPoint Point;
+  static constexpr uint8_t POINT_FORMAT = 2;
+#endif
+
+  struct Entry {
+    /**
+     * The bounds of the shape in radians.
+     */
+    double west, north, east, south;
+
+    /**
+     * Positions of the sections of this shape, relative to the start
+     * of the payload.  The index blocks use the #XShape layout: the
+     * number of points of each line (lines) or the number of
+     * triangle strip vertices (polygons), followed by the indices.
+     */
+    uint32_t points_offset, lines_offset;
+    uint32_t index_offset[MAX_LEVELS];
+    uint32_t label_offset;
+
+    uint8_t type;
+
+    /**
+     * The number of lines; zero if the shape is empty and was not
+     * added to the grid.
+     */
+    uint8_t num_lines;
+
+    uint16_t reserved;
+  };
+
+  struct Footer {
+    uint32_t magic;
+    uint32_t version;
+
+    uint8_t point_format;
+    uint8_t tchar_size;
+    uint8_t reserved[2];
+
+    uint32_t num_shapes;
+
+    /**
+     * The center the #ShapePoint coordinates are relative to
+     * (radians).
+     */
+    double center_longitude, center_latitude;
+
+    /**
+     * The minimum point distance the indices of each thinning level
+     * were built for.
+     */
+    float min_distance[MAX_LEVELS];
+
+    /**
+     * The area covered by the grid (radians).
+     */
+    double grid_west, grid_north, grid_east, grid_south;
+
+    uint16_t grid_width, grid_height;
+
+    /**
+     * Position of the #Entry array, relative to the start of the
+     * payload.
+     */
+    uint32_t entries_offset;
+
+    /**
+     * Position of the grid: the start of each cell in the item list
+     * (grid_width * grid_height + 1 values), followed by the item
+     * list (the shape numbers).
+     */
+    uint32_t grid_offset;
+    uint32_t num_grid_items;
+  };
+
+  /**
+   * A validated view of one shape.
+   */
+  struct Shape {
+    GeoBounds bounds;
+    uint8_t type, num_lines;
+    const uint16_t *lines;
+    const Point *points;
+
+    /**
+     * The index blocks of all thinning levels; nullptr if there are
+     * none.
+     */
+    const uint16_t *index_count[MAX_LEVELS];
+
+    const TCHAR *label;
+  };
+
+private:
+  std::unique_ptr<FileMapping> mapping;
+
+  const uint8_t *payload;
+  size_t payload_size;
+
+  const Entry *entries;
+  unsigned num_shapes;
+
+  const uint32_t *grid_cells, *grid_items;
+  unsigned grid_width, grid_height, num_grid_items;
+  GeoBounds grid_bounds;
+
+  GeoPoint center;
+  float min_distance[MAX_LEVELS];
+
+public:
+  XShapeStore();
+  ~XShapeStore();
+
+  XShapeStore(const XShapeStore &) = delete;
+  XShapeStore &operator=(const XShapeStore &) = delete;
+
+  bool IsDefined() const {
+    return entries != nullptr;
+  }
+
+  unsigned GetShapeCount() const {
+    return num_shapes;
+  }
+
+  const GeoPoint &GetCenter() const {
+    return center;
+  }
+
+  float GetMinimumPointDistance(unsigned level) const {
+    return min_distance[level];
+  }
+
+  /**
+   * Take over the specified mapping and validate its structure.  The
+   * shapes themselves are validated by GetShape().
+   *
+   * @param offset the position of the payload within the mapping
+   * (before the alignment padding)
+   * @return false if the file is malformed
+   */
+  bool Open(std::unique_ptr<FileMapping> &&_mapping, size_t offset);
+
+  void Close();
+
+  /**
+   * Invoke the visitor with the number of each shape whose bounds
+   * overlap the given rectangle.  A shape may be visited more than
+   * once.
+   */
+  template<typename V>
+  void VisitShapes(const GeoBounds &rect, V &&visitor) const {
+    unsigned x0, y0, x1, y1;
+    if (!GetCellRange(rect, x0, y0, x1, y1))
+      return;
+
+    for (unsigned y = y0; y <= y1; ++y) {
+      for (unsigned x = x0; x <= x1; ++x) {
+        const unsigned cell = y * grid_width + x;
+        for (unsigned j = grid_cells[cell], end = grid_cells[cell + 1];
+             j < end; ++j) {
+          const unsigned i = grid_items[j];
+          if (i < num_shapes && GetBounds(i).Overlaps(rect))
+            visitor(i);
+        }
+      }
+    }
+  }
+
+  gcc_pure
+  GeoBounds GetBounds(unsigned i) const;
+
+  /**
+   * Resolve and validate the specified shape.
+   *
+   * @return false if the shape is empty or malformed
+   */
+  bool GetShape(unsigned i, Shape &shape) const;
+
+private:
+  bool GetCellRange(const GeoBounds &rect,
+                    unsigned &x0, unsigned &y0,
+                    unsigned &x1, unsigned &y1) const;
+
+  gcc_pure
+  const void *GetSection(uint32_t offset, size_t size, size_t align) const;
+
+  gcc_pure
+  const uint16_t *GetIndexBlock(uint32_t offset, const Shape &shape,
+                                unsigned num_points) const;
+};
+
+/**
+ * Writes a #XShapeStore file.
+ */
+class XShapeStoreWriter {
+  FILE *const file;
+
+  std::vector<XShapeStore::Entry> entries;
+
+  XShapeStore::Footer footer;
+
+  uint32_t position = 0;
+
+  bool failed = false;
+
+public:
+  /**
+   * Write the alignment padding.
+   *
+   * @param center the center the #ShapePoint coordinates are
+   * relative to
+   * @param min_distance the minimum point distance of each thinning
+   * level; the indices of all levels are built and stored (OpenGL
+   * only)
+   */
+  XShapeStoreWriter(FILE *_file, const GeoPoint &center,
+                    const float *min_distance);
+
+  /**
+   * Append a shape.  Shapes must be added in the order of the
+   * shapefile.
+   */
+  void Add(const XShape &shape);
+
+  /**
+   * Write the shape index, the grid and the footer.  The caller is
+   * responsible for closing the file.
+   *
+   * @return false on error
+   */
+  bool Finish();
+
+private:
+  bool Pad(size_t align);
+
+  /**
+   * Write a section, aligned to the given alignment.
+   *
+   * @return the position of the section or XShapeStore::NONE on
+   * error
+   */
+  uint32_t Write(const void *data, size_t size, size_t align);
+};
+
+#endif
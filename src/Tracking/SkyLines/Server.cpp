@@ -28,12 +28,36 @@ Copyright_License {
 #include "OS/ByteOrder.hpp"
 #include "Util/CRC.hpp"
 
+#include <algorithm>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <string.h>
+#include <errno.h>
+#endif
+
 namespace SkyLinesTracking {
 
 Server::Server(boost::asio::io_service &io_service,
-               boost::asio::ip::udp::endpoint endpoint)
-  :socket(io_service, endpoint)
+               boost::asio::ip::udp::endpoint endpoint,
+               bool reuse_port)
+  :socket(io_service, endpoint.protocol())
 {
+  if (reuse_port) {
+#ifdef SO_REUSEPORT
+    const int value = 1;
+    if (setsockopt(socket.native_handle(), SOL_SOCKET, SO_REUSEPORT,
+                   &value, sizeof(value)) < 0)
+      throw boost::system::system_error(errno,
+                                        boost::system::system_category(),
+                                        "Failed to set SO_REUSEPORT");
+#else
+    throw std::runtime_error("SO_REUSEPORT not supported");
+#endif
+  }
+
+  socket.bind(endpoint);
+
   AsyncReceive();
 }
 
@@ -58,6 +82,54 @@ Server::SendBuffer(const boost::asio::ip::udp::endpoint &endpoint,
   }
 }
 
+void
+Server::SendBuffers(const Datagram *datagrams, size_t n)
+{
+#ifdef __linux__
+  static constexpr size_t MAX_BATCH = 64;
+
+  struct mmsghdr msgs[MAX_BATCH];
+  struct iovec iovecs[MAX_BATCH];
+
+  while (n > 0) {
+    const size_t batch = std::min(n, MAX_BATCH);
+
+    for (size_t i = 0; i < batch; ++i) {
+      const auto &d = datagrams[i];
+
+      iovecs[i].iov_base =
+        const_cast<void *>(boost::asio::buffer_cast<const void *>(d.data));
+      iovecs[i].iov_len = boost::asio::buffer_size(d.data);
+
+      auto &h = msgs[i].msg_hdr;
+      h.msg_name = const_cast<void *>((const void *)d.endpoint.data());
+      h.msg_namelen = d.endpoint.size();
+      h.msg_iov = &iovecs[i];
+      h.msg_iovlen = 1;
+      h.msg_control = nullptr;
+      h.msg_controllen = 0;
+      h.msg_flags = 0;
+    }
+
+    int result = sendmmsg(socket.native_handle(), msgs, batch, 0);
+    if (result <= 0) {
+      /* the first datagram has failed; report and skip it, and try
+         again with the rest */
+      OnSendError(datagrams->endpoint,
+                  boost::system::system_error(errno,
+                                              boost::system::system_category()));
+      result = 1;
+    }
+
+    datagrams += result;
+    n -= result;
+  }
+#else
+  for (size_t i = 0; i < n; ++i)
+    SendBuffer(datagrams[i].endpoint, datagrams[i].data);
+#endif
+}
+
 void
 Server::OnPing(const Client &client, unsigned id)
 {
@@ -169,11 +241,72 @@ Server::OnDatagramReceived(Client &&client,
   }
 }
 
+#ifdef __linux__
+
+inline bool
+Server::ReceiveBatch()
+{
+  struct mmsghdr msgs[RECEIVE_BATCH];
+  struct iovec iovecs[RECEIVE_BATCH];
+  struct sockaddr_storage addresses[RECEIVE_BATCH];
+
+  for (unsigned i = 0; i < RECEIVE_BATCH; ++i) {
+    iovecs[i].iov_base = buffers[i];
+    iovecs[i].iov_len = sizeof(buffers[i]);
+
+    auto &h = msgs[i].msg_hdr;
+    h.msg_name = &addresses[i];
+    h.msg_iov = &iovecs[i];
+    h.msg_iovlen = 1;
+    h.msg_control = nullptr;
+    h.msg_controllen = 0;
+    h.msg_flags = 0;
+  }
+
+  /* limit the number of rounds, to give other handlers in this
+     io_service a chance to run */
+  for (unsigned round = 0; round < 8; ++round) {
+    for (unsigned i = 0; i < RECEIVE_BATCH; ++i)
+      msgs[i].msg_hdr.msg_namelen = sizeof(addresses[i]);
+
+    int n = recvmmsg(socket.native_handle(), msgs, RECEIVE_BATCH,
+                     MSG_DONTWAIT, nullptr);
+    if (n < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+        break;
+
+      const int e = errno;
+      socket.close();
+      OnError(boost::system::system_error(e,
+                                          boost::system::system_category()));
+      return false;
+    }
+
+    for (int i = 0; i < n; ++i) {
+      const auto &h = msgs[i].msg_hdr;
+      if (h.msg_namelen > sizeof(addresses[i]))
+        continue;
+
+      Client client;
+      memcpy(client.endpoint.data(), h.msg_name, h.msg_namelen);
+      client.endpoint.resize(h.msg_namelen);
+
+      OnDatagramReceived(std::move(client), buffers[i], msgs[i].msg_len);
+    }
+
+    if (unsigned(n) < RECEIVE_BATCH)
+      /* the socket is drained */
+      break;
+  }
+
+  return true;
+}
+
+#endif
+
 void
 Server::OnReceive(const boost::system::error_code &ec, size_t size)
 {
-  // TODO: use recvmmsg() on Linux
-
   if (ec) {
     if (ec == boost::asio::error::operation_aborted)
       return;
@@ -184,7 +317,14 @@ Server::OnReceive(const boost::system::error_code &ec, size_t size)
     return;
   }
 
+#ifdef __linux__
+  (void)size;
+
+  if (!ReceiveBatch())
+    return;
+#else
   OnDatagramReceived(std::move(client_buffer), buffer, size);
+#endif
 
   AsyncReceive();
 }
@@ -192,11 +332,20 @@ Server::OnReceive(const boost::system::error_code &ec, size_t size)
 void
 Server::AsyncReceive()
 {
+#ifdef __linux__
+  /* wait until the socket becomes readable, and then receive many
+     datagrams at once with recvmmsg() */
+  socket.async_receive(boost::asio::null_buffers(),
+                       std::bind(&Server::OnReceive, this,
+                                 std::placeholders::_1,
+                                 std::placeholders::_2));
+#else
   socket.async_receive_from(boost::asio::buffer(buffer, sizeof(buffer)),
                             client_buffer.endpoint,
                             std::bind(&Server::OnReceive, this,
                                       std::placeholders::_1,
                                       std::placeholders::_2));
+#endif
 }
 
 }
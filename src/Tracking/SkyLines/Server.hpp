@@ -43,7 +43,17 @@ namespace SkyLinesTracking {
 class Server {
   boost::asio::ip::udp::socket socket;
 
+#ifdef __linux__
+  /**
+   * The maximum number of datagrams received with one recvmmsg()
+   * call.
+   */
+  static constexpr unsigned RECEIVE_BATCH = 32;
+
+  uint8_t buffers[RECEIVE_BATCH][4096];
+#else
   uint8_t buffer[4096];
+#endif
 
 public:
   struct Client {
@@ -51,12 +61,28 @@ public:
     uint64_t key;
   };
 
+  /**
+   * An outgoing datagram for SendBuffers().
+   */
+  struct Datagram {
+    boost::asio::ip::udp::endpoint endpoint;
+    boost::asio::const_buffer data;
+  };
+
 private:
+#ifndef __linux__
   Client client_buffer;
+#endif
 
 public:
+  /**
+   * @param reuse_port set SO_REUSEPORT, to allow several instances
+   * (e.g. one per thread) to be bound to the same port; the kernel
+   * distributes incoming datagrams among them
+   */
   Server(boost::asio::io_service &io_service,
-         boost::asio::ip::udp::endpoint endpoint);
+         boost::asio::ip::udp::endpoint endpoint,
+         bool reuse_port=false);
 
   ~Server();
 
@@ -77,6 +103,12 @@ public:
   void SendBuffer(const boost::asio::ip::udp::endpoint &endpoint,
                   boost::asio::const_buffer data);
 
+  /**
+   * Send several datagrams at once.  On Linux, this uses sendmmsg(),
+   * which needs only one system call for the whole batch.
+   */
+  void SendBuffers(const Datagram *datagrams, size_t n);
+
   template<typename P>
   void SendPacket(const boost::asio::ip::udp::endpoint &endpoint,
                   const P &packet) {
@@ -88,6 +120,16 @@ private:
   void OnReceive(const boost::system::error_code &ec, size_t size);
   void AsyncReceive();
 
+#ifdef __linux__
+  /**
+   * Receive all pending datagrams with recvmmsg().
+   *
+   * @return false if the socket has failed (and OnError() has been
+   * called)
+   */
+  bool ReceiveBatch();
+#endif
+
 protected:
   virtual void OnPing(const Client &client, unsigned id);
 
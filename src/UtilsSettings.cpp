@@ -173,7 +173,7 @@ SettingsLeave(const UISettings &old_ui_settings)
   if (TopographyFileChanged) {
     main_window.SetTopography(nullptr);
     topography->Reset();
-    LoadConfiguredTopography(*topography, operation);
+    LoadConfiguredTopography(*topography, file_cache, operation);
     main_window.SetTopography(topography);
   }
 
@@ -185,7 +185,7 @@ SettingsLeave(const UISettings &old_ui_settings)
       glide_computer->ClearAirspaces();
 
     airspace_database.Clear();
-    ReadAirspace(airspace_database, terrain,
+    ReadAirspace(airspace_database, file_cache, terrain,
                  CommonInterface::GetComputerSettings().pressure,
                  operation);
   }
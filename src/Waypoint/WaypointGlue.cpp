@@ -34,6 +34,11 @@ Copyright_License {
 #include "OS/Path.hpp"
 #include "IO/MapFile.hpp"
 #include "IO/ZipArchive.hpp"
+#include "Thread/WorkStealingPool.hpp"
+
+#include <algorithm>
+#include <list>
+#include <vector>
 
 static bool
 LoadWaypointFile(Waypoints &waypoints, Path path,
@@ -52,34 +57,118 @@ LoadWaypointFile(Waypoints &waypoints, Path path,
 }
 
 static bool
-LoadWaypointFile(Waypoints &waypoints, Path path,
+LoadWaypointFile(Waypoints &waypoints, struct zzip_dir *dir, const char *path,
+                 WaypointFileType file_type,
                  WaypointOrigin origin,
                  const RasterTerrain *terrain, OperationEnvironment &operation)
 {
-  if (!ReadWaypointFile(path, waypoints,
+  if (!ReadWaypointFile(dir, path, file_type, waypoints,
                         WaypointFactory(origin, terrain),
                         operation)) {
-    LogFormat(_T("Failed to read waypoint file: %s"), path.c_str());
+    LogFormat("Failed to read waypoint file: %s", path);
     return false;
   }
 
   return true;
 }
 
-static bool
-LoadWaypointFile(Waypoints &waypoints, struct zzip_dir *dir, const char *path,
-                 WaypointFileType file_type,
-                 WaypointOrigin origin,
-                 const RasterTerrain *terrain, OperationEnvironment &operation)
+/**
+ * A waypoint file which is parsed by LoadWaypointFiles().
+ */
+struct WaypointFile {
+  const AllocatedPath path;
+  const WaypointFileType file_type;
+  const WaypointOrigin origin;
+
+  /**
+   * The waypoints of this file if it was parsed by a worker thread;
+   * they are merged into the destination afterwards.
+   */
+  Waypoints waypoints;
+
+  bool success = false;
+
+  WaypointFile(AllocatedPath &&_path, WaypointOrigin _origin)
+    :path(std::move(_path)), file_type(DetermineWaypointFileType(path)),
+     origin(_origin) {}
+
+  void Load(Waypoints &dest, const RasterTerrain *terrain,
+            OperationEnvironment &operation) {
+    success = LoadWaypointFile(dest, path, file_type, origin,
+                               terrain, operation);
+  }
+};
+
+/**
+ * Parses the first file directly into the destination and all
+ * others into their own #Waypoints object.
+ */
+class WaypointFileJob final : public TaskRunner::Job {
+  Waypoints &way_points;
+  const std::vector<WaypointFile *> &files;
+  const RasterTerrain *const terrain;
+
+public:
+  WaypointFileJob(Waypoints &_way_points,
+                  const std::vector<WaypointFile *> &_files,
+                  const RasterTerrain *_terrain)
+    :way_points(_way_points), files(_files), terrain(_terrain) {}
+
+  void RunTask(unsigned i) override {
+    /* progress can only be reported from the calling thread */
+    NullOperationEnvironment operation;
+
+    WaypointFile &file = *files[i];
+    file.Load(i == 0 ? way_points : file.waypoints, terrain, operation);
+  }
+};
+
+/**
+ * Move all waypoints from #src to #dest, preserving the order in
+ * which they were read.
+ */
+static void
+MergeWaypoints(Waypoints &dest, Waypoints &src)
 {
-  if (!ReadWaypointFile(dir, path, file_type, waypoints,
-                        WaypointFactory(origin, terrain),
-                        operation)) {
-    LogFormat("Failed to read waypoint file: %s", path);
-    return false;
+  std::vector<WaypointPtr> v(src.begin(), src.end());
+  src.Clear();
+
+  std::sort(v.begin(), v.end(),
+            [](const WaypointPtr &a, const WaypointPtr &b){
+              return a->id < b->id;
+            });
+
+  for (auto &i : v)
+    dest.Append(std::move(i));
+}
+
+/**
+ * Parse the given files in parallel (one thread per file) and append
+ * their waypoints to #way_points in the order of the list.
+ */
+static void
+LoadWaypointFiles(Waypoints &way_points, std::list<WaypointFile> &files,
+                  const RasterTerrain *terrain,
+                  OperationEnvironment &operation)
+{
+  std::vector<WaypointFile *> v;
+  for (auto &i : files)
+    v.push_back(&i);
+
+  const unsigned n_threads =
+    std::min<unsigned>(v.size(), WorkStealingPool::GetProcessorCount());
+  if (n_threads <= 1) {
+    for (auto *i : v)
+      i->Load(way_points, terrain, operation);
+    return;
   }
 
-  return true;
+  WaypointFileJob job(way_points, v, terrain);
+  WorkStealingPool pool(n_threads);
+  pool.Run(job, v.size());
+
+  for (auto i = std::next(v.begin()); i != v.end(); ++i)
+    MergeWaypoints(way_points, (*i)->waypoints);
 }
 
 bool
@@ -99,23 +188,27 @@ WaypointGlue::LoadWaypoints(Waypoints &way_points,
                    WaypointFileType::SEEYOU,
                    WaypointOrigin::USER, terrain, operation);
 
+  std::list<WaypointFile> files;
+
   // ### FIRST FILE ###
   auto path = Profile::GetPath(ProfileKeys::WaypointFile);
   if (!path.IsNull())
-    found |= LoadWaypointFile(way_points, path, WaypointOrigin::PRIMARY,
-                              terrain, operation);
+    files.emplace_back(std::move(path), WaypointOrigin::PRIMARY);
 
   // ### SECOND FILE ###
   path = Profile::GetPath(ProfileKeys::AdditionalWaypointFile);
   if (!path.IsNull())
-    found |= LoadWaypointFile(way_points, path, WaypointOrigin::ADDITIONAL,
-                              terrain, operation);
+    files.emplace_back(std::move(path), WaypointOrigin::ADDITIONAL);
 
   // ### WATCHED WAYPOINT/THIRD FILE ###
   path = Profile::GetPath(ProfileKeys::WatchedWaypointFile);
   if (!path.IsNull())
-    found |= LoadWaypointFile(way_points, path, WaypointOrigin::WATCHED,
-                              terrain, operation);
+    files.emplace_back(std::move(path), WaypointOrigin::WATCHED);
+
+  LoadWaypointFiles(way_points, files, terrain, operation);
+
+  for (const auto &i : files)
+    found |= i.success;
 
   // ### MAP/FOURTH FILE ###
 
@@ -0,0 +1,108 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+/*
+ * Benchmark for AirspaceRoute::Solve().  The aircraft glides towards
+ * a fixed destination through a dense set of random airspaces (see
+ * setup_airspaces()), and the route is solved once per second, like
+ * #RouteComputer does.
+ */
+
+#include "harness_airspace.hpp"
+#include "Engine/Route/AirspaceRoute.hpp"
+#include "Engine/Route/Config.hpp"
+#include "Engine/Airspace/Predicate/AirspacePredicate.hpp"
+#include "Engine/GlideSolvers/GlideSettings.hpp"
+#include "Engine/GlideSolvers/GlidePolar.hpp"
+#include "Geo/SpeedVector.hpp"
+#include "OS/Clock.hpp"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(int argc, char **argv)
+{
+  const unsigned n_airspaces = argc > 1 ? atoi(argv[1]) : 200;
+
+  const GeoPoint center(Angle::Degrees(7), Angle::Degrees(46));
+
+  srand(0);
+  Airspaces airspaces;
+  setup_airspaces(airspaces, center, n_airspaces);
+
+  GlideSettings settings;
+  settings.SetDefaults();
+  RoutePlannerConfig config;
+  config.SetDefaults();
+  config.mode = RoutePlannerConfig::Mode::AIRSPACE;
+
+  const GlidePolar polar(1);
+  const SpeedVector wind(Angle::Degrees(0), 0);
+
+  AirspaceRoute route;
+  const AirspacePredicateTrue predicate;
+
+  const AGeoPoint destination(GeoPoint(center.longitude + Angle::Degrees(0.5),
+                                       center.latitude + Angle::Degrees(0.4)),
+                              500);
+  const GeoPoint start(center.longitude - Angle::Degrees(0.5),
+                       center.latitude - Angle::Degrees(0.4));
+
+  /* 40 m/s towards the destination, sinking with 0.8 m/s */
+  const double distance = start.Distance(destination);
+  const unsigned duration = unsigned(distance / 40);
+
+  unsigned n_solved = 0, n_points = 0;
+  unsigned long checksum = 0;
+
+  const uint64_t begin = MonotonicClockUS();
+
+  for (unsigned t = 0; t < duration; ++t) {
+    const AGeoPoint aircraft(start.Interpolate(destination,
+                                               t / double(duration)),
+                             3000 - 0.8 * t);
+
+    route.UpdatePolar(settings, config, polar, polar, wind);
+    route.Synchronise(airspaces, predicate, destination, aircraft);
+    if (route.Solve(destination, aircraft, config))
+      ++n_solved;
+
+    for (const auto &p : route.GetSolution()) {
+      checksum = checksum * 31 +
+        (unsigned long)lround(p.longitude.Degrees() * 1e6) * 7 +
+        (unsigned long)lround(p.latitude.Degrees() * 1e6) * 3 +
+        (unsigned long)p.altitude;
+      ++n_points;
+    }
+  }
+
+  const uint64_t elapsed = MonotonicClockUS() - begin;
+
+  printf("%u airspaces, %u solves: %llu us total, %.1f us per solve\n",
+         airspaces.GetSize(), duration, (unsigned long long)elapsed,
+         double(elapsed) / duration);
+  printf("%u solved, %u route points, checksum %08lx\n",
+         n_solved, n_points, checksum & 0xffffffff);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,134 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+/*
+ * Benchmark for AirspaceWarningManager::Update().  A few hours of
+ * flight with one fix per second zig-zag through a dense set of
+ * random airspaces (see setup_airspaces()), and the number of
+ * intercept solutions per second is reported.
+ */
+
+#include "harness_airspace.hpp"
+#include "Engine/Airspace/AirspaceWarningConfig.hpp"
+#include "Engine/Airspace/AbstractAirspace.hpp"
+#include "Engine/GlideSolvers/GlidePolar.hpp"
+#include "Engine/Navigation/Aircraft.hpp"
+#include "Task/Stats/TaskStats.hpp"
+#include "OS/Clock.hpp"
+
+#include <map>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static constexpr unsigned DURATION = 3 * 3600;
+
+/**
+ * Generate the aircraft state at the given second of the flight: 40
+ * m/s legs of 25 minutes, alternating between east and west, each
+ * shifted to the north.
+ */
+static AircraftState
+MakeState(const GeoPoint &center, unsigned t)
+{
+  static constexpr unsigned LEG = 1500;
+  static constexpr double SPEED = 40;
+  static constexpr double METERS_PER_DEGREE = 111195.;
+
+  const unsigned leg = t / LEG, phase = t % LEG;
+  const bool east = leg % 2 == 0;
+
+  double x = SPEED * phase / METERS_PER_DEGREE;
+  if (!east)
+    x = SPEED * LEG / METERS_PER_DEGREE - x;
+
+  const double y = 0.1 * leg + 0.02 * sin(phase / 60.);
+
+  AircraftState state;
+  state.Reset();
+  state.time = 36000 + t;
+  state.location = GeoPoint(center.longitude + Angle::Degrees(x - 0.7),
+                            center.latitude + Angle::Degrees(y - 0.6));
+  state.track = east ? Angle::QuarterCircle() : Angle::QuarterCircle() * 3;
+  state.ground_speed = state.true_airspeed = SPEED;
+  state.altitude = 2000 + 1500 * sin(t / 900.);
+  state.altitude_agl = state.altitude;
+  state.vario = 0;
+  return state;
+}
+
+int main(int argc, char **argv)
+{
+  const unsigned n_airspaces = argc > 1 ? atoi(argv[1]) : 1000;
+
+  const GeoPoint center(Angle::Degrees(7), Angle::Degrees(46));
+
+  srand(0);
+  Airspaces airspaces;
+  setup_airspaces(airspaces, center, n_airspaces);
+
+  /* number the airspaces for an order-independent checksum */
+  std::map<const AbstractAirspace *, unsigned> numbers;
+  for (const auto &i : airspaces.QueryAll())
+    numbers.emplace(&i.GetAirspace(), numbers.size());
+
+  AirspaceWarningConfig config;
+  config.SetDefaults();
+
+  AirspaceWarningManager warnings(config, airspaces);
+  warnings.Reset(MakeState(center, 0));
+
+  const GlidePolar glide_polar(1);
+  TaskStats task_stats;
+  task_stats.reset();
+
+  unsigned checksum = 0, max_warnings = 0;
+
+  const uint64_t start = MonotonicClockUS();
+
+  for (unsigned t = 1; t < DURATION; ++t) {
+    warnings.Update(MakeState(center, t), glide_polar, task_stats, false, 1);
+
+    unsigned sum = 0;
+    for (const auto &w : warnings)
+      sum += (numbers[&w.GetAirspace()] + 1) * 8 + w.GetWarningState();
+    checksum = checksum * 31 + sum;
+
+    if (warnings.size() > max_warnings)
+      max_warnings = warnings.size();
+  }
+
+  const uint64_t duration = MonotonicClockUS() - start;
+  const unsigned long n_intercepts = warnings.GetInterceptCount();
+
+  printf("%u airspaces, %u fixes: %llu us total, %.1f us per fix\n",
+         airspaces.GetSize(), DURATION - 1,
+         (unsigned long long)duration, double(duration) / (DURATION - 1));
+  printf("%lu intercepts, %.0f intercepts per second, max %u warnings\n",
+         n_intercepts,
+         duration > 0 ? n_intercepts * 1e6 / duration : 0.,
+         max_warnings);
+  printf("checksum %08x\n", checksum);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,79 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+/*
+ * Benchmark for the bilinear terrain interpolation.  Pass "scalar"
+ * as argument to benchmark the old code path (one
+ * RasterBuffer::GetInterpolated() call per sample) instead of
+ * #TerrainInterpolationBatch.
+ */
+
+#include "Terrain/RasterBuffer.hpp"
+#include "Terrain/InterpolationBatch.hpp"
+
+#include <string.h>
+#include <stdlib.h>
+
+static constexpr unsigned WIDTH = 1024, HEIGHT = 1024;
+static constexpr unsigned N_LOCATIONS = 4096;
+
+int main(int argc, char **argv)
+{
+  const bool scalar = argc > 1 && strcmp(argv[1], "scalar") == 0;
+
+  RasterBuffer buffer(WIDTH, HEIGHT);
+  TerrainHeight *p = buffer.GetData();
+  for (unsigned i = 0; i < WIDTH * HEIGHT; ++i)
+    p[i] = TerrainHeight(rand() % 4000);
+
+  static unsigned lx[N_LOCATIONS], ly[N_LOCATIONS];
+  for (unsigned i = 0; i < N_LOCATIONS; ++i) {
+    lx[i] = rand() % buffer.GetFineWidth();
+    ly[i] = rand() % buffer.GetFineHeight();
+  }
+
+  static TerrainHeight result[N_LOCATIONS];
+  long sum = 0;
+
+  for (unsigned j = 16 * 1024; j-- > 0;) {
+    if (scalar) {
+      for (unsigned i = 0; i < N_LOCATIONS; ++i)
+        result[i] = buffer.GetInterpolated(lx[i], ly[i]);
+    } else {
+      TerrainInterpolationBatch batch;
+      TerrainHeight *dest = result;
+      for (unsigned i = 0; i < N_LOCATIONS; ++i) {
+        buffer.AppendInterpolated(batch, lx[i], ly[i]);
+        if (batch.IsFull())
+          dest = batch.Flush(dest);
+      }
+
+      batch.Flush(dest);
+    }
+
+    /* prevent gcc from optimizing this loop away */
+    sum += result[j % N_LOCATIONS].GetValue();
+  }
+
+  return sum == 42;
+}
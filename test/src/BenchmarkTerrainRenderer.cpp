@@ -0,0 +1,308 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+/*
+ * Benchmark for the terrain slope shading.  The height matrix is
+ * filled from the given map file at several zoom levels, and each
+ * one is shaded serially and with a #WorkStealingPool.  Finally,
+ * scrolling a rendered image vertically is compared with rendering
+ * the moved area from scratch.
+ */
+
+#include "Terrain/RasterMap.hpp"
+#include "Terrain/HeightMatrix.hpp"
+#include "Terrain/SlopeShading.hpp"
+#include "Terrain/Loader.hpp"
+#include "Projection/WindowProjection.hpp"
+#include "Geo/GeoBounds.hpp"
+#include "Screen/RawBitmap.hpp"
+#include "Thread/WorkStealingPool.hpp"
+#include "OS/Args.hpp"
+#include "OS/Clock.hpp"
+#include "IO/ZipArchive.hpp"
+#include "Operation/Operation.hpp"
+#include "Util/PrintException.hxx"
+
+#include <memory>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* a high-DPI map window */
+static constexpr unsigned WIDTH = 1600, HEIGHT = 1200;
+
+static constexpr unsigned ITERATIONS = 20;
+
+/**
+ * A synthetic color table in the layout of
+ * RasterRenderer::PrepareColorTable().
+ */
+static void
+FillColorTable(RawColor *table)
+{
+  for (int mag = -64; mag < 64; mag++)
+    for (unsigned i = 0; i < 256; i++)
+      table[i + (mag + 64) * 256] = RawColor(i, mag + 64, 255 - i);
+}
+
+static uint32_t
+Checksum(const RawColor *p, size_t n)
+{
+  const uint8_t *b = (const uint8_t *)p;
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i < n * sizeof(*p); ++i)
+    h = (h ^ b[i]) * 16777619u;
+  return h;
+}
+
+/**
+ * @return the duration of one image in microseconds
+ */
+static double
+Run(const HeightMatrix &matrix, RawColor *image,
+    const SlopeShadingParameters &shading, TaskRunner *task_runner)
+{
+  const uint64_t start = MonotonicClockUS();
+  for (unsigned i = 0; i < ITERATIONS; ++i)
+    GenerateSlopeImage(matrix, image, matrix.GetWidth(), shading,
+                       PixelRect(0, 0, matrix.GetWidth(), matrix.GetHeight()),
+                       task_runner);
+  return double(MonotonicClockUS() - start) / ITERATIONS;
+}
+
+/**
+ * The sampling grid of a #HeightMatrix with one cell per pixel.
+ */
+struct Grid {
+#ifdef ENABLE_OPENGL
+  GeoBounds bounds;
+
+  explicit Grid(const WindowProjection &projection)
+    :bounds(projection.GetScreenBounds()) {}
+
+  void Fill(HeightMatrix &matrix, const RasterMap &map) const {
+    matrix.Fill(map, bounds, WIDTH, HEIGHT, true);
+  }
+
+  void FillRows(HeightMatrix &matrix, const RasterMap &map,
+                unsigned y_begin, unsigned y_end) const {
+    matrix.FillRows(map, bounds, y_begin, y_end, true);
+  }
+
+  /**
+   * Move the grid so that row y is at y - dy.
+   */
+  Grid Moved(int dy) const {
+    const Angle cell_height = bounds.GetHeight() / HEIGHT;
+
+    Grid result(*this);
+    result.bounds =
+      GeoBounds(GeoPoint(bounds.GetWest(),
+                         bounds.GetNorth() - cell_height * dy),
+                GeoPoint(bounds.GetEast(),
+                         bounds.GetSouth() - cell_height * dy));
+    return result;
+  }
+#else
+  WindowProjection projection;
+
+  explicit Grid(const WindowProjection &_projection)
+    :projection(_projection) {}
+
+  void Fill(HeightMatrix &matrix, const RasterMap &map) const {
+    matrix.Fill(map, projection, 1, true);
+  }
+
+  void FillRows(HeightMatrix &matrix, const RasterMap &map,
+                unsigned y_begin, unsigned y_end) const {
+    matrix.FillRows(map, projection, 1, y_begin, y_end, true);
+  }
+
+  Grid Moved(int dy) const {
+    const PixelPoint origin = projection.GetScreenOrigin();
+
+    Grid result(*this);
+    result.projection.SetGeoLocation(projection.ScreenToGeo(origin.x,
+                                                            origin.y + dy));
+    result.projection.UpdateScreenBounds();
+    return result;
+  }
+#endif
+};
+
+/**
+ * Scroll an image by the given number of rows, and compare it with
+ * an image which was rendered from scratch.
+ */
+static void
+RunScroll(const RasterMap &map, const Grid &grid, int dy,
+          const SlopeShadingParameters &shading, TaskRunner *task_runner)
+{
+  const std::unique_ptr<RawColor[]> image(new RawColor[WIDTH * HEIGHT]);
+  const std::unique_ptr<RawColor[]> reference(new RawColor[WIDTH * HEIGHT]);
+  const PixelRect all(0, 0, WIDTH, HEIGHT);
+  const Grid moved = grid.Moved(dy);
+
+  HeightMatrix matrix;
+  grid.Fill(matrix, map);
+  GenerateSlopeImage(matrix, image.get(), WIDTH, shading, all, task_runner);
+
+  uint64_t start = MonotonicClockUS();
+
+  matrix.ScrollRows(dy);
+  if (dy > 0)
+    moved.FillRows(matrix, map, HEIGHT - dy, HEIGHT);
+  else
+    moved.FillRows(matrix, map, 0, -dy);
+
+  TrivialArray<PixelRect, 2> dirty;
+  ScrollSlopeImage(image.get(), WIDTH, WIDTH, HEIGHT, dy,
+                   shading.quantisation, dirty);
+  for (const auto &rect : dirty)
+    GenerateSlopeImage(matrix, image.get(), WIDTH, shading, rect,
+                       task_runner);
+
+  const uint64_t scroll_duration = MonotonicClockUS() - start;
+
+  start = MonotonicClockUS();
+
+  HeightMatrix reference_matrix;
+  moved.Fill(reference_matrix, map);
+  GenerateSlopeImage(reference_matrix, reference.get(), WIDTH, shading, all,
+                     task_runner);
+
+  const uint64_t full_duration = MonotonicClockUS() - start;
+
+  /* both must be identical */
+  unsigned n_cells = 0, n_pixels = 0, max_delta = 0;
+  for (unsigned i = 0; i < WIDTH * HEIGHT; ++i) {
+    const unsigned delta = abs(matrix.GetData()[i].GetValue() -
+                               reference_matrix.GetData()[i].GetValue());
+    if (delta > 0) {
+      ++n_cells;
+      max_delta = std::max(max_delta, delta);
+    }
+
+    if (memcmp(&image[i], &reference[i], sizeof(image[i])) != 0)
+      ++n_pixels;
+  }
+
+  printf("scroll %d q=%u: %llu us, full %llu us, "
+         "%u cells (max %u m) and %u pixels differ\n",
+         dy, shading.quantisation,
+         (unsigned long long)scroll_duration,
+         (unsigned long long)full_duration,
+         n_cells, max_delta, n_pixels);
+}
+
+int main(int argc, char **argv)
+try {
+  Args args(argc, argv, "PATH [THREADS]");
+  const auto map_path = args.ExpectNextPath();
+  unsigned n_threads = WorkStealingPool::GetProcessorCount();
+  if (!args.IsEmpty())
+    n_threads = strtoul(args.GetNext(), nullptr, 10);
+  args.ExpectEnd();
+
+  ZipArchive archive(map_path);
+
+  RasterMap map;
+
+  NullOperationEnvironment operation;
+  if (!LoadTerrainOverview(archive.get(), map.GetTileCache(),
+                           operation)) {
+    fprintf(stderr, "failed to load map\n");
+    return EXIT_FAILURE;
+  }
+
+  map.UpdateProjection();
+
+  SharedMutex mutex;
+  do {
+    UpdateTerrainTiles(archive.get(), map.GetTileCache(), mutex,
+                       map.GetProjection(),
+                       map.GetMapCenter(), 100000);
+  } while (map.IsDirty());
+
+  const std::unique_ptr<RawColor[]> colors(new RawColor[256 * 128]);
+  FillColorTable(colors.get());
+
+  const std::unique_ptr<RawColor[]> image(new RawColor[WIDTH * HEIGHT]);
+
+  WorkStealingPool pool(n_threads);
+
+  SlopeShadingParameters shading;
+  shading.colors = colors.get() + 64 * 256;
+  shading.height_scale = 4;
+  shading.contour_height_scale = 8;
+  shading.contrast = 200;
+  shading.sx = -120;
+  shading.sy = 150;
+  shading.sz = 160;
+
+  printf("threads: %u\n", n_threads);
+
+  for (const double radius : {5000., 20000., 80000.}) {
+    WindowProjection projection;
+    projection.SetScreenSize({WIDTH, HEIGHT});
+    projection.SetScaleFromRadius(radius);
+    projection.SetGeoLocation(map.GetMapCenter());
+    projection.SetScreenOrigin(WIDTH / 2, HEIGHT / 2);
+    projection.UpdateScreenBounds();
+
+    const Grid grid(projection);
+
+    HeightMatrix matrix;
+    grid.Fill(matrix, map);
+
+    for (const unsigned quantisation : {1u, 4u}) {
+      shading.quantisation = quantisation;
+      shading.height_slope_factor =
+        std::min(unsigned(radius / 500) + 1,
+                 8192u / (quantisation * quantisation));
+
+      const double serial = Run(matrix, image.get(), shading, nullptr);
+      const uint32_t serial_checksum =
+        Checksum(image.get(), matrix.GetWidth() * matrix.GetHeight());
+
+      const double parallel = Run(matrix, image.get(), shading, &pool);
+      const uint32_t parallel_checksum =
+        Checksum(image.get(), matrix.GetWidth() * matrix.GetHeight());
+
+      printf("radius=%.0f q=%u %ux%u: serial %.0f us, parallel %.0f us, "
+             "checksum %08x%s\n",
+             radius, quantisation, matrix.GetWidth(), matrix.GetHeight(),
+             serial, parallel, serial_checksum,
+             parallel_checksum == serial_checksum ? "" : " MISMATCH");
+
+      for (const int dy : {int(HEIGHT / 8), -int(HEIGHT / 16), 1, -2})
+        RunScroll(map, grid, dy, shading, &pool);
+    }
+  }
+
+  return EXIT_SUCCESS;
+} catch (const std::runtime_error &e) {
+  PrintException(e);
+  return EXIT_FAILURE;
+}
@@ -0,0 +1,119 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+/*
+ * Benchmark for Trace::push_back() and the thinning algorithm.  A
+ * synthetic 10 hour flight with one fix per second (straight glides
+ * alternating with drifting thermal circles) is fed into traces
+ * configured like the ones in #TraceComputer.
+ */
+
+#include "Engine/Trace/Trace.hpp"
+#include "Geo/GeoPoint.hpp"
+#include "OS/Clock.hpp"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static constexpr unsigned DURATION = 10 * 3600;
+
+/**
+ * Generate the fix at the given second of the flight.
+ */
+static TracePoint
+MakeFix(unsigned t)
+{
+  /* 20 minutes cruise, then 5 minutes circling */
+  static constexpr unsigned CRUISE = 1200, CLIMB = 300, CYCLE = CRUISE + CLIMB;
+
+  const unsigned cycle = t / CYCLE, phase = t % CYCLE;
+
+  /* cruise track: 30 m/s, with a slowly changing heading */
+  const double distance = 30. * (cycle * CRUISE + std::min(phase, CRUISE));
+  const double heading = 0.3 * sin(distance / 50000.);
+  double x = distance * cos(heading);
+  double y = distance * sin(heading);
+  double altitude = 1500 + 300 * sin(t / 600.);
+
+  if (phase > CRUISE) {
+    /* 30 seconds per circle with a radius of 150 m, drifting with
+       the wind */
+    const double a = (phase - CRUISE) * 2 * M_PI / 30;
+    x += 150 * sin(a) + 2. * (phase - CRUISE);
+    y += 150 * (1 - cos(a));
+    altitude += 2. * (phase - CRUISE);
+  }
+
+  static constexpr double METERS_PER_DEGREE = 111195.;
+  const GeoPoint location(Angle::Degrees(10 + x / METERS_PER_DEGREE / 0.64),
+                          Angle::Degrees(50 + y / METERS_PER_DEGREE));
+
+  return TracePoint(location, 36000 + t, altitude, 0., 0);
+}
+
+static unsigned
+Checksum(const Trace &trace)
+{
+  unsigned sum = trace.size();
+  for (const TracePoint &point : trace)
+    sum = sum * 31 + point.GetTime();
+  return sum;
+}
+
+int main(int argc, char **argv)
+{
+  const unsigned n_runs = argc > 1 ? atoi(argv[1]) : 10;
+
+  static TracePoint fixes[DURATION];
+  for (unsigned t = 0; t < DURATION; ++t)
+    fixes[t] = MakeFix(t);
+
+  unsigned checksum = 0;
+
+  const uint64_t start = MonotonicClockUS();
+
+  for (unsigned run = 0; run < n_runs; ++run) {
+    /* the same parameters as in TraceComputer */
+    Trace full(120, Trace::null_time, 1024);
+    Trace contest(0, Trace::null_time, 256);
+    Trace sprint(0, 9000, 128);
+
+    for (unsigned t = 0; t < DURATION; ++t) {
+      full.push_back(fixes[t]);
+      contest.push_back(fixes[t]);
+      sprint.push_back(fixes[t]);
+    }
+
+    checksum = Checksum(full) ^ Checksum(contest) ^ Checksum(sprint);
+  }
+
+  const uint64_t duration = MonotonicClockUS() - start;
+
+  printf("%u runs, %u fixes each: %llu us total, %.1f ns per fix\n",
+         n_runs, DURATION, (unsigned long long)duration,
+         duration * 1000. / (n_runs * DURATION * 3));
+  printf("checksum %08x\n", checksum);
+
+  return EXIT_SUCCESS;
+}
@@ -35,12 +35,12 @@ int main(int argc, char **argv)
   FlarmNetDatabase database;
   FlarmNetReader::LoadFile(path, database);
 
-  for (auto i = database.begin(), end = database.end(); i != end; ++i) {
-    const FlarmNetRecord &record = i->second;
+  for (unsigned i = 0, n = database.GetCount(); i < n; ++i) {
+    const FlarmNetRecord record = database.GetRecord(i);
 
     _tprintf(_T("%s\t%s\t%s\t%s\n"),
-             record.id.c_str(), record.pilot.c_str(),
-             record.registration.c_str(), record.callsign.c_str());
+             record.id, record.pilot,
+             record.registration, record.callsign);
   }
 
   return EXIT_SUCCESS;
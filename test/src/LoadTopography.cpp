@@ -23,13 +23,16 @@ Copyright_License {
 
 /*
  * This program loads the topography from a map file and exits.  Useful
- * for valgrind and profiling.
+ * for valgrind and profiling.  If a cache directory is given, the
+ * topography is compiled into it and loaded again from there.
  */
 
 #include "Topography/TopographyStore.hpp"
 #include "Topography/TopographyFile.hpp"
 #include "Topography/XShape.hpp"
 #include "OS/Args.hpp"
+#include "OS/Clock.hpp"
+#include "IO/FileCache.hpp"
 #include "IO/ZipArchive.hpp"
 #include "IO/ZipLineReader.hpp"
 #include "Operation/Operation.hpp"
@@ -61,11 +64,30 @@ TriangulateAll(const TopographyStore &store)
 
 #endif
 
-int main(int argc, char **argv)
-try {
-  Args args(argc, argv, "PATH");
-  const auto path = args.ExpectNextPath();
-  args.ExpectEnd();
+static unsigned
+CountShapes(const TopographyStore &store)
+{
+  unsigned n = 0;
+  for (unsigned i = 0; i < store.size(); ++i) {
+    const TopographyFile &file = store[i];
+    const ScopeLock protect(file.mutex);
+    for (auto j = file.begin(); j != file.end(); ++j)
+      ++n;
+  }
+
+  return n;
+}
+
+/**
+ * Load all shapes (from the cache if one is given) and triangulate
+ * them.
+ *
+ * @return the number of shapes
+ */
+static unsigned
+LoadTopography(Path path, FileCache *cache, uint64_t &duration)
+{
+  const uint64_t start = MonotonicClockUS();
 
   ZipArchive archive(path);
 
@@ -73,7 +95,7 @@ try {
 
   TopographyStore topography;
   NullOperationEnvironment operation;
-  topography.Load(operation, reader, NULL, archive.get());
+  topography.Load(operation, reader, NULL, archive.get(), cache, path);
 
   topography.LoadAll();
 
@@ -81,6 +103,44 @@ try {
   TriangulateAll(topography);
 #endif
 
+  duration = MonotonicClockUS() - start;
+
+  return CountShapes(topography);
+}
+
+int main(int argc, char **argv)
+try {
+  Args args(argc, argv, "PATH [CACHE_DIR]");
+  const auto path = args.ExpectNextPath();
+  AllocatedPath cache_path = args.IsEmpty()
+    ? AllocatedPath(nullptr)
+    : AllocatedPath(args.ExpectNextPath());
+  args.ExpectEnd();
+
+  uint64_t duration;
+  const unsigned n = LoadTopography(path, nullptr, duration);
+
+  if (!cache_path.IsNull()) {
+    printf("shapefile: %u shapes, load %u us\n", n, unsigned(duration));
+
+    FileCache cache(std::move(cache_path));
+
+    uint64_t compile_duration;
+    LoadTopography(path, &cache, compile_duration);
+    printf("compile: %u us\n", unsigned(compile_duration));
+
+    uint64_t cached_duration;
+    const unsigned n_cached = LoadTopography(path, &cache, cached_duration);
+    if (n_cached != n) {
+      fprintf(stderr, "Shape count mismatch: %u != %u\n", n_cached, n);
+      return EXIT_FAILURE;
+    }
+
+    printf("compiled: load %u us (%.1fx faster)\n",
+           unsigned(cached_duration),
+           cached_duration > 0 ? double(duration) / cached_duration : 0.);
+  }
+
   return EXIT_SUCCESS;
 } catch (const std::runtime_error &e) {
   PrintException(e);
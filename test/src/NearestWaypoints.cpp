@@ -27,8 +27,11 @@ Copyright_License {
 #include "Engine/Waypoint/WaypointVisitor.hpp"
 #include "OS/ConvertPathName.hpp"
 #include "OS/Args.hpp"
+#include "OS/Clock.hpp"
 #include "Operation/Operation.hpp"
 
+#include <vector>
+
 #include <stdint.h>
 #include <stdio.h>
 #include <tchar.h>
@@ -114,6 +117,55 @@ GetNearestWaypoint(const GeoPoint &location, const Waypoints &waypoints,
   return waypoints.GetNearestIf(location, range, predicate);
 }
 
+class CountVisitor : public WaypointVisitor {
+public:
+  unsigned count = 0;
+
+  void Visit(const WaypointPtr &p) override {
+    ++count;
+  }
+};
+
+/**
+ * Run range and nearest queries around each waypoint and print the
+ * query throughput.
+ */
+static void
+Benchmark(const Waypoints &waypoints, double range, WaypointType type,
+          unsigned n)
+{
+  std::vector<GeoPoint> locations;
+  for (const auto &i : waypoints)
+    locations.push_back(i->location);
+
+  if (locations.empty())
+    return;
+
+  CountVisitor visitor;
+  uint64_t start = MonotonicClockUS();
+  for (unsigned i = 0; i < n; ++i)
+    waypoints.VisitWithinRange(locations[i % locations.size()], range,
+                               visitor);
+  uint64_t duration = MonotonicClockUS() - start;
+
+  printf("VisitWithinRange: %u queries, %u results, %.2f us/query\n",
+         n, visitor.count, double(duration) / n);
+
+  unsigned found = 0;
+  start = MonotonicClockUS();
+  for (unsigned i = 0; i < n; ++i)
+    if (GetNearestWaypoint(locations[i % locations.size()], waypoints,
+                           range, type))
+      ++found;
+  duration = MonotonicClockUS() - start;
+
+  printf("GetNearestIf: %u queries, %u results, %.2f us/query\n",
+         n, found, double(duration) / n);
+
+  printf("index memory: %lu bytes\n",
+         (unsigned long)waypoints.GetIndexMemoryUsage());
+}
+
 static void
 PrintWaypoint(const Waypoint *waypoint)
 {
@@ -131,6 +183,7 @@ int main(int argc, char **argv)
 {
   WaypointType type = WaypointType::ALL;
   double range = 100000;
+  unsigned benchmark = 0;
 
   Args args(argc, argv,
             "PATH\n\nPATH is expected to be any compatible waypoint file.\n"
@@ -140,7 +193,9 @@ int main(int argc, char **argv)
             "2.12343 34.38432\n"
             "65.18234 -173.48307\n\n"
             "Output is in the format: LAT LON ELEV (in m) NAME\n\ne.g.\n"
-            "50.823055 6.186384 189 Aachen Merzbruc");
+            "50.823055 6.186384 189 Aachen Merzbruc\n\n"
+            "With --benchmark=N, N queries around the waypoints are\n"
+            "timed instead of reading stdin.");
 
   const char *arg;
   while ((arg = args.PeekNext()) != NULL && *arg == '-') {
@@ -151,6 +206,8 @@ int main(int argc, char **argv)
       double _range = strtod(value, NULL);
       if (_range > 0)
         range = _range;
+    } else if ((value = StringAfterPrefix(arg, "--benchmark=")) != NULL) {
+      benchmark = strtoul(value, NULL, 10);
     } else if (StringStartsWith(arg, "--airports-only")) {
       type = WaypointType::AIRPORT;
     } else if (StringStartsWith(arg, "--landables-only")) {
@@ -167,6 +224,11 @@ int main(int argc, char **argv)
   if (!LoadWaypoints(path, waypoints))
     return EXIT_FAILURE;
 
+  if (benchmark > 0) {
+    Benchmark(waypoints, range, type, benchmark);
+    return EXIT_SUCCESS;
+  }
+
   char buffer[1024];
   const char *line;
   while ((line = fgets(buffer, sizeof(buffer) - 3, stdin)) != NULL) {
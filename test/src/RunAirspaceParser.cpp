@@ -22,8 +22,11 @@ Copyright_License {
 */
 
 #include "Airspace/AirspaceParser.hpp"
+#include "Airspace/AirspaceCache.hpp"
 #include "Engine/Airspace/Airspaces.hpp"
 #include "OS/Args.hpp"
+#include "OS/Clock.hpp"
+#include "OS/FileMapping.hpp"
 #include "IO/FileLineReader.hpp"
 #include "Operation/Operation.hpp"
 #include "Util/PrintException.hxx"
@@ -31,12 +34,71 @@ Copyright_License {
 #include <stdio.h>
 #include <tchar.h>
 
+/**
+ * Write the airspaces in the compiled format, load them again and
+ * compare the load time with the parser's.
+ */
+static bool
+BenchmarkCache(const Airspaces &airspaces, Path cache_path,
+               uint64_t parse_duration)
+{
+  std::vector<const AbstractAirspace *> items;
+  for (const auto &i : airspaces.QueryAll())
+    items.push_back(&i.GetAirspace());
+
+  FILE *file = _tfopen(cache_path.c_str(), _T("wb"));
+  if (file == nullptr) {
+    fprintf(stderr, "Failed to create cache file\n");
+    return false;
+  }
+
+  const bool written = WriteAirspaceCache(file, items);
+  if (fclose(file) != 0 || !written) {
+    fprintf(stderr, "Failed to write cache file\n");
+    return false;
+  }
+
+  const uint64_t start = MonotonicClockUS();
+
+  FileMapping mapping(cache_path);
+  if (mapping.error()) {
+    fprintf(stderr, "Failed to map cache file\n");
+    return false;
+  }
+
+  Airspaces cached;
+  if (!ReadAirspaceCache(cached, mapping.data(), mapping.size())) {
+    fprintf(stderr, "Failed to load cache file\n");
+    return false;
+  }
+
+  cached.Optimise();
+
+  const uint64_t load_duration = MonotonicClockUS() - start;
+
+  if (cached.GetSize() != airspaces.GetSize()) {
+    fprintf(stderr, "Airspace count mismatch: %u != %u\n",
+            cached.GetSize(), airspaces.GetSize());
+    return false;
+  }
+
+  printf("compiled: %u bytes, load %u us (%.1fx faster)\n",
+         unsigned(mapping.size()), unsigned(load_duration),
+         load_duration > 0 ? double(parse_duration) / load_duration : 0.);
+  return true;
+}
+
 int main(int argc, char **argv)
 try {
-  Args args(argc, argv, "PATH");
+  Args args(argc, argv, "PATH [CACHE]");
   const auto path = args.ExpectNextPath();
+  const AllocatedPath cache_path = args.IsEmpty()
+    ? AllocatedPath(nullptr)
+    : AllocatedPath(args.ExpectNextPath());
   args.ExpectEnd();
 
+  const uint64_t start = MonotonicClockUS();
+
   FileLineReader reader(path, Charset::AUTO);
 
   Airspaces airspaces;
@@ -50,6 +112,16 @@ try {
 
   airspaces.Optimise();
 
+  const uint64_t parse_duration = MonotonicClockUS() - start;
+
+  if (!cache_path.IsNull()) {
+    printf("parsed: %u airspaces, load %u us\n",
+           airspaces.GetSize(), unsigned(parse_duration));
+
+    if (!BenchmarkCache(airspaces, cache_path, parse_duration))
+      return EXIT_FAILURE;
+  }
+
   printf("OK\n");
 
   return EXIT_SUCCESS;
@@ -0,0 +1,225 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+/*
+ * A load generator for the SkyLines tracking server
+ * (xcsoar-cloud-server).  It simulates many pilots flying in the
+ * same area, all sending fixes through one UDP socket, and reports
+ * how many fixes were sent and how many traffic records the server
+ * has fanned out.
+ */
+
+#include "Tracking/SkyLines/Client.hpp"
+#include "Tracking/SkyLines/Handler.hpp"
+#include "Tracking/SkyLines/Assemble.hpp"
+#include "Tracking/SkyLines/Protocol.hpp"
+#include "Geo/GeoPoint.hpp"
+#include "OS/Args.hpp"
+
+#include <boost/asio/steady_timer.hpp>
+
+#include <vector>
+#include <cmath>
+
+#include <stdio.h>
+
+/**
+ * The simulated pilots are placed on a grid with this spacing
+ * [degrees], so a pilot has many neighbours within the server's
+ * traffic range.
+ */
+static constexpr double GRID_SPACING = 0.02;
+
+static constexpr auto TICK = std::chrono::milliseconds(10);
+
+/**
+ * Re-send the traffic requests in this interval, to keep the server
+ * sending traffic to our pilots.  Each pilot sends its request right
+ * after one of its fixes, so the requests are spread over the fix
+ * stream; a burst of requests would overflow the server's socket
+ * buffer, and the lost requests would not be repeated for a whole
+ * interval.
+ */
+static constexpr auto TRAFFIC_REQUEST_INTERVAL = std::chrono::seconds(60);
+
+class LoadGenerator final : public SkyLinesTracking::Handler {
+  SkyLinesTracking::Client client;
+
+  boost::asio::steady_timer timer;
+
+  const unsigned n_pilots;
+  const double fixes_per_tick;
+  const std::chrono::steady_clock::duration duration;
+
+  std::chrono::steady_clock::time_point start_time;
+
+  /**
+   * When shall each pilot send its next traffic request?
+   */
+  std::vector<std::chrono::steady_clock::time_point> next_traffic_request;
+
+  double pending_fixes = 0;
+
+  unsigned next_pilot = 0;
+
+  unsigned long n_fixes = 0, n_traffic = 0;
+
+public:
+  LoadGenerator(boost::asio::io_service &io_service,
+                unsigned _n_pilots, unsigned rate, unsigned seconds)
+    :client(io_service, this), timer(io_service),
+     n_pilots(_n_pilots),
+     fixes_per_tick(rate * std::chrono::duration<double>(TICK).count()),
+     duration(std::chrono::seconds(seconds)),
+     next_traffic_request(_n_pilots) {}
+
+  SkyLinesTracking::Client &GetClient() {
+    return client;
+  }
+
+  void PrintResult() const {
+    const double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now()
+                                    - start_time).count();
+
+    printf("sent %lu fixes in %.1f s (%.0f/s)\n",
+           n_fixes, seconds, n_fixes / seconds);
+    printf("received %lu traffic records (%.0f/s)\n",
+           n_traffic, n_traffic / seconds);
+  }
+
+  /* virtual methods from SkyLinesTracking::Handler */
+  void OnSkyLinesReady() override {
+    start_time = std::chrono::steady_clock::now();
+    ScheduleTick();
+  }
+
+  void OnTraffic(uint32_t pilot_id, unsigned time_of_day_ms,
+                 const GeoPoint &location, int altitude) override {
+    ++n_traffic;
+  }
+
+  void OnSkyLinesError(const std::exception &e) override {
+    fprintf(stderr, "Error: %s\n", e.what());
+    timer.get_io_service().stop();
+  }
+
+private:
+  static uint64_t GetKey(unsigned pilot) {
+    return 0x10000 + pilot;
+  }
+
+  GeoPoint GetLocation(unsigned pilot) const {
+    const unsigned side = unsigned(std::sqrt(n_pilots)) + 1;
+
+    /* let the pilots circle slowly around their grid points */
+    const Angle phase = Angle::Degrees(double(n_fixes % 360));
+    const auto sc = phase.SinCos();
+
+    return GeoPoint(Angle::Degrees(11 + (pilot % side) * GRID_SPACING
+                                   + sc.first * 0.002),
+                    Angle::Degrees(47 + (pilot / side) * GRID_SPACING
+                                   + sc.second * 0.002));
+  }
+
+  void SendFix(unsigned pilot) {
+    const uint32_t flags = SkyLinesTracking::FixPacket::FLAG_LOCATION |
+      SkyLinesTracking::FixPacket::FLAG_ALTITUDE;
+
+    client.SendPacket(SkyLinesTracking::MakeFix(GetKey(pilot), flags,
+                                                n_fixes,
+                                                GetLocation(pilot),
+                                                Angle::Zero(), 30, 30,
+                                                1500, 0, 0));
+    ++n_fixes;
+
+    /* the server ignores traffic requests from unknown clients, so
+       this must follow a fix */
+    const auto now = std::chrono::steady_clock::now();
+    if (now >= next_traffic_request[pilot]) {
+      client.SendPacket(SkyLinesTracking::MakeTrafficRequest(GetKey(pilot),
+                                                             false, false,
+                                                             true));
+      next_traffic_request[pilot] = now + TRAFFIC_REQUEST_INTERVAL;
+    }
+  }
+
+  void ScheduleTick() {
+    timer.expires_from_now(TICK);
+    timer.async_wait(std::bind(&LoadGenerator::OnTick, this,
+                               std::placeholders::_1));
+  }
+
+  void OnTick(const boost::system::error_code &ec) {
+    if (ec)
+      return;
+
+    const auto now = std::chrono::steady_clock::now();
+    if (now >= start_time + duration) {
+      timer.get_io_service().stop();
+      return;
+    }
+
+    for (pending_fixes += fixes_per_tick; pending_fixes >= 1;
+         pending_fixes -= 1) {
+      SendFix(next_pilot);
+      next_pilot = (next_pilot + 1) % n_pilots;
+    }
+
+    ScheduleTick();
+  }
+};
+
+int
+main(int argc, char *argv[])
+try {
+  Args args(argc, argv, "HOST PILOTS FIXES_PER_SECOND SECONDS");
+  const char *host = args.ExpectNext();
+  const int n_pilots = args.ExpectNextInt();
+  const int rate = args.ExpectNextInt();
+  const int seconds = args.ExpectNextInt();
+  args.ExpectEnd();
+
+  if (n_pilots <= 0 || rate <= 0 || seconds <= 0)
+    args.UsageError();
+
+  boost::asio::io_service io_service;
+
+  const boost::asio::ip::udp::resolver::query query(boost::asio::ip::udp::v4(),
+                                                    host,
+                                                    SkyLinesTracking::Client::GetDefaultPortString());
+
+  LoadGenerator generator(io_service, n_pilots, rate, seconds);
+
+  auto &client = generator.GetClient();
+  client.SetKey(1);
+  client.Open(query);
+
+  io_service.run();
+
+  generator.PrintResult();
+  return EXIT_SUCCESS;
+} catch (const std::exception &e) {
+  fprintf(stderr, "%s\n", e.what());
+  return EXIT_FAILURE;
+}
@@ -27,6 +27,7 @@ Copyright_License {
 #include "Projection/WindowProjection.hpp"
 #include "Screen/Layout.hpp"
 #include "OS/Args.hpp"
+#include "OS/Clock.hpp"
 #include "IO/ZipArchive.hpp"
 #include "Operation/Operation.hpp"
 #include "Util/PrintException.hxx"
@@ -72,6 +73,7 @@ try {
   projection.UpdateScreenBounds();
 
   HeightMatrix matrix;
+  const uint64_t start = MonotonicClockUS();
 #ifdef ENABLE_OPENGL
   matrix.Fill(map, projection.GetScreenBounds(),
               projection.GetScreenWidth(), projection.GetScreenHeight(),
@@ -79,6 +81,7 @@ try {
 #else
   matrix.Fill(map, projection, 1, false);
 #endif
+  printf("Fill: %u us\n", unsigned(MonotonicClockUS() - start));
 
   return EXIT_SUCCESS;
 } catch (const std::runtime_error &e) {
@@ -116,7 +116,7 @@ LoadFiles(PlacesOfInterestSettings &poi_settings,
   NullOperationEnvironment operation;
 
   topography = new TopographyStore();
-  LoadConfiguredTopography(*topography, operation);
+  LoadConfiguredTopography(*topography, nullptr, operation);
 
   terrain = RasterTerrain::OpenTerrain(NULL, operation);
 
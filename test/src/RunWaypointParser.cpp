@@ -60,6 +60,8 @@ int main(int argc, char **argv)
 
   way_points.Optimise();
   printf("Size %d\n", way_points.size());
+  printf("Index %lu bytes\n",
+         (unsigned long)way_points.GetIndexMemoryUsage());
 
   DumpVisitor visitor;
   way_points.VisitNamePrefix(_T(""), visitor);
@@ -22,6 +22,7 @@ Copyright_License {
 */
 
 #include "Airspace/AirspaceParser.hpp"
+#include "Airspace/AirspaceCache.hpp"
 #include "Engine/Airspace/AbstractAirspace.hpp"
 #include "Engine/Airspace/AirspaceCircle.hpp"
 #include "Engine/Airspace/AirspacePolygon.hpp"
@@ -34,6 +35,9 @@ Copyright_License {
 #include "Operation/Operation.hpp"
 #include "TestUtil.hpp"
 
+#include <vector>
+
+#include <stdio.h>
 #include <tchar.h>
 
 struct AirspaceClassTestCouple
@@ -58,14 +62,8 @@ ParseFile(Path path, Airspaces &airspaces)
 }
 
 static void
-TestOpenAir()
+CheckOpenAir(const Airspaces &airspaces)
 {
-  Airspaces airspaces;
-  if (!ParseFile(Path(_T("test/data/airspace/openair.txt")), airspaces)) {
-    skip(3, 0, "Failed to parse input file");
-    return;
-  }
-
   const AirspaceClassTestCouple classes[] = {
     { _T("Class-R-Test"), RESTRICT },
     { _T("Class-Q-Test"), DANGER },
@@ -165,6 +163,63 @@ TestOpenAir()
   }
 }
 
+static void
+TestOpenAir()
+{
+  Airspaces airspaces;
+  if (!ParseFile(Path(_T("test/data/airspace/openair.txt")), airspaces)) {
+    skip(3, 0, "Failed to parse input file");
+    return;
+  }
+
+  CheckOpenAir(airspaces);
+}
+
+/**
+ * Compile the OpenAir test file, load the result and check that it
+ * still contains the same airspaces.
+ */
+static void
+TestCache()
+{
+  Airspaces parsed;
+  if (!ParseFile(Path(_T("test/data/airspace/openair.txt")), parsed)) {
+    skip(3, 0, "Failed to parse input file");
+    return;
+  }
+
+  std::vector<const AbstractAirspace *> items;
+  for (const auto &i : parsed.QueryAll())
+    items.push_back(&i.GetAirspace());
+
+  FILE *file = tmpfile();
+  ok1(file != nullptr && WriteAirspaceCache(file, items));
+
+  std::vector<uint8_t> buffer;
+  if (file != nullptr) {
+    buffer.resize(ftell(file));
+    rewind(file);
+    if (fread(buffer.data(), 1, buffer.size(), file) != buffer.size())
+      buffer.clear();
+    fclose(file);
+  }
+
+  Airspaces airspaces;
+  if (!ok1(ReadAirspaceCache(airspaces, buffer.data(), buffer.size()))) {
+    skip(51, 0, "Failed to load the compiled file");
+    return;
+  }
+
+  airspaces.Optimise();
+
+  /* a corrupt file must be rejected */
+  buffer[buffer.size() / 2] ^= 0x10;
+  Airspaces corrupt;
+  ok1(!ReadAirspaceCache(corrupt, buffer.data(), buffer.size()));
+
+  CheckOpenAir(airspaces);
+}
+
 static void
 TestTNP()
 {
@@ -275,9 +330,10 @@ TestTNP()
 
 int main(int argc, char **argv)
 try {
-  plan_tests(102);
+  plan_tests(156);
 
   TestOpenAir();
+  TestCache();
   TestTNP();
 
   return exit_status();
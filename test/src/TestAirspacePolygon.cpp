@@ -0,0 +1,229 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+/*
+ * Compare the indexed hit tests of AirspacePolygon (see
+ * PolygonEdgeIndex) with the plain implementation.
+ */
+
+#include "Airspace/AirspaceParser.hpp"
+#include "Engine/Airspace/AirspacePolygon.hpp"
+#include "Engine/Airspace/AirspaceIntersectSort.hpp"
+#include "Engine/Airspace/AirspaceIntersectionVector.hpp"
+#include "Engine/Airspace/Airspaces.hpp"
+#include "Geo/Flat/FlatProjection.hpp"
+#include "Geo/Flat/FlatRay.hpp"
+#include "Geo/Flat/FlatBoundingBox.hpp"
+#include "Geo/GeoBounds.hpp"
+#include "Util/PrintException.hxx"
+#include "IO/FileLineReader.hpp"
+#include "Operation/Operation.hpp"
+#include "TestUtil.hpp"
+
+#include <vector>
+
+#include <math.h>
+#include <stdlib.h>
+
+/**
+ * The plain implementation of AirspacePolygon::Intersects().
+ */
+static AirspaceIntersectionVector
+ReferenceIntersects(const AbstractAirspace &airspace,
+                    const GeoPoint &start, const GeoPoint &end,
+                    const FlatProjection &projection)
+{
+  const FlatRay ray(projection.ProjectInteger(start),
+                    projection.ProjectInteger(end));
+
+  AirspaceIntersectSort sorter(start, airspace);
+
+  const SearchPointVector &border = airspace.GetPoints();
+  for (auto it = border.begin(); it + 1 != border.end(); ++it) {
+    const FlatRay r_seg(it->GetFlatLocation(), (it + 1)->GetFlatLocation());
+    auto t = ray.DistinctIntersection(r_seg);
+    if (t >= 0)
+      sorter.add(t, projection.Unproject(ray.Parametric(t)));
+  }
+
+  return sorter.all();
+}
+
+static bool
+Equals(const AirspaceIntersectionVector &a,
+       const AirspaceIntersectionVector &b)
+{
+  if (a.size() != b.size())
+    return false;
+
+  for (unsigned i = 0; i < a.size(); ++i)
+    if (a[i].first != b[i].first || a[i].second != b[i].second)
+      return false;
+
+  return true;
+}
+
+/**
+ * Generate a location in the bounding box of the polygon, including a
+ * margin of 20% on each side.
+ */
+static GeoPoint
+RandomLocation(const GeoBounds &bounds)
+{
+  const double x = rand() * 1.4 / RAND_MAX - 0.2;
+  const double y = rand() * 1.4 / RAND_MAX - 0.2;
+  return GeoPoint(bounds.GetWest() + bounds.GetWidth() * x,
+                  bounds.GetSouth() + bounds.GetHeight() * y);
+}
+
+/**
+ * The ray tests are skipped on polygons larger than this (in flat
+ * units); the random rays may be 1.4 times as long.
+ */
+static constexpr int MAX_FLAT_SIZE = 20000;
+
+struct Mismatches {
+  unsigned indexed = 0, inside = 0, intersects = 0;
+};
+
+static void
+Compare(const AbstractAirspace &airspace, const FlatProjection &projection,
+        Mismatches &m)
+{
+  if (airspace.GetShape() != AbstractAirspace::Shape::POLYGON ||
+      airspace.GetPoints().size() < PolygonEdgeIndex::MIN_POINTS)
+    return;
+
+  ++m.indexed;
+
+  const SearchPointVector &border = airspace.GetPoints();
+  const GeoBounds bounds = airspace.GetGeoBounds();
+
+  /* the vertices themselves are the interesting corner cases */
+  for (const auto &i : border)
+    if (airspace.Inside(i.GetLocation()) != border.IsInside(i.GetLocation()))
+      ++m.inside;
+
+  for (unsigned i = 0; i < 2000; ++i) {
+    const GeoPoint p = RandomLocation(bounds);
+    if (airspace.Inside(p) != border.IsInside(p))
+      ++m.inside;
+  }
+
+  /* the integer cross products in FlatRay overflow on huge polygons
+     (and the plain implementation returns garbage there) */
+  const FlatBoundingBox box = border.CalculateBoundingbox();
+  if (box.GetUpperRight().x - box.GetLowerLeft().x > MAX_FLAT_SIZE ||
+      box.GetUpperRight().y - box.GetLowerLeft().y > MAX_FLAT_SIZE)
+    return;
+
+  for (unsigned i = 0; i < 500; ++i) {
+    const GeoPoint a = RandomLocation(bounds), b = RandomLocation(bounds);
+    if (!Equals(airspace.Intersects(a, b, projection),
+                ReferenceIntersects(airspace, a, b, projection)))
+      ++m.intersects;
+  }
+
+  /* short vectors starting at the vertices */
+  for (const auto &i : border) {
+    const GeoPoint &a = i.GetLocation();
+    const GeoPoint b(a.longitude + bounds.GetWidth() * 0.01,
+                     a.latitude - bounds.GetHeight() * 0.02);
+    if (!Equals(airspace.Intersects(a, b, projection),
+                ReferenceIntersects(airspace, a, b, projection)))
+      ++m.intersects;
+  }
+}
+
+static void
+TestFile(Path path, bool has_large_polygons)
+{
+  Airspaces airspaces;
+
+  {
+    FileLineReader reader(path, Charset::AUTO);
+    AirspaceParser parser(airspaces);
+    NullOperationEnvironment operation;
+    if (!ok1(parser.Parse(reader, operation))) {
+      skip(3, 0, "Failed to parse input file");
+      return;
+    }
+  }
+
+  airspaces.Optimise();
+
+  Mismatches m;
+  for (const auto &i : airspaces.QueryAll())
+    Compare(i.GetAirspace(), airspaces.GetProjection(), m);
+
+  ok1((m.indexed > 0) == has_large_polygons);
+  ok1(m.inside == 0);
+  ok1(m.intersects == 0);
+}
+
+/**
+ * A star shaped polygon with many spikes, which has lots of edges in
+ * each band.
+ */
+static void
+TestStar()
+{
+  const GeoPoint center(Angle::Degrees(7), Angle::Degrees(51));
+
+  std::vector<GeoPoint> points;
+  for (unsigned i = 0; i < 3000; ++i) {
+    const double radius = i % 2 == 0 ? 0.5 : 0.05 + 0.4 * rand() / RAND_MAX;
+    const Angle angle = Angle::FullCircle() * (i / 3000.);
+    points.emplace_back(center.longitude + Angle::Degrees(radius) * angle.cos(),
+                        center.latitude + Angle::Degrees(radius) * angle.sin());
+  }
+
+  AirspacePolygon airspace(points);
+
+  const FlatProjection projection(center);
+  airspace.GetBoundingBox(projection);
+
+  Mismatches m;
+  Compare(airspace, projection, m);
+
+  ok1(m.indexed > 0);
+  ok1(m.inside == 0);
+  ok1(m.intersects == 0);
+}
+
+int main(int argc, char **argv)
+try {
+  plan_tests(15);
+
+  srand(0);
+
+  TestFile(Path(_T("test/data/airspace/openair.txt")), false);
+  TestFile(Path(_T("test/data/AirspaceAus-DAA.txt")), true);
+  TestFile(Path(_T("test/data/airspace/tnp.sua")), false);
+  TestStar();
+
+  return exit_status();
+} catch (const std::runtime_error &e) {
+  PrintException(e);
+  return EXIT_FAILURE;
+}
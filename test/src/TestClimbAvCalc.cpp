@@ -114,13 +114,32 @@ TestExpiration()
   ok1(!c.Expired(61, 60));
 }
 
+static void
+TestTimeWarp()
+{
+  /* value-initialised, as in a container */
+  ClimbAverageCalculator c{};
+
+  constexpr double AVERAGE_TIME = 30;
+
+  ok1(c.Expired(0, 60));
+
+  for (unsigned i = 0; i <= 100; i++)
+    c.GetAverage(100 + i, 2 * i, AVERAGE_TIME);
+
+  // Time warp discards the old samples
+  ok1(equals(c.GetAverage(50, 0, AVERAGE_TIME), 0));
+  ok1(equals(c.GetAverage(60, 30, AVERAGE_TIME), 3));
+}
+
 int main(int argc, char **argv)
 {
-  plan_tests(16);
+  plan_tests(19);
 
   TestBasic();
   TestDuplicateTimestamps();
   TestExpiration();
+  TestTimeWarp();
 
   return exit_status();
 }
@@ -24,40 +24,45 @@
 #include "FLARM/FlarmNetReader.hpp"
 #include "FLARM/FlarmNetRecord.hpp"
 #include "FLARM/FlarmId.hpp"
+#include "OS/FileMapping.hpp"
 #include "OS/Path.hpp"
+#include "Util/StringAPI.hxx"
 #include "TestUtil.hpp"
 
-int main(int argc, char **argv)
-{
-  plan_tests(15);
+#include <stdio.h>
 
-  FlarmNetDatabase db;
-  int count = FlarmNetReader::LoadFile(Path(_T("test/data/flarmnet/data.fln")),
-                                       db);
-  ok1(count == 6);
+static const char *cache_path = "output/flarmnet.cache";
+
+static void
+TestLookups(const FlarmNetDatabase &db)
+{
+  ok1(db.GetCount() == 6);
 
   FlarmId id = FlarmId::Parse("DDA85C", NULL);
 
-  const FlarmNetRecord *record = db.FindRecordById(id);
-  ok1(record != NULL);
+  FlarmNetRecord record = db.FindRecordById(id);
+  ok1(record.IsDefined());
+
+  ok1(StringIsEqual(record.id, _T("DDA85C")));
+  ok1(StringIsEqual(record.pilot, _T("Tobias Bieniek")));
+  ok1(StringIsEqual(record.airfield, _T("AACHEN")));
+  ok1(StringIsEqual(record.plane_type, _T("Hornet")));
+  ok1(StringIsEqual(record.registration, _T("D-4449")));
+  ok1(StringIsEqual(record.callsign, _T("TH")));
+  ok1(StringIsEqual(record.frequency, _T("130.625")));
+  ok1(record.GetId() == id);
 
-  ok1(StringIsEqual(record->id, _T("DDA85C")));
-  ok1(StringIsEqual(record->pilot, _T("Tobias Bieniek")));
-  ok1(StringIsEqual(record->airfield, _T("AACHEN")));
-  ok1(StringIsEqual(record->plane_type, _T("Hornet")));
-  ok1(StringIsEqual(record->registration, _T("D-4449")));
-  ok1(StringIsEqual(record->callsign, _T("TH")));
-  ok1(StringIsEqual(record->frequency, _T("130.625")));
+  ok1(!db.FindRecordById(FlarmId::Parse("123456", NULL)).IsDefined());
 
-  const FlarmNetRecord *array[3];
+  FlarmNetRecord array[3];
   ok1(db.FindRecordsByCallSign(_T("TH"), array, 3) == 2);
 
   bool found4449 = false, found5799 = false;
   for (unsigned i = 0; i < 2; i++) {
     record = array[i];
-    if (StringIsEqual(record->registration, _T("D-4449")))
+    if (StringIsEqual(record.registration, _T("D-4449")))
       found4449 = true;
-    if (StringIsEqual(record->registration, _T("D-5799")))
+    if (StringIsEqual(record.registration, _T("D-5799")))
       found5799 = true;
   }
   ok1(found4449);
@@ -78,5 +83,89 @@ int main(int argc, char **argv)
   ok1(foundDDA85C);
   ok1(foundDDA896);
 
+  /* the result is limited to the buffer size */
+  ok1(db.FindIdsByCallSign(_T("TH"), ids, 1) == 1);
+  ok1(db.FindIdsByCallSign(_T("T"), ids, 3) == 0);
+
+  /* prefix search */
+  ok1(db.FindIdsByCallSignPrefix(_T("T"), ids, 3) == 2);
+  ok1(db.FindIdsByCallSignPrefix(_T("TH"), ids, 3) == 2);
+  ok1(db.FindIdsByCallSignPrefix(_T("T"), ids, 1) == 1);
+  ok1(db.FindIdsByCallSignPrefix(_T("THX"), ids, 3) == 0);
+  ok1(db.FindIdsByCallSignPrefix(_T("1"), ids, 3) >= 1 &&
+      ids[0] == FlarmId::Parse("DDA86A", NULL));
+
+  /* the record with the lowest id is the first one */
+  record = db.FindFirstRecordByCallSign(_T("TH"));
+  ok1(record.IsDefined() && record.GetId() == id);
+  ok1(db.FindFirstRecordByCallSign(_T("1A")).GetId() ==
+      FlarmId::Parse("DDA86A", NULL));
+  ok1(!db.FindFirstRecordByCallSign(_T("XX")).IsDefined());
+}
+
+static void
+TestBuilder()
+{
+  FlarmNetDatabaseBuilder builder;
+
+  const FlarmNetRecord a = {
+    _T("DDA85C"), _T("A"), _T(""), _T(""), _T(""), _T("TH"), _T(""),
+  };
+  const FlarmNetRecord b = {
+    _T("DDA85C"), _T("B"), _T(""), _T(""), _T(""), _T("TH"), _T(""),
+  };
+  const FlarmNetRecord malformed = {
+    _T("XYZ"), _T("C"), _T(""), _T(""), _T(""), _T("TH"), _T(""),
+  };
+  builder.Add(a);
+  builder.Add(b);
+  builder.Add(malformed);
+
+  FlarmNetDatabase db;
+  db.Load(builder);
+
+  /* only the first record of a duplicate id is used */
+  ok1(db.GetCount() == 1);
+  ok1(StringIsEqual(db.FindRecordById(FlarmId::Parse("DDA85C", NULL)).pilot,
+                    _T("A")));
+}
+
+static void
+TestCache(const FlarmNetDatabase &db)
+{
+  /* write some garbage first, like the FileCache header */
+  FILE *file = fopen(cache_path, "wb");
+  ok1(file != NULL);
+  ok1(fwrite("XYZ", 1, 3, file) == 3);
+  ok1(db.Save(file));
+  fclose(file);
+
+  FlarmNetDatabase mapped;
+  auto mapping = std::make_unique<FileMapping>(Path(_T("output/flarmnet.cache")));
+  ok1(!mapping->error());
+  ok1(!mapped.Open(std::move(mapping), 0));
+  ok1(mapped.IsEmpty());
+
+  mapping = std::make_unique<FileMapping>(Path(_T("output/flarmnet.cache")));
+  ok1(mapped.Open(std::move(mapping), 3));
+
+  TestLookups(mapped);
+
+  remove(cache_path);
+}
+
+int main(int argc, char **argv)
+{
+  plan_tests(64);
+
+  FlarmNetDatabase db;
+  int count = FlarmNetReader::LoadFile(Path(_T("test/data/flarmnet/data.fln")),
+                                       db);
+  ok1(count == 6);
+
+  TestLookups(db);
+  TestBuilder();
+  TestCache(db);
+
   return exit_status();
 }
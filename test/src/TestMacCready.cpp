@@ -29,6 +29,8 @@
 
 #include "TestUtil.hpp"
 
+#include <vector>
+
 static GlideSettings glide_settings;
 static GlidePolar glide_polar(0);
 
@@ -139,25 +141,85 @@ TestAll()
   TestWind(SpeedVector(Angle::Zero(), 30));
 }
 
+static bool
+IsEqualResult(const GlideResult &a, const GlideResult &b)
+{
+  if (a.validity != b.validity)
+    return false;
+
+  if (!a.IsOk())
+    return true;
+
+  return equals(a.vector.distance, b.vector.distance) &&
+    equals(a.time_elapsed, b.time_elapsed) &&
+    equals(a.time_virtual, b.time_virtual) &&
+    equals(a.height_climb, b.height_climb) &&
+    equals(a.height_glide, b.height_glide) &&
+    equals(a.altitude_difference, b.altitude_difference) &&
+    equals(a.pure_glide_altitude_difference,
+           b.pure_glide_altitude_difference) &&
+    equals(a.effective_wind_speed, b.effective_wind_speed);
+}
+
+/**
+ * Verify that the batch solvers agree with the scalar solvers.
+ */
+static void
+TestBatch()
+{
+  std::vector<GlideState> tasks;
+
+  for (double distance : { 0., 100., 1000., 10000., 100000. })
+    for (double altitude : { -1000., -200., 0., 100., 500., 4000. })
+      for (double wind_speed : { 0., 5., 15., 30. })
+        for (unsigned bearing = 0; bearing < 360; bearing += 30)
+          tasks.emplace_back(GeoVector(distance, Angle::Degrees(45)),
+                             2000, 2000 + altitude,
+                             SpeedVector(Angle::Degrees(bearing),
+                                         wind_speed));
+
+  const MacCready mac(glide_settings, glide_polar);
+  std::vector<GlideResult> results(tasks.size());
+
+  mac.SolveBatch(tasks.data(), results.data(), tasks.size());
+
+  bool same = true;
+  for (unsigned i = 0; i < tasks.size(); ++i)
+    same &= IsEqualResult(results[i], mac.Solve(tasks[i]));
+  ok1(same);
+
+  mac.SolveStraightBatch(tasks.data(), results.data(), tasks.size());
+
+  same = true;
+  for (unsigned i = 0; i < tasks.size(); ++i)
+    same &= IsEqualResult(results[i], mac.SolveStraight(tasks[i]));
+  ok1(same);
+}
+
 int main(int argc, char **argv)
 {
-  plan_tests(2095);
+  plan_tests(2105);
 
   glide_settings.SetDefaults();
 
   TestAll();
+  TestBatch();
 
   glide_polar.SetMC(0.1);
   TestAll();
+  TestBatch();
 
   glide_polar.SetMC(1);
   TestAll();
+  TestBatch();
 
   glide_polar.SetMC(4);
   TestAll();
+  TestBatch();
 
   glide_polar.SetMC(10);
   TestAll();
+  TestBatch();
 
   return exit_status();
 }
@@ -0,0 +1,300 @@
+/* Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+
+#include "Cloud/Sharded.hpp"
+#include "Cloud/Serialiser.hpp"
+#include "IO/OutputStream.hxx"
+#include "IO/Reader.hxx"
+#include "Util/Macros.hpp"
+#include "TestUtil.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include <stdint.h>
+#include <string.h>
+
+static constexpr double RANGE = 50000;
+
+class MemoryOutputStream final : public OutputStream {
+public:
+  std::vector<uint8_t> buffer;
+
+  void Write(const void *data, size_t size) override {
+    const uint8_t *p = (const uint8_t *)data;
+    buffer.insert(buffer.end(), p, p + size);
+  }
+};
+
+class MemoryReader final : public Reader {
+  const std::vector<uint8_t> &buffer;
+  size_t position = 0;
+
+public:
+  explicit MemoryReader(const std::vector<uint8_t> &_buffer)
+    :buffer(_buffer) {}
+
+  size_t Read(void *data, size_t size) override {
+    size = std::min(size, buffer.size() - position);
+    memcpy(data, buffer.data() + position, size);
+    position += size;
+    return size;
+  }
+};
+
+/**
+ * A deterministic pseudo random number generator, so failures can be
+ * reproduced.
+ */
+static unsigned
+NextRandom(unsigned &state)
+{
+  state = state * 1103515245u + 12345u;
+  return state >> 8;
+}
+
+static double
+RandomDouble(unsigned &state, double min, double max)
+{
+  return min + (max - min) * (NextRandom(state) % 1000000) / 1000000.;
+}
+
+static const boost::asio::ip::udp::endpoint &
+GetEndpoint()
+{
+  static const boost::asio::ip::udp::endpoint endpoint(boost::asio::ip::udp::v4(),
+                                                       5597);
+  return endpoint;
+}
+
+/**
+ * Locations around which clients are clustered, including the date
+ * line and the poles, and thus boxes crossing cell and shard
+ * boundaries.
+ */
+static const GeoPoint centers[] = {
+  GeoPoint(Angle::Degrees(7.7), Angle::Degrees(51.4)),
+  GeoPoint(Angle::Degrees(145.9), Angle::Degrees(-36.5)),
+  GeoPoint(Angle::Degrees(179.9), Angle::Degrees(-17)),
+  GeoPoint(Angle::Degrees(-179.9), Angle::Degrees(-17.2)),
+  GeoPoint(Angle::Degrees(12), Angle::Degrees(89.9)),
+  GeoPoint(Angle::Degrees(-70), Angle::Degrees(-89.9)),
+  GeoPoint(Angle::Degrees(-0.5), Angle::Degrees(0.5)),
+};
+
+static void
+Populate(ShardedCloudData &data)
+{
+  unsigned state = 42;
+
+  for (unsigned i = 0; i < 2000; ++i) {
+    const GeoPoint &center = centers[i % ARRAY_SIZE(centers)];
+    GeoPoint location(center.longitude +
+                            Angle::Degrees(RandomDouble(state, -1.5, 1.5)),
+                            center.latitude +
+                            Angle::Degrees(RandomDouble(state, -1.5, 1.5)));
+    data.Make(GetEndpoint(), 1000 + i, location.Normalize(), 1000);
+  }
+
+  for (unsigned i = 0; i < 200; ++i) {
+    const GeoPoint &center = centers[i % ARRAY_SIZE(centers)];
+    GeoPoint top(center.longitude +
+                       Angle::Degrees(RandomDouble(state, -0.5, 0.5)),
+                       center.latitude +
+                       Angle::Degrees(RandomDouble(state, -0.5, 0.5)));
+    top.Normalize();
+    data.MakeThermal(1000 + i, AGeoPoint(top, 500),
+                     AGeoPoint(top, 1500), 2);
+  }
+}
+
+gcc_pure
+static std::vector<uint64_t>
+QueryClients(const ShardedCloudData &data, GeoPoint location)
+{
+  std::vector<uint64_t> result;
+  data.VisitClientsWithinRange(location, RANGE,
+                               [&result](const CloudClient &client){
+                                 result.push_back(client.key);
+                               });
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+gcc_pure
+static std::vector<uint64_t>
+QueryThermals(const ShardedCloudData &data, GeoPoint location)
+{
+  std::vector<uint64_t> result;
+  data.VisitThermalsWithinRange(location, RANGE,
+                                [&result](const CloudThermal &thermal){
+                                  result.push_back(thermal.client_key);
+                                });
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+/**
+ * Compare range queries of a sharded instance with a single-shard
+ * reference.
+ */
+static bool
+SameResults(const ShardedCloudData &reference, const ShardedCloudData &data)
+{
+  for (const auto &center : centers)
+    if (QueryClients(data, center) != QueryClients(reference, center) ||
+        QueryThermals(data, center) != QueryThermals(reference, center))
+      return false;
+
+  return true;
+}
+
+static void
+TestRange(const ShardedCloudData &reference)
+{
+  for (const auto &center : centers)
+    ok1(!QueryClients(reference, center).empty());
+
+  for (unsigned n_shards : {2, 7, 64}) {
+    ShardedCloudData data(n_shards);
+    Populate(data);
+    ok1(SameResults(reference, data));
+  }
+}
+
+static void
+TestMove()
+{
+  ShardedCloudData data(7);
+
+  const GeoPoint a(Angle::Degrees(7.7), Angle::Degrees(51.4));
+  const GeoPoint b(Angle::Degrees(-120), Angle::Degrees(37));
+
+  const auto info = data.Make(GetEndpoint(), 1, a, 500);
+  ok1(QueryClients(data, a) == std::vector<uint64_t>{1});
+  ok1(QueryClients(data, b).empty());
+
+  /* move the client to another continent, probably owned by another
+     shard */
+  const auto moved = data.Make(GetEndpoint(), 1, b, 600);
+  ok1(moved.id == info.id);
+  ok1(QueryClients(data, a).empty());
+  ok1(QueryClients(data, b) == std::vector<uint64_t>{1});
+
+  GeoPoint location = GeoPoint::Invalid();
+  int altitude = 0;
+  ok1(data.WithClient(1, [&](const CloudClient &client){
+        location = client.location;
+        altitude = client.altitude;
+      }));
+  ok1(location == b);
+  ok1(altitude == 600);
+
+  ok1(!data.WithClient(2, [](const CloudClient &){}));
+}
+
+static void
+TestWrap()
+{
+  ShardedCloudData data(7);
+
+  /* both sides of the date line */
+  data.Make(GetEndpoint(), 1,
+            GeoPoint(Angle::Degrees(179.9), Angle::Degrees(-17)), 500);
+  data.Make(GetEndpoint(), 2,
+            GeoPoint(Angle::Degrees(-179.9), Angle::Degrees(-17)), 500);
+  ok1(QueryClients(data, GeoPoint(Angle::Degrees(179.95),
+                                  Angle::Degrees(-17))) ==
+      (std::vector<uint64_t>{1, 2}));
+
+  /* near the pole, the range covers all longitudes */
+  data.Make(GetEndpoint(), 3,
+            GeoPoint(Angle::Degrees(0), Angle::Degrees(89.9)), 500);
+  data.Make(GetEndpoint(), 4,
+            GeoPoint(Angle::Degrees(180), Angle::Degrees(89.9)), 500);
+  ok1(QueryClients(data, GeoPoint(Angle::Degrees(90),
+                                  Angle::Degrees(89.9))) ==
+      (std::vector<uint64_t>{3, 4}));
+}
+
+static void
+TestExpire()
+{
+  ShardedCloudData data(7);
+  Populate(data);
+
+  data.Expire(std::chrono::steady_clock::now() - std::chrono::hours(1));
+  ok1(data.WithClient(1000, [](const CloudClient &){}));
+
+  data.Expire(std::chrono::steady_clock::now() + std::chrono::hours(1));
+  ok1(!data.WithClient(1000, [](const CloudClient &){}));
+
+  for (const auto &center : centers)
+    ok1(QueryClients(data, center).empty());
+}
+
+static void
+TestSaveLoad(const ShardedCloudData &reference)
+{
+  ShardedCloudData data(7);
+  Populate(data);
+
+  MemoryOutputStream os;
+
+  {
+    Serialiser s(os);
+    data.Save(s);
+    s.Flush();
+  }
+
+  /* load into a different number of shards */
+  ShardedCloudData loaded(3);
+
+  {
+    MemoryReader r(os.buffer);
+    Deserialiser s(r);
+    loaded.Load(s);
+  }
+
+  ok1(SameResults(reference, loaded));
+
+  /* client ids are not reused */
+  const auto info = loaded.Make(GetEndpoint(), 1, centers[0], 500);
+  ok1(info.id >= 2000);
+}
+
+int main(int argc, char **argv)
+{
+  plan_tests(7 + 3 + 9 + 2 + 2 + 7 + 2);
+
+  ShardedCloudData reference(1);
+  Populate(reference);
+
+  TestRange(reference);
+  TestMove();
+  TestWrap();
+  TestExpire();
+  TestSaveLoad(reference);
+
+  return exit_status();
+}
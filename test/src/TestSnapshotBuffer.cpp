@@ -0,0 +1,173 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#include "Thread/SnapshotBuffer.hpp"
+#include "Thread/Thread.hpp"
+#include "TestUtil.hpp"
+
+/**
+ * A value which allows detecting torn snapshots: all elements must be
+ * equal.
+ */
+struct Snapshot {
+  static constexpr unsigned SIZE = 64;
+
+  unsigned values[SIZE];
+
+  void Fill(unsigned value) {
+    for (auto &i : values)
+      i = value;
+  }
+
+  bool IsConsistent() const {
+    for (auto i : values)
+      if (i != values[0])
+        return false;
+    return true;
+  }
+};
+
+static constexpr unsigned N_READERS = 3;
+static constexpr unsigned N_PUBLISH = 200000;
+
+typedef SnapshotBuffer<Snapshot, N_READERS> Buffer;
+
+class ProducerThread final : public Thread {
+  Buffer &buffer;
+
+public:
+  explicit ProducerThread(Buffer &_buffer)
+    :Thread("producer"), buffer(_buffer) {}
+
+protected:
+  void Run() override {
+    for (unsigned i = 1; i <= N_PUBLISH; ++i) {
+      buffer.GetBack().Fill(i);
+      buffer.Publish();
+    }
+  }
+};
+
+class ReaderThread final : public Thread {
+  Buffer::Reader reader;
+
+public:
+  bool consistent = true, monotonic = true;
+  unsigned last = 0;
+
+  explicit ReaderThread(Buffer &buffer)
+    :Thread("reader"), reader(buffer) {}
+
+protected:
+  void Run() override {
+    while (last < N_PUBLISH) {
+      if (!reader.Update())
+        continue;
+
+      /* check twice: the borrowed snapshot must not be modified
+         while the producer keeps publishing */
+      const Snapshot &snapshot = reader.GetFront();
+      const unsigned value = snapshot.values[0];
+      consistent &= snapshot.IsConsistent();
+      consistent &= snapshot.IsConsistent() && snapshot.values[0] == value;
+      monotonic &= value > last || (last == 0 && value == 0);
+      last = value;
+    }
+  }
+};
+
+static void
+TestSingleThread()
+{
+  SnapshotBuffer<unsigned, 2> buffer;
+  SnapshotBuffer<unsigned, 2>::Reader a(buffer), b(buffer);
+
+  /* nothing was published yet */
+  ok1(!a.IsFresh());
+  ok1(!a.Update());
+
+  buffer.Publish(1);
+  ok1(a.IsFresh());
+  ok1(a.Update());
+  ok1(a.GetFront() == 1);
+  ok1(!a.IsFresh());
+  ok1(!a.Update());
+
+  /* only the latest snapshot is delivered; the borrowed front buffer
+     is not touched by the producer */
+  buffer.Publish(2);
+  buffer.Publish(3);
+  buffer.Publish(4);
+  buffer.Publish(5);
+  ok1(a.GetFront() == 1);
+  ok1(b.Update());
+  ok1(b.GetFront() == 5);
+
+  buffer.Publish(6);
+  buffer.Publish(7);
+  buffer.Publish(8);
+  ok1(a.GetFront() == 1);
+  ok1(b.GetFront() == 5);
+
+  ok1(a.Update());
+  ok1(a.GetFront() == 8);
+  ok1(b.Update());
+  ok1(b.GetFront() == 8);
+  ok1(!a.Update());
+  ok1(!b.Update());
+}
+
+static void
+TestConcurrent()
+{
+  Buffer buffer;
+  buffer.GetBack().Fill(0);
+  buffer.Publish();
+
+  ReaderThread r1(buffer), r2(buffer), r3(buffer);
+  ProducerThread producer(buffer);
+
+  r1.Start();
+  r2.Start();
+  r3.Start();
+  producer.Start();
+
+  producer.Join();
+  r1.Join();
+  r2.Join();
+  r3.Join();
+
+  ok1(r1.consistent && r2.consistent && r3.consistent);
+  ok1(r1.monotonic && r2.monotonic && r3.monotonic);
+  ok1(r1.last == N_PUBLISH && r2.last == N_PUBLISH && r3.last == N_PUBLISH);
+}
+
+int main(int argc, char **argv)
+{
+  plan_tests(21);
+
+  TestSingleThread();
+  TestConcurrent();
+
+  return exit_status();
+}
@@ -0,0 +1,156 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#include "Terrain/RasterBuffer.hpp"
+#include "Terrain/InterpolationBatch.hpp"
+
+extern "C" {
+#include "tap.h"
+}
+
+#include <stdlib.h>
+
+static constexpr unsigned WIDTH = 64, HEIGHT = 48;
+
+static void
+FillBuffer(RasterBuffer &buffer)
+{
+  TerrainHeight *p = buffer.GetData();
+  for (unsigned i = 0; i < WIDTH * HEIGHT; ++i) {
+    const int r = rand() % 100;
+    if (r == 0)
+      p[i] = TerrainHeight::Invalid();
+    else if (r == 1)
+      /* water */
+      p[i] = TerrainHeight(-30000 - rand() % 100);
+    else if (r < 10)
+      /* below sea level */
+      p[i] = TerrainHeight(-(rand() % 500));
+    else
+      p[i] = TerrainHeight(rand() % 9000);
+  }
+}
+
+/**
+ * Compare TerrainInterpolationBatch::Compute() with
+ * RasterBuffer::GetInterpolated() for the specified number of random
+ * sub-pixel locations.
+ */
+static bool
+CompareRandom(const RasterBuffer &buffer, unsigned n)
+{
+  TerrainInterpolationBatch batch;
+  TerrainHeight expected[TerrainInterpolationBatch::CAPACITY];
+  TerrainHeight actual[TerrainInterpolationBatch::CAPACITY];
+
+  for (unsigned i = 0; i < n; ++i) {
+    /* include some locations which are out of range */
+    const unsigned lx = rand() % (buffer.GetFineWidth() + 512);
+    const unsigned ly = rand() % (buffer.GetFineHeight() + 512);
+
+    expected[i] = buffer.GetInterpolated(lx, ly);
+    buffer.AppendInterpolated(batch, lx, ly);
+  }
+
+  batch.Compute(actual);
+
+  for (unsigned i = 0; i < n; ++i)
+    if (actual[i].GetValue() != expected[i].GetValue())
+      return false;
+
+  return true;
+}
+
+static bool
+CompareEdges(const RasterBuffer &buffer)
+{
+  TerrainInterpolationBatch batch;
+  TerrainHeight expected[8], actual[8];
+
+  const unsigned x = WIDTH - 1, y = HEIGHT - 1;
+  const unsigned locations[8][4] = {
+    { 0, 0, 0, 0 },
+    { x, 0, 0x80, 0x40 },
+    { 0, y, 0xff, 0xff },
+    { x, y, 0x10, 0xf0 },
+    { x - 1, y - 1, 0xff, 0x01 },
+    { 1, 1, 0x01, 0xff },
+    { x, 1, 0xff, 0xff },
+    { 1, y, 0xff, 0xff },
+  };
+
+  for (unsigned i = 0; i < 8; ++i) {
+    const auto &l = locations[i];
+    expected[i] = buffer.GetInterpolated(l[0], l[1], l[2], l[3]);
+    buffer.AppendInterpolated(batch, l[0], l[1], l[2], l[3]);
+  }
+
+  batch.Compute(actual);
+
+  for (unsigned i = 0; i < 8; ++i)
+    if (actual[i].GetValue() != expected[i].GetValue())
+      return false;
+
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  plan_tests(8);
+
+  RasterBuffer buffer(WIDTH, HEIGHT);
+  FillBuffer(buffer);
+
+  /* various sizes to exercise both the SIMD and the portable code */
+  ok1(CompareRandom(buffer, 1));
+  ok1(CompareRandom(buffer, 3));
+  ok1(CompareRandom(buffer, 4));
+  ok1(CompareRandom(buffer, 37));
+  ok1(CompareRandom(buffer, TerrainInterpolationBatch::CAPACITY));
+  ok1(CompareEdges(buffer));
+
+  /* ScanLine() uses the batch internally */
+  TerrainHeight scan[200];
+  buffer.ScanLine(0, 0, buffer.GetFineWidth() - 1, buffer.GetFineHeight() - 1,
+                  scan, 200, true);
+  bool scan_ok = true;
+  for (unsigned i = 0; i < 200; ++i) {
+    unsigned cx = (i * (int)(buffer.GetFineWidth() - 1)) / 199;
+    unsigned cy = (i * (int)(buffer.GetFineHeight() - 1)) / 199;
+    if (scan[i].GetValue() != buffer.GetInterpolated(cx, cy).GetValue())
+      scan_ok = false;
+  }
+  ok1(scan_ok);
+
+  buffer.ScanLine(10, 300, buffer.GetFineWidth() - 1, 300,
+                  scan, 100, true);
+  scan_ok = true;
+  for (unsigned i = 0; i < 100; ++i) {
+    unsigned cx = 10 + (i * (int)(buffer.GetFineWidth() - 11)) / 99;
+    if (scan[i].GetValue() != buffer.GetInterpolated(cx, 300).GetValue())
+      scan_ok = false;
+  }
+  ok1(scan_ok);
+
+  return exit_status();
+}
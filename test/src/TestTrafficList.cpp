@@ -0,0 +1,129 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#include "FLARM/List.hpp"
+#include "TestUtil.hpp"
+
+#include <stdio.h>
+
+static FlarmId
+MakeId(unsigned i)
+{
+  /* similar ids, as issued by the manufacturers */
+  char buffer[16];
+  snprintf(buffer, sizeof(buffer), "DD%04X", i);
+  return FlarmId::Parse(buffer, nullptr);
+}
+
+static void
+Fill(TrafficList &list, double clock)
+{
+  for (unsigned i = 0; i < TrafficList::MAX_COUNT; ++i) {
+    FlarmTraffic *traffic = list.AllocateTraffic(MakeId(i));
+    if (traffic == nullptr)
+      return;
+
+    traffic->valid.Update(clock + (i % 2));
+  }
+}
+
+static bool
+FindAll(const TrafficList &list, unsigned step)
+{
+  for (unsigned i = 0; i < TrafficList::MAX_COUNT; i += step) {
+    const FlarmTraffic *traffic = list.FindTraffic(MakeId(i));
+    if (traffic == nullptr || !(traffic->id == MakeId(i)))
+      return false;
+  }
+
+  return true;
+}
+
+static void
+TestAllocate()
+{
+  TrafficList list;
+  list.Clear();
+
+  ok1(list.IsEmpty());
+  ok1(list.FindTraffic(MakeId(0)) == nullptr);
+
+  Fill(list, 10);
+  ok1(list.GetActiveTrafficCount() == TrafficList::MAX_COUNT);
+  ok1(FindAll(list, 1));
+  ok1(list.FindTraffic(MakeId(TrafficList::MAX_COUNT)) == nullptr);
+  ok1(list.AllocateTraffic(MakeId(TrafficList::MAX_COUNT)) == nullptr);
+
+  /* copies keep a working index */
+  const TrafficList copy = list;
+  ok1(FindAll(copy, 1));
+
+  list.Clear();
+  ok1(list.IsEmpty());
+  ok1(list.FindTraffic(MakeId(0)) == nullptr);
+}
+
+static void
+TestExpire()
+{
+  TrafficList list;
+  list.Clear();
+
+  Fill(list, 10);
+
+  /* the even ones expire first */
+  list.Expire(12.5);
+  ok1(list.GetActiveTrafficCount() == TrafficList::MAX_COUNT / 2);
+  ok1(FindAll(list, 2) == false);
+
+  bool found_even = false, found_odd = true;
+  for (unsigned i = 0; i < TrafficList::MAX_COUNT; ++i) {
+    const FlarmTraffic *traffic = list.FindTraffic(MakeId(i));
+    if (i % 2 == 0)
+      found_even |= traffic != nullptr;
+    else
+      found_odd &= traffic != nullptr && traffic->id == MakeId(i);
+  }
+
+  ok1(!found_even);
+  ok1(found_odd);
+
+  /* the free slots can be reused */
+  FlarmTraffic *traffic = list.AllocateTraffic(MakeId(0));
+  ok1(traffic != nullptr);
+  ok1(list.FindTraffic(MakeId(0)) == traffic);
+
+  list.Expire(20);
+  ok1(list.IsEmpty());
+  ok1(list.FindTraffic(MakeId(1)) == nullptr);
+}
+
+int main(int argc, char **argv)
+{
+  plan_tests(17);
+
+  TestAllocate();
+  TestExpire();
+
+  return exit_status();
+}
@@ -0,0 +1,115 @@
+/*
+Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#include "Thread/WorkStealingPool.hpp"
+#include "TestUtil.hpp"
+
+#include <atomic>
+#include <memory>
+
+/**
+ * Counts how often each task was executed and stores a result per
+ * task, so the caller can verify that no task was lost or duplicated.
+ */
+class CountingJob final : public TaskRunner::Job {
+  const unsigned n;
+  std::unique_ptr<std::atomic<unsigned>[]> counts;
+  std::unique_ptr<unsigned[]> results;
+
+public:
+  explicit CountingJob(unsigned _n)
+    :n(_n),
+     counts(new std::atomic<unsigned>[n]),
+     results(new unsigned[n]) {
+    for (unsigned i = 0; i < n; ++i) {
+      counts[i] = 0;
+      results[i] = 0;
+    }
+  }
+
+  bool Check() const {
+    for (unsigned i = 0; i < n; ++i)
+      if (counts[i] != 1 || results[i] != Compute(i))
+        return false;
+    return true;
+  }
+
+  /* virtual methods from class TaskRunner::Job */
+  void RunTask(unsigned i) override {
+    ++counts[i];
+    results[i] = Compute(i);
+  }
+
+private:
+  /**
+   * Some work whose duration depends on the task index, so the
+   * queues drain unevenly and the threads have to steal.
+   */
+  static unsigned Compute(unsigned i) {
+    unsigned x = i;
+    for (unsigned j = 0, m = (i % 17) * 100; j < m; ++j)
+      x = x * 1103515245u + 12345u;
+    return x;
+  }
+};
+
+static bool
+RunCounting(TaskRunner &runner, unsigned n)
+{
+  CountingJob job(n);
+  runner.Run(job, n);
+  return job.Check();
+}
+
+static void
+TestPool(unsigned n_threads)
+{
+  WorkStealingPool pool(n_threads);
+  ok1(pool.GetConcurrency() == n_threads);
+
+  /* fewer tasks than threads, and an empty job */
+  ok(RunCounting(pool, 0) && RunCounting(pool, 1) && RunCounting(pool, 3),
+     "small jobs (%u threads)", n_threads);
+
+  ok(RunCounting(pool, 100000), "large job (%u threads)", n_threads);
+
+  /* many short jobs in a row must not lose a wakeup */
+  bool all = true;
+  for (unsigned i = 0; i < 1000; ++i)
+    all = all && RunCounting(pool, 1 + i % 32);
+  ok(all, "repeated jobs (%u threads)", n_threads);
+}
+
+int main(int argc, char **argv)
+{
+  plan_tests(17);
+
+  ok1(WorkStealingPool::GetProcessorCount() >= 1);
+
+  TestPool(1);
+  TestPool(2);
+  TestPool(4);
+  TestPool(8);
+
+  return exit_status();
+}
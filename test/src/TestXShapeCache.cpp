@@ -0,0 +1,136 @@
+/* Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+#include "Topography/XShapeCache.hpp"
+#include "Topography/XShape.hpp"
+#include "TestUtil.hpp"
+
+#include <algorithm>
+
+static constexpr unsigned N = 5;
+
+/**
+ * Create a shape which refers to static data (like a mapped shape),
+ * so its memory usage is just the size of the object.
+ */
+static const XShape *
+MakeShape()
+{
+  static constexpr uint16_t lines[1] = { 2 };
+  static const XShapeStore::Point points[2] = {};
+
+  XShapeStore::Shape shape;
+  shape.bounds = GeoBounds(GeoPoint(Angle::Degrees(7), Angle::Degrees(51)),
+                           GeoPoint(Angle::Degrees(8), Angle::Degrees(50)));
+  shape.type = MS_SHAPE_LINE;
+  shape.num_lines = 1;
+  shape.lines = lines;
+  shape.points = points;
+  std::fill_n(shape.index_count, XShapeStore::MAX_LEVELS, nullptr);
+  shape.label = nullptr;
+
+  return new XShape(shape);
+}
+
+int main(int argc, char **argv)
+{
+  plan_tests(36);
+
+  const XShape *probe = MakeShape();
+  const size_t shape_size = probe->GetMemoryUsage();
+  ok1(shape_size >= sizeof(XShape));
+  delete probe;
+
+  XShapeCache cache(3 * shape_size);
+  XShapeCache::Item items[N];
+
+  /* a shape which was never loaded is a miss */
+  ok1(!cache.Acquire(items[0]));
+  ok1(cache.GetMisses() == 1);
+  ok1(cache.GetHits() == 0);
+
+  for (auto &item : items)
+    item.shape = MakeShape();
+
+  /* the fourth shape exceeds the budget and evicts the first one */
+  for (unsigned i = 0; i < 4; ++i)
+    cache.Retain(items[i]);
+
+  ok1(cache.GetSize() == 3 * shape_size);
+  ok1(cache.GetEvictions() == 1);
+  ok1(items[0].shape == nullptr);
+  ok1(!items[0].retained);
+  ok1(items[1].retained && items[2].retained && items[3].retained);
+
+  /* an evicted shape must be loaded again */
+  ok1(!cache.Acquire(items[0]));
+  ok1(cache.GetMisses() == 2);
+
+  /* a retained shape is a hit and leaves the cache */
+  ok1(cache.Acquire(items[1]));
+  ok1(cache.GetHits() == 1);
+  ok1(items[1].shape != nullptr);
+  ok1(!items[1].retained);
+  ok1(cache.GetSize() == 2 * shape_size);
+
+  /* it becomes the most recently used one when it leaves the cache
+     bounds again, so the next eviction hits the oldest one */
+  cache.Retain(items[1]);
+  cache.Retain(items[4]);
+  ok1(cache.GetEvictions() == 2);
+  ok1(items[2].shape == nullptr);
+  ok1(items[1].retained);
+  ok1(items[3].retained);
+  ok1(items[4].retained);
+  ok1(cache.GetSize() == 3 * shape_size);
+
+  /* Remove() does not count and does not delete */
+  cache.Remove(items[3]);
+  ok1(!items[3].retained);
+  ok1(items[3].shape != nullptr);
+  ok1(cache.GetSize() == 2 * shape_size);
+  ok1(cache.GetHits() == 1);
+  ok1(cache.GetMisses() == 2);
+
+  /* removing an item which is not retained is a no-op */
+  cache.Remove(items[3]);
+  ok1(items[3].shape != nullptr);
+  ok1(cache.GetSize() == 2 * shape_size);
+
+  /* a zero budget evicts everything */
+  cache.SetBudget(0);
+  ok1(cache.GetSize() == 0);
+  ok1(cache.GetEvictions() == 4);
+  ok1(items[1].shape == nullptr);
+  ok1(items[4].shape == nullptr);
+
+  /* with a zero budget, shapes are deleted right away */
+  cache.Retain(items[3]);
+  ok1(items[3].shape == nullptr);
+  ok1(cache.GetEvictions() == 5);
+
+  cache.ResetCounters();
+  ok1(cache.GetHits() == 0 && cache.GetMisses() == 0 &&
+      cache.GetEvictions() == 0);
+
+  return exit_status();
+}
@@ -0,0 +1,356 @@
+/* Copyright_License {
+
+  XCSoar Glide Computer - http://www.xcsoar.org/
+  Copyright (C) 2000-2016 The XCSoar Project
+  A detailed list of copyright holders can be found in the file "AUTHORS".
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+}
+*/
+
+
+#include "Topography/XShapeStore.hpp"
+#include "Topography/XShape.hpp"
+#include "OS/FileMapping.hpp"
+#include "OS/Path.hpp"
+#include "Util/StringAPI.hxx"
+#include "TestUtil.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <stdio.h>
+#include <string.h>
+
+static const char *const store_path = "output/xshape.store";
+
+/**
+ * The garbage before the payload, like the #FileCache header.
+ */
+static constexpr size_t PREFIX = 3;
+
+/**
+ * The position of the payload within the file.
+ */
+static constexpr size_t PAYLOAD = 8;
+
+static const float min_distance[XShapeStore::MAX_LEVELS] = { 1, 2, 3, 4 };
+
+static const GeoPoint center(Angle::Degrees(7), Angle::Degrees(50));
+
+static constexpr uint16_t lines_a[2] = { 2, 3 };
+static constexpr uint16_t lines_b[1] = { 2 };
+static XShapeStore::Point points_a[5], points_b[2];
+
+static XShapeStore::Shape
+MakeShape(const GeoBounds &bounds, const uint16_t *lines, unsigned num_lines,
+          const XShapeStore::Point *points, const TCHAR *label)
+{
+  XShapeStore::Shape shape;
+  shape.bounds = bounds;
+  shape.type = MS_SHAPE_LINE;
+  shape.num_lines = num_lines;
+  shape.lines = lines;
+  shape.points = points;
+  std::fill_n(shape.index_count, XShapeStore::MAX_LEVELS, nullptr);
+  shape.label = label;
+  return shape;
+}
+
+static const GeoBounds bounds_a(GeoPoint(Angle::Degrees(7), Angle::Degrees(51)),
+                                GeoPoint(Angle::Degrees(8), Angle::Degrees(50)));
+static const GeoBounds bounds_b(GeoPoint(Angle::Degrees(9), Angle::Degrees(49)),
+                                GeoPoint(Angle::Degrees(10), Angle::Degrees(48)));
+
+/**
+ * Write a store with two shapes and an empty one, and return the
+ * file contents.
+ */
+static std::vector<uint8_t>
+WriteStore()
+{
+  memset(points_a, 0x11, sizeof(points_a));
+  memset(points_b, 0x22, sizeof(points_b));
+
+  FILE *file = fopen(store_path, "wb");
+  ok1(file != nullptr);
+  ok1(fwrite("XYZ", 1, PREFIX, file) == PREFIX);
+
+  XShapeStoreWriter writer(file, center, min_distance);
+  writer.Add(XShape(MakeShape(bounds_a, lines_a, 2, points_a, _T("A"))));
+  writer.Add(XShape(MakeShape(bounds_b, lines_b, 1, points_b, nullptr)));
+  writer.Add(XShape(MakeShape(bounds_a, lines_a, 0, points_a, nullptr)));
+  ok1(writer.Finish());
+  fclose(file);
+
+  std::vector<uint8_t> data;
+  file = fopen(store_path, "rb");
+  int ch;
+  while ((ch = fgetc(file)) != EOF)
+    data.push_back(ch);
+  fclose(file);
+  return data;
+}
+
+/**
+ * Write the (modified) file contents and open them.
+ */
+static bool
+OpenStore(XShapeStore &store, const std::vector<uint8_t> &data)
+{
+  FILE *file = fopen(store_path, "wb");
+  if (file == nullptr ||
+      fwrite(data.data(), 1, data.size(), file) != data.size()) {
+    fclose(file);
+    return false;
+  }
+
+  fclose(file);
+
+  auto mapping = std::make_unique<FileMapping>(Path(_T("output/xshape.store")));
+  return !mapping->error() && store.Open(std::move(mapping), PREFIX);
+}
+
+static XShapeStore::Footer
+GetFooter(const std::vector<uint8_t> &data)
+{
+  XShapeStore::Footer footer;
+  memcpy(&footer, &data[data.size() - sizeof(footer)], sizeof(footer));
+  return footer;
+}
+
+/**
+ * Open a copy of the file with a modified footer.
+ */
+template<typename F>
+static bool
+OpenWithFooter(const std::vector<uint8_t> &data, F &&f)
+{
+  XShapeStore::Footer footer = GetFooter(data);
+  f(footer);
+
+  std::vector<uint8_t> copy(data);
+  memcpy(&copy[copy.size() - sizeof(footer)], &footer, sizeof(footer));
+
+  XShapeStore store;
+  return OpenStore(store, copy);
+}
+
+/**
+ * Open a copy of the file with a modified grid cell start.
+ */
+static bool
+OpenWithGridCell(const std::vector<uint8_t> &data, unsigned cell,
+                 uint32_t value)
+{
+  const XShapeStore::Footer footer = GetFooter(data);
+
+  std::vector<uint8_t> copy(data);
+  memcpy(&copy[PAYLOAD + footer.grid_offset + cell * sizeof(value)],
+         &value, sizeof(value));
+
+  XShapeStore store;
+  return OpenStore(store, copy);
+}
+
+/**
+ * Resolve the first shape in a copy of the file with a modified
+ * entry.
+ */
+template<typename F>
+static bool
+GetShapeWithEntry(const std::vector<uint8_t> &data, F &&f)
+{
+  const XShapeStore::Footer footer = GetFooter(data);
+  const size_t position = PAYLOAD + footer.entries_offset;
+
+  XShapeStore::Entry entry;
+  memcpy(&entry, &data[position], sizeof(entry));
+  f(entry, footer);
+
+  std::vector<uint8_t> copy(data);
+  memcpy(&copy[position], &entry, sizeof(entry));
+
+  XShapeStore store;
+  if (!OpenStore(store, copy))
+    return false;
+
+  XShapeStore::Shape shape;
+  return store.GetShape(0, shape);
+}
+
+static void
+TestRoundTrip(const std::vector<uint8_t> &data)
+{
+  XShapeStore store;
+  ok1(OpenStore(store, data));
+  ok1(store.IsDefined());
+  ok1(store.GetShapeCount() == 3);
+  ok1(store.GetCenter() == center);
+  ok1(store.GetMinimumPointDistance(3) == min_distance[3]);
+
+  XShapeStore::Shape shape;
+  ok1(store.GetShape(0, shape));
+  ok1(shape.type == MS_SHAPE_LINE);
+  ok1(shape.num_lines == 2);
+  ok1(shape.lines[0] == 2 && shape.lines[1] == 3);
+  ok1(memcmp(shape.points, points_a, sizeof(points_a)) == 0);
+  ok1(shape.label != nullptr && StringIsEqual(shape.label, _T("A")));
+  ok1(shape.bounds.GetWest() == bounds_a.GetWest() &&
+      shape.bounds.GetSouth() == bounds_a.GetSouth());
+
+  ok1(store.GetShape(1, shape));
+  ok1(shape.num_lines == 1);
+  ok1(memcmp(shape.points, points_b, sizeof(points_b)) == 0);
+  ok1(shape.label == nullptr);
+
+  /* the empty shape is stored, but can't be resolved */
+  ok1(!store.GetShape(2, shape));
+  ok1(!store.GetShape(3, shape));
+
+  /* the grid finds only the shape overlapping the rectangle */
+  std::vector<unsigned> found;
+  store.VisitShapes(bounds_b, [&found](unsigned i){ found.push_back(i); });
+  ok1(!found.empty() &&
+      std::all_of(found.begin(), found.end(),
+                  [](unsigned i){ return i == 1; }));
+}
+
+static void
+TestTruncated(const std::vector<uint8_t> &data)
+{
+  XShapeStore store;
+
+  /* a missing byte moves the footer */
+  std::vector<uint8_t> copy(data.begin(), data.end() - 1);
+  ok1(!OpenStore(store, copy));
+  ok1(!store.IsDefined());
+
+  /* the footer alone is not enough */
+  copy.assign(data.end() - sizeof(XShapeStore::Footer), data.end());
+  copy.insert(copy.begin(), PAYLOAD, 0);
+  ok1(!OpenStore(store, copy));
+
+  /* less than a footer */
+  copy.assign(data.begin(), data.begin() + PAYLOAD + 4);
+  ok1(!OpenStore(store, copy));
+
+  /* nothing after the prefix */
+  copy.assign(data.begin(), data.begin() + PREFIX);
+  ok1(!OpenStore(store, copy));
+}
+
+static void
+TestCorruptFooter(const std::vector<uint8_t> &data)
+{
+  typedef XShapeStore::Footer Footer;
+
+  ok1(!OpenWithFooter(data, [](Footer &f){ ++f.magic; }));
+  ok1(!OpenWithFooter(data, [](Footer &f){ ++f.version; }));
+  ok1(!OpenWithFooter(data, [](Footer &f){ ++f.point_format; }));
+  ok1(!OpenWithFooter(data, [](Footer &f){ ++f.tchar_size; }));
+  ok1(!OpenWithFooter(data, [](Footer &f){ ++f.entries_offset; }));
+  ok1(!OpenWithFooter(data, [](Footer &f){ f.entries_offset = 0xfffffff8; }));
+  ok1(!OpenWithFooter(data, [](Footer &f){ f.num_shapes = 0x10000000; }));
+  ok1(!OpenWithFooter(data, [](Footer &f){ ++f.grid_offset; }));
+  ok1(!OpenWithFooter(data, [](Footer &f){ f.grid_offset = 0xfffffff8; }));
+  ok1(!OpenWithFooter(data, [](Footer &f){ f.grid_width = 0; }));
+  ok1(!OpenWithFooter(data, [](Footer &f){ f.grid_height = 0xffff; }));
+  ok1(!OpenWithFooter(data, [](Footer &f){ ++f.num_grid_items; }));
+}
+
+static void
+TestCorruptGrid(const std::vector<uint8_t> &data)
+{
+  const XShapeStore::Footer footer = GetFooter(data);
+  const unsigned num_cells = footer.grid_width * footer.grid_height;
+
+  ok1(!OpenWithGridCell(data, 0, 1));
+  ok1(!OpenWithGridCell(data, num_cells, footer.num_grid_items + 1));
+  ok1(!OpenWithGridCell(data, num_cells, 0));
+
+  /* item numbers are checked while visiting */
+  std::vector<uint8_t> copy(data);
+  const uint32_t bad_item = 1000;
+  for (unsigned i = 0; i < footer.num_grid_items; ++i)
+    memcpy(&copy[PAYLOAD + footer.grid_offset +
+                 (num_cells + 1 + i) * sizeof(bad_item)],
+           &bad_item, sizeof(bad_item));
+
+  XShapeStore store;
+  ok1(OpenStore(store, copy));
+
+  unsigned n = 0;
+  store.VisitShapes(bounds_a, [&n](unsigned){ ++n; });
+  ok1(n == 0);
+}
+
+static void
+TestCorruptEntry(const std::vector<uint8_t> &data)
+{
+  typedef XShapeStore::Entry Entry;
+  typedef XShapeStore::Footer Footer;
+
+  /* the unmodified entry is fine */
+  ok1(GetShapeWithEntry(data, [](Entry &, const Footer &){}));
+
+  ok1(!GetShapeWithEntry(data, [](Entry &e, const Footer &){
+        e.num_lines = XShapeStore::MAX_LINES + 1;
+      }));
+  ok1(!GetShapeWithEntry(data, [](Entry &e, const Footer &){
+        e.north = e.south - 1;
+      }));
+  ok1(!GetShapeWithEntry(data, [](Entry &e, const Footer &){
+        e.lines_offset = XShapeStore::NONE;
+      }));
+  ok1(!GetShapeWithEntry(data, [](Entry &e, const Footer &){
+        ++e.lines_offset;
+      }));
+  ok1(!GetShapeWithEntry(data, [](Entry &e, const Footer &f){
+        e.lines_offset = f.entries_offset;
+      }));
+  ok1(!GetShapeWithEntry(data, [](Entry &e, const Footer &){
+        e.points_offset = XShapeStore::NONE;
+      }));
+  ok1(!GetShapeWithEntry(data, [](Entry &e, const Footer &f){
+        /* the points would extend into the shape index */
+        e.points_offset = f.entries_offset - sizeof(XShapeStore::Point);
+      }));
+  ok1(!GetShapeWithEntry(data, [](Entry &e, const Footer &f){
+        e.label_offset = f.entries_offset;
+      }));
+  ok1(!GetShapeWithEntry(data, [](Entry &e, const Footer &){
+        e.index_offset[0] = 0x7ffffff0;
+      }));
+}
+
+int main(int argc, char **argv)
+{
+  plan_tests(55);
+
+  const std::vector<uint8_t> data = WriteStore();
+  ok1(data.size() > PAYLOAD + sizeof(XShapeStore::Footer));
+
+  TestRoundTrip(data);
+  TestTruncated(data);
+  TestCorruptFooter(data);
+  TestCorruptGrid(data);
+  TestCorruptEntry(data);
+
+  remove(store_path);
+
+  return exit_status();
+}
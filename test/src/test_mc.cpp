@@ -28,10 +28,12 @@
 #include "GlideSolvers/MacCready.hpp"
 #include "Navigation/Aircraft.hpp"
 #include "OS/FileUtil.hpp"
+#include "OS/Clock.hpp"
 
 #include <stdio.h>
 #include <fstream>
 #include <string>
+#include <vector>
 #include <math.h>
 
 const double Vmin(5.0);
@@ -266,6 +268,58 @@ test_cb()
   return true;
 }
 
+/**
+ * Generate tasks covering final glide, partial glide, climb-cruise
+ * and vertical tasks in all wind directions.
+ */
+static std::vector<GlideState>
+MakeTasks(unsigned n)
+{
+  std::vector<GlideState> tasks;
+  tasks.reserve(n);
+
+  for (unsigned i = 0; i < n; ++i) {
+    const double distance = (i % 7) * 9000.0 + (i % 3) * 17.0;
+    const double altitude = (int(i % 11) - 3) * 150.0;
+    const SpeedVector wind(Angle::Degrees((i * 37) % 360),
+                           (i % 5) * 4.5);
+    tasks.emplace_back(GeoVector(distance, Angle::Degrees((i * 53) % 360)),
+                       0, altitude, wind);
+  }
+
+  return tasks;
+}
+
+/**
+ * Compare the throughput of Solve() and SolveBatch() over a large
+ * set of tasks, as in the AbortTask with a big landable database.
+ */
+static void
+benchmark_batch()
+{
+  GlideSettings settings;
+  settings.SetDefaults();
+
+  const GlidePolar polar(1);
+  const MacCready mac(settings, polar);
+
+  const auto tasks = MakeTasks(100000);
+  std::vector<GlideResult> results(tasks.size());
+
+  uint64_t start = MonotonicClockUS();
+  for (unsigned i = 0; i < tasks.size(); ++i)
+    results[i] = mac.Solve(tasks[i]);
+  const uint64_t scalar = MonotonicClockUS() - start;
+
+  start = MonotonicClockUS();
+  mac.SolveBatch(tasks.data(), results.data(), tasks.size());
+  const uint64_t batch = MonotonicClockUS() - start;
+
+  printf("# %u tasks: Solve %lu us, SolveBatch %lu us\n",
+         unsigned(tasks.size()), (unsigned long)scalar,
+         (unsigned long)batch);
+}
+
 int main() {
 
   plan_tests(3);
@@ -276,6 +330,8 @@ int main() {
   ok(test_stf(),"mc stf",0);
   ok(test_cb(),"cruise bearing",0);
 
+  benchmark_batch();
+
   return exit_status();
 
 }
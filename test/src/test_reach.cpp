@@ -35,9 +35,13 @@
 #include "Geo/SpeedVector.hpp"
 #include "Operation/Operation.hpp"
 #include "OS/FileUtil.hpp"
+#include "Thread/WorkStealingPool.hpp"
+#include "Time/PeriodClock.hpp"
 
 #include <zzip/zzip.h>
 
+#include <vector>
+
 #include <string.h>
 
 static void
@@ -101,6 +105,266 @@ test_reach(const RasterMap &map, double mwind, double mc, double height_min_work
   //  printf("# pixel size %g\n", (double)pd);
 }
 
+class FanCollector final : public FlatTriangleFanVisitor {
+public:
+  std::vector<FlatGeoPoint> points;
+
+  void VisitFan(FlatGeoPoint origin, ConstBuffer<FlatGeoPoint> fan) override {
+    points.push_back(origin);
+    points.insert(points.end(), fan.begin(), fan.end());
+  }
+};
+
+static std::vector<FlatGeoPoint>
+CollectReach(const TerrainRoute &route, const GeoPoint &origin, bool working)
+{
+  const Angle range = Angle::Degrees(10);
+  const GeoBounds bounds(GeoPoint(origin.longitude - range,
+                                  origin.latitude + range),
+                         GeoPoint(origin.longitude + range,
+                                  origin.latitude - range));
+
+  FanCollector collector;
+  route.AcceptInRange(bounds, collector, working);
+  return std::move(collector.points);
+}
+
+/**
+ * Solve the reach from a number of locations with 1, 2 and 4
+ * threads, report the speed-up and verify that the results are the
+ * same as the serial solver's.
+ */
+static void
+test_parallel_reach(const RasterMap &map, double height_min_working)
+{
+  GlideSettings settings;
+  settings.SetDefaults();
+  RoutePlannerConfig config;
+  config.SetDefaults();
+  config.reach_calc_mode = RoutePlannerConfig::ReachMode::TURNING;
+
+  GlidePolar polar(0.1);
+  SpeedVector wind(Angle::Degrees(0), 0);
+  TerrainRoute route;
+  route.UpdatePolar(settings, config, polar, polar, wind, height_min_working);
+  route.SetTerrain(&map);
+
+  const GeoPoint center = map.GetMapCenter();
+
+  std::vector<AGeoPoint> origins;
+  for (int i = -2; i <= 2; ++i) {
+    for (int j = -2; j <= 2; ++j) {
+      GeoPoint p(center.longitude + Angle::Degrees(0.1 * i),
+                 center.latitude + Angle::Degrees(0.1 * j));
+      origins.emplace_back(p, map.GetHeight(p).GetValueOr0() + 3000);
+    }
+  }
+
+  std::vector<std::vector<FlatGeoPoint>> expected;
+  int serial_ms = 0;
+
+  for (unsigned n_threads : { 1, 2, 4 }) {
+    WorkStealingPool pool(n_threads);
+    route.SetTaskRunner(&pool);
+
+    bool identical = true;
+    unsigned k = 0;
+
+    PeriodClock clock;
+    clock.Update();
+
+    for (const auto &origin : origins) {
+      route.SolveReachTerrain(origin, config, INT_MAX);
+      route.SolveReachWorking(origin, config, INT_MAX);
+
+      auto terrain = CollectReach(route, origin, false);
+      auto working = CollectReach(route, origin, true);
+
+      if (n_threads == 1) {
+        expected.emplace_back(std::move(terrain));
+        expected.emplace_back(std::move(working));
+      } else {
+        identical = identical && terrain == expected[k++];
+        identical = identical && working == expected[k++];
+      }
+    }
+
+    const int ms = clock.Elapsed();
+    if (n_threads == 1)
+      serial_ms = ms;
+    else
+      ok(identical, "parallel reach (%u threads)", n_threads);
+
+    printf("# %u threads: %d ms, speed-up %.2f\n",
+           n_threads, ms, ms > 0 ? (double)serial_ms / ms : 0.);
+
+    route.SetTaskRunner(nullptr);
+  }
+}
+
+/**
+ * Collects the hull of each reach fan as a polygon of geographic
+ * points.
+ */
+class HullCollector final : public FlatTriangleFanVisitor {
+  const FlatProjection &projection;
+
+public:
+  std::vector<std::vector<GeoPoint>> hulls;
+
+  explicit HullCollector(const FlatProjection &_projection)
+    :projection(_projection) {}
+
+  void VisitFan(FlatGeoPoint origin, ConstBuffer<FlatGeoPoint> fan) override {
+    hulls.emplace_back();
+    for (const auto &p : fan)
+      hulls.back().push_back(projection.Unproject(p));
+  }
+
+  gcc_pure
+  bool IsInside(const GeoPoint &p) const {
+    for (const auto &hull : hulls)
+      if (IsInside(hull, p))
+        return true;
+    return false;
+  }
+
+private:
+  static bool IsInside(const std::vector<GeoPoint> &hull, const GeoPoint &p) {
+    bool inside = false;
+    for (auto i = hull.begin(), end = hull.end(), j = std::prev(end);
+         i != end; j = i++) {
+      const double ix = i->longitude.Degrees(), iy = i->latitude.Degrees();
+      const double jx = j->longitude.Degrees(), jy = j->latitude.Degrees();
+      const double px = p.longitude.Degrees(), py = p.latitude.Degrees();
+      if ((iy > py) == (jy > py))
+        continue;
+
+      if (px < (jx - ix) * (py - iy) / (jy - iy) + ix)
+        inside = !inside;
+    }
+
+    return inside;
+  }
+};
+
+/**
+ * Solve the reach along a straight track with small steps, once with
+ * incremental updates and once with full calculations.  The
+ * incremental result must never be more optimistic than the full
+ * one: no destination may have a higher arrival height, and the
+ * footprint must not be larger.
+ */
+static void
+test_incremental_reach(const RasterMap &map, double height_min_working)
+{
+  GlideSettings settings;
+  settings.SetDefaults();
+  RoutePlannerConfig config;
+  config.SetDefaults();
+  config.reach_calc_mode = RoutePlannerConfig::ReachMode::TURNING;
+
+  GlidePolar polar(0.1);
+  SpeedVector wind(Angle::Degrees(0), 0);
+  TerrainRoute route;
+  route.UpdatePolar(settings, config, polar, polar, wind, height_min_working);
+  route.SetTerrain(&map);
+
+  const GeoPoint center = map.GetMapCenter();
+  const int altitude = map.GetHeight(center).GetValueOr0() + 1000;
+
+  constexpr unsigned N_FIXES = 30, N_DESTINATIONS = 16, N_GRID = 20;
+
+  int results[2][N_FIXES][N_DESTINATIONS];
+  bool inside[2][N_FIXES][N_GRID][N_GRID];
+  int ms[2];
+
+  for (unsigned incremental = 0; incremental < 2; ++incremental) {
+    route.ClearReach();
+
+    int elapsed = 0;
+
+    for (unsigned i = 0; i < N_FIXES; ++i) {
+      /* 100 m north and 2 m lower per fix, climbing 20 m in the
+         middle */
+      const GeoPoint location(center.longitude,
+                              center.latitude + Angle::Degrees(0.0009 * i));
+      const int climb = i >= N_FIXES / 2 ? 40 : 0;
+      const AGeoPoint origin(location, altitude - 2 * i + climb);
+
+      if (!incremental)
+        route.ClearReach();
+
+      PeriodClock clock;
+      clock.Update();
+      route.SolveReachTerrain(origin, config, INT_MAX);
+      elapsed += clock.Elapsed();
+
+      for (unsigned j = 0; j < N_DESTINATIONS; ++j) {
+        const Angle a = Angle::FullCircle() * j / N_DESTINATIONS;
+        const GeoPoint p(location.longitude + Angle::Degrees(0.1) * a.cos(),
+                         location.latitude + Angle::Degrees(0.1) * a.sin());
+        ReachResult reach;
+        route.FindPositiveArrival(AGeoPoint(p, map.GetHeight(p).GetValueOr0()),
+                                  reach);
+        results[incremental][i][j] = reach.IsReachableTerrain()
+          ? (int)reach.terrain
+          : -1;
+      }
+
+      const Angle range = Angle::Degrees(1);
+      const GeoBounds bounds(GeoPoint(location.longitude - range,
+                                      location.latitude + range),
+                             GeoPoint(location.longitude + range,
+                                      location.latitude - range));
+      HullCollector hulls(route.GetTerrainReachProjection());
+      route.AcceptInRange(bounds, hulls, false);
+
+      for (unsigned x = 0; x < N_GRID; ++x) {
+        for (unsigned y = 0; y < N_GRID; ++y) {
+          const double fx = (double)x / (N_GRID - 1) * 2 - 1;
+          const double fy = (double)y / (N_GRID - 1) * 2 - 1;
+          const GeoPoint p(location.longitude + Angle::Degrees(0.15 * fx),
+                           location.latitude + Angle::Degrees(0.15 * fy));
+          inside[incremental][i][x][y] = hulls.IsInside(p);
+        }
+      }
+    }
+
+    ms[incremental] = elapsed;
+  }
+
+  unsigned n_optimistic = 0, n_different = 0;
+  for (unsigned i = 0; i < N_FIXES; ++i) {
+    for (unsigned j = 0; j < N_DESTINATIONS; ++j) {
+      if (results[1][i][j] > results[0][i][j])
+        ++n_optimistic;
+      if ((results[0][i][j] < 0) != (results[1][i][j] < 0))
+        ++n_different;
+    }
+  }
+
+  ok(n_optimistic == 0, "incremental reach arrival (%u optimistic, %u different)",
+     n_optimistic, n_different);
+
+  unsigned n_outside = 0, n_smaller = 0;
+  for (unsigned i = 0; i < N_FIXES; ++i) {
+    for (unsigned x = 0; x < N_GRID; ++x) {
+      for (unsigned y = 0; y < N_GRID; ++y) {
+        if (inside[1][i][x][y] && !inside[0][i][x][y])
+          ++n_outside;
+        if (inside[0][i][x][y] && !inside[1][i][x][y])
+          ++n_smaller;
+      }
+    }
+  }
+
+  ok(n_outside == 0, "incremental reach hull (%u outside, %u missing)",
+     n_outside, n_smaller);
+
+  printf("# full: %d ms, incremental: %d ms\n", ms[0], ms[1]);
+}
+
 int main(int argc, char** argv) {
   static const char hc_path[] = "tmp/map.xcm";
   const char *map_path;
@@ -135,11 +399,13 @@ int main(int argc, char** argv) {
   } while (map.IsDirty());
   zzip_dir_close(dir);
 
-  plan_tests(8);
+  plan_tests(12);
   test_reach(map, 0, 0.1, 0);
   test_reach(map, 0, 0.1, 750);
   test_reach(map, 0, 0.1, 500);
   test_reach(map, 0, 0.1, 250);
+  test_parallel_reach(map, 500);
+  test_incremental_reach(map, 500);
 
   return exit_status();
 }
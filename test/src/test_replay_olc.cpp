@@ -162,6 +162,7 @@ test_replay(const Contest olc_type,
                                  trace_computer.GetFull(),
                                  trace_computer.GetSprint());
   contest_manager.SetHandicap(settings_computer.contest.handicap);
+  contest_manager.SetTimeBudget(20000);
 
   DerivedInfo calculated;
 
@@ -192,6 +193,13 @@ test_replay(const Contest olc_type,
 
   if (verbose) {
     PrintDistanceCounts();
+
+    const ContestTiming &timing = contest_manager.GetTiming();
+    std::cout << "# ticks " << timing.ticks
+              << " avg " << timing.GetAverageTick() << "us"
+              << " max " << timing.max_tick << "us\n"
+              << "# first solution after " << timing.first_solution_ticks
+              << " ticks, " << timing.first_solution << "us\n";
   }
   return compare_scores(official_score, 
                         contest_manager.GetStats().GetResult(0));
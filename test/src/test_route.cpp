@@ -30,6 +30,7 @@
 #include "GlideSolvers/GlideSettings.hpp"
 #include "GlideSolvers/GlidePolar.hpp"
 #include "Terrain/RasterMap.hpp"
+#include "Terrain/RasterTileCache.hpp"
 #include "Terrain/Loader.hpp"
 #include "OS/ConvertPathName.hpp"
 #include "OS/FileUtil.hpp"
@@ -45,6 +46,47 @@
 
 #define NUM_SOL 15
 
+/**
+ * Compare the batched terrain lookups with one
+ * GetInterpolatedHeight() call per location.  The number of
+ * locations exceeds the batch capacity.
+ */
+static bool
+test_interpolated_heights(RasterMap &map)
+{
+  static constexpr unsigned N = 300;
+
+  const GeoBounds &bounds = map.GetBounds();
+  GeoPoint locations[N];
+  RasterLocation raster_locations[N];
+  for (unsigned i = 0; i < N; ++i) {
+    /* a diagonal which starts and ends outside the map */
+    const double f = -0.1 + 1.2 * i / (N - 1);
+    locations[i] = GeoPoint(bounds.GetWest() + bounds.GetWidth() * f,
+                            bounds.GetNorth() - bounds.GetHeight() * f * f);
+    raster_locations[i] = map.GetProjection().ProjectFine(locations[i]);
+  }
+
+  TerrainHeight heights[N];
+  map.GetInterpolatedHeights(locations, heights, N);
+
+  TerrainHeight cache_heights[N];
+  const RasterTileCache &cache = map.GetTileCache();
+  cache.GetInterpolatedHeights(raster_locations, cache_heights, N);
+
+  for (unsigned i = 0; i < N; ++i) {
+    const TerrainHeight expected = map.GetInterpolatedHeight(locations[i]);
+    const TerrainHeight expected_cache =
+      cache.GetInterpolatedHeight(raster_locations[i].x,
+                                  raster_locations[i].y);
+    if (heights[i].GetValue() != expected.GetValue() ||
+        cache_heights[i].GetValue() != expected_cache.GetValue())
+      return false;
+  }
+
+  return true;
+}
+
 static bool
 test_route(const unsigned n_airspaces, const RasterMap& map)
 {
@@ -207,7 +249,8 @@ main(int argc, char** argv)
   } while (map.IsDirty());
   zzip_dir_close(dir);
 
-  plan_tests(4 + NUM_SOL);
+  plan_tests(5 + NUM_SOL);
+  ok(test_interpolated_heights(map), "batched interpolation", 0);
   ok(test_route(28, map), "route 28", 0);
   return exit_status();
 }